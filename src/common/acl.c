@@ -16,93 +16,193 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
 #include "common/acl.h"
 
-static inline uint32_t acl_sa_ipv4(sockaddr_t *a) {
-	return a->addr4.sin_addr.s_addr;
-}
+/*! \brief Maximal address length in bytes. */
+#define ACL_ADDR_MAXLEN 16
 
-static inline uint32_t acl_fill_mask32(short c) {
-	/*! \todo Consider optimizing using LUT. */
-	assert(c >= 0 && c <= 32);
-	unsigned r = 0;
-	/*! This actually builds big-endian mask
-	 *  as we will match against addresses in
-	 *  network byte-order (big-endian).
-	 *  Otherwise it should be built from
-	 *  HO bit -> LO bit.
-	 */
-	for (char i = 0; i < c; ++i) {
-		r |= (1 << i);
-	}
-	return r;
+/*!
+ * \brief Node of the compressed binary radix tree.
+ *
+ * Each node represents an address prefix, its children extend the prefix
+ * by at least one bit (the first bit after the prefix selects the child).
+ * Nodes without a rule only join two longer prefixes.
+ */
+struct acl_node {
+	uint8_t addr[ACL_ADDR_MAXLEN]; /*!< Prefix, trailing bits zeroed. */
+	short prefix;                  /*!< Prefix length in bits. */
+	acl_key_t *key;                /*!< Rule for the prefix or NULL. */
+	struct acl_node *child[2];     /*!< Longer prefixes. */
+};
+
+/*!
+ * \brief Returns tree index, address and its length in bits.
+ *
+ * \retval Tree index (0 for IPv4, 1 for IPv6).
+ * \retval -1 for unsupported family.
+ */
+static int acl_addr(const sockaddr_t *sa, const uint8_t **addr, short *bits)
+{
+	switch (sockaddr_family(sa)) {
+	case AF_INET:
+		*addr = (const uint8_t *)&sa->addr4.sin_addr;
+		*bits = IPV4_PREFIXLEN;
+		return 0;
+#ifndef DISABLE_IPV6
+	case AF_INET6:
+		*addr = (const uint8_t *)&sa->addr6.sin6_addr;
+		*bits = IPV6_PREFIXLEN;
+		return 1;
+#endif
+	default:
+		return -1;
+	}
 }
 
-static int acl_compare(void *k1, void *k2)
+/*! \brief Returns n-th bit of the address (from the most significant). */
+static inline int acl_bit(const uint8_t *addr, short n)
 {
-	sockaddr_t* a1 = (sockaddr_t *)k1;
-	sockaddr_t* a2 = (sockaddr_t *)k2;
+	return (addr[n / 8] >> (7 - n % 8)) & 1;
+}
 
-	/* Check different length, IPv4 goes first. */
-	int ldiff = a1->len - a2->len;
-	if (ldiff != 0) {
-		return ldiff < 0 ? -1 : 1;
+/*! \brief Returns length of the common prefix, at most \a bits long. */
+static short acl_common(const uint8_t *a1, const uint8_t *a2, short bits)
+{
+	short n = 0;
+	while (n + 8 <= bits && a1[n / 8] == a2[n / 8]) {
+		n += 8;
+	}
+	if (n < bits) {
+		uint8_t diff = a1[n / 8] ^ a2[n / 8];
+		while (n < bits && (diff & (0x80 >> (n % 8))) == 0) {
+			++n;
+		}
 	}
+	return n;
+}
 
-	/* Compare integers if IPv4. */
-	if (sockaddr_family(a1) == AF_INET) {
+/*! \brief Creates a node for the first \a prefix bits of the address. */
+static acl_node_t *acl_node_new(const uint8_t *addr, short prefix,
+                                acl_key_t *key)
+{
+	acl_node_t *node = calloc(1, sizeof(acl_node_t));
+	if (node == NULL) {
+		return NULL;
+	}
 
-		/* Compute mask .*/
-		uint32_t mask = acl_fill_mask32(a1->prefix);
+	memcpy(node->addr, addr, (prefix + 7) / 8);
+	if (prefix % 8 != 0) {
+		node->addr[prefix / 8] &= 0xff << (8 - prefix % 8);
+	}
+	node->prefix = prefix;
+	node->key = key;
+	return node;
+}
 
-		/* Compare address. */
-		int cmp1 = (acl_sa_ipv4(a1) & mask);
-		int cmp2 = (acl_sa_ipv4(a2) & mask);
-		if (cmp1 > cmp2) return  1;
-		if (cmp1 < cmp2) return -1;
-		return 0;
+static void acl_tree_free(acl_node_t *node)
+{
+	if (node == NULL) {
+		return;
 	}
 
-	/* IPv6 matching. */
-#ifndef DISABLE_IPV6
-	if (sockaddr_family(a1) == AF_INET6) {
-
-		/* Get mask .*/
-		short chunk = a1->prefix;
-
-		/* Compare address by 32bit chunks. */
-		uint32_t* a1p = (uint32_t *)(&a1->addr6.sin6_addr);
-		uint32_t* a2p = (uint32_t *)(&a2->addr6.sin6_addr);
-
-		/* Mask 0 = 0 bits to compare from LO->HO (in big-endian).
-		 * Mask 128 = 128 bits to compare.
-		 */
-		while (chunk > 0) {
-			uint32_t mask = 0xffffffff;
-			if (chunk > sizeof(mask) << 3) {
-				chunk -= sizeof(mask) << 3;
-			} else {
-				mask = acl_fill_mask32(chunk);
-				chunk = 0;
-			}
+	acl_tree_free(node->child[0]);
+	acl_tree_free(node->child[1]);
+	free(node->key);
+	free(node);
+}
 
-			int cmp1 = (*(a1p++) & mask);
-			int cmp2 = (*(a2p++) & mask);
-			if (cmp1 > cmp2) return  1;
-			if (cmp1 < cmp2) return -1;
+/*!
+ * \brief Inserts rule for the prefix, the first rule for a prefix wins.
+ *
+ * \retval 0 if inserted.
+ * \retval 1 if the prefix already has a rule.
+ * \retval -1 on error.
+ */
+static int acl_tree_insert(acl_node_t **root, const uint8_t *addr,
+                           short prefix, acl_key_t *key)
+{
+	/* Find the first node which isn't a prefix of the address. */
+	acl_node_t **pos = root;
+	while (*pos != NULL) {
+		acl_node_t *node = *pos;
+		short len = node->prefix < prefix ? node->prefix : prefix;
+		if (acl_common(node->addr, addr, len) < node->prefix) {
+			break;
+		}
+		if (node->prefix == prefix) {
+			if (node->key != NULL) {
+				return 1;
+			}
+			node->key = key;
+			return 0;
 		}
+		pos = &node->child[acl_bit(addr, node->prefix)];
+	}
 
+	acl_node_t *leaf = acl_node_new(addr, prefix, key);
+	if (leaf == NULL) {
+		return -1;
+	}
+
+	/* Free slot. */
+	acl_node_t *node = *pos;
+	if (node == NULL) {
+		*pos = leaf;
+		return 0;
+	}
+
+	/* New prefix covers the node. */
+	short len = node->prefix < prefix ? node->prefix : prefix;
+	short common = acl_common(node->addr, addr, len);
+	if (common == prefix) {
+		leaf->child[acl_bit(node->addr, prefix)] = node;
+		*pos = leaf;
 		return 0;
 	}
-#endif
 
+	/* Prefixes diverge, join them with a node without rule. */
+	acl_node_t *join = acl_node_new(addr, common, NULL);
+	if (join == NULL) {
+		free(leaf);
+		return -1;
+	}
+	join->child[acl_bit(addr, common)] = leaf;
+	join->child[acl_bit(node->addr, common)] = node;
+	*pos = join;
 	return 0;
 }
 
+/*! \brief Finds rule with the longest prefix matching the address. */
+static acl_key_t *acl_tree_find(acl_node_t *node, const uint8_t *addr,
+                                short bits)
+{
+	acl_key_t *found = NULL;
+	short matched = 0;
+	while (node != NULL) {
+		/* Check only bits not checked in the ancestors. */
+		short len = node->prefix - (matched & ~7);
+		if (acl_common(node->addr + matched / 8, addr + matched / 8,
+		               len) < len) {
+			break;
+		}
+		matched = node->prefix;
+		if (node->key != NULL) {
+			found = node->key;
+		}
+		if (matched == bits) {
+			break;
+		}
+		node = node->child[acl_bit(addr, matched)];
+	}
+
+	return found;
+}
+
 acl_t *acl_new(acl_rule_t default_rule, const char *name)
 {
 	/* Trailing '\0' for NULL name. */
@@ -114,31 +214,11 @@ acl_t *acl_new(acl_rule_t default_rule, const char *name)
 	}
 
 	/* Allocate memory for ACL. */
-	acl_t* acl = malloc(sizeof(acl_t) + name_len);
+	acl_t* acl = calloc(1, sizeof(acl_t) + name_len);
 	if (!acl) {
 		return 0;
 	}
 
-	/* Initialize skip list. */
-	acl->rules = skip_create_list(acl_compare);
-	if (!acl->rules) {
-		free(acl);
-		return 0;
-	}
-
-	/* Initialize skip list for rules with TSIG. */
-	/*! \todo This needs a better structure to make
-	 *        nodes with TSIG preferred, but for now
-	 *        it will do to sort nodes into two lists.
-	 *        (issue #1675)
-	 */
-	acl->rules_pref = skip_create_list(acl_compare);
-	if (!acl->rules_pref) {
-		skip_destroy_list(&acl->rules, 0, free);
-		free(acl);
-		return 0;
-	}
-
 	/* Initialize. */
 	memcpy(&acl->name, name, name_len);
 	acl->default_rule = default_rule;
@@ -152,8 +232,7 @@ void acl_delete(acl_t **acl)
 	}
 
 	/* Truncate rules. */
-	skip_destroy_list(&(*acl)->rules, 0, free);
-	skip_destroy_list(&(*acl)->rules_pref, 0, free);
+	acl_truncate(*acl);
 
 	/* Free ACL. */
 	free(*acl);
@@ -167,7 +246,19 @@ int acl_create(acl_t *acl, const sockaddr_t* addr, acl_rule_t rule, void *val,
 		return ACL_ERROR;
 	}
 
-	/* Insert into skip list. */
+	const uint8_t *bin = NULL;
+	short bits = 0;
+	int family = acl_addr(addr, &bin, &bits);
+	if (family < 0) {
+		return ACL_ERROR;
+	}
+
+	/* Longer prefix than address means whole address. */
+	short prefix = addr->prefix;
+	if (prefix < 0 || prefix > bits) {
+		prefix = bits;
+	}
+
 	acl_key_t *key = malloc(sizeof(acl_key_t));
 	if (key == NULL) {
 		return ACL_ERROR;
@@ -177,11 +268,18 @@ int acl_create(acl_t *acl, const sockaddr_t* addr, acl_rule_t rule, void *val,
 	key->rule = rule;
 	key->val = val;
 
-
+	acl_node_t **root = &acl->rules[family];
 	if (flags & ACL_PREFER) {
-		skip_insert(acl->rules_pref, &key->addr, key, 0);
-	} else {
-		skip_insert(acl->rules, &key->addr, key, 0);
+		root = &acl->rules_pref[family];
+	}
+
+	/* Insert into prefix tree. */
+	int ret = acl_tree_insert(root, bin, prefix, key);
+	if (ret != 0) {
+		free(key);
+	}
+	if (ret < 0) {
+		return ACL_ERROR;
 	}
 
 	return ACL_ACCEPT;
@@ -193,9 +291,16 @@ int acl_match(acl_t *acl, const sockaddr_t* addr, acl_key_t **key)
 		return ACL_ERROR;
 	}
 
-	acl_key_t *found = skip_find(acl->rules_pref, (void*)addr);
-	if (found == NULL) {
-		found = skip_find(acl->rules, (void*)addr);
+	const uint8_t *bin = NULL;
+	short bits = 0;
+	int family = acl_addr(addr, &bin, &bits);
+
+	acl_key_t *found = NULL;
+	if (family >= 0) {
+		found = acl_tree_find(acl->rules_pref[family], bin, bits);
+		if (found == NULL) {
+			found = acl_tree_find(acl->rules[family], bin, bits);
+		}
 	}
 
 	/* Set stored value if exists. */
@@ -218,12 +323,11 @@ int acl_truncate(acl_t *acl)
 	}
 
 	/* Destroy all rules. */
-	skip_destroy_list(&acl->rules, 0, free);
-	skip_destroy_list(&acl->rules_pref, 0, free);
-	acl->rules = skip_create_list(acl_compare);
-	acl->rules_pref = skip_create_list(acl_compare);
-	if (acl->rules == NULL || acl->rules_pref == NULL) {
-		return ACL_ERROR;
+	for (int i = 0; i < ACL_FAMILIES; ++i) {
+		acl_tree_free(acl->rules[i]);
+		acl_tree_free(acl->rules_pref[i]);
+		acl->rules[i] = NULL;
+		acl->rules_pref[i] = NULL;
 	}
 
 	return ACL_ACCEPT;
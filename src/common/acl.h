@@ -23,6 +23,10 @@
  * An access control list is a named structure
  * for efficient IP address and port matching.
  *
+ * Rules are kept in compressed binary radix trees (one per address family),
+ * so the address is matched against the longest rule prefix in time
+ * proportional to the address length, regardless of the number of rules.
+ *
  * \addtogroup common_lib
  * @{
  */
@@ -30,7 +34,6 @@
 #ifndef _KNOTD_ACL_H_
 #define _KNOTD_ACL_H_
 
-#include "common/skip-list.h"
 #include "common/sockaddr.h"
 
 /*! \brief ACL rules types. */
@@ -45,11 +48,17 @@ enum acl_flag_t {
 	ACL_PREFER = 1 << 0 /* Preferred node. */
 };
 
+/*! \brief Number of supported address families (IPv4, IPv6). */
+#define ACL_FAMILIES 2
+
+/*! \brief Radix tree node. */
+typedef struct acl_node acl_node_t;
+
 /*! \brief ACL structure. */
 typedef struct acl_t {
 	acl_rule_t default_rule; /*!< \brief Default rule. */
-	skip_list_t *rules;      /*!< \brief Data container. */
-	skip_list_t *rules_pref; /*!< \brief Preferred data container. */
+	acl_node_t *rules[ACL_FAMILIES];      /*!< \brief Rule trees. */
+	acl_node_t *rules_pref[ACL_FAMILIES]; /*!< \brief Preferred rules. */
 	char name[];       /*!< \brief ACL semantic name. */
 } acl_t;
 
@@ -81,7 +90,8 @@ void acl_delete(acl_t **acl);
 /*!
  * \brief Create new ACL rule.
  *
- * \todo Support address subnets (issue #1366).
+ * Rule applies to all addresses matching the address prefix, port is
+ * ignored. If there already is a rule for the prefix, it is kept.
  *
  * \param acl Pointer to ACL instance.
  * \param addr IP address.
@@ -98,6 +108,9 @@ int acl_create(acl_t *acl, const sockaddr_t* addr, acl_rule_t rule, void *val,
 /*!
  * \brief Match address against ACL.
  *
+ * Preferred rules are searched first, the rule with the longest matching
+ * prefix is used.
+ *
  * \param acl Pointer to ACL instance.
  * \param addr IP address.
  * \param key Set to related key or NULL if not found.
@@ -135,21 +148,6 @@ static inline const char* acl_name(acl_t *acl) {
 	return acl->name;
 }
 
-/*!
- * \brief Return ACL rules.
- *
- * \param acl Pointer to ACL instance.
- *
- * \retval ACL rules skip-list.
- */
-static inline skip_list_t* acl_rules(acl_t *acl) {
-        if (!acl) {
-                return 0;
-        }
-
-        return acl->rules;
-}
-
 #endif /* _KNOTD_ACL_H_ */
 
 /*! @} */
@@ -0,0 +1,310 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "common/arena.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+/*! \brief Binary logarithm of chunk size. */
+#define ARENA_CHUNK_BITS 20
+
+/*! \brief Number of address bits covered by the chunk bitmap. */
+#define ARENA_ADDR_BITS (sizeof(void *) > 4 ? 47 : 32)
+
+/*!
+ * \brief Chunk header, placed at the start of each chunk.
+ */
+typedef struct arena_chunk {
+	arena_t *arena;            /*!< Owner arena. */
+	struct arena_chunk *next;  /*!< Next chunk in arena. */
+	size_t size;               /*!< Mapped size. */
+} arena_chunk_t;
+
+/*! \brief Bitmap of chunks (one bit per ARENA_CHUNK_SIZE of addresses). */
+static uint8_t *arena_map = NULL;
+static pthread_once_t arena_map_once = PTHREAD_ONCE_INIT;
+
+/*! \brief TLS key for current arena. */
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+/*! \brief Map chunk bitmap, pages are only touched when chunks are set. */
+static void arena_map_init()
+{
+	size_t len = ((size_t)1 << (ARENA_ADDR_BITS - ARENA_CHUNK_BITS)) / 8;
+	void *map = mmap(NULL, len, PROT_READ | PROT_WRITE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (map != MAP_FAILED) {
+		arena_map = map;
+	}
+}
+
+static void arena_key_init()
+{
+	(void)pthread_key_create(&arena_key, NULL);
+}
+
+/*! \brief Mark chunk address range in the bitmap. */
+static void arena_map_set(arena_chunk_t *chunk, int used)
+{
+	size_t first = (uintptr_t)chunk >> ARENA_CHUNK_BITS;
+	size_t count = chunk->size >> ARENA_CHUNK_BITS;
+	for (size_t i = first; i < first + count; ++i) {
+		uint8_t bit = 1 << (i & 7);
+		if (used) {
+			__sync_fetch_and_or(arena_map + (i >> 3), bit);
+		} else {
+			__sync_fetch_and_and(arena_map + (i >> 3), ~bit);
+		}
+	}
+}
+
+/*!
+ * \brief Map a new chunk aligned to its size.
+ * \retval Mapped chunk on success.
+ * \retval NULL on error.
+ */
+static arena_chunk_t *arena_chunk_new(arena_t *arena, size_t size)
+{
+	/* Round up to chunk size. */
+	size = (size + ARENA_CHUNK_SIZE - 1) & ~((size_t)ARENA_CHUNK_SIZE - 1);
+
+	/* Map with extra space and trim to alignment. */
+	size_t len = size + ARENA_CHUNK_SIZE;
+	char *mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		return NULL;
+	}
+	uintptr_t mask = ARENA_CHUNK_SIZE - 1;
+	char *aligned = (char *)(((uintptr_t)mem + mask) & ~mask);
+	if (aligned > mem) {
+		munmap(mem, aligned - mem);
+	}
+	if (aligned + size < mem + len) {
+		munmap(aligned + size, (mem + len) - (aligned + size));
+	}
+
+	/* Addresses beyond the bitmap can't be used. */
+	if (((uintptr_t)aligned + size - 1) >> ARENA_ADDR_BITS) {
+		munmap(aligned, size);
+		return NULL;
+	}
+
+	arena_chunk_t *chunk = (arena_chunk_t *)aligned;
+	chunk->arena = arena;
+	chunk->size = size;
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->mapped += size;
+	arena_map_set(chunk, 1);
+
+	return chunk;
+}
+
+/*! \brief Unmap all chunks and free the arena (reference destructor). */
+static void arena_destroy(ref_t *ref)
+{
+	arena_t *arena = (arena_t *)ref;
+	while (arena->chunks) {
+		arena_chunk_t *chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		arena_map_set(chunk, 0);
+		munmap(chunk, chunk->size);
+	}
+
+	free(arena);
+}
+
+arena_t *arena_new()
+{
+	(void)pthread_once(&arena_map_once, arena_map_init);
+	if (arena_map == NULL) {
+		return NULL;
+	}
+
+	arena_t *arena = malloc(sizeof(arena_t));
+	if (arena == NULL) {
+		return NULL;
+	}
+
+	memset(arena, 0, sizeof(arena_t));
+	ref_init(&arena->ref, arena_destroy);
+	ref_retain(&arena->ref);
+
+	return arena;
+}
+
+void arena_retain(arena_t *arena)
+{
+	if (arena) {
+		ref_retain(&arena->ref);
+	}
+}
+
+void arena_release(arena_t *arena)
+{
+	if (arena) {
+		ref_release(&arena->ref);
+	}
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+	if (arena == NULL) {
+		return NULL;
+	}
+
+	size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+	/* Large blocks get their own chunk. */
+	if (size >= ARENA_LARGE) {
+		arena_chunk_t *chunk = arena_chunk_new(arena,
+		                                       sizeof(*chunk) + size);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		arena->used += size;
+		return chunk + 1;
+	}
+
+	if (arena->pos == NULL || (size_t)(arena->end - arena->pos) < size) {
+		arena_chunk_t *chunk = arena_chunk_new(arena,
+		                                       ARENA_CHUNK_SIZE);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		arena->pos = (char *)(chunk + 1);
+		arena->end = (char *)chunk + chunk->size;
+	}
+
+	void *ret = arena->pos;
+	arena->pos += size;
+	arena->used += size;
+
+	return ret;
+}
+
+arena_t *arena_owner(const void *ptr)
+{
+	if (ptr == NULL || arena_map == NULL) {
+		return NULL;
+	}
+
+	uintptr_t addr = (uintptr_t)ptr;
+	if (addr >> ARENA_ADDR_BITS) {
+		return NULL;
+	}
+
+	size_t i = addr >> ARENA_CHUNK_BITS;
+	if (!(arena_map[i >> 3] & (1 << (i & 7)))) {
+		return NULL;
+	}
+
+	/* Blocks start in the first chunk-sized part of their chunk. */
+	arena_chunk_t *chunk = (arena_chunk_t *)(addr & ~(uintptr_t)
+	                                         (ARENA_CHUNK_SIZE - 1));
+	return chunk->arena;
+}
+
+void arena_enter(arena_t *arena)
+{
+	(void)pthread_once(&arena_key_once, arena_key_init);
+	(void)pthread_setspecific(arena_key, arena);
+}
+
+void arena_leave()
+{
+	arena_enter(NULL);
+}
+
+arena_t *arena_current()
+{
+	(void)pthread_once(&arena_key_once, arena_key_init);
+	return pthread_getspecific(arena_key);
+}
+
+void *arena_malloc(size_t size)
+{
+	arena_t *arena = arena_current();
+	if (arena != NULL) {
+		return arena_alloc(arena, size);
+	}
+
+	return malloc(size);
+}
+
+void *arena_realloc(void *ptr, size_t old_size, size_t size)
+{
+	if (ptr == NULL) {
+		return arena_malloc(size);
+	}
+
+	arena_t *arena = arena_owner(ptr);
+	if (arena == NULL) {
+		return realloc(ptr, size);
+	}
+
+	/* Resize in place if the block is the last one in the current arena. */
+	size_t old_aligned = (old_size + ARENA_ALIGN - 1) &
+	                     ~((size_t)ARENA_ALIGN - 1);
+	size_t aligned = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+	char *mem = ptr;
+	if (arena == arena_current() && mem + old_aligned == arena->pos &&
+	    (size_t)(arena->end - mem) >= aligned) {
+		if (aligned < old_aligned) {
+			/* Arena memory is handed out zeroed. */
+			memset(mem + aligned, 0, old_aligned - aligned);
+		}
+		arena->pos = mem + aligned;
+		arena->used = arena->used - old_aligned + aligned;
+		return ptr;
+	}
+
+	/* Shrink other blocks in place. */
+	if (size <= old_size) {
+		return ptr;
+	}
+
+	/* Grow other blocks on the heap, so that further growth is cheap and
+	 * the arena is not filled with abandoned copies. */
+	void *ret = malloc(size);
+	if (ret != NULL) {
+		memcpy(ret, ptr, old_size);
+	}
+
+	return ret;
+}
+
+void arena_free(void *ptr)
+{
+	if (arena_owner(ptr) == NULL) {
+		free(ptr);
+	}
+}
@@ -0,0 +1,169 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file arena.h
+ *
+ * \brief Arena allocator for zone contents.
+ *
+ * Arena carves memory from large chunks with a simple pointer bump. Memory
+ * is never returned piecewise, all chunks are unmapped at once when the last
+ * reference to the arena is released. Loading a zone into an arena thus
+ * avoids millions of malloc() calls and freeing it takes a few munmap()s.
+ *
+ * Chunks are aligned to \ref ARENA_CHUNK_SIZE and registered in a global
+ * bitmap, so arena_owner() tells arena memory from heap memory in O(1)
+ * without touching the memory itself. This allows objects from arenas and
+ * from the heap to be mixed and freed by the same code, see arena_free()
+ * and arena_realloc().
+ *
+ * Arena is not thread safe. Allocations are done by a single thread, which
+ * enters the arena with arena_enter(); arena_malloc() and arena_realloc()
+ * then allocate from it instead of the heap.
+ *
+ * \code
+ * arena_t *arena = arena_new();
+ * arena_enter(arena);
+ * void *mem = arena_malloc(N); // From arena
+ * arena_leave();
+ * arena_free(mem);             // No-op, memory belongs to the arena
+ * arena_release(arena);        // All arena memory is freed
+ * \endcode
+ *
+ * \addtogroup alloc
+ * @{
+ */
+
+#ifndef _KNOTD_COMMON_ARENA_H_
+#define _KNOTD_COMMON_ARENA_H_
+
+#include <stddef.h>
+
+#include "common/ref.h"
+
+#define ARENA_CHUNK_SIZE (1 << 20) //!< Chunk size and alignment (1MB).
+#define ARENA_ALIGN 8              //!< Alignment of allocated blocks.
+#define ARENA_LARGE (ARENA_CHUNK_SIZE / 8) //!< Blocks with own chunks.
+
+struct arena_chunk;
+
+/*!
+ * \brief Arena descriptor.
+ */
+typedef struct arena {
+	ref_t ref;                  /*!< Reference counter (must be first). */
+	struct arena_chunk *chunks; /*!< List of mapped chunks. */
+	char *pos;                  /*!< Free space in current chunk. */
+	char *end;                  /*!< End of current chunk. */
+	size_t mapped;              /*!< Number of mapped bytes. */
+	size_t used;                /*!< Number of allocated bytes. */
+} arena_t;
+
+/*!
+ * \brief Create an empty arena with one reference.
+ *
+ * \retval New arena on success.
+ * \retval NULL on error.
+ */
+arena_t *arena_new();
+
+/*!
+ * \brief Add a reference to the arena.
+ *
+ * \param arena Arena (may be NULL).
+ */
+void arena_retain(arena_t *arena);
+
+/*!
+ * \brief Release a reference, the last one frees all arena memory.
+ *
+ * \param arena Arena (may be NULL).
+ */
+void arena_release(arena_t *arena);
+
+/*!
+ * \brief Allocate memory from the arena.
+ *
+ * \param arena Arena.
+ * \param size Requested size.
+ *
+ * \retval Pointer to zeroed memory aligned to \ref ARENA_ALIGN.
+ * \retval NULL on error.
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/*!
+ * \brief Return arena owning the memory block.
+ *
+ * \param ptr Start of a memory block.
+ *
+ * \retval Owner arena.
+ * \retval NULL if the block is not allocated from an arena.
+ */
+arena_t *arena_owner(const void *ptr);
+
+/*!
+ * \brief Make the arena current for the calling thread.
+ *
+ * \param arena Arena, NULL to leave the current one.
+ */
+void arena_enter(arena_t *arena);
+
+/*!
+ * \brief Stop using the current arena in the calling thread.
+ */
+void arena_leave();
+
+/*!
+ * \brief Return current arena of the calling thread or NULL.
+ */
+arena_t *arena_current();
+
+/*!
+ * \brief Allocate from the current arena or from the heap if there's none.
+ *
+ * \param size Requested size.
+ *
+ * \retval Pointer to allocated memory.
+ * \retval NULL on error.
+ */
+void *arena_malloc(size_t size);
+
+/*!
+ * \brief Resize memory from an arena or from the heap.
+ *
+ * The last block allocated from the current arena is resized in place if the
+ * chunk has space left. Other arena blocks are shrunk in place and moved to
+ * the heap when growing, the old block is left to the arena.
+ *
+ * \param ptr Memory block or NULL.
+ * \param old_size Current size of the block.
+ * \param size Requested size.
+ *
+ * \retval Pointer to resized memory.
+ * \retval NULL on error, original block is left untouched.
+ */
+void *arena_realloc(void *ptr, size_t old_size, size_t size);
+
+/*!
+ * \brief Free memory block, blocks from arenas are left to their arena.
+ *
+ * \param ptr Memory block or NULL.
+ */
+void arena_free(void *ptr);
+
+#endif /* _KNOTD_COMMON_ARENA_H_ */
+
+/*! @} */
@@ -21,6 +21,13 @@
 #include <stdlib.h>			// malloc
 #include <stdint.h>			// uint8_t
 
+/* SSSE3 and AVX2 code is compiled separately and enabled at runtime. */
+#if defined(HAVE_SSE2) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define KNOT_BASE64_SIMD
+#include <immintrin.h>
+#endif
+
 /*! \brief Maximal length of binary input to Base64 encoding. */
 #define MAX_BIN_DATA_LEN	((INT32_MAX / 4) * 3)
 
@@ -82,6 +89,339 @@ const uint8_t base64_dec[256] = {
 	[ 42] = KO, ['U'] = 20, [128] = KO, [171] = KO, [214] = KO,
 };
 
+/*----------------------------------------------------------------------------*/
+/* Vector kernels                                                             */
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Vector kernels process a prefix of whole blocks and return the length of
+ * the input consumed, the rest (padding included) goes to the scalar code.
+ * Decoding stops at the first vector containing anything outside of the
+ * alphabet, so errors and padding are always handled by the scalar code.
+ * Loads and stores never cross the buffer bounds checked by the callers.
+ */
+
+#ifdef KNOT_BASE64_SIMD
+
+/*! \brief Splits 3-byte groups to 6-bit values, one per byte. */
+__attribute__((target("ssse3"), always_inline))
+static inline __m128i enc_reshuffle_ssse3(__m128i v)
+{
+	// Spread each group to 32 bits as [b1 b0 b2 b1].
+	v = _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+	                                      7, 6, 8, 7, 10, 9, 11, 10));
+
+	// Move 1. and 3. value to the low byte of 16-bit words...
+	__m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+	__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+
+	// ...and 2. and 4. value to the high byte.
+	__m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+	__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+	return _mm_or_si128(t1, t3);
+}
+
+/*! \brief Translates 6-bit values to Base64 characters. */
+__attribute__((target("ssse3"), always_inline))
+static inline __m128i enc_translate_ssse3(__m128i v)
+{
+	// Offsets to add for ranges 26-51, 52-61, 62, 63 and 0-25.
+	const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+	                                    '0' - 52, '0' - 52, '0' - 52,
+	                                    '0' - 52, '0' - 52, '0' - 52,
+	                                    '0' - 52, '0' - 52, '+' - 62,
+	                                    '/' - 63, 'A', 0, 0);
+
+	// 0-51 -> 0, 52-63 -> 1-12; then 0-25 -> 13.
+	__m128i idx = _mm_subs_epu8(v, _mm_set1_epi8(51));
+	__m128i low = _mm_cmpgt_epi8(_mm_set1_epi8(26), v);
+	idx = _mm_or_si128(idx, _mm_and_si128(low, _mm_set1_epi8(13)));
+
+	return _mm_add_epi8(v, _mm_shuffle_epi8(shift, idx));
+}
+
+/*!
+ * \brief Translates Base64 characters to 6-bit values.
+ *
+ * \retval 0 if all characters are in the alphabet.
+ * \retval -1 otherwise, \a v is left unchanged.
+ */
+__attribute__((target("ssse3"), always_inline))
+static inline int dec_translate_ssse3(__m128i *v)
+{
+	// Character classes by low and high nibble, any common bit is error.
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11,
+	                                     0x11, 0x11, 0x11, 0x11,
+	                                     0x11, 0x11, 0x13, 0x1A,
+	                                     0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02,
+	                                     0x04, 0x08, 0x04, 0x08,
+	                                     0x10, 0x10, 0x10, 0x10,
+	                                     0x10, 0x10, 0x10, 0x10);
+	// Offsets by high nibble, '/' is moved to its own slot.
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+	                                       0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask = _mm_set1_epi8(0x2f);
+
+	__m128i hi_nib = _mm_and_si128(_mm_srli_epi32(*v, 4), mask);
+	__m128i lo_nib = _mm_and_si128(*v, mask);
+	__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+	__m128i lo = _mm_shuffle_epi8(lut_lo, lo_nib);
+	__m128i bad = _mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+	                             _mm_setzero_si128());
+	if (_mm_movemask_epi8(bad) != 0) {
+		return -1;
+	}
+
+	__m128i slash = _mm_cmpeq_epi8(*v, mask);
+	__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(slash, hi_nib));
+	*v = _mm_add_epi8(*v, roll);
+
+	return 0;
+}
+
+/*! \brief Packs 6-bit values to 3-byte groups in the low 12 bytes. */
+__attribute__((target("ssse3"), always_inline))
+static inline __m128i dec_reshuffle_ssse3(__m128i v)
+{
+	// Merge value pairs to 12 bits, then to 24 bits per group.
+	v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+	v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+
+	return _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+	                                         14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(const uint8_t *in, size_t in_len,
+                                  uint8_t *out)
+{
+	size_t i = 0;
+	for (; i + 16 <= in_len; i += 12) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+		v = enc_translate_ssse3(enc_reshuffle_ssse3(v));
+		_mm_storeu_si128((__m128i *)out, v);
+		out += 16;
+	}
+	return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t base64_decode_ssse3(const uint8_t *in, size_t in_len,
+                                  uint8_t *out)
+{
+	size_t i = 0;
+	// Keep room for the 16-byte store.
+	for (; i + 24 <= in_len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+		if (dec_translate_ssse3(&v) != 0) {
+			break;
+		}
+		_mm_storeu_si128((__m128i *)out, dec_reshuffle_ssse3(v));
+		out += 12;
+	}
+	return i;
+}
+
+/* AVX2 kernels work on 128-bit lanes, the same way as SSSE3 ones. */
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i dup_avx2(__m128i v)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(v), v, 1);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i enc_reshuffle_avx2(__m256i v)
+{
+	v = _mm256_shuffle_epi8(v, dup_avx2(
+		_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+		              7, 6, 8, 7, 10, 9, 11, 10)));
+
+	__m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+	__m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+	__m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+	__m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+	return _mm256_or_si256(t1, t3);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i enc_translate_avx2(__m256i v)
+{
+	const __m256i shift = dup_avx2(
+		_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+		              '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		              '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		              '/' - 63, 'A', 0, 0));
+
+	__m256i idx = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+	__m256i low = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), v);
+	idx = _mm256_or_si256(idx, _mm256_and_si256(low, _mm256_set1_epi8(13)));
+
+	return _mm256_add_epi8(v, _mm256_shuffle_epi8(shift, idx));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline int dec_translate_avx2(__m256i *v)
+{
+	const __m256i lut_lo = dup_avx2(
+		_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A));
+	const __m256i lut_hi = dup_avx2(
+		_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+	const __m256i lut_roll = dup_avx2(
+		_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+		              0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i mask = _mm256_set1_epi8(0x2f);
+
+	__m256i hi_nib = _mm256_and_si256(_mm256_srli_epi32(*v, 4), mask);
+	__m256i lo_nib = _mm256_and_si256(*v, mask);
+	__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nib);
+	__m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nib);
+	__m256i bad = _mm256_cmpgt_epi8(_mm256_and_si256(lo, hi),
+	                                _mm256_setzero_si256());
+	if (_mm256_movemask_epi8(bad) != 0) {
+		return -1;
+	}
+
+	__m256i slash = _mm256_cmpeq_epi8(*v, mask);
+	__m256i roll = _mm256_shuffle_epi8(lut_roll,
+	                                   _mm256_add_epi8(slash, hi_nib));
+	*v = _mm256_add_epi8(*v, roll);
+
+	return 0;
+}
+
+/*! \brief Packs 6-bit values to 3-byte groups in the low 24 bytes. */
+__attribute__((target("avx2"), always_inline))
+static inline __m256i dec_reshuffle_avx2(__m256i v)
+{
+	v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+	v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+	v = _mm256_shuffle_epi8(v, dup_avx2(
+		_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+		              14, 13, 12, -1, -1, -1, -1)));
+
+	// Join the 12-byte lane results.
+	return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4,
+	                                                        5, 6, 7, 7));
+}
+
+__attribute__((target("avx2")))
+static size_t base64_encode_avx2(const uint8_t *in, size_t in_len,
+                                 uint8_t *out)
+{
+	size_t i = 0;
+	for (; i + 28 <= in_len; i += 24) {
+		__m128i lo = _mm_loadu_si128((const __m128i *)(in + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(in + i + 12));
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo),
+		                                    hi, 1);
+		v = enc_translate_avx2(enc_reshuffle_avx2(v));
+		_mm256_storeu_si256((__m256i *)out, v);
+		out += 32;
+	}
+	/* Inlined SSSE3 code is VEX encoded here, no transition penalty. */
+	if (i + 16 <= in_len) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+		v = enc_translate_ssse3(enc_reshuffle_ssse3(v));
+		_mm_storeu_si128((__m128i *)out, v);
+		i += 12;
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t base64_decode_avx2(const uint8_t *in, size_t in_len,
+                                 uint8_t *out)
+{
+	size_t i = 0;
+	// Keep room for the 32-byte store.
+	for (; i + 44 <= in_len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+		if (dec_translate_avx2(&v) != 0) {
+			break;
+		}
+		_mm256_storeu_si256((__m256i *)out, dec_reshuffle_avx2(v));
+		out += 24;
+	}
+	if (i + 24 <= in_len) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+		if (dec_translate_ssse3(&v) == 0) {
+			v = dec_reshuffle_ssse3(v);
+			_mm_storeu_si128((__m128i *)out, v);
+			i += 16;
+		}
+	}
+	return i;
+}
+
+#endif /* KNOT_BASE64_SIMD */
+
+/*!
+ * \brief Vector kernels, process a prefix and return its length.
+ */
+typedef struct {
+	size_t (*encode)(const uint8_t *, size_t, uint8_t *);
+	size_t (*decode)(const uint8_t *, size_t, uint8_t *);
+	const char *name;
+} base64_impl_t;
+
+static size_t base64_none(const uint8_t *in, size_t in_len, uint8_t *out)
+{
+	return 0;
+}
+
+static const base64_impl_t *base64_impl_sel = NULL;
+
+/*!
+ * \brief Selects the best implementation for the running CPU.
+ *
+ * Concurrent callers may both select, but they store the same value.
+ */
+static const base64_impl_t *base64_select()
+{
+	static const base64_impl_t impl_scalar = {
+		base64_none, base64_none, "scalar"
+	};
+#ifdef KNOT_BASE64_SIMD
+	static const base64_impl_t impl_ssse3 = {
+		base64_encode_ssse3, base64_decode_ssse3, "ssse3"
+	};
+	static const base64_impl_t impl_avx2 = {
+		base64_encode_avx2, base64_decode_avx2, "avx2"
+	};
+#endif
+
+	const base64_impl_t *impl = base64_impl_sel;
+	if (impl != NULL) {
+		return impl;
+	}
+
+	impl = &impl_scalar;
+#ifdef KNOT_BASE64_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		impl = &impl_avx2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		impl = &impl_ssse3;
+	}
+#endif
+	base64_impl_sel = impl;
+	return impl;
+}
+
+/*! \brief Shorter inputs are not worth the vector kernel call. */
+#define BASE64_VECTOR_MIN	32
+
+const char *base64_impl()
+{
+	return base64_select()->name;
+}
+
 int32_t base64_encode(const uint8_t  *in,
                       const uint32_t in_len,
                       uint8_t        *out,
@@ -101,6 +441,13 @@ int32_t base64_encode(const uint8_t  *in,
 		return KNOT_ERANGE;
 	}
 
+	// Vector kernels encode a prefix of whole blocks.
+	if (in_len >= BASE64_VECTOR_MIN) {
+		size_t done = base64_select()->encode(in, in_len, out);
+		data += done;
+		text += (done / 3) * 4;
+	}
+
 	// Encoding loop takes 3 bytes and creates 4 characters.
 	while (data < stop) {
 		// Computing 1. Base64 character.
@@ -212,6 +559,13 @@ int32_t base64_decode(const uint8_t  *in,
 		return KNOT_BASE64_ESIZE;
 	}
 
+	// Vector kernels decode a prefix of whole blocks without padding.
+	if (in_len >= BASE64_VECTOR_MIN) {
+		size_t done = base64_select()->decode(in, in_len, out);
+		data += done;
+		bin += (done / 4) * 3;
+	}
+
 	// Decoding loop takes 4 characters and creates 3 bytes.
 	while (data < stop) {
 		// Filling and transforming 4 Base64 chars.
@@ -107,6 +107,16 @@ int32_t base64_decode_alloc(const uint8_t  *in,
                             const uint32_t in_len,
                             uint8_t        **out);
 
+/*!
+ * \brief Returns name of the Base64 implementation in use.
+ *
+ * Long inputs are processed with SSSE3 or AVX2 if available on the running
+ * CPU, output and error codes are the same for all implementations.
+ *
+ * \return "avx2", "ssse3" or "scalar".
+ */
+const char *base64_impl();
+
 #endif // _KNOTD_COMMON__BASE64_H_
 
 /*! @} */
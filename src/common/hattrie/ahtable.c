@@ -10,12 +10,18 @@
 #include <string.h>
 #include "ahtable.h"
 #include "murmurhash3.h"
+#include "common/errcode.h"
+
+/* Buckets must fill exactly one cache line. */
+typedef char ahtable_bucket_size_check[sizeof(ahtable_bucket_t) == 64 ? 1 : -1];
 
 enum {
-    AH_SORTED  = 0x01,/* sorted iteration */
-    AH_INDEXED = 0x02 /* reuse index from table */
+    AH_SORTED  = 0x01 /* sorted iteration */
 };
 
+/* Initial size of the order index. */
+#define AHTABLE_INDEX_INIT 16
+
 const size_t ahtable_max_load_factor = 10000.0; /* arbitrary large number => don't resize */
 static const uint16_t LONG_KEYLEN_MASK = 0x7fff;
 
@@ -63,10 +69,17 @@ static int cmpkeystr(const char* a, size_t ka, slot_t b)
     return c == 0 ? (int) ka - (int) kb : c;
 }
 
+/* Key with its reference, used for sorting when the index is built. */
+typedef struct index_ent_t_
+{
+    slot_t s;
+    ahtable_ref_t r;
+} index_ent_t;
+
 static int cmpkey(const void* a_, const void* b_)
 {
-    slot_t a = *(slot_t*) a_;
-    slot_t b = *(slot_t*) b_;
+    slot_t a = ((const index_ent_t*) a_)->s;
+    slot_t b = ((const index_ent_t*) b_)->s;
 
     size_t ka = keylen(a), kb = keylen(b);
 
@@ -83,19 +96,28 @@ ahtable_t* ahtable_create()
 }
 
 
+static ahtable_bucket_t* alloc_buckets(size_t n)
+{
+    void* p = NULL;
+    if (posix_memalign(&p, sizeof(ahtable_bucket_t),
+                       n * sizeof(ahtable_bucket_t)) != 0) {
+        return NULL;
+    }
+    memset(p, 0, n * sizeof(ahtable_bucket_t));
+    return p;
+}
+
+
 ahtable_t* ahtable_create_n(size_t n)
 {
     ahtable_t* T = malloc(sizeof(ahtable_t));
     memset(T, 0, sizeof(ahtable_t));
 
-    T->n = n;
+    /* bucket is selected by mask */
+    T->n = 1;
+    while (T->n < n) T->n <<= 1;
     T->max_m = (size_t) (ahtable_max_load_factor * (double) T->n);
-    T->slots = malloc(n * sizeof(slot_t));
-    memset(T->slots, 0, n * sizeof(slot_t));
-
-    const size_t sslen = 2 * T->n * sizeof(uint32_t); /* used | reserved */
-    T->slot_sizes = malloc(sslen);
-    memset(T->slot_sizes, 0, sslen);
+    T->buckets = alloc_buckets(T->n);
 
     return T;
 }
@@ -105,9 +127,8 @@ void ahtable_free(ahtable_t* T)
 {
     if (T == NULL) return;
     size_t i;
-    for (i = 0; i < T->n; ++i) free(T->slots[i]);
-    free(T->slots);
-    free(T->slot_sizes);
+    for (i = 0; i < T->n; ++i) free(T->buckets[i].data);
+    free(T->buckets);
     free(T->index);
     free(T);
 }
@@ -122,18 +143,126 @@ size_t ahtable_size(const ahtable_t* T)
 void ahtable_clear(ahtable_t* T)
 {
     size_t i;
-    for (i = 0; i < T->n; ++i) free(T->slots[i]);
+    for (i = 0; i < T->n; ++i) free(T->buckets[i].data);
+    free(T->buckets);
     T->n = AHTABLE_INIT_SIZE;
-    T->slots = realloc(T->slots, T->n * sizeof(slot_t));
-    memset(T->slots, 0, T->n * sizeof(slot_t));
+    T->m = 0;
+    T->max_m = (size_t) (ahtable_max_load_factor * (double) T->n);
+    T->buckets = alloc_buckets(T->n);
+
+    /* index is kept, it is valid for an empty table */
+}
 
-    const size_t sslen = 2 * T->n * sizeof(uint32_t); /* used | reserved */
-    T->slot_sizes = realloc(T->slot_sizes, sslen);
-    memset(T->slot_sizes, 0, sslen);
 
-    if (T->index) {
-        free(T->index);
-        T->index = NULL;
+static inline uint32_t ahtable_hash(const char* key, size_t len)
+{
+    return hash_mum(key, len);
+}
+
+static inline ahtable_bucket_t* bucket_of(ahtable_t* T, uint32_t h)
+{
+    return &T->buckets[h & (T->n - 1)];
+}
+
+/* fingerprint uses upper bits, bucket index the lower ones */
+static inline uint8_t fingerprint(uint32_t h)
+{
+    return (uint8_t) (h >> 24);
+}
+
+static inline size_t entry_size(size_t len)
+{
+    return len + sizeof(value_t) + (len >= 128 ? 2 : 1);
+}
+
+
+static inline slot_t refslot(const ahtable_t* T, ahtable_ref_t r)
+{
+    return T->buckets[r.b].data + r.off;
+}
+
+/* Position of the first of n index entries not less than the key. */
+static size_t index_lower_bound(const ahtable_t* T, size_t n,
+                                const char* key, size_t len)
+{
+    size_t a = 0, b = n;
+    while (a < b) {
+        size_t k = a + (b - a) / 2;
+        if (cmpkeystr(key, len, refslot(T, T->index[k])) > 0) {
+            a = k + 1;
+        } else {
+            b = k;
+        }
+    }
+    return a;
+}
+
+/* Add new key to the order index, T->m does not count it yet.
+ * The index is left untouched if it can't be grown. */
+static int index_add(ahtable_t* T, const char* key, size_t len,
+                     ahtable_ref_t r)
+{
+    if (T->index_size <= T->m) {
+        size_t size = 2 * T->index_size;
+        ahtable_ref_t* index = realloc(T->index,
+                                       size * sizeof(ahtable_ref_t));
+        if (index == NULL) return KNOT_ENOMEM;
+        T->index = index;
+        T->index_size = size;
+    }
+
+    size_t k = index_lower_bound(T, T->m, key, len);
+    memmove(T->index + k + 1, T->index + k,
+            (T->m - k) * sizeof(ahtable_ref_t));
+    T->index[k] = r;
+    return KNOT_EOK;
+}
+
+/* Remove key from the order index, keys behind it in the bucket are moved
+ * by 'size' bytes towards the bucket start. */
+static void index_del(ahtable_t* T, const char* key, size_t len,
+                      ahtable_ref_t r, size_t size)
+{
+    size_t k = index_lower_bound(T, T->m, key, len);
+    assert(k < T->m && T->index[k].b == r.b && T->index[k].off == r.off);
+    memmove(T->index + k, T->index + k + 1,
+            (T->m - k - 1) * sizeof(ahtable_ref_t));
+
+    size_t j;
+    for (j = 0; j < T->m - 1; ++j) {
+        if (T->index[j].b == r.b && T->index[j].off > r.off) {
+            T->index[j].off -= size;
+        }
+    }
+}
+
+
+/* Record key stored at given offset of the bucket in the bucket header. */
+static void bucket_add_fp(ahtable_bucket_t* b, uint32_t off, size_t len,
+                          uint32_t h)
+{
+    if (b->tail == off && b->nfp < AHTABLE_BUCKET_FP && off <= UINT16_MAX) {
+        b->fp[b->nfp] = fingerprint(h);
+        b->off[b->nfp] = (uint16_t) off;
+        ++b->nfp;
+        b->tail = off + entry_size(len);
+    }
+}
+
+/* Rebuild bucket header after keys were removed. */
+static void bucket_reindex(ahtable_bucket_t* b)
+{
+    b->nfp = 0;
+    b->tail = 0;
+
+    slot_t s = b->data;
+    while (s < b->data + b->size) {
+        size_t len = 0;
+        const char* key = slotkey(s, &len);
+        uint32_t off = (uint32_t) (s - b->data);
+        bucket_add_fp(b, off, len, ahtable_hash(key, len));
+        if (b->tail != off + entry_size(len)) break;
+        s += entry_size(len);
     }
 }
 
@@ -169,26 +298,22 @@ static void ahtable_expand(ahtable_t* T)
 {
     /* Resizing a table is essentially building a brand new one.
      * One little shortcut we can take on the memory allocation front is to
-     * figure out how much memory each slot needs in advance.
+     * figure out how much memory each bucket needs in advance.
      */
     assert(T->n > 0);
     size_t new_n = 2 * T->n;
-    size_t slot_scount = 2 * new_n; /* used | reserved */
-    uint32_t* slot_sizes = malloc(slot_scount * sizeof(uint32_t));
-    memset(slot_sizes, 0, slot_scount * sizeof(uint32_t));
+    ahtable_bucket_t* buckets = alloc_buckets(new_n);
 
     const char* key;
     size_t len = 0;
     size_t m = 0;
-    size_t h;
+    uint32_t h;
     ahtable_iter_t i;
     ahtable_iter_begin(T, &i, false);
     while (!ahtable_iter_finished(&i)) {
         key = ahtable_iter_key(&i, &len);
-        h = hash(key, len) % new_n;
-        slot_sizes[h] +=
-            len + sizeof(value_t) + (len >= 128 ? 2 : 1);
-        slot_sizes[new_n + h] = slot_sizes[h];
+        h = ahtable_hash(key, len) & (new_n - 1);
+        buckets[h].reserved += entry_size(len);
 
         ++m;
         ahtable_iter_next(&i);
@@ -197,33 +322,40 @@ static void ahtable_expand(ahtable_t* T)
     ahtable_iter_free(&i);
 
 
-    /* allocate slots */
-    slot_t* slots = malloc(new_n * sizeof(slot_t));
+    /* allocate key arrays */
     size_t j;
     for (j = 0; j < new_n; ++j) {
-        if (slot_sizes[j] > 0) {
-            slots[j] = malloc(slot_sizes[j]);
+        if (buckets[j].reserved > 0) {
+            buckets[j].data = malloc(buckets[j].reserved);
         }
-        else slots[j] = NULL;
     }
 
     /* rehash values. A few shortcuts can be taken here as well, as we know
      * there will be no collisions. Instead of the regular insertion routine,
-     * we keep track of the ends of every slot and simply insert keys.
+     * we keep track of the ends of every bucket and simply insert keys.
+     * Keys are visited in order if the table is indexed, so the index only
+     * needs to be pointed to the new locations.
      * */
-    slot_t* slots_next = malloc(new_n * sizeof(slot_t));
-    memcpy(slots_next, slots, new_n * sizeof(slot_t));
     m = 0;
     value_t* u;
     value_t* v;
-    ahtable_iter_begin(T, &i, false);
+    ahtable_bucket_t* b;
+    ahtable_iter_begin(T, &i, T->index != NULL);
     while (!ahtable_iter_finished(&i)) {
 
         key = ahtable_iter_key(&i, &len);
-        h = hash(key, len) % new_n;
-
-        slots_next[h] = ins_key(slots_next[h], key, len, &u);
         v = ahtable_iter_val(&i);
+        h = ahtable_hash(key, len);
+        b = &buckets[h & (new_n - 1)];
+
+        /* current index entry is not needed anymore */
+        if (T->index) {
+            T->index[m].b = (uint32_t) (b - buckets);
+            T->index[m].off = b->size;
+        }
+        bucket_add_fp(b, b->size, len, h);
+        ins_key(b->data + b->size, key, len, &u);
+        b->size += entry_size(len);
         *u = *v;
 
         ++m;
@@ -233,75 +365,91 @@ static void ahtable_expand(ahtable_t* T)
     ahtable_iter_free(&i);
 
 
-    free(slots_next);
-    for (j = 0; j < T->n; ++j) free(T->slots[j]);
-
-    free(T->slots);
-    T->slots = slots;
-
-    free(T->slot_sizes);
-    T->slot_sizes = slot_sizes;
+    for (j = 0; j < T->n; ++j) free(T->buckets[j].data);
+    free(T->buckets);
+    T->buckets = buckets;
 
     T->n = new_n;
     T->max_m = (size_t) (ahtable_max_load_factor * (double) T->n);
 }
 
+/* Insert key into its bucket, return NULL if there's no memory for it. */
 static value_t* insert_key(ahtable_t* T, uint32_t h, const char* key, size_t len)
 {
-    uint32_t new_size = T->slot_sizes[h];
-    new_size += (len >= 128 ? 2 : 1);        // key length
-    new_size += len * sizeof(unsigned char); // key
-    new_size += sizeof(value_t);             // value
+    ahtable_bucket_t* b = bucket_of(T, h);
+    uint32_t new_size = b->size + entry_size(len);
+
+    /* check reserved size */
+    if (b->reserved < new_size) {
+        uint32_t reserved = next_size(new_size);
+        slot_t data = realloc(b->data, reserved);
+        if (data == NULL) return NULL;
+        b->data = data;
+        b->reserved = reserved;
+    }
 
-    /* fetch reserved size */
-    uint32_t* reserved = &T->slot_sizes[T->n + h];
-    if (*reserved < new_size) {
-        *reserved = next_size(new_size);
-        T->slots[h] = realloc(T->slots[h], *reserved);
+    if (T->index) {
+        ahtable_ref_t r = { (uint32_t) (b - T->buckets), b->size };
+        if (index_add(T, key, len, r) != KNOT_EOK) return NULL;
     }
     ++T->m;
 
     value_t *val = NULL;
-    ins_key(T->slots[h] + T->slot_sizes[h], key, len, &val);
-    T->slot_sizes[h] = new_size;
+    bucket_add_fp(b, b->size, len, h);
+    ins_key(b->data + b->size, key, len, &val);
+    b->size = new_size;
 
     return val;
 }
 
 
-static value_t* find_val(ahtable_t* T, const char* key, size_t len, uint32_t i)
+/* Find key in the bucket, return pointer to the key length or NULL. */
+static slot_t find_slot(ahtable_t* T, const char* key, size_t len, uint32_t h)
 {
+    ahtable_bucket_t* b = bucket_of(T, h);
+    const uint8_t fp = fingerprint(h);
     size_t k = 0;
+    slot_t s;
+
+    /* compare only keys with matching fingerprint */
+    unsigned j;
+    for (j = 0; j < b->nfp; ++j) {
+        if (b->fp[j] != fp) continue;
 
-    /* search the array for our key */
-    slot_t s = T->slots[i];
-    slot_t np = T->slots[i] + T->slot_sizes[i];
+        s = b->data + b->off[j];
+        const char* skey = slotkey(s, &k);
+        if (k == len && memcmp(skey, key, len) == 0) {
+            return s;
+        }
+    }
+
+    /* search the rest of the array for our key */
+    s = b->data + b->tail;
+    slot_t np = b->data + b->size;
     while (s < np) {
         /* get the key length */
         k = keylen(s);
-        s += k < 128 ? 1 : 2;
-
-        /* skip keys that are longer than ours */
-        if (k != len) {
-            s += k + sizeof(value_t);
-            continue;
-        }
+        size_t hdr = k < 128 ? 1 : 2;
 
         /* key found. */
-        if (memcmp(s, key, len) == 0) {
-            return (value_t*) (s + len);
-        }
-        /* key not found. */
-        else {
-            s += k + sizeof(value_t);
-            continue;
+        if (k == len && memcmp(s + hdr, key, len) == 0) {
+            return s;
         }
+
+        s += hdr + k + sizeof(value_t);
     }
 
     return NULL;
 }
 
 
+static value_t* find_val(ahtable_t* T, const char* key, size_t len, uint32_t h)
+{
+    slot_t s = find_slot(T, key, len, h);
+    return s == NULL ? NULL : slotval(s);
+}
+
+
 value_t* ahtable_get(ahtable_t* T, const char* key, size_t len)
 {
     /* if we are at capacity, preemptively resize */
@@ -310,10 +458,10 @@ value_t* ahtable_get(ahtable_t* T, const char* key, size_t len)
     }
 
     /* attempt to find value for given key */
-    uint32_t i = hash(key, len) % T->n;
-    value_t *ret = find_val(T, key, len, i);
+    uint32_t h = ahtable_hash(key, len);
+    value_t *ret = find_val(T, key, len, h);
     if (ret == NULL) { /* insert if not found */
-        ret = insert_key(T, i, key, len);
+        ret = insert_key(T, h, key, len);
     }
 
     return ret;
@@ -322,39 +470,62 @@ value_t* ahtable_get(ahtable_t* T, const char* key, size_t len)
 
 value_t* ahtable_tryget(ahtable_t* T, const char* key, size_t len )
 {
-    uint32_t i = hash(key, len) % T->n;
-    return find_val(T, key, len, i);
+    return find_val(T, key, len, ahtable_hash(key, len));
 }
 
 value_t *ahtable_indexval(ahtable_t* T, unsigned i)
 {
-    return slotval(T->index[i]);
+    return slotval(refslot(T, T->index[i]));
 }
 
-void ahtable_build_index(ahtable_t* T)
+/* Sort references to all keys into a new array of given size (at least T->m),
+ * return NULL if out of memory. */
+static ahtable_ref_t* sorted_refs(const ahtable_t* T, size_t size)
 {
-    if (T->index) {
-        free(T->index);
-        T->index = NULL;
-    }
+    ahtable_ref_t* refs = malloc(size * sizeof(ahtable_ref_t));
+    if (refs == NULL || T->m == 0) return refs;
 
-    if (T->m == 0) return;
-
-    T->index = malloc(T->m * sizeof(slot_t));
+    index_ent_t* xs = malloc(T->m * sizeof(index_ent_t));
+    if (xs == NULL) {
+        free(refs);
+        return NULL;
+    }
 
     slot_t s;
     size_t j, k, u;
     for (j = 0, u = 0; j < T->n; ++j) {
-        s = T->slots[j];
-        while (s < T->slots[j] + T->slot_sizes[j]) {
-            T->index[u++] = s;
+        s = T->buckets[j].data;
+        while (s < T->buckets[j].data + T->buckets[j].size) {
+            xs[u].s = s;
+            xs[u].r.b = (uint32_t) j;
+            xs[u].r.off = (uint32_t) (s - T->buckets[j].data);
+            ++u;
             k = keylen(s);
             s += k < 128 ? 1 : 2;
             s += k + sizeof(value_t);
         }
     }
 
-    qsort(T->index, T->m, sizeof(slot_t), cmpkey);
+    qsort(xs, T->m, sizeof(index_ent_t), cmpkey);
+    for (u = 0; u < T->m; ++u) refs[u] = xs[u].r;
+    free(xs);
+    return refs;
+}
+
+int ahtable_build_index(ahtable_t* T)
+{
+    if (T->index) return KNOT_EOK;
+
+    /* sort keys once, the index is maintained from now on */
+    size_t size = AHTABLE_INDEX_INIT;
+    while (size < T->m) size *= 2;
+    ahtable_ref_t* index = sorted_refs(T, size);
+    if (index == NULL) return KNOT_ENOMEM;
+
+    /* publish complete index only */
+    T->index_size = size;
+    T->index = index;
+    return KNOT_EOK;
 }
 
 int ahtable_find_leq (ahtable_t* T, const char* key, size_t len, value_t** dst)
@@ -363,87 +534,65 @@ int ahtable_find_leq (ahtable_t* T, const char* key, size_t len, value_t** dst)
     if (T->m == 0) return 1;
     assert(T->index != NULL);
 
-    /* the array is T->m size and sorted, use binary search */
-    int r = 0;
-    int a = 0, b = T->m - 1, k = 0;
-    while (a <= b) {
-        k = (a + b) / 2;    /* divide interval */
-        r = cmpkeystr(key, len, T->index[k]);
-        if (r == 0) {
-            break;
-        }
-        if (r < 0) {
-            b = k - 1;
-        } else {
-            a = k + 1;
-        }
-
-    }
-
-
-    if (r < 0) {
-        --k;    /* k is after previous node */
-        r = -1;
-    } else if (r > 0) {
-        r = -1; /* k is previous node */
-    }
-    if (k > -1) {
+    /* the index is T->m size and sorted, use binary search */
+    size_t k = index_lower_bound(T, T->m, key, len);
+    if (k < T->m && cmpkeystr(key, len, refslot(T, T->index[k])) == 0) {
         *dst = ahtable_indexval(T, k);
+        return 0;
     }
 
-    return r;
+    /* k is after previous key */
+    if (k == 0) return 1;
+    *dst = ahtable_indexval(T, k - 1);
+    return -1;
 }
 
-void ahtable_insert (ahtable_t* T, const char* key, size_t len, value_t val)
+int ahtable_insert (ahtable_t* T, const char* key, size_t len, value_t val)
 {
     /* if we are at capacity, preemptively resize */
     if (T->m >= T->max_m) {
         ahtable_expand(T);
     }
 
-    uint32_t i = hash(key, len) % T->n;
-    *insert_key(T, i, key, len) = val;
+    value_t* v = insert_key(T, ahtable_hash(key, len), key, len);
+    if (v == NULL) return KNOT_ENOMEM;
+    *v = val;
+    return KNOT_EOK;
 }
 
 
-int ahtable_del(ahtable_t* T, const char* key, size_t len)
+/* Remove key from the bucket and the order index. */
+static void del_slot(ahtable_t* T, ahtable_bucket_t* b, slot_t s)
 {
-    uint32_t i = hash(key, len) % T->n;
-    size_t k;
-    slot_t s;
+    size_t len = 0;
+    const char* key = slotkey(s, &len);
+    size_t size = entry_size(len);
+    if (T->index) {
+        ahtable_ref_t r = { (uint32_t) (b - T->buckets),
+                            (uint32_t) (s - b->data) };
+        index_del(T, key, len, r, size);
+    }
 
-    /* search the array for our key */
-    s = T->slots[i];
-    while ((size_t) (s - T->slots[i]) < T->slot_sizes[i]) {
-        /* get the key length */
-        k = keylen(s);
-        s += k < 128 ? 1 : 2;
+    /* move everything over, resize the array */
+    unsigned char* t = s + size;
+    memmove(s, t, b->size - (size_t) (t - b->data));
+    b->size -= size;
+    bucket_reindex(b);
+    --T->m;
+}
 
-        /* skip keys that are longer than ours */
-        if (k != len) {
-            s += k + sizeof(value_t);
-            continue;
-        }
 
-        /* key found. */
-        if (memcmp(s, key, len) == 0) {
-            /* move everything over, resize the array */
-            unsigned char* t = s + len + sizeof(value_t);
-            s -= k < 128 ? 1 : 2;
-            memmove(s, t, T->slot_sizes[i] - (size_t) (t - T->slots[i]));
-            T->slot_sizes[i] -= (size_t) (t - s);
-            --T->m;
-            return 0;
-        }
-        /* key not found. */
-        else {
-            s += k + sizeof(value_t);
-            continue;
-        }
+int ahtable_del(ahtable_t* T, const char* key, size_t len)
+{
+    uint32_t h = ahtable_hash(key, len);
+    slot_t s = find_slot(T, key, len, h);
+    if (s == NULL) {
+        // Key was not found. Do nothing.
+        return -1;
     }
 
-    // Key was not found. Do nothing.
-    return -1;
+    del_slot(T, bucket_of(T, h), s);
+    return 0;
 }
 
 
@@ -452,27 +601,18 @@ sorted flag to ahtable_iter_begin. */
 
 static void ahtable_sorted_iter_begin(ahtable_t* T, ahtable_iter_t *i)
 {
-    if (T->index) {
-        i->d.xs = T->index;
-        i->flags |= AH_INDEXED;
-        return;
+    /* walk the order index, unindexed table is sorted for the iterator */
+    i->i = 0;
+    if (T->index == NULL && T->m > 0) {
+        i->xs = sorted_refs(T, T->m);
+        if (i->xs == NULL) i->i = T->m; /* out of memory, nothing to walk */
     }
+}
 
-    i->d.xs = malloc(T->m * sizeof(slot_t));
-
-    slot_t s;
-    size_t j, k, u;
-    for (j = 0, u = 0; j < T->n; ++j) {
-        s = T->slots[j];
-        while (s < T->slots[j] + T->slot_sizes[j]) {
-            i->d.xs[u++] = s;
-            k = keylen(s);
-            s += k < 128 ? 1 : 2;
-            s += k + sizeof(value_t);
-        }
-    }
 
-    qsort(i->d.xs, T->m, sizeof(slot_t), cmpkey);
+static inline ahtable_ref_t ahtable_sorted_iter_ref(ahtable_iter_t* i)
+{
+    return i->xs ? i->xs[i->i] : i->T->index[i->i];
 }
 
 
@@ -491,16 +631,24 @@ static inline void ahtable_sorted_iter_next(ahtable_iter_t* i)
 static void ahtable_sorted_iter_del(ahtable_iter_t* i)
 {
     if (ahtable_iter_finished(i)) return;
-    /*! \todo same as unsorted, but remove from iterator sorted array */
-    assert(0);
-}
 
-
-static inline void ahtable_sorted_iter_free(ahtable_iter_t* i)
-{
-    if (i == NULL) return;
-    if (!(i->flags & AH_INDEXED)) {
-        free(i->d.xs);
+    /* next key takes over the current position in the index */
+    ahtable_ref_t r = ahtable_sorted_iter_ref(i);
+    ahtable_bucket_t* b = &i->T->buckets[r.b];
+    slot_t s = b->data + r.off;
+    size_t size = entry_size(keylen(s));
+    del_slot(i->T, b, s);
+
+    /* private order is updated the same way as the index */
+    if (i->xs) {
+        size_t j;
+        memmove(i->xs + i->i, i->xs + i->i + 1,
+                (i->T->m - i->i) * sizeof(ahtable_ref_t));
+        for (j = i->i; j < i->T->m; ++j) {
+            if (i->xs[j].b == r.b && i->xs[j].off > r.off) {
+                i->xs[j].off -= size;
+            }
+        }
     }
 }
 
@@ -508,21 +656,21 @@ static inline void ahtable_sorted_iter_free(ahtable_iter_t* i)
 static const char* ahtable_sorted_iter_key(ahtable_iter_t* i, size_t* len)
 {
     if (ahtable_iter_finished(i)) return NULL;
-    return slotkey(i->d.xs[i->i], len);
+    return slotkey(refslot(i->T, ahtable_sorted_iter_ref(i)), len);
 }
 
 
 static value_t*  ahtable_sorted_iter_val(ahtable_iter_t* i)
 {
     if (ahtable_iter_finished(i)) return NULL;
-    return slotval(i->d.xs[i->i]);
+    return slotval(refslot(i->T, ahtable_sorted_iter_ref(i)));
 }
 
 static void ahtable_unsorted_iter_begin(ahtable_t* T, ahtable_iter_t *i)
 {
     for (i->i = 0; i->i < i->T->n; ++i->i) {
-        i->d.s = T->slots[i->i];
-        if ((size_t) (i->d.s - T->slots[i->i]) >= T->slot_sizes[i->i]) continue;
+        i->s = T->buckets[i->i].data;
+        if (T->buckets[i->i].size == 0) continue;
         break;
     }
 }
@@ -539,41 +687,38 @@ static void ahtable_unsorted_iter_next(ahtable_iter_t* i)
     if (ahtable_iter_finished(i)) return;
 
     /* get the key length */
-    size_t k = keylen(i->d.s);
-    i->d.s += k < 128 ? 1 : 2;
+    size_t k = keylen(i->s);
+    i->s += k < 128 ? 1 : 2;
 
     /* skip to the next key */
-    i->d.s += k + sizeof(value_t);
+    i->s += k + sizeof(value_t);
 
-    if ((size_t) (i->d.s - i->T->slots[i->i]) >= i->T->slot_sizes[i->i]) {
+    ahtable_bucket_t* b = &i->T->buckets[i->i];
+    if ((size_t) (i->s - b->data) >= b->size) {
         do {
             ++i->i;
         } while(i->i < i->T->n &&
-                i->T->slot_sizes[i->i] == 0);
+                i->T->buckets[i->i].size == 0);
 
-        if (i->i < i->T->n) i->d.s = i->T->slots[i->i];
-        else i->d.s = NULL;
+        if (i->i < i->T->n) i->s = i->T->buckets[i->i].data;
+        else i->s = NULL;
     }
 }
 
 static void ahtable_unsorted_iter_del(ahtable_iter_t* i)
 {
-    /* get the entry length */
-    size_t k = keylen(i->d.s);
-    unsigned char* t = i->d.s + (k < 128 ? 1 : 2) + k + sizeof(value_t);
-    memmove(i->d.s, t, i->T->slot_sizes[i->i] - (size_t)(t - i->T->slots[i->i]));
-    i->T->slot_sizes[i->i] -= (size_t)(t - i->d.s);
-    --i->T->m;
+    del_slot(i->T, &i->T->buckets[i->i], i->s);
 
     /* find next filled slot*/
-    if ((size_t) (i->d.s - i->T->slots[i->i]) >= i->T->slot_sizes[i->i]) {
+    ahtable_bucket_t* b = &i->T->buckets[i->i];
+    if ((size_t) (i->s - b->data) >= b->size) {
         do {
             ++i->i;
         } while(i->i < i->T->n &&
-                i->T->slot_sizes[i->i] == 0);
+                i->T->buckets[i->i].size == 0);
 
-        if (i->i < i->T->n) i->d.s = i->T->slots[i->i];
-        else i->d.s = NULL;
+        if (i->i < i->T->n) i->s = i->T->buckets[i->i].data;
+        else i->s = NULL;
     }
 }
 
@@ -581,7 +726,7 @@ static const char* ahtable_unsorted_iter_key(ahtable_iter_t* i, size_t* len)
 {
     if (ahtable_iter_finished(i)) return NULL;
 
-    slot_t s = i->d.s;
+    slot_t s = i->s;
     size_t k;
     if (0x1 & *s) {
         k = (size_t) (*((uint16_t*) s)) >> 1;
@@ -600,7 +745,7 @@ static const char* ahtable_unsorted_iter_key(ahtable_iter_t* i, size_t* len)
 static value_t* ahtable_unsorted_iter_val(ahtable_iter_t* i)
 {
     if (ahtable_iter_finished(i)) return NULL;
-    return slotval(i->d.s);
+    return slotval(i->s);
 }
 
 
@@ -638,7 +783,8 @@ bool ahtable_iter_finished(ahtable_iter_t* i)
 void ahtable_iter_free(ahtable_iter_t* i)
 {
     if (i == NULL) return;
-    if (i->flags & AH_SORTED) ahtable_sorted_iter_free(i);
+    free(i->xs);
+    i->xs = NULL;
 }
 
 
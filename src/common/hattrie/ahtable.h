@@ -31,6 +31,39 @@ extern "C" {
 
 typedef unsigned char* slot_t;
 
+/* Number of keys per bucket with a fingerprint. */
+#define AHTABLE_BUCKET_FP 14
+
+/* Hash table bucket, one cache line.
+ *
+ * Keys are stored in the 'data' array. The first keys in the array have a
+ * fingerprint (8 bits of their hash) and offset in the bucket header, so a
+ * lookup compares only keys with a matching fingerprint and rejects most
+ * misses without touching the key array. Keys which do not fit into the
+ * header ('tail' onwards) are scanned sequentially.
+ */
+typedef struct ahtable_bucket_t_
+{
+    slot_t   data;                       // key/value pairs
+    uint32_t size;                       // used size of data
+    uint32_t reserved;                   // allocated size of data
+    uint32_t tail;                       // end of keys with fingerprint
+    uint8_t  nfp;                        // number of keys with fingerprint
+    uint8_t  fp[AHTABLE_BUCKET_FP];      // fingerprints
+    uint16_t off[AHTABLE_BUCKET_FP];     // offsets of keys in data
+} __attribute__((aligned(64))) ahtable_bucket_t;
+
+/* Reference to a key in the order index.
+ *
+ * Keys are referenced by bucket and offset instead of a pointer, so the index
+ * survives reallocation of the bucket arrays.
+ */
+typedef struct ahtable_ref_t_
+{
+    uint32_t b;                          // bucket
+    uint32_t off;                        // offset of the key in bucket data
+} ahtable_ref_t;
+
 typedef struct ahtable_t_
 {
     /* these fields are reserved for hattrie to fiddle with */
@@ -38,18 +71,18 @@ typedef struct ahtable_t_
     unsigned char c0;
     unsigned char c1;
 
-    size_t n;        // number of slots
+    size_t n;        // number of buckets (power of two)
     size_t m;        // number of key/value pairs stored
     size_t max_m;    // number of stored keys before we resize
 
-    uint32_t*  slot_sizes;
-    slot_t*  slots;
-    slot_t*  index;  // order index (optional)
+    ahtable_bucket_t* buckets;
+    ahtable_ref_t* index;  // order index (optional, maintained once built)
+    size_t index_size;     // allocated size of the order index
 } ahtable_t;
 
 ahtable_t* ahtable_create   (void);         // Create an empty hash table.
 ahtable_t* ahtable_create_n (size_t n);     // Create an empty hash table, with
-                                            //  n slots reserved.
+                                            //  n buckets reserved.
 
 void       ahtable_free   (ahtable_t*);       // Free all memory used by a table.
 void       ahtable_clear  (ahtable_t*);       // Remove all entries.
@@ -57,7 +90,8 @@ size_t     ahtable_size   (const ahtable_t*); // Number of stored keys.
 
 
 /** Find the given key in the table, inserting it if it does not exist, and
- * returning a pointer to it's key.
+ * returning a pointer to it's key. NULL is returned if the key can't be
+ * inserted for lack of memory.
  *
  * This pointer is not guaranteed to be valid after additional calls to
  * ahtable_get, ahtable_del, ahtable_clear, or other functions that modifies the
@@ -74,10 +108,18 @@ value_t* ahtable_tryget (ahtable_t*, const char* key, size_t len);
 value_t *ahtable_indexval(ahtable_t*, unsigned i);
 
 /** Build order index for fast ordered lookup.
+ *
+ * The index is kept sorted on every insertion and deletion afterwards, so it
+ * needs to be built only once. Building an existing index is a no-op.
+ * The table is left unchanged if the index can't be allocated.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
  */
-void ahtable_build_index(ahtable_t*);
+int ahtable_build_index(ahtable_t*);
 
 /** Find a key that is exact match or lexicographic predecessor.
+ *  The table must be indexed with ahtable_build_index().
  *  \retval  0 if exact match
  *  \retval  1 if couldn't find and no predecessor is found
  *  \retval -1 if found predecessor
@@ -86,8 +128,11 @@ int ahtable_find_leq (ahtable_t*, const char* key, size_t len, value_t** dst);
 
 
 /** Insert given key and value without checking for existence.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM, the table is left unchanged.
  */
-void ahtable_insert (ahtable_t* T, const char* key, size_t len, value_t val);
+int ahtable_insert (ahtable_t* T, const char* key, size_t len, value_t val);
 
 
 int ahtable_del(ahtable_t*, const char* key, size_t len);
@@ -96,11 +141,9 @@ typedef struct ahtable_iter_t_
 {
     unsigned flags;
     ahtable_t* T; // parent
-    uint32_t i; // current key
-    union {
-        slot_t* xs; // pointers to keys
-        slot_t s;           // slot position
-    } d;
+    uint32_t i; // current key (index position if sorted)
+    slot_t s;   // slot position (unsorted)
+    ahtable_ref_t* xs; // private key order (sorted, table not indexed)
 
 } ahtable_iter_t;
 
@@ -11,6 +11,7 @@
 #include <string.h>
 #include "hat-trie.h"
 #include "ahtable.h"
+#include "common/errcode.h"
 
 /* number of child nodes for used alphabet */
 #define NODE_CHILDS (TRIE_MAXCHAR+1)
@@ -319,7 +320,13 @@ hattrie_t* hattrie_dup(const hattrie_t* T, value_t (*nval)(value_t))
     hattrie_iter_t *i = hattrie_iter_begin(T, false);
     while (!hattrie_iter_finished(i)) {
         k = hattrie_iter_key(i, &l);
-        *hattrie_get(N, k, l) = nval(*hattrie_iter_val(i));
+        value_t *val = hattrie_get(N, k, l);
+        if (val == NULL) {
+            hattrie_free(N);
+            N = NULL;
+            break;
+        }
+        *val = nval(*hattrie_iter_val(i));
         hattrie_iter_next(i);
     }
     hattrie_iter_free(i);
@@ -339,24 +346,28 @@ hattrie_t* hattrie_create_n(unsigned bucket_size, const mm_ctx_t *mm)
     return T;
 }
 
-static void node_build_index(node_ptr node)
+static int node_build_index(node_ptr node)
 {
     /* build index on all ahtable nodes */
     if (*node.flag & NODE_TYPE_TRIE) {
         size_t i;
         for (i = 0; i < NODE_CHILDS; ++i) {
             if (i > 0 && node.t->xs[i].t == node.t->xs[i - 1].t) continue;
-            if (node.t->xs[i].t) node_build_index(node.t->xs[i]);
+            if (node.t->xs[i].t) {
+                int ret = node_build_index(node.t->xs[i]);
+                if (ret != KNOT_EOK) return ret;
+            }
         }
+        return KNOT_EOK;
     }
     else {
-        ahtable_build_index(node.b);
+        return ahtable_build_index(node.b);
     }
 }
 
-void hattrie_build_index(hattrie_t *T)
+int hattrie_build_index(hattrie_t *T)
 {
-    node_build_index(T->root);
+    return node_build_index(T->root);
 }
 
 static void node_apply(node_ptr node, void (*f)(value_t*,void*), void* d)
@@ -427,6 +438,19 @@ int hattrie_split_mid(node_ptr node, unsigned *left_m, unsigned *right_m)
     return j;
 }
 
+/* Insert key into a table created by split, the order index is dropped if it
+ * can't grow, hattrie_build_index() builds it again. */
+static void hattrie_split_insert(ahtable_t* t, const char* key, size_t len,
+                                 value_t val)
+{
+    if (ahtable_insert(t, key, len, val) != KNOT_EOK && t->index) {
+        free(t->index);
+        t->index = NULL;
+        t->index_size = 0;
+        (void) ahtable_insert(t, key, len, val);
+    }
+}
+
 static void hattrie_split_fill(node_ptr src, node_ptr left, node_ptr right, uint8_t split)
 {
     /* right should be most of the time hybrid */
@@ -447,10 +471,10 @@ static void hattrie_split_fill(node_ptr src, node_ptr left, node_ptr right, uint
             if (src.b != right.b) {
                 /* insert to right (new bucket) */
                 if (*right.flag & NODE_TYPE_PURE_BUCKET) {
-                    ahtable_insert(right.b, key + 1, len - 1, *u);
+                    hattrie_split_insert(right.b, key + 1, len - 1, *u);
                 }
                 else {
-                    ahtable_insert(right.b, key, len, *u);
+                    hattrie_split_insert(right.b, key, len, *u);
                 }
                 /* transferred to right (from reused) */
                 if (src.b == left.b) {
@@ -462,10 +486,10 @@ static void hattrie_split_fill(node_ptr src, node_ptr left, node_ptr right, uint
             if (src.b != left.b) {
                 /* insert to left (new bucket) */
                 if (*left.flag & NODE_TYPE_PURE_BUCKET) {
-                    ahtable_insert(left.b, key + 1, len - 1, *u);
+                    hattrie_split_insert(left.b, key + 1, len - 1, *u);
                 }
                 else {
-                    ahtable_insert(left.b, key, len, *u);
+                    hattrie_split_insert(left.b, key, len, *u);
                 }
                 /* transferred to left (from reused) */
                 if (src.b == right.b) {
@@ -509,6 +533,13 @@ static void hattrie_split_h(node_ptr parent, node_ptr node)
         left.b = ahtable_create();
     }
 
+    /* new tables keep the order index if the split one had it,
+     * hattrie_build_index() retries if it can't be allocated */
+    if (node.b->index) {
+        (void) ahtable_build_index(left.b);
+        (void) ahtable_build_index(right.b);
+    }
+
     /* setup created nodes */
     left.b->c0    = c0;
     left.b->c1    = j;
@@ -29,7 +29,7 @@ extern "C" {
 
 /* Hat-trie defines. */
 typedef void* value_t;         /* User pointers as value. */
-#define AHTABLE_INIT_SIZE 1024
+#define AHTABLE_INIT_SIZE 256  /* Buckets, ~6 keys per bucket when full. */
 #define TRIE_ZEROBUCKETS  0    /* Do not use hash buckets (pure trie). */
 #define TRIE_BUCKET_SIZE  1536 /* Reasonably low for ordered search perf. */
 #define TRIE_MAXCHAR      0xff /* Use 7-bit ASCII alphabet. */
@@ -49,14 +49,20 @@ hattrie_t* hattrie_create_n (unsigned, const mm_ctx_t *);
  */
 hattrie_t* hattrie_dup (const hattrie_t*, value_t (*nval)(value_t));
 
-/** Build order index on all ahtable nodes in trie.
+/** Build order index on all ahtable nodes in trie, it is maintained on
+ * insertion and deletion afterwards. Ordered lookup (hattrie_find_leq)
+ * requires the index.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
  */
-void hattrie_build_index (hattrie_t*);
+int hattrie_build_index (hattrie_t*);
 
 void hattrie_apply_rev (hattrie_t*, void (*f)(value_t*,void*), void* d);
 
 /** Find the given key in the trie, inserting it if it does not exist, and
- * returning a pointer to it's key.
+ * returning a pointer to it's key. NULL is returned if the key can't be
+ * inserted for lack of memory.
  *
  * This pointer is not guaranteed to be valid after additional calls to
  * hattrie_get, hattrie_del, hattrie_clear, or other functions that modifies the
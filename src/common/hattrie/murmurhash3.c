@@ -2,6 +2,7 @@
  * by its author, Austin Appleby. */
 
 #include <config.h>
+#include <string.h>
 #include "murmurhash3.h"
 
 static inline uint32_t fmix(uint32_t h)
@@ -75,3 +76,69 @@ uint32_t hash(const char* data, size_t len_)
 
     return h1;
 }
+
+
+#ifdef __SIZEOF_INT128__
+
+static const uint64_t mum_p0 = 0xa0761d6478bd642fULL;
+static const uint64_t mum_p1 = 0xe7037ed1a0b428dbULL;
+static const uint64_t mum_p2 = 0x8ebc6af09c88c6e3ULL;
+
+static inline uint64_t mum(uint64_t a, uint64_t b)
+{
+    __uint128_t r = (__uint128_t) a * b;
+    return (uint64_t) r ^ (uint64_t) (r >> 64);
+}
+
+static inline uint64_t read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash_mum(const char* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*) data;
+    uint64_t seed = mum_p0 ^ len;
+    uint64_t a = 0, b = 0;
+
+    while (len > 16) {
+        seed = mum(read64(p) ^ mum_p1, read64(p + 8) ^ seed);
+        p += 16;
+        len -= 16;
+    }
+
+    /* remaining 0-16 bytes, overlapping reads */
+    if (len >= 8) {
+        a = read64(p);
+        b = read64(p + len - 8);
+    }
+    else if (len >= 4) {
+        a = read32(p);
+        b = read32(p + len - 4);
+    }
+    else if (len > 0) {
+        a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8)
+          | p[len - 1];
+    }
+
+    uint64_t h = mum(mum(a ^ mum_p1, b ^ seed) ^ mum_p2, len ^ mum_p1);
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+#else
+
+uint32_t hash_mum(const char* data, size_t len)
+{
+    return hash(data, len);
+}
+
+#endif
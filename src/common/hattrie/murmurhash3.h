@@ -7,4 +7,8 @@
 
 uint32_t hash(const char* data, size_t len);
 
+/* Multiply-mix hash in the style of wyhash, reads 8 bytes at a time.
+ * Falls back to MurmurHash3 where 128-bit multiplication is not available. */
+uint32_t hash_mum(const char* data, size_t len);
+
 #endif
@@ -21,10 +21,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <sys/time.h>
 
 #include "common/log.h"
 #include "common/lists.h"
+#include "common/atomic.h"
 #include "knot/common.h"
 #include "knot/conf/conf.h"
 
@@ -38,7 +43,67 @@ static ssize_t LOG_FDS_OPEN = 0;
 #define facility_next(f) (f) += (1 << LOG_SRC_BITS)
 #define facility_levels(f, i) *((f) + (i))
 
-int log_setup(int logfiles)
+/*! \brief Size of per-thread message ring (power of 2). */
+#define LOG_RING_SIZE (64 * 1024)
+/*! \brief Size of per-stream output batch. */
+#define LOG_BATCH_SIZE (64 * 1024)
+/*! \brief Writer wakes up at least this often (ms). */
+#define LOG_FLUSH_INTERVAL 10
+/*! \brief Maximal length of formatted date and time. */
+#define LOG_TIME_LEN 64
+
+/*! \brief Queued message header, followed by the message text. */
+typedef struct log_rec {
+	time_t sec;        /*!< Time of the message. */
+	unsigned usec;
+	unsigned len;      /*!< Length of the message text. */
+	uint8_t src;       /*!< Origin of the message. */
+	uint8_t level;     /*!< Message level. */
+} log_rec_t;
+
+/*!
+ * \brief Single-producer single-consumer ring of messages.
+ *
+ * Each thread owns one ring, the writer thread is the only consumer.
+ * Positions only grow (modulo unsigned int), the producer owns \a head,
+ * the consumer owns \a tail.
+ */
+typedef struct log_ring {
+	unsigned head;         /*!< Write position. */
+	unsigned dropped;      /*!< Messages dropped by the producer. */
+	unsigned tail;         /*!< Read position. */
+	unsigned closed;       /*!< Owner thread has finished. */
+	struct log_ring *next; /*!< Next registered ring. */
+	uint8_t data[LOG_RING_SIZE];
+} log_ring_t;
+
+/*! \brief Output batch for a single stream. */
+typedef struct log_batch {
+	char *buf;
+	size_t len;
+} log_batch_t;
+
+/*! \brief Asynchronous logging state. */
+static struct {
+	unsigned running;          /*!< Writer thread is running. */
+	bool initialized;          /*!< Semaphore is initialized. */
+	log_ring_t *rings;         /*!< Registered rings (pushed to head). */
+	pthread_t writer;
+	sem_t wakeup;              /*!< Wakes the writer up before timeout. */
+	pthread_mutex_t lock;      /*!< Guards output and configuration. */
+	log_batch_t *batch;        /*!< Output batches per facility. */
+	int batch_count;
+	unsigned freed_dropped;    /*!< Dropped in already freed rings. */
+	unsigned reported;         /*!< Dropped messages already reported. */
+} LOG_ASYNC = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/*! \brief Ring of the current thread. */
+static __thread log_ring_t *LOG_RING = NULL;
+/*! \brief Key for marking rings of finished threads. */
+static pthread_key_t LOG_RING_KEY;
+static pthread_once_t LOG_RING_ONCE = PTHREAD_ONCE_INIT;
+
+static int _log_setup(int logfiles)
 {
 	/* Check facilities count. */
 	if (logfiles < 0) {
@@ -75,6 +140,14 @@ int log_setup(int logfiles)
 	return KNOT_EOK;
 }
 
+int log_setup(int logfiles)
+{
+	pthread_mutex_lock(&LOG_ASYNC.lock);
+	int ret = _log_setup(logfiles);
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
+	return ret;
+}
+
 
 
 int log_init()
@@ -105,12 +178,14 @@ int log_init()
 
 void log_close()
 {
+	log_async_stop();
 	log_truncate();
 	closelog();
 }
 
 void log_truncate()
 {
+	pthread_mutex_lock(&LOG_ASYNC.lock);
 	LOG_FCL_SIZE = 0;
 	if (LOG_FCL) {
 		free(LOG_FCL);
@@ -127,6 +202,7 @@ void log_truncate()
 		LOG_FDS = 0;
 		LOG_FDS_OPEN = 0;
 	}
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
 }
 
 int log_isopen()
@@ -134,7 +210,7 @@ int log_isopen()
 	return LOG_FCL_SIZE;
 }
 
-int log_open_file(const char* filename)
+static int _log_open_file(const char* filename)
 {
 	// Check facility
 	if (knot_unlikely(!LOG_FCL_SIZE || LOGT_FILE + LOG_FDS_OPEN >= LOG_FCL_SIZE)) {
@@ -153,6 +229,14 @@ int log_open_file(const char* filename)
 	return LOGT_FILE + LOG_FDS_OPEN++;
 }
 
+int log_open_file(const char* filename)
+{
+	pthread_mutex_lock(&LOG_ASYNC.lock);
+	int ret = _log_open_file(filename);
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
+	return ret;
+}
+
 uint8_t log_levels(int facility, logsrc_t src)
 {
 	// Check facility
@@ -171,6 +255,7 @@ int log_levels_set(int facility, logsrc_t src, uint8_t levels)
 	}
 
 	// Get facility pointer from offset
+	pthread_mutex_lock(&LOG_ASYNC.lock);
 	uint8_t *lp = LOG_FCL + (facility << LOG_SRC_BITS);
 
 	// Assign level if not multimask
@@ -182,6 +267,7 @@ int log_levels_set(int facility, logsrc_t src, uint8_t levels)
 			*(lp + i) = levels;
 		}
 	}
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
 
 	return KNOT_EOK;
 }
@@ -192,12 +278,66 @@ int log_levels_add(int facility, logsrc_t src, uint8_t levels)
 	return log_levels_set(facility, src, new_levels);
 }
 
-static int _log_msg(logsrc_t src, int level, const char *msg)
+/*!
+ * \brief Formats date and time prefix of a message.
+ *
+ * Local time is formatted once per second, the result is cached per thread.
+ *
+ * \return Length of the prefix (without terminating '\0').
+ */
+static int log_time(char *buf, time_t sec, unsigned usec)
 {
-	if(!log_isopen()) {
-		return KNOT_ERROR;
+	static __thread time_t cached_sec = -1;
+	static __thread char cached[LOG_TIME_LEN];
+	static __thread int cached_len = 0;
+	static __thread long cached_off = 0;
+
+	if (sec != cached_sec) {
+		struct tm lt;
+		cached_len = 0;
+		if (localtime_r(&sec, &lt) != NULL) {
+			cached_len = strftime(cached, sizeof(cached),
+			                      "%Y-%m-%dT%H:%M:%S ", &lt);
+			cached_off = lt.tm_gmtoff;
+		}
+		cached_sec = sec;
 	}
 
+	int len = cached_len;
+	memcpy(buf, cached, len);
+	buf[len] = '\0';
+
+	bool precise = false;
+
+#ifdef ENABLE_MICROSECONDS_LOG
+	precise = true;
+#endif /* ENABLE_MICROSECONDS_LOG */
+
+	if (precise && len > 0) {
+		char pm = (cached_off > 0) ? '+' : '-';
+		len += snprintf(buf + len - 1, LOG_TIME_LEN - len + 1,
+		                ".%.6lu%c%.2u:%.2u ", (unsigned long)usec, pm,
+		                (unsigned int)cached_off / 3600,
+		                (unsigned int)(cached_off / 60) % 60) - 1;
+	}
+
+	return len;
+}
+
+/*! \brief Returns stream of a logging facility. */
+static FILE *log_stream(int facility)
+{
+	switch(facility) {
+	case LOGT_STDERR: return stderr;
+	case LOGT_STDOUT: return stdout;
+	default: return LOG_FDS[facility - LOGT_FILE];
+	}
+}
+
+/*! \brief Writes message to all facilities from the calling thread. */
+static int log_write(logsrc_t src, int level, const char *msg,
+                     time_t sec, unsigned usec)
+{
 	int ret = 0;
 	FILE *stream = stdout;
 	uint8_t *f = facility_at(LOGT_SYSLOG);
@@ -212,31 +352,8 @@ static int _log_msg(logsrc_t src, int level, const char *msg)
 	level = LOG_MASK(level);
 
 	/* Prefix date and time. */
-	char tstr[128] = {0};
-	int tlen = 0;
-	struct tm lt;
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	time_t sec = tv.tv_sec;
-	if (localtime_r(&sec, &lt) != NULL) {
-		bool precise = false;
-
-#ifdef ENABLE_MICROSECONDS_LOG
-		precise = true;
-#endif /* ENABLE_MICROSECONDS_LOG */
-
-		tlen = strftime(tstr, sizeof(tstr),
-				"%Y-%m-%dT%H:%M:%S ", &lt);
-
-		if (precise && tlen > 0) {
-			char pm = (lt.tm_gmtoff > 0) ? '+' : '-';
-			snprintf(tstr + tlen - 1, sizeof(tstr) - tlen + 1,
-			         ".%.6lu%c%.2u:%.2u ",
-			         (unsigned long)tv.tv_usec, pm,
-			         (unsigned int)lt.tm_gmtoff / 3600,
-			         (unsigned int)(lt.tm_gmtoff / 60) % 60);
-		}
-	}
+	char tstr[LOG_TIME_LEN];
+	log_time(tstr, sec, usec);
 
 	// Log streams
 	for (int i = LOGT_STDERR; i < LOGT_FILE + LOG_FDS_OPEN; ++i) {
@@ -245,14 +362,8 @@ static int _log_msg(logsrc_t src, int level, const char *msg)
 		f = facility_at(i);
 		if (facility_levels(f, src) & level) {
 
-			// Select stream
-			switch(i) {
-			case LOGT_STDERR: stream = stderr; break;
-			case LOGT_STDOUT: stream = stdout; break;
-			default: stream = LOG_FDS[i - LOGT_FILE]; break;
-			}
-
 			// Print
+			stream = log_stream(i);
 			ret = fprintf(stream, "%s%s", tstr, msg);
 			if (stream == stdout) {
 				fflush(stream);
@@ -267,6 +378,409 @@ static int _log_msg(logsrc_t src, int level, const char *msg)
 	return ret;
 }
 
+/*----------------------------------------------------------------------------*/
+/* Asynchronous logging                                                       */
+/*----------------------------------------------------------------------------*/
+
+/*! \brief Size of the queued record with given message length. */
+#define LOG_REC_SIZE(len) ((sizeof(log_rec_t) + (len) + 7) & ~7)
+
+static void ring_read(const log_ring_t *r, unsigned pos, void *dst, size_t len)
+{
+	size_t off = pos & (LOG_RING_SIZE - 1);
+	size_t first = LOG_RING_SIZE - off < len ? LOG_RING_SIZE - off : len;
+	memcpy(dst, r->data + off, first);
+	memcpy((uint8_t *)dst + first, r->data, len - first);
+}
+
+static void ring_write(log_ring_t *r, unsigned pos, const void *src, size_t len)
+{
+	size_t off = pos & (LOG_RING_SIZE - 1);
+	size_t first = LOG_RING_SIZE - off < len ? LOG_RING_SIZE - off : len;
+	memcpy(r->data + off, src, first);
+	memcpy(r->data, (const uint8_t *)src + first, len - first);
+}
+
+/*!
+ * \brief Marks ring of a finished thread, the writer frees it.
+ *
+ * Runs on the exiting thread, a message logged after it (e.g. from another
+ * thread-specific destructor) gets a new ring instead of the closed one.
+ */
+static void log_ring_close(void *ring)
+{
+	log_ring_t *r = ring;
+	LOG_RING = NULL;
+	store_once(&r->closed, 1, __ATOMIC_RELEASE);
+}
+
+static void log_ring_key_init()
+{
+	pthread_key_create(&LOG_RING_KEY, log_ring_close);
+}
+
+/*! \brief Returns ring of the calling thread, creates it if needed. */
+static log_ring_t *log_ring()
+{
+	log_ring_t *r = LOG_RING;
+	if (r != NULL) {
+		return r;
+	}
+
+	pthread_once(&LOG_RING_ONCE, log_ring_key_init);
+	r = calloc(1, sizeof(log_ring_t));
+	if (r == NULL) {
+		return NULL;
+	}
+	pthread_setspecific(LOG_RING_KEY, r);
+
+	/* Register, only the writer removes rings (never the first one). */
+	do {
+		r->next = read_ptr((void **)&LOG_ASYNC.rings, __ATOMIC_ACQUIRE);
+	} while (!__sync_bool_compare_and_swap(&LOG_ASYNC.rings, r->next, r));
+
+	LOG_RING = r;
+	return r;
+}
+
+/*! \brief Checks if any facility logs given message. */
+static bool log_wanted(logsrc_t src, int level)
+{
+	size_t facilities = LOG_FCL_SIZE >> LOG_SRC_BITS;
+	for (int i = 0; i < facilities; ++i) {
+		if (facility_levels(facility_at(i), src) & LOG_MASK(level)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * \brief Queues message for the writer thread.
+ *
+ * \retval Message length if queued.
+ * \retval 0 if the message was dropped (ring is full).
+ * \retval KNOT_ENOMEM if the ring couldn't be created.
+ */
+static int log_enqueue(logsrc_t src, int level, const char *msg, size_t len)
+{
+	log_ring_t *r = log_ring();
+	if (r == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	unsigned need = LOG_REC_SIZE(len);
+	unsigned head = r->head;
+	unsigned used = head - read_once(&r->tail, __ATOMIC_ACQUIRE);
+	if (need > LOG_RING_SIZE - used) {
+		atomic_inc(&r->dropped, __ATOMIC_RELAXED);
+		return 0;
+	}
+
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	log_rec_t rec = {
+		.sec = tv.tv_sec,
+		.usec = tv.tv_usec,
+		.len = len,
+		.src = src,
+		.level = level
+	};
+	ring_write(r, head, &rec, sizeof(rec));
+	ring_write(r, head + sizeof(rec), msg, len);
+	store_once(&r->head, head + need, __ATOMIC_RELEASE);
+
+	/* Don't wait for the timeout if the ring fills up. */
+	if (used < LOG_RING_SIZE / 2 && used + need >= LOG_RING_SIZE / 2) {
+		sem_post(&LOG_ASYNC.wakeup);
+	}
+
+	return len;
+}
+
+/*! \brief Writes out batched output of a stream. */
+static void log_batch_flush(int facility)
+{
+	log_batch_t *b = &LOG_ASYNC.batch[facility];
+	FILE *stream = log_stream(facility);
+
+	/* Keep order with previous direct writes. */
+	fflush(stream);
+
+	int fd = fileno(stream);
+	size_t off = 0;
+	while (off < b->len) {
+		ssize_t n = write(fd, b->buf + off, b->len - off);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		off += n;
+	}
+
+	b->len = 0;
+}
+
+/*! \brief Appends message to the stream batch. */
+static void log_batch_add(int facility, const char *tstr, size_t tlen,
+                          const char *msg, size_t len)
+{
+	/* Make room for the facility. */
+	if (facility >= LOG_ASYNC.batch_count) {
+		size_t size = (facility + 1) * sizeof(log_batch_t);
+		log_batch_t *batch = realloc(LOG_ASYNC.batch, size);
+		if (batch != NULL) {
+			memset(batch + LOG_ASYNC.batch_count, 0,
+			       (facility + 1 - LOG_ASYNC.batch_count) *
+			       sizeof(log_batch_t));
+			LOG_ASYNC.batch = batch;
+			LOG_ASYNC.batch_count = facility + 1;
+		}
+	}
+
+	log_batch_t *b = NULL;
+	if (facility < LOG_ASYNC.batch_count) {
+		b = &LOG_ASYNC.batch[facility];
+		if (b->buf == NULL) {
+			b->buf = malloc(LOG_BATCH_SIZE);
+		}
+	}
+
+	/* Write directly if out of memory or too long. */
+	if (b == NULL || b->buf == NULL || tlen + len > LOG_BATCH_SIZE) {
+		if (b != NULL && b->len > 0) {
+			log_batch_flush(facility);
+		}
+		fprintf(log_stream(facility), "%s%s", tstr, msg);
+		return;
+	}
+
+	if (b->len + tlen + len > LOG_BATCH_SIZE) {
+		log_batch_flush(facility);
+	}
+	memcpy(b->buf + b->len, tstr, tlen);
+	memcpy(b->buf + b->len + tlen, msg, len);
+	b->len += tlen + len;
+}
+
+/*! \brief Sends queued message to all facilities. */
+static void log_write_rec(const log_rec_t *rec, const char *msg)
+{
+	uint8_t *f = facility_at(LOGT_SYSLOG);
+	int level = LOG_MASK(rec->level);
+
+	// Syslog
+	if (facility_levels(f, rec->src) & level) {
+		syslog(rec->level, "%s", msg);
+	}
+
+	// Log streams
+	char tstr[LOG_TIME_LEN];
+	int tlen = -1;
+	for (int i = LOGT_STDERR; i < LOGT_FILE + LOG_FDS_OPEN; ++i) {
+		f = facility_at(i);
+		if (facility_levels(f, rec->src) & level) {
+			if (tlen < 0) {
+				tlen = log_time(tstr, rec->sec, rec->usec);
+			}
+			log_batch_add(i, tstr, tlen, msg, rec->len);
+		}
+	}
+}
+
+/*! \brief Writes out queued messages of a ring. */
+static void log_drain_ring(log_ring_t *r, char *msg)
+{
+	unsigned tail = r->tail;
+	unsigned head = read_once(&r->head, __ATOMIC_ACQUIRE);
+	while (tail != head) {
+		log_rec_t rec;
+		ring_read(r, tail, &rec, sizeof(rec));
+		ring_read(r, tail + sizeof(rec), msg, rec.len);
+		msg[rec.len] = '\0';
+		log_write_rec(&rec, msg);
+
+		tail += LOG_REC_SIZE(rec.len);
+		store_once(&r->tail, tail, __ATOMIC_RELEASE);
+	}
+}
+
+/*!
+ * \brief Writes out all queued messages.
+ *
+ * \note Caller must hold LOG_ASYNC.lock.
+ */
+static void log_drain()
+{
+	/* Keep messages until the log is set up. */
+	if (!log_isopen()) {
+		return;
+	}
+
+	static char msg[LOG_RING_SIZE + 1];
+	unsigned dropped = LOG_ASYNC.freed_dropped;
+	log_ring_t *prev = NULL;
+	log_ring_t *r = read_ptr((void **)&LOG_ASYNC.rings, __ATOMIC_ACQUIRE);
+	while (r != NULL) {
+		log_ring_t *next = r->next;
+		log_drain_ring(r, msg);
+		dropped += read_once(&r->dropped, __ATOMIC_RELAXED);
+
+		/* Free rings of finished threads, new rings are pushed
+		 * to the head, so only the first one can't be unlinked. */
+		if (prev != NULL && read_once(&r->closed, __ATOMIC_ACQUIRE)) {
+			log_drain_ring(r, msg);
+			LOG_ASYNC.freed_dropped += r->dropped;
+			prev->next = next;
+			free(r);
+		} else {
+			prev = r;
+		}
+		r = next;
+	}
+
+	/* Report dropped messages. */
+	if (dropped != LOG_ASYNC.reported) {
+		char buf[128];
+		int len = snprintf(buf, sizeof(buf), "[warning] Logging "
+		                   "overloaded, %u messages dropped.\n",
+		                   dropped - LOG_ASYNC.reported);
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		log_rec_t rec = {
+			.sec = tv.tv_sec,
+			.usec = tv.tv_usec,
+			.len = len,
+			.src = LOG_SERVER,
+			.level = LOG_WARNING
+		};
+		log_write_rec(&rec, buf);
+		LOG_ASYNC.reported = dropped;
+	}
+
+	/* Write out batches. */
+	for (int i = LOGT_STDERR; i < LOG_ASYNC.batch_count; ++i) {
+		if (LOG_ASYNC.batch[i].len > 0) {
+			log_batch_flush(i);
+		}
+	}
+}
+
+/*! \brief Writer thread, periodically writes out queued messages. */
+static void *log_writer(void *arg)
+{
+	while (read_once(&LOG_ASYNC.running, __ATOMIC_ACQUIRE)) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += LOG_FLUSH_INTERVAL * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec += 1;
+			ts.tv_nsec -= 1000000000L;
+		}
+		sem_timedwait(&LOG_ASYNC.wakeup, &ts);
+
+		pthread_mutex_lock(&LOG_ASYNC.lock);
+		log_drain();
+		pthread_mutex_unlock(&LOG_ASYNC.lock);
+	}
+
+	return NULL;
+}
+
+int log_async_start()
+{
+	if (read_once(&LOG_ASYNC.running, __ATOMIC_ACQUIRE)) {
+		return KNOT_EOK;
+	}
+
+	/* Semaphore is kept, late producers may still post it. */
+	if (!LOG_ASYNC.initialized) {
+		if (sem_init(&LOG_ASYNC.wakeup, 0, 0) != 0) {
+			return KNOT_ERROR;
+		}
+		/* Write out queued messages on exit(). */
+		atexit(log_async_stop);
+		LOG_ASYNC.initialized = true;
+	}
+
+	store_once(&LOG_ASYNC.running, 1, __ATOMIC_RELEASE);
+
+	/* Signals are left for the other threads. */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	int ret = pthread_create(&LOG_ASYNC.writer, NULL, log_writer, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (ret != 0) {
+		store_once(&LOG_ASYNC.running, 0, __ATOMIC_RELEASE);
+		return KNOT_ERROR;
+	}
+
+	return KNOT_EOK;
+}
+
+void log_async_stop()
+{
+	if (!read_once(&LOG_ASYNC.running, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	store_once(&LOG_ASYNC.running, 0, __ATOMIC_RELEASE);
+	sem_post(&LOG_ASYNC.wakeup);
+	pthread_join(LOG_ASYNC.writer, NULL);
+
+	/* Write out the rest, rings are kept for their threads. */
+	pthread_mutex_lock(&LOG_ASYNC.lock);
+	log_drain();
+	for (int i = 0; i < LOG_ASYNC.batch_count; ++i) {
+		free(LOG_ASYNC.batch[i].buf);
+	}
+	free(LOG_ASYNC.batch);
+	LOG_ASYNC.batch = NULL;
+	LOG_ASYNC.batch_count = 0;
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
+}
+
+size_t log_dropped()
+{
+	pthread_mutex_lock(&LOG_ASYNC.lock);
+	size_t dropped = LOG_ASYNC.freed_dropped;
+	log_ring_t *r = read_ptr((void **)&LOG_ASYNC.rings, __ATOMIC_ACQUIRE);
+	for (; r != NULL; r = r->next) {
+		dropped += read_once(&r->dropped, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&LOG_ASYNC.lock);
+
+	return dropped;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static int _log_msg(logsrc_t src, int level, const char *msg)
+{
+	if(!log_isopen()) {
+		return KNOT_ERROR;
+	}
+
+	/* Queue message for the writer thread. */
+	if (read_once(&LOG_ASYNC.running, __ATOMIC_ACQUIRE)) {
+		if (!log_wanted(src, level)) {
+			return 0;
+		}
+		int ret = log_enqueue(src, level, msg, strlen(msg));
+		if (ret >= 0) {
+			return ret;
+		}
+	}
+
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return log_write(src, level, msg, tv.tv_sec, tv.tv_usec);
+}
+
 int log_msg(logsrc_t src, int level, const char *msg, ...)
 {
 	/* Buffer for log message. */
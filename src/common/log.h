@@ -98,6 +98,33 @@ void log_close();
  */
 void log_truncate();
 
+/*!
+ * \brief Start asynchronous logging.
+ *
+ * Messages are queued in per-thread lock-free rings and written out
+ * in batches by a dedicated thread, so the logging thread never blocks
+ * on I/O. Messages are dropped (and counted) when the ring of the calling
+ * thread is full. Order is kept for messages from the same thread.
+ *
+ * Queued messages are written out on log_close() or on exit().
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_ERROR if the writer thread couldn't be started.
+ */
+int log_async_start();
+
+/*!
+ * \brief Stop asynchronous logging and write out queued messages.
+ *
+ * Logging is synchronous afterwards.
+ */
+void log_async_stop();
+
+/*!
+ * \brief Return number of messages dropped because of full queues.
+ */
+size_t log_dropped();
+
 /*!
  * \brief Return positive number if open.
  *
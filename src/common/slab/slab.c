@@ -399,6 +399,36 @@ void* slab_alloc(slab_t* slab)
 	return item;
 }
 
+/*! \brief Return buf to its slab. */
+static void slab_buf_free(slab_t* slab, void* ptr)
+{
+	// Return buf to slab
+	*((void**)ptr) = (void*)slab->head;
+	slab->head = (void**)ptr;
+	++slab->bufs_free;
+
+#ifdef MEM_DEBUG
+	// Increment statistics
+	__sync_add_and_fetch(&slab->cache->stat_frees, 1);
+#endif
+
+	// Return to partial
+	if(knot_unlikely(slab->bufs_free == 1)) {
+		slab_list_move(&slab->cache->slabs_free, slab);
+	} else {
+#ifdef MEM_SLAB_CAP
+	// Recycle if empty
+		if(knot_unlikely(slab_isempty(slab))) {
+			if(slab->cache->empty == MEM_SLAB_CAP) {
+				slab_destroy(&slab);
+			} else {
+				++slab->cache->empty;
+			}
+		}
+#endif
+	}
+}
+
 void slab_free(void* ptr)
 {
 	// Null pointer check
@@ -413,30 +443,11 @@ void slab_free(void* ptr)
 	// Check if it exists in directory
 	if (slab->magic == SLAB_MAGIC) {
 
-		// Return buf to slab
-		*((void**)ptr) = (void*)slab->head;
-		slab->head = (void**)ptr;
-		++slab->bufs_free;
-
-#ifdef MEM_DEBUG
-		// Increment statistics
-		__sync_add_and_fetch(&slab->cache->stat_frees, 1);
-#endif
-
-		// Return to partial
-		if(knot_unlikely(slab->bufs_free == 1)) {
-			slab_list_move(&slab->cache->slabs_free, slab);
+		// Bufs from magazine caches go to thread magazine
+		if (slab->cache->mcache) {
+			slab_mcache_free(slab->cache->mcache, ptr);
 		} else {
-#ifdef MEM_SLAB_CAP
-		// Recycle if empty
-			if(knot_unlikely(slab_isempty(slab))) {
-				if(slab->cache->empty == MEM_SLAB_CAP) {
-					slab_destroy(&slab);
-				} else {
-					++slab->cache->empty;
-				}
-			}
-#endif
+			slab_buf_free(slab, ptr);
 		}
 
 	} else {
@@ -521,3 +532,319 @@ int slab_cache_reap(slab_cache_t* cache)
 	cache->empty = 0;
 	return count;
 }
+
+/*
+ * Magazine layer.
+ */
+
+/*! \brief Return bufs from magazine to slabs (cache must be locked). */
+static void slab_mag_flush(slab_mag_t* mag)
+{
+	while (mag->rounds > 0) {
+		void* ptr = mag->bufs[--mag->rounds];
+		slab_buf_free(slab_from_ptr(ptr), ptr);
+	}
+}
+
+/*! \brief Fill magazine from slabs (cache must be locked). */
+static void slab_mag_fill(slab_mcache_t* mcache, slab_mag_t* mag)
+{
+	while (mag->rounds < SLAB_MAG_SIZE) {
+		void* ptr = slab_cache_alloc(&mcache->cache);
+		if (ptr == NULL) {
+			break;
+		}
+		mag->bufs[mag->rounds++] = ptr;
+	}
+}
+
+/*! \brief Return empty magazine to depot or free it (cache must be locked). */
+static void slab_mag_put_empty(slab_mcache_t* mcache, slab_mag_t* mag)
+{
+	if (mcache->empty_count < SLAB_MAG_DEPOT) {
+		mcache->empty[mcache->empty_count++] = mag;
+	} else {
+		free(mag);
+	}
+}
+
+/*! \brief Take empty magazine from depot or allocate (cache must be locked). */
+static slab_mag_t* slab_mag_get_empty(slab_mcache_t* mcache)
+{
+	if (mcache->empty_count > 0) {
+		return mcache->empty[--mcache->empty_count];
+	}
+
+	slab_mag_t* mag = malloc(sizeof(slab_mag_t));
+	if (mag != NULL) {
+		mag->rounds = 0;
+	}
+	return mag;
+}
+
+/*! \brief Add statistics counters. */
+static void slab_mcache_stats_add(slab_mcache_stats_t* to,
+                                  const slab_mcache_stats_t* from)
+{
+	to->allocs += from->allocs;
+	to->frees += from->frees;
+	to->depot_gets += from->depot_gets;
+	to->depot_puts += from->depot_puts;
+	to->slab_fills += from->slab_fills;
+	to->slab_flushes += from->slab_flushes;
+}
+
+/*! \brief Return layer magazines to depot, unlink it (cache must be locked). */
+static void slab_mag_layer_release(slab_mag_layer_t* layer)
+{
+	slab_mcache_t* mcache = layer->mcache;
+	slab_mag_t* mags[2] = { layer->loaded, layer->previous };
+	for (int i = 0; i < 2; ++i) {
+		if (mags[i]->rounds == SLAB_MAG_SIZE &&
+		    mcache->full_count < SLAB_MAG_DEPOT) {
+			mcache->full[mcache->full_count++] = mags[i];
+			continue;
+		}
+		slab_mag_flush(mags[i]);
+		slab_mag_put_empty(mcache, mags[i]);
+	}
+
+	slab_mcache_stats_add(&mcache->stats, &layer->stats);
+
+	if (layer->prev) {
+		layer->prev->next = layer->next;
+	} else {
+		mcache->layers = layer->next;
+	}
+	if (layer->next) {
+		layer->next->prev = layer->prev;
+	}
+}
+
+/*! \brief Release thread layer on thread exit (automatically called). */
+static void slab_mag_layer_free(void* ptr)
+{
+	slab_mag_layer_t* layer = (slab_mag_layer_t*)ptr;
+	slab_mcache_t* mcache = layer->mcache;
+
+	pthread_mutex_lock(&mcache->lock);
+	slab_mag_layer_release(layer);
+	pthread_mutex_unlock(&mcache->lock);
+
+	free(layer);
+}
+
+/*! \brief Return calling thread layer, create if it doesn't exist. */
+static slab_mag_layer_t* slab_mag_layer(slab_mcache_t* mcache)
+{
+	slab_mag_layer_t* layer = pthread_getspecific(mcache->key);
+	if (knot_likely(layer != NULL)) {
+		return layer;
+	}
+
+	if (posix_memalign((void **)&layer, SLAB_CACHELINE,
+	                   sizeof(slab_mag_layer_t)) != 0) {
+		return NULL;
+	}
+	memset(layer, 0, sizeof(slab_mag_layer_t));
+	layer->mcache = mcache;
+
+	pthread_mutex_lock(&mcache->lock);
+	layer->loaded = slab_mag_get_empty(mcache);
+	layer->previous = slab_mag_get_empty(mcache);
+	if (layer->loaded == NULL || layer->previous == NULL) {
+		free(layer->loaded);
+		free(layer->previous);
+		pthread_mutex_unlock(&mcache->lock);
+		free(layer);
+		return NULL;
+	}
+	layer->next = mcache->layers;
+	if (mcache->layers) {
+		mcache->layers->prev = layer;
+	}
+	mcache->layers = layer;
+	pthread_mutex_unlock(&mcache->lock);
+
+	if (pthread_setspecific(mcache->key, layer) != 0) {
+		slab_mag_layer_free(layer);
+		return NULL;
+	}
+
+	return layer;
+}
+
+/*! \brief Swap loaded and previous magazine. */
+static inline void slab_mag_swap(slab_mag_layer_t* layer)
+{
+	slab_mag_t* mag = layer->loaded;
+	layer->loaded = layer->previous;
+	layer->previous = mag;
+}
+
+/*!
+ * \brief Reload thread magazines when both are empty.
+ * \retval 0 if loaded magazine is not empty.
+ * \retval -1 on error.
+ */
+static int slab_mag_reload(slab_mcache_t* mcache, slab_mag_layer_t* layer)
+{
+	pthread_mutex_lock(&mcache->lock);
+	if (mcache->full_count > 0) {
+		// Exchange empty magazine for a full one
+		slab_mag_put_empty(mcache, layer->previous);
+		layer->previous = layer->loaded;
+		layer->loaded = mcache->full[--mcache->full_count];
+		++layer->stats.depot_gets;
+	} else {
+		slab_mag_fill(mcache, layer->loaded);
+		++layer->stats.slab_fills;
+	}
+	pthread_mutex_unlock(&mcache->lock);
+
+	return layer->loaded->rounds > 0 ? 0 : -1;
+}
+
+/*! \brief Unload thread magazines when both are full. */
+static void slab_mag_unload(slab_mcache_t* mcache, slab_mag_layer_t* layer)
+{
+	pthread_mutex_lock(&mcache->lock);
+	slab_mag_t* mag = NULL;
+	if (mcache->full_count < SLAB_MAG_DEPOT &&
+	    (mag = slab_mag_get_empty(mcache)) != NULL) {
+		// Exchange full magazine for an empty one
+		mcache->full[mcache->full_count++] = layer->previous;
+		layer->previous = layer->loaded;
+		layer->loaded = mag;
+		++layer->stats.depot_puts;
+	} else {
+		// Depot is full, return bufs to slabs
+		slab_mag_flush(layer->previous);
+		slab_mag_swap(layer);
+		++layer->stats.slab_flushes;
+	}
+	pthread_mutex_unlock(&mcache->lock);
+}
+
+int slab_mcache_init(slab_mcache_t* mcache, size_t bufsize)
+{
+	if (knot_unlikely(!mcache)) {
+		return -1;
+	}
+
+	memset(mcache, 0, sizeof(slab_mcache_t));
+	if (slab_cache_init(&mcache->cache, bufsize) != 0) {
+		return -1;
+	}
+	mcache->cache.mcache = mcache;
+
+	if (pthread_mutex_init(&mcache->lock, NULL) != 0) {
+		return -1;
+	}
+	if (pthread_key_create(&mcache->key, slab_mag_layer_free) != 0) {
+		pthread_mutex_destroy(&mcache->lock);
+		return -1;
+	}
+
+	dbg_mem("%s: created magazine cache of size %zu\n",
+	          __func__, bufsize);
+
+	return 0;
+}
+
+void slab_mcache_destroy(slab_mcache_t* mcache)
+{
+	// Remaining thread layers are no longer reachable from threads
+	pthread_key_delete(mcache->key);
+	while (mcache->layers) {
+		slab_mag_layer_t* layer = mcache->layers;
+		slab_mag_layer_release(layer);
+		free(layer);
+	}
+
+	// Free depot magazines, bufs are freed with the slabs
+	while (mcache->full_count > 0) {
+		free(mcache->full[--mcache->full_count]);
+	}
+	while (mcache->empty_count > 0) {
+		free(mcache->empty[--mcache->empty_count]);
+	}
+
+	slab_cache_destroy(&mcache->cache);
+	pthread_mutex_destroy(&mcache->lock);
+}
+
+void* slab_mcache_alloc(slab_mcache_t* mcache)
+{
+	slab_mag_layer_t* layer = slab_mag_layer(mcache);
+	if (knot_unlikely(layer == NULL)) {
+		// No thread layer, allocate directly from slabs
+		pthread_mutex_lock(&mcache->lock);
+		void* ptr = slab_cache_alloc(&mcache->cache);
+		pthread_mutex_unlock(&mcache->lock);
+		return ptr;
+	}
+
+	if (knot_unlikely(layer->loaded->rounds == 0)) {
+		if (layer->previous->rounds > 0) {
+			slab_mag_swap(layer);
+		} else if (slab_mag_reload(mcache, layer) != 0) {
+			return NULL;
+		}
+	}
+
+	++layer->stats.allocs;
+	return layer->loaded->bufs[--layer->loaded->rounds];
+}
+
+void slab_mcache_free(slab_mcache_t* mcache, void* ptr)
+{
+	slab_mag_layer_t* layer = slab_mag_layer(mcache);
+	if (knot_unlikely(layer == NULL)) {
+		// No thread layer, return directly to slab
+		pthread_mutex_lock(&mcache->lock);
+		slab_buf_free(slab_from_ptr(ptr), ptr);
+		pthread_mutex_unlock(&mcache->lock);
+		return;
+	}
+
+	if (knot_unlikely(layer->loaded->rounds == SLAB_MAG_SIZE)) {
+		if (layer->previous->rounds == 0) {
+			slab_mag_swap(layer);
+		} else {
+			slab_mag_unload(mcache, layer);
+		}
+	}
+
+	++layer->stats.frees;
+	layer->loaded->bufs[layer->loaded->rounds++] = ptr;
+}
+
+int slab_mcache_reap(slab_mcache_t* mcache)
+{
+	pthread_mutex_lock(&mcache->lock);
+	while (mcache->full_count > 0) {
+		slab_mag_t* mag = mcache->full[--mcache->full_count];
+		slab_mag_flush(mag);
+		free(mag);
+	}
+	while (mcache->empty_count > 0) {
+		free(mcache->empty[--mcache->empty_count]);
+	}
+	int count = slab_cache_reap(&mcache->cache);
+	pthread_mutex_unlock(&mcache->lock);
+
+	return count;
+}
+
+void slab_mcache_stats(slab_mcache_t* mcache, slab_mcache_stats_t* stats)
+{
+	memset(stats, 0, sizeof(slab_mcache_stats_t));
+
+	pthread_mutex_lock(&mcache->lock);
+	slab_mcache_stats_add(stats, &mcache->stats);
+	for (slab_mag_layer_t* it = mcache->layers; it != NULL; it = it->next) {
+		slab_mcache_stats_add(stats, &it->stats);
+	}
+	pthread_mutex_unlock(&mcache->lock);
+}
@@ -72,11 +72,31 @@
  * \endcode
  *
  *
+ * Caches shared between threads should use the magazine layer
+ * (\ref slab_mcache_t). Each thread keeps two magazines (small stacks of
+ * free bufs) and allocates and frees from them without locking. Only when
+ * both are exhausted (or full), the thread exchanges a magazine with the
+ * shared depot or refills (flushes) a magazine from (to) the underlying slab
+ * cache under a lock. The depot holds at most \ref SLAB_MAG_DEPOT magazines
+ * of each kind, the rest is returned to the slabs.
+ *
+ * \code
+ * slab_mcache_t mcache;
+ * slab_mcache_init(&mcache, N); // Initialize, N means chunk size
+ * ...
+ * void* mem = slab_mcache_alloc(&mcache); // From any thread
+ * ...
+ * slab_free(mem); // From any thread, routed to the magazine layer
+ * ...
+ * slab_mcache_destroy(&mcache); // When no other thread uses it
+ * \endcode
+ *
  * \todo Allocate slab headers elsewhere and use just first sizeof(void*) bytes
  *       in each slab as a pointer to slab header. This could improve the
  *       performance (issue #1583).
  *
- * \note Slab allocation is not thread safe for performance reasons.
+ * \note Slab allocation is not thread safe for performance reasons, use
+ *       the magazine layer for caches shared between threads.
  *
  * \addtogroup alloc
  * @{
@@ -92,7 +112,11 @@
 #define SLAB_MINSIZE 4096  //!< Slab minimal size (4K blocks)
 #define SLAB_MIN_BUFLEN 8  //!< Minimal allocation block size is 8B.
 #define SLAB_DEPOT_SIZE 16 //!< N slabs cached = N*SLAB_SIZE kB cap
+#define SLAB_MAG_SIZE 32   //!< Number of bufs in a magazine.
+#define SLAB_MAG_DEPOT 8   //!< Max. full (and empty) magazines in depot.
+#define SLAB_CACHELINE 64  //!< Alignment of per-thread data.
 struct slab_cache_t;
+struct slab_mcache_t;
 extern size_t SLAB_MASK;
 
 /* Macros. */
@@ -178,12 +202,64 @@ typedef struct slab_cache_t {
 	size_t bufsize;          /*!< Cache object (buf) size. */
 	slab_t *slabs_free;      /*!< List of free slabs. */
 	slab_t *slabs_full;      /*!< List of full slabs. */
+	struct slab_mcache_t *mcache; /*!< Owner magazine cache (or NULL). */
 
 	/* Statistics. */
 	unsigned long stat_allocs; /*!< Allocation count. */
 	unsigned long stat_frees;  /*!< Free count. */
 } slab_cache_t;
 
+/*!
+ * \brief Magazine, a stack of free bufs owned by a single thread.
+ */
+typedef struct slab_mag_t {
+	unsigned rounds;            /*!< Number of bufs in magazine. */
+	void *bufs[SLAB_MAG_SIZE];  /*!< Stack of bufs. */
+} slab_mag_t;
+
+/*!
+ * \brief Magazine cache statistics.
+ */
+typedef struct slab_mcache_stats_t {
+	unsigned long allocs;       /*!< Allocation count. */
+	unsigned long frees;        /*!< Free count. */
+	unsigned long depot_gets;   /*!< Full magazines taken from depot. */
+	unsigned long depot_puts;   /*!< Full magazines given to depot. */
+	unsigned long slab_fills;   /*!< Magazines filled from slabs. */
+	unsigned long slab_flushes; /*!< Magazines flushed to slabs. */
+} slab_mcache_stats_t;
+
+/*!
+ * \brief Per-thread magazine layer.
+ *
+ * Aligned to cache line, so threads don't share cache lines.
+ */
+typedef struct slab_mag_layer_t {
+	slab_mag_t *loaded;            /*!< Magazine in use. */
+	slab_mag_t *previous;          /*!< Previously used magazine. */
+	struct slab_mcache_t *mcache;  /*!< Owner cache. */
+	struct slab_mag_layer_t *prev, *next; /*!< Neighbours in layer list. */
+	slab_mcache_stats_t stats;     /*!< Thread statistics. */
+} slab_mag_layer_t;
+
+/*!
+ * \brief Thread-safe slab cache with per-thread magazines.
+ *
+ * Slab cache and depot are protected by the lock, per-thread layers are
+ * kept in thread-specific data and used without locking.
+ */
+typedef struct slab_mcache_t {
+	slab_cache_t cache;              /*!< Underlying slab cache. */
+	pthread_mutex_t lock;            /*!< Lock for cache and depot. */
+	pthread_key_t key;               /*!< Key for per-thread layers. */
+	slab_mag_layer_t *layers;        /*!< List of per-thread layers. */
+	slab_mag_t *full[SLAB_MAG_DEPOT];  /*!< Depot of full magazines. */
+	unsigned full_count;             /*!< Number of full magazines. */
+	slab_mag_t *empty[SLAB_MAG_DEPOT]; /*!< Depot of empty magazines. */
+	unsigned empty_count;            /*!< Number of empty magazines. */
+	slab_mcache_stats_t stats;       /*!< Statistics of exited threads. */
+} slab_mcache_t;
+
 /*!
  * \brief Create a slab of predefined size.
  *
@@ -273,6 +349,71 @@ void* slab_cache_alloc(slab_cache_t* cache);
  */
 int slab_cache_reap(slab_cache_t* cache);
 
+/*!
+ * \brief Create a thread-safe slab cache with per-thread magazines.
+ *
+ * \param mcache Pointer to uninitialized cache.
+ * \param bufsize Single item size for later allocs.
+ * \retval 0 on success.
+ * \retval -1 on error;
+ */
+int slab_mcache_init(slab_mcache_t* mcache, size_t bufsize);
+
+/*!
+ * \brief Destroy a magazine cache.
+ *
+ * All bufs including those held in per-thread magazines are freed.
+ *
+ * \warning No other thread may use the cache during and after this call.
+ *
+ * \param mcache Pointer to magazine cache.
+ */
+void slab_mcache_destroy(slab_mcache_t* mcache);
+
+/*!
+ * \brief Allocate from the magazine cache.
+ *
+ * Uses calling thread magazines, takes a full magazine from the depot
+ * or fills a magazine from the slab cache if they are exhausted.
+ *
+ * \param mcache Given magazine cache.
+ * \retval Pointer to allocated memory.
+ * \retval NULL on error.
+ */
+void* slab_mcache_alloc(slab_mcache_t* mcache);
+
+/*!
+ * \brief Return memory to the magazine cache.
+ *
+ * Memory may be freed from any thread, it is put into the calling thread
+ * magazine. Called from slab_free() for bufs from magazine caches.
+ *
+ * \param mcache Owner magazine cache.
+ * \param ptr Returned memory.
+ */
+void slab_mcache_free(slab_mcache_t* mcache, void* ptr);
+
+/*!
+ * \brief Return depot magazines to slabs and free unused slabs.
+ *
+ * Per-thread magazines are not affected.
+ *
+ * \param mcache Given magazine cache.
+ * \return Number of freed slabs.
+ */
+int slab_mcache_reap(slab_mcache_t* mcache);
+
+/*!
+ * \brief Collect magazine cache statistics.
+ *
+ * Counters of running threads are read without synchronization, so the
+ * result is approximate while the cache is in use.
+ *
+ * \param mcache Given magazine cache.
+ * \param stats Statistics to be filled.
+ */
+void slab_mcache_stats(slab_mcache_t* mcache, slab_mcache_stats_t* stats);
+
 #endif /* _KNOTD_COMMON_SLAB_H_ */
 
 /*! @} */
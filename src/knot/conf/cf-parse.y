@@ -31,6 +31,7 @@
 #include "common/sockaddr.h"
 #include "libknot/dname.h"
 #include "libknot/binary.h"
+#include "libknot/tsig-op.h"
 #include "knot/conf/conf.h"
 #include "libknotd_la-cf-parse.h" /* Automake generated header. */
 
@@ -305,14 +306,7 @@ static void conf_zone_start(void *scanner, char *name) {
       cf_error(scanner, "out of memory while allocating zone config");
       return;
    }
-   memset(this_zone, 0, sizeof(conf_zone_t));
-   this_zone->enable_checks = -1; // Default policy applies
-   this_zone->notify_timeout = -1; // Default policy applies
-   this_zone->notify_retries = 0; // Default policy applies
-   this_zone->ixfr_fslimit = -1; // Default policy applies
-   this_zone->dbsync_timeout = -1; // Default policy applies
-   this_zone->disable_any = -1; // Default policy applies
-   this_zone->build_diffs = -1; // Default policy applies
+   conf_init_zone(this_zone); // Default policy applies
 
    // Append mising dot to ensure FQDN
    size_t nlen = strlen(name);
@@ -357,13 +351,6 @@ static void conf_zone_start(void *scanner, char *name) {
      *hattrie_get(new_config->names, (const char*)dn->name, dn->size) = (void *)1;
      ++new_config->zones_count;
      knot_dname_free(&dn);
-
-     /* Initialize ACL lists. */
-     init_list(&this_zone->acl.xfr_in);
-     init_list(&this_zone->acl.xfr_out);
-     init_list(&this_zone->acl.notify_in);
-     init_list(&this_zone->acl.notify_out);
-     init_list(&this_zone->acl.update_in);
    }
 }
 
@@ -411,10 +398,12 @@ static int conf_mask(void* scanner, int nval, int prefixlen) {
 
 %token <tok> ZONES FILENAME
 %token <tok> DISABLE_ANY
+%token <tok> PRERENDER_RDATA
 %token <tok> SEMANTIC_CHECKS
 %token <tok> NOTIFY_RETRIES
 %token <tok> NOTIFY_TIMEOUT
 %token <tok> DBSYNC_TIMEOUT
+%token <tok> DBSYNC_COMPACT
 %token <tok> IXFR_FSLIMIT
 %token <tok> XFR_IN
 %token <tok> XFR_OUT
@@ -422,6 +411,8 @@ static int conf_mask(void* scanner, int nval, int prefixlen) {
 %token <tok> NOTIFY_IN
 %token <tok> NOTIFY_OUT
 %token <tok> BUILD_DIFFS
+%token <tok> DNSSEC_ENABLE
+%token <tok> DNSSEC_KEYDIR
 %token <tok> MAX_CONN_IDLE
 %token <tok> MAX_CONN_HS
 %token <tok> MAX_CONN_REPLY
@@ -615,6 +606,7 @@ keys:
              k->k.name = dname;
              k->k.algorithm = $3.alg;
              knot_binary_from_base64($4.t, &(k->k.secret));
+             knot_tsig_key_prepare(&k->k);
 	     free($4.t);
              add_tail(&new_config->keys, &k->n);
              ++new_config->key_count;
@@ -849,10 +841,15 @@ zone:
  | zone zone_acl_start zone_acl_list
  | zone FILENAME TEXT ';' { this_zone->file = $3.t; }
  | zone BUILD_DIFFS BOOL ';' { this_zone->build_diffs = $3.i; }
+ | zone DNSSEC_ENABLE BOOL ';' { this_zone->dnssec_enable = $3.i; }
+ | zone DNSSEC_KEYDIR TEXT ';' { this_zone->dnssec_keydir = $3.t; }
  | zone SEMANTIC_CHECKS BOOL ';' { this_zone->enable_checks = $3.i; }
  | zone DISABLE_ANY BOOL ';' { this_zone->disable_any = $3.i; }
+ | zone PRERENDER_RDATA BOOL ';' { this_zone->prerender_rdata = $3.i; }
  | zone DBSYNC_TIMEOUT NUM ';' { this_zone->dbsync_timeout = $3.i; }
  | zone DBSYNC_TIMEOUT INTERVAL ';' { this_zone->dbsync_timeout = $3.i; }
+ | zone DBSYNC_COMPACT NUM ';' { this_zone->dbsync_compact = $3.i; }
+ | zone DBSYNC_COMPACT INTERVAL ';' { this_zone->dbsync_compact = $3.i; }
  | zone IXFR_FSLIMIT SIZE ';' { new_config->ixfr_fslimit = $3.l; }
  | zone IXFR_FSLIMIT NUM ';' { this_zone->ixfr_fslimit = $3.i; }
  | zone NOTIFY_RETRIES NUM ';' {
@@ -875,7 +872,10 @@ zones:
    ZONES '{'
  | zones zone '}'
  | zones DISABLE_ANY BOOL ';' { new_config->disable_any = $3.i; }
+ | zones PRERENDER_RDATA BOOL ';' { new_config->prerender_rdata = $3.i; }
  | zones BUILD_DIFFS BOOL ';' { new_config->build_diffs = $3.i; }
+ | zones DNSSEC_ENABLE BOOL ';' { new_config->dnssec_enable = $3.i; }
+ | zones DNSSEC_KEYDIR TEXT ';' { new_config->dnssec_keydir = $3.t; }
  | zones SEMANTIC_CHECKS BOOL ';' { new_config->zone_checks = $3.i; }
  | zones IXFR_FSLIMIT SIZE ';' { new_config->ixfr_fslimit = $3.l; }
  | zones IXFR_FSLIMIT NUM ';' { new_config->ixfr_fslimit = $3.i; }
@@ -901,6 +901,14 @@ zones:
        }
  }
  | zones DBSYNC_TIMEOUT INTERVAL ';' { new_config->dbsync_timeout = $3.i; }
+ | zones DBSYNC_COMPACT NUM ';' {
+	if ($3.i < 0) {
+	   cf_error(scanner, "zonefile compaction interval must not be negative");
+       } else {
+	   new_config->dbsync_compact = $3.i;
+       }
+ }
+ | zones DBSYNC_COMPACT INTERVAL ';' { new_config->dbsync_compact = $3.i; }
  ;
 
 log_prios_start: {
@@ -30,6 +30,7 @@
 #include "knot/conf/extra.h"
 #include "knot/common.h"
 #include "knot/ctl/remote.h"
+#include "common/getline.h"
 
 /*
  * Defaults.
@@ -133,6 +134,498 @@ static void conf_update_hooks(conf_t *conf)
 	}
 }
 
+/*! \brief Write data to the ACL fingerprint, only count if \a dst is NULL. */
+static size_t conf_acl_fp_put(uint8_t *dst, size_t pos, const void *data,
+                              size_t len)
+{
+	if (dst != NULL) {
+		memcpy(dst + pos, data, len);
+	}
+
+	return pos + len;
+}
+
+/*! \brief Write length-prefixed data to the ACL fingerprint. */
+static size_t conf_acl_fp_put_data(uint8_t *dst, size_t pos,
+                                   const void *data, size_t len)
+{
+	pos = conf_acl_fp_put(dst, pos, &len, sizeof(size_t));
+	return conf_acl_fp_put(dst, pos, data, len);
+}
+
+/*!
+ * \brief Write contents of the zone ACL remotes in order.
+ *
+ * \param zone Zone config.
+ * \param dst Destination buffer or NULL.
+ *
+ * \return Fingerprint size.
+ */
+static size_t conf_acl_fp_write(const conf_zone_t *zone, uint8_t *dst)
+{
+	const list *acls[] = {
+		&zone->acl.xfr_in, &zone->acl.xfr_out, &zone->acl.notify_in,
+		&zone->acl.notify_out, &zone->acl.update_in
+	};
+
+	size_t pos = 0;
+	uint8_t more = 1, end = 0;
+	for (size_t i = 0; i < sizeof(acls) / sizeof(list *); ++i) {
+		conf_remote_t *r = NULL;
+		WALK_LIST(r, *acls[i]) {
+			const conf_iface_t *rem = r->remote;
+			pos = conf_acl_fp_put(dst, pos, &more, 1);
+			pos = conf_acl_fp_put_data(dst, pos, rem->address,
+			            rem->address ? strlen(rem->address) : 0);
+			pos = conf_acl_fp_put(dst, pos, &rem->prefix,
+			                      sizeof(rem->prefix));
+			pos = conf_acl_fp_put(dst, pos, &rem->port,
+			                      sizeof(rem->port));
+			pos = conf_acl_fp_put(dst, pos, &rem->family,
+			                      sizeof(rem->family));
+			pos = conf_acl_fp_put_data(dst, pos, &rem->via,
+			                           rem->via.len);
+
+			const knot_tsig_key_t *key = rem->key;
+			if (key == NULL) {
+				pos = conf_acl_fp_put(dst, pos, &end, 1);
+				continue;
+			}
+			pos = conf_acl_fp_put(dst, pos, &more, 1);
+			pos = conf_acl_fp_put(dst, pos, &key->algorithm,
+			                      sizeof(key->algorithm));
+			pos = conf_acl_fp_put_data(dst, pos,
+			                           knot_dname_name(key->name),
+			                           knot_dname_size(key->name));
+			pos = conf_acl_fp_put_data(dst, pos, key->secret.data,
+			                           key->secret.size);
+		}
+
+		/* End of the ACL. */
+		pos = conf_acl_fp_put(dst, pos, &end, 1);
+	}
+
+	return pos;
+}
+
+/*!
+ * \brief Create fingerprint of the zone ACLs.
+ *
+ * Zone configs outlive the remotes they refer to (they are carried over on
+ * reload), so the ACLs are compared by the fingerprint instead.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_ENOMEM if out of memory.
+ */
+static int conf_acl_fp_create(conf_zone_t *zone)
+{
+	free(zone->acl_fp);
+	zone->acl_fp_len = conf_acl_fp_write(zone, NULL);
+	zone->acl_fp = malloc(zone->acl_fp_len);
+	if (zone->acl_fp == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	conf_acl_fp_write(zone, zone->acl_fp);
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Apply global defaults and create paths for zone config.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_ENOMEM if out of memory.
+ */
+static int conf_process_zone(const conf_t *conf, conf_zone_t *zone)
+{
+	// Default policy for dbsync timeout
+	if (zone->dbsync_timeout < 0) {
+		zone->dbsync_timeout = conf->dbsync_timeout;
+	}
+
+	// Default policy for zonefile compaction
+	if (zone->dbsync_compact < 0) {
+		zone->dbsync_compact = conf->dbsync_compact;
+	}
+
+	// Default policy for ixfr-from-differences
+	if (zone->build_diffs < 0) {
+		zone->build_diffs = conf->build_diffs;
+	}
+
+	// Default policy for DNSSEC signing
+	if (zone->dnssec_enable < 0) {
+		zone->dnssec_enable = conf->dnssec_enable;
+	}
+	if (zone->dnssec_keydir == NULL && conf->dnssec_keydir) {
+		zone->dnssec_keydir = strdup(conf->dnssec_keydir);
+		if (zone->dnssec_keydir == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	// Default policy for semantic checks
+	if (zone->enable_checks < 0) {
+		zone->enable_checks = conf->zone_checks;
+	}
+
+	// Default policy for disabling ANY type queries for AA
+	if (zone->disable_any < 0) {
+		zone->disable_any = conf->disable_any;
+	}
+
+	// Default policy for pre-rendered RDATA
+	if (zone->prerender_rdata < 0) {
+		zone->prerender_rdata = conf->prerender_rdata;
+	}
+
+	// Default policy for NOTIFY retries
+	if (zone->notify_retries <= 0) {
+		zone->notify_retries = conf->notify_retries;
+	}
+
+	// Default policy for NOTIFY timeout
+	if (zone->notify_timeout <= 0) {
+		zone->notify_timeout = conf->notify_timeout;
+	}
+
+	// Default policy for IXFR FSLIMIT
+	if (zone->ixfr_fslimit == 0) {
+		zone->ixfr_fslimit = conf->ixfr_fslimit;
+	}
+
+	// Default zone file
+	if (zone->file == NULL) {
+		zone->file = strcdup(zone->name, ".zone");
+		if (!zone->file) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	// Relative zone filenames should be relative to storage
+	if (zone->file[0] != '/') {
+		size_t prefix_len = strlen(conf->storage) + 1; // + '\0'
+		size_t zp_len = strlen(zone->file) + 1;
+		char *ap = malloc(prefix_len + zp_len);
+		if (ap != NULL) {
+			memcpy(ap, conf->storage, prefix_len);
+			ap[prefix_len - 1] = '/';
+			memcpy(ap + prefix_len, zone->file, zp_len);
+			free(zone->file);
+			zone->file = ap;
+		} else {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	// Normalize zone filename
+	zone->file = strcpath(zone->file);
+	if (zone->file == NULL) {
+		zone->db = NULL;
+		return KNOT_ENOMEM;
+	}
+
+	// Create zone db filename
+	size_t zname_len = strlen(zone->name);
+	size_t stor_len = strlen(conf->storage);
+	size_t size = stor_len + zname_len + 4; // /db,\0
+	char *dest = malloc(size);
+	if (dest == NULL) {
+		zone->db = NULL; /* Not enough memory. */
+		return KNOT_ENOMEM;
+	}
+	char *dpos = dest;
+
+	/* Since we have already allocd dest to accomodate
+	 * storage/zname length strcpy is safe. */
+	memcpy(dpos, conf->storage, stor_len + 1);
+	dpos += stor_len;
+	if (*(dpos - 1) != '/') {
+		*(dpos++) = '/';
+		*dpos = '\0';
+	}
+
+	/* Copy origin and remove bad characters. */
+	memcpy(dpos, zone->name, zname_len + 1);
+	for (int i = 0; i < zname_len; ++i) {
+		if (dpos[i] == '/') dpos[i] = '_';
+	}
+
+	memcpy(dpos + zname_len, "db", 3);
+	zone->db = dest;
+
+	// Create IXFR db filename
+	stor_len = strlen(conf->storage);
+	size = stor_len + zname_len + 9; // /diff.db,\0
+	dest = malloc(size);
+	if (dest == NULL) {
+		zone->ixfr_db = NULL; /* Not enough memory. */
+		return KNOT_ENOMEM;
+	}
+	dpos = dest;
+	memcpy(dpos, conf->storage, stor_len + 1);
+	dpos += stor_len;
+	if (conf->storage[stor_len - 1] != '/') {
+		*(dpos++) = '/';
+		*dpos = '\0';
+	}
+
+	const char *dbext = "diff.db";
+	memcpy(dpos, zone->name, zname_len + 1);
+	for (int i = 0; i < zname_len; ++i) {
+		if (dpos[i] == '/') dpos[i] = '_';
+	}
+	memcpy(dpos + zname_len, dbext, strlen(dbext) + 1);
+	zone->ixfr_db = dest;
+
+	// Fingerprint of the ACLs for comparison on reload
+	return conf_acl_fp_create(zone);
+}
+
+/*!
+ * \brief Create zone config with initial policy and FQDN name.
+ *
+ * \retval New zone config, global defaults are not applied yet.
+ * \retval NULL if out of memory.
+ */
+static conf_zone_t *conf_zone_create(const char *name)
+{
+	conf_zone_t *zone = malloc(sizeof(conf_zone_t));
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	/* Same initial policy as the zones from the config file. */
+	conf_init_zone(zone);
+
+	/* Append missing dot to ensure FQDN. */
+	size_t nlen = strlen(name);
+	zone->name = malloc(nlen + 2);
+	if (zone->name == NULL) {
+		free(zone);
+		return NULL;
+	}
+	memcpy(zone->name, name, nlen + 1);
+	if (name[nlen - 1] != '.') {
+		zone->name[nlen] = '.';
+		zone->name[nlen + 1] = '\0';
+	}
+
+	return zone;
+}
+
+/*! \brief Find or insert zone slot in the table by its lowercase name. */
+static value_t *conf_zone_slot(hattrie_t *table, const char *name)
+{
+	knot_dname_t *dn = knot_dname_new_from_str(name, strlen(name), NULL);
+	if (dn == NULL || knot_dname_to_lower(dn) != KNOT_EOK) {
+		knot_dname_free(&dn);
+		return NULL;
+	}
+
+	const char *key = (const char *)knot_dname_name(dn);
+	size_t len = knot_dname_size(dn);
+	value_t *val = hattrie_get(table, key, len);
+	knot_dname_free(&dn);
+	return val;
+}
+
+/*! \brief Free the last zone changes indexed by zone name. */
+static void conf_zones_state_free(hattrie_t *changes)
+{
+	hattrie_iter_t *it = hattrie_iter_begin(changes, false);
+	for (; it != NULL && !hattrie_iter_finished(it);
+	     hattrie_iter_next(it)) {
+		free(*hattrie_iter_val(it));
+	}
+	hattrie_iter_free(it);
+	hattrie_free(changes);
+}
+
+/*!
+ * \brief Rewrite the zone state file with the given changes.
+ *
+ * The changes are written to a temporary file which replaces the zone
+ * state file, so the file is never left half-written. The file keeps its
+ * owner and permissions.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_ENOMEM if out of memory.
+ * \retval KNOT_ERROR if the file can't be written.
+ */
+static int conf_zones_state_write(const char *path, hattrie_t *changes)
+{
+	struct stat st;
+	if (stat(path, &st) < 0) {
+		return KNOT_ERROR;
+	}
+
+	char *tmp = strcdup(path, ".XXXXXX");
+	if (tmp == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int fd = mkstemp(tmp);
+	if (fd < 0) {
+		free(tmp);
+		return KNOT_ERROR;
+	}
+
+	FILE *fp = NULL;
+	if (fchown(fd, st.st_uid, st.st_gid) == 0 &&
+	    fchmod(fd, st.st_mode & 07777) == 0) {
+		fp = fdopen(fd, "w");
+	}
+	if (fp == NULL) {
+		close(fd);
+		unlink(tmp);
+		free(tmp);
+		return KNOT_ERROR;
+	}
+
+	int ret = KNOT_EOK;
+	hattrie_iter_t *it = hattrie_iter_begin(changes, true);
+	if (it == NULL) {
+		ret = KNOT_ENOMEM;
+	}
+	for (; it != NULL && !hattrie_iter_finished(it);
+	     hattrie_iter_next(it)) {
+		const char *change = (const char *)*hattrie_iter_val(it);
+		if (fprintf(fp, "%s\n", change) < 0) {
+			ret = KNOT_ERROR;
+			break;
+		}
+	}
+	hattrie_iter_free(it);
+
+	if (fclose(fp) != 0 && ret == KNOT_EOK) {
+		ret = KNOT_ERROR;
+	}
+	if (ret == KNOT_EOK && rename(tmp, path) < 0) {
+		ret = KNOT_ERROR;
+	}
+	if (ret != KNOT_EOK) {
+		unlink(tmp);
+	}
+
+	free(tmp);
+	return ret;
+}
+
+/*!
+ * \brief Apply zones added or removed at runtime to the configured zones.
+ *
+ * Each line of the zone state file holds a zone name prefixed with the
+ * change (see conf_zone_state_t), later changes of a zone take precedence.
+ * Added zones get the default settings, zones already configured are kept
+ * with their settings. The file is compacted to the last change of each
+ * zone afterwards.
+ *
+ * \retval KNOT_EOK on success or if there is no zone state file.
+ * \retval KNOT_ENOMEM if out of memory.
+ */
+static int conf_process_zones_state(conf_t *conf)
+{
+	char *path = strcdup(conf->storage, "/" CONFIG_ZONES_STATE);
+	if (path == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL) {
+		free(path);
+		return KNOT_EOK; /* No changes at runtime. */
+	}
+
+	/* Index configured zones by name, keep the last change of each. */
+	hattrie_t *zones = hattrie_create();
+	hattrie_t *changes = hattrie_create();
+	if (zones == NULL || changes == NULL) {
+		hattrie_free(zones);
+		hattrie_free(changes);
+		fclose(fp);
+		free(path);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	conf_zone_t *zone = NULL;
+	WALK_LIST(zone, conf->zones) {
+		value_t *val = conf_zone_slot(zones, zone->name);
+		if (val != NULL) {
+			*val = zone;
+		}
+	}
+
+	char *line = NULL;
+	size_t line_len = 0;
+	ssize_t read = 0;
+	size_t lines = 0;
+	while ((read = knot_getline(&line, &line_len, fp)) != -1) {
+		/* Strip line break, skip malformed lines. */
+		++lines;
+		if (read > 0 && line[read - 1] == '\n') {
+			line[--read] = '\0';
+		}
+		if (read < 2) {
+			continue;
+		}
+
+		const char *name = line + 1;
+		value_t *val = conf_zone_slot(zones, name);
+		if (val == NULL) {
+			log_server_warning("Invalid zone '%s' in zone state "
+			                   "file.\n", name);
+			continue;
+		}
+
+		value_t *last = conf_zone_slot(changes, name);
+		if (last == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
+		}
+		free(*last);
+		*last = strdup(line);
+		if (*last == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
+		}
+
+		zone = (conf_zone_t *)*val;
+		if (line[0] == CONF_ZONE_ADDED && zone == NULL) {
+			zone = conf_zone_create(name);
+			if (zone == NULL) {
+				ret = KNOT_ENOMEM;
+				break;
+			}
+			add_tail(&conf->zones, &zone->n);
+			++conf->zones_count;
+			*val = zone;
+		} else if (line[0] == CONF_ZONE_REMOVED && zone != NULL) {
+			rem_node(&zone->n);
+			conf_free_zone(zone);
+			--conf->zones_count;
+			*val = NULL;
+		}
+	}
+
+	free(line);
+	fclose(fp);
+	hattrie_free(zones);
+
+	/* Drop superseded changes, failure only keeps the file as it is. */
+	if (ret == KNOT_EOK && hattrie_weight(changes) < lines) {
+		if (conf_zones_state_write(path, changes) != KNOT_EOK) {
+			log_server_warning("Failed to compact zone state file "
+			                   "'%s'.\n", path);
+		}
+	}
+
+	conf_zones_state_free(changes);
+	free(path);
+	return ret;
+}
+
 /*!
  * \brief Process parsed configuration.
  *
@@ -210,135 +703,19 @@ static int conf_process(conf_t *conf)
 	/* Default parallel transfers. */
 	if (conf->xfers <= 0) conf->xfers = CONFIG_XFERS;
 
+	// Zones added or removed at runtime
+	int ret = conf_process_zones_state(conf);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
 	// Postprocess zones
-	int ret = KNOT_EOK;
 	node *n = 0;
 	WALK_LIST (n, conf->zones) {
-		conf_zone_t *zone = (conf_zone_t*)n;
-
-		// Default policy for dbsync timeout
-		if (zone->dbsync_timeout < 0) {
-			zone->dbsync_timeout = conf->dbsync_timeout;
-		}
-
-		// Default policy for ixfr-from-differences
-		if (zone->build_diffs < 0) {
-			zone->build_diffs = conf->build_diffs;
-		}
-
-		// Default policy for semantic checks
-		if (zone->enable_checks < 0) {
-			zone->enable_checks = conf->zone_checks;
-		}
-
-		// Default policy for disabling ANY type queries for AA
-		if (zone->disable_any < 0) {
-			zone->disable_any = conf->disable_any;
+		int zret = conf_process_zone(conf, (conf_zone_t *)n);
+		if (zret != KNOT_EOK) {
+			ret = zret;
 		}
-
-		// Default policy for NOTIFY retries
-		if (zone->notify_retries <= 0) {
-			zone->notify_retries = conf->notify_retries;
-		}
-
-		// Default policy for NOTIFY timeout
-		if (zone->notify_timeout <= 0) {
-			zone->notify_timeout = conf->notify_timeout;
-		}
-
-		// Default policy for IXFR FSLIMIT
-		if (zone->ixfr_fslimit == 0) {
-			zone->ixfr_fslimit = conf->ixfr_fslimit;
-		}
-
-		// Default zone file
-		if (zone->file == NULL) {
-			zone->file = strcdup(zone->name, ".zone");
-			if (!zone->file) {
-				ret = KNOT_ENOMEM;
-				continue;
-			}
-		}
-
-		// Relative zone filenames should be relative to storage
-		if (zone->file[0] != '/') {
-			size_t prefix_len = strlen(conf->storage) + 1; // + '\0'
-			size_t zp_len = strlen(zone->file) + 1;
-			char *ap = malloc(prefix_len + zp_len);
-			if (ap != NULL) {
-				memcpy(ap, conf->storage, prefix_len);
-				ap[prefix_len - 1] = '/';
-				memcpy(ap + prefix_len, zone->file, zp_len);
-				free(zone->file);
-				zone->file = ap;
-			} else {
-				ret = KNOT_ENOMEM;
-				continue;
-			}
-		}
-
-		// Normalize zone filename
-		zone->file = strcpath(zone->file);
-		if (zone->file == NULL) {
-			zone->db = NULL;
-			ret = KNOT_ENOMEM;
-			continue;
-		}
-
-		// Create zone db filename
-		size_t zname_len = strlen(zone->name);
-		size_t stor_len = strlen(conf->storage);
-		size_t size = stor_len + zname_len + 4; // /db,\0
-		char *dest = malloc(size);
-		if (dest == NULL) {
-			zone->db = NULL; /* Not enough memory. */
-			ret = KNOT_ENOMEM; /* Error report. */
-			continue;
-		}
-		char *dpos = dest;
-
-		/* Since we have already allocd dest to accomodate
-		 * storage/zname length strcpy is safe. */
-		memcpy(dpos, conf->storage, stor_len + 1);
-		dpos += stor_len;
-		if (*(dpos - 1) != '/') {
-			*(dpos++) = '/';
-			*dpos = '\0';
-		}
-
-		/* Copy origin and remove bad characters. */
-		memcpy(dpos, zone->name, zname_len + 1);
-		for (int i = 0; i < zname_len; ++i) {
-			if (dpos[i] == '/') dpos[i] = '_';
-		}
-
-		memcpy(dpos + zname_len, "db", 3);
-		zone->db = dest;
-
-		// Create IXFR db filename
-		stor_len = strlen(conf->storage);
-		size = stor_len + zname_len + 9; // /diff.db,\0
-		dest = malloc(size);
-		if (dest == NULL) {
-			zone->ixfr_db = NULL; /* Not enough memory. */
-			ret = KNOT_ENOMEM; /* Error report. */
-			continue;
-		}
-		dpos = dest;
-		memcpy(dpos, conf->storage, stor_len + 1);
-		dpos += stor_len;
-		if (conf->storage[stor_len - 1] != '/') {
-			*(dpos++) = '/';
-			*dpos = '\0';
-		}
-
-		const char *dbext = "diff.db";
-		memcpy(dpos, zone->name, zname_len + 1);
-		for (int i = 0; i < zname_len; ++i) {
-			if (dpos[i] == '/') dpos[i] = '_';
-		}
-		memcpy(dpos + zname_len, dbext, strlen(dbext) + 1);
-		zone->ixfr_db = dest;
 	}
 
 	/* Update UID and GID. */
@@ -529,12 +906,14 @@ conf_t *conf_new(const char* path)
 	c->notify_retries = CONFIG_NOTIFY_RETRIES;
 	c->notify_timeout = CONFIG_NOTIFY_TIMEOUT;
 	c->dbsync_timeout = CONFIG_DBSYNC_TIMEOUT;
+	c->dbsync_compact = CONFIG_DBSYNC_COMPACT;
 	c->ixfr_fslimit = -1;
 	c->uid = -1;
 	c->gid = -1;
 	c->xfers = -1;
 	c->rrl_slip = -1;
 	c->build_diffs = 0; /* Disable by default. */
+	c->dnssec_enable = 0; /* Disable by default. */
 
 	/* ACLs. */
 	c->ctl.acl = acl_new(ACL_DENY, "remote_ctl");
@@ -690,6 +1069,10 @@ void conf_truncate(conf_t *conf, int unload_hooks)
 		free(conf->nsid);
 		conf->nsid = 0;
 	}
+	if (conf->dnssec_keydir) {
+		free(conf->dnssec_keydir);
+		conf->dnssec_keydir = 0;
+	}
 
 	/* Free remote control list. */
 	WALK_LIST_DELSAFE(n, nxt, conf->ctl.allow) {
@@ -868,6 +1251,112 @@ char* strcpath(char *path)
 	return path;
 }
 
+/*! \brief Compare optional strings. */
+static int conf_str_equal(const char *s1, const char *s2)
+{
+	if (s1 == NULL || s2 == NULL) {
+		return s1 == s2;
+	}
+
+	return strcmp(s1, s2) == 0;
+}
+
+int conf_zone_equal(const conf_zone_t *z1, const conf_zone_t *z2)
+{
+	if (z1 == NULL || z2 == NULL) {
+		return z1 == z2;
+	}
+
+	return conf_str_equal(z1->name, z2->name) &&
+	       z1->cls == z2->cls &&
+	       conf_str_equal(z1->file, z2->file) &&
+	       conf_str_equal(z1->db, z2->db) &&
+	       conf_str_equal(z1->ixfr_db, z2->ixfr_db) &&
+	       z1->ixfr_fslimit == z2->ixfr_fslimit &&
+	       z1->dbsync_timeout == z2->dbsync_timeout &&
+	       z1->dbsync_compact == z2->dbsync_compact &&
+	       z1->enable_checks == z2->enable_checks &&
+	       z1->disable_any == z2->disable_any &&
+	       z1->prerender_rdata == z2->prerender_rdata &&
+	       z1->notify_retries == z2->notify_retries &&
+	       z1->notify_timeout == z2->notify_timeout &&
+	       z1->build_diffs == z2->build_diffs &&
+	       z1->dnssec_enable == z2->dnssec_enable &&
+	       conf_str_equal(z1->dnssec_keydir, z2->dnssec_keydir) &&
+	       z1->acl_fp_len == z2->acl_fp_len &&
+	       memcmp(z1->acl_fp, z2->acl_fp, z1->acl_fp_len) == 0;
+}
+
+void conf_init_zone(conf_zone_t *zone)
+{
+	memset(zone, 0, sizeof(conf_zone_t));
+	zone->enable_checks = -1; // Default policy applies
+	zone->notify_timeout = -1; // Default policy applies
+	zone->notify_retries = 0; // Default policy applies
+	zone->ixfr_fslimit = -1; // Default policy applies
+	zone->dbsync_timeout = -1; // Default policy applies
+	zone->dbsync_compact = -1; // Default policy applies
+	zone->disable_any = -1; // Default policy applies
+	zone->prerender_rdata = -1; // Default policy applies
+	zone->build_diffs = -1; // Default policy applies
+	zone->dnssec_enable = -1; // Default policy applies
+
+	init_list(&zone->acl.xfr_in);
+	init_list(&zone->acl.xfr_out);
+	init_list(&zone->acl.notify_in);
+	init_list(&zone->acl.notify_out);
+	init_list(&zone->acl.update_in);
+}
+
+conf_zone_t *conf_zone_new(const conf_t *conf, const char *name)
+{
+	if (conf == NULL || name == NULL || *name == '\0') {
+		return NULL;
+	}
+
+	conf_zone_t *zone = conf_zone_create(name);
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	if (conf_process_zone(conf, zone) != KNOT_EOK) {
+		conf_free_zone(zone);
+		return NULL;
+	}
+
+	return zone;
+}
+
+int conf_zone_state_save(const conf_t *conf, const char *name,
+                         conf_zone_state_t state)
+{
+	if (conf == NULL || name == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	char *path = strcdup(conf->storage, "/" CONFIG_ZONES_STATE);
+	if (path == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	/* Changes are appended, the last one of a zone applies. */
+	FILE *fp = fopen(path, "a");
+	free(path);
+	if (fp == NULL) {
+		return knot_map_errno(EACCES, ENOENT);
+	}
+
+	int ret = KNOT_EOK;
+	if (fprintf(fp, "%c%s\n", (char)state, name) < 0) {
+		ret = KNOT_ERROR;
+	}
+	if (fclose(fp) != 0) {
+		ret = KNOT_ERROR;
+	}
+
+	return ret;
+}
+
 void conf_free_zone(conf_zone_t *zone)
 {
 	if (!zone) {
@@ -885,6 +1374,8 @@ void conf_free_zone(conf_zone_t *zone)
 	free(zone->file);
 	free(zone->db);
 	free(zone->ixfr_db);
+	free(zone->dnssec_keydir);
+	free(zone->acl_fp);
 	free(zone);
 }
 
@@ -47,12 +47,25 @@
 #define CONFIG_NOTIFY_RETRIES 5  /*!< 5 retries (suggested in RFC1996) */
 #define CONFIG_NOTIFY_TIMEOUT 60 /*!< 60s (suggested in RFC1996) */
 #define CONFIG_DBSYNC_TIMEOUT (60*60) /*!< 1 hour. */
+#define CONFIG_DBSYNC_COMPACT 0 /*!< Rewrite zonefile on each sync. */
 #define CONFIG_REPLY_WD 10 /*!< SOA/NOTIFY query timeout [s]. */
 #define CONFIG_HANDSHAKE_WD 10 /*!< [secs] for connection to make a request.*/
 #define CONFIG_IDLE_WD  60 /*!< [secs] of allowed inactivity between requests */
 #define CONFIG_RRL_SLIP 2 /*!< Default slip value. */
 #define CONFIG_RRL_SIZE 393241 /*!< Htable default size. */
 #define CONFIG_XFERS 10
+#define CONFIG_ZONES_STATE "zones.state" /*!< Zones changed at runtime. */
+
+/*!
+ * \brief Zone changes made at runtime.
+ *
+ * Changes are recorded in the zone state file in the storage directory,
+ * one zone per line prefixed with the change character.
+ */
+typedef enum conf_zone_state_t {
+	CONF_ZONE_ADDED   = '+', /*!< Zone added with default settings. */
+	CONF_ZONE_REMOVED = '-'  /*!< Zone removed. */
+} conf_zone_state_t;
 
 /*!
  * \brief Configuration for the interface
@@ -119,11 +132,15 @@ typedef struct conf_zone_t {
 	char *ixfr_db;            /*!< Path to a IXFR database file. */
 	size_t ixfr_fslimit;      /*!< File size limit for IXFR journal. */
 	int dbsync_timeout;       /*!< Interval between syncing to zonefile.*/
+	int dbsync_compact;       /*!< Interval between zonefile rewrites. */
 	int enable_checks;        /*!< Semantic checks for parser.*/
 	int disable_any;          /*!< Disable ANY type queries for AA.*/
+	int prerender_rdata;      /*!< Keep RDATA in wire format. */
 	int notify_retries;       /*!< NOTIFY query retries. */
 	int notify_timeout;       /*!< Timeout for NOTIFY response (s). */
 	int build_diffs;          /*!< Calculate differences from changes. */
+	int dnssec_enable;        /*!< Sign the zone on load. */
+	char *dnssec_keydir;      /*!< Directory with zone signing keys. */
 	struct {
 		list xfr_in;      /*!< Remotes accepted for for xfr-in.*/
 		list xfr_out;     /*!< Remotes accepted for xfr-out.*/
@@ -131,6 +148,8 @@ typedef struct conf_zone_t {
 		list notify_out;  /*!< Remotes accepted for notify-out.*/
 		list update_in;   /*!< Remotes accepted for DDNS.*/
 	} acl;
+	uint8_t *acl_fp;          /*!< Fingerprint of the ACL remotes. */
+	size_t acl_fp_len;        /*!< ACL fingerprint length. */
 } conf_zone_t;
 
 /*!
@@ -244,11 +263,15 @@ typedef struct conf_t {
 	int zones_count;  /*!< Count of zones. */
 	int zone_checks;  /*!< Semantic checks for parser.*/
 	int disable_any;  /*!< Disable ANY type queries for AA.*/
+	int prerender_rdata; /*!< Keep RDATA of zones in wire format. */
 	int notify_retries; /*!< NOTIFY query retries. */
 	int notify_timeout; /*!< Timeout for NOTIFY response in seconds. */
 	int dbsync_timeout; /*!< Default interval between syncing to zonefile.*/
+	int dbsync_compact; /*!< Default interval between zonefile rewrites. */
 	size_t ixfr_fslimit; /*!< File size limit for IXFR journal. */
 	int build_diffs;     /*!< Calculate differences from changes. */
+	int dnssec_enable;   /*!< Sign zones on load. */
+	char *dnssec_keydir; /*!< Default directory with signing keys. */
 	hattrie_t *names; /*!< Zone tree for duplicate checking. */
 
 	/*
@@ -394,6 +417,65 @@ static inline conf_t* conf() {
  */
 char* strcpath(char *path);
 
+/*!
+ * \brief Compare two zone configurations.
+ *
+ * Zones are equal if all their settings match, remotes in the ACLs are
+ * compared by their contents and order (using the ACL fingerprints, the
+ * remotes themselves may already be freed).
+ *
+ * \retval 1 if the configurations are equal.
+ * \retval 0 otherwise.
+ */
+int conf_zone_equal(const conf_zone_t *z1, const conf_zone_t *z2);
+
+/*!
+ * \brief Initialize zone config with the initial policy.
+ *
+ * Settings are left for the global defaults, which are applied when the
+ * configuration is processed. ACL lists are empty.
+ *
+ * \param zone Zone config to initialize.
+ */
+void conf_init_zone(conf_zone_t *zone);
+
+/*!
+ * \brief Create zone config with default settings.
+ *
+ * Global defaults of the given configuration are applied and the zone file
+ * is expected in the storage directory, as for a zone configured only by
+ * its name.
+ *
+ * \param conf Configuration providing the defaults.
+ * \param name Zone name.
+ *
+ * \retval New zone config (must be freed with conf_free_zone()).
+ * \retval NULL on error.
+ */
+conf_zone_t *conf_zone_new(const conf_t *conf, const char *name);
+
+/*!
+ * \brief Record zone added or removed at runtime.
+ *
+ * The change is appended to the zone state file in the storage directory.
+ * The file is applied to the configured zones and compacted to the last
+ * change of each zone when the configuration is opened, so the change
+ * persists across reloads and restarts. Remove the file to return to the
+ * zones in the configuration file.
+ *
+ * \param conf Configuration with the storage directory.
+ * \param name Zone name.
+ * \param state Zone change.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_EINVAL on invalid parameters.
+ * \retval KNOT_ENOMEM if out of memory.
+ * \retval KNOT_EACCES, KNOT_ENOENT if the file can't be opened.
+ * \retval KNOT_ERROR if the change can't be written.
+ */
+int conf_zone_state_save(const conf_t *conf, const char *name,
+                         conf_zone_state_t state);
+
 /*! \brief Free zone config. */
 void conf_free_zone(conf_zone_t *zone);
 
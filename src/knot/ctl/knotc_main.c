@@ -22,6 +22,7 @@
 #include <time.h>
 #include <getopt.h>
 #include <ctype.h>
+#include <signal.h>
 #ifdef HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
@@ -90,6 +91,8 @@ static int cmd_refresh(int argc, char *argv[], unsigned flags);
 static int cmd_flush(int argc, char *argv[], unsigned flags);
 static int cmd_status(int argc, char *argv[], unsigned flags);
 static int cmd_zonestatus(int argc, char *argv[], unsigned flags);
+static int cmd_zone_add(int argc, char *argv[], unsigned flags);
+static int cmd_zone_remove(int argc, char *argv[], unsigned flags);
 static int cmd_checkconf(int argc, char *argv[], unsigned flags);
 static int cmd_checkzone(int argc, char *argv[], unsigned flags);
 
@@ -103,6 +106,8 @@ knot_cmd_t knot_cmd_tbl[] = {
 	{&cmd_flush,      0, "flush",      "",       "\t\tFlush journal and update zone files."},
 	{&cmd_status,     0, "status",     "",       "\tCheck if server is running."},
 	{&cmd_zonestatus, 0, "zonestatus", "",       "\tShow status of configured zones."},
+	{&cmd_zone_add,   0, "zone-add",   "<zone>...", "Add zones without reloading configuration."},
+	{&cmd_zone_remove,0, "zone-remove","<zone>...", "Remove zones without reloading configuration."},
 	{&cmd_checkconf,  1, "checkconf",  "",       "\tCheck current server configuration."},
 	{&cmd_checkzone,  1, "checkzone",  "[zone]", "Check zone (all if not specified)."},
 	{NULL, 0, NULL, NULL, NULL}
@@ -761,6 +766,26 @@ static int cmd_zonestatus(int argc, char *argv[], unsigned flags)
 	return cmd_remote("zonestatus", KNOT_RRTYPE_TXT, 0, NULL);
 }
 
+static int cmd_zone_add(int argc, char *argv[], unsigned flags)
+{
+	if (argc < 1) {
+		log_server_error("No zone specified for 'zone-add'.\n");
+		return 1;
+	}
+
+	return cmd_remote("zone-add", KNOT_RRTYPE_NS, argc, argv);
+}
+
+static int cmd_zone_remove(int argc, char *argv[], unsigned flags)
+{
+	if (argc < 1) {
+		log_server_error("No zone specified for 'zone-remove'.\n");
+		return 1;
+	}
+
+	return cmd_remote("zone-remove", KNOT_RRTYPE_NS, argc, argv);
+}
+
 static int cmd_checkconf(int argc, char *argv[], unsigned flags)
 {
 	/* Check config. */
@@ -775,12 +800,25 @@ static int cmd_checkconf(int argc, char *argv[], unsigned flags)
 	return 0;
 }
 
+/*! \brief Empty handler, checking threads are stopped with SIGALRM. */
+static void checkzone_interrupt(int s)
+{
+}
+
 static int cmd_checkzone(int argc, char *argv[], unsigned flags)
 {
 	/* Zone checking */
 	int rc = 0;
 	node *n = 0;
 
+	/* Semantic checks run in threads, do not terminate on wakeup. */
+	struct sigaction emptyset;
+	memset(&emptyset, 0, sizeof(struct sigaction));
+	emptyset.sa_handler = checkzone_interrupt;
+	sigemptyset(&emptyset.sa_mask);
+	emptyset.sa_flags = 0;
+	sigaction(SIGALRM, &emptyset, NULL);
+
 	/* Generate databases for all zones */
 	WALK_LIST(n, conf()->zones) {
 		/* Fetch zone */
@@ -63,6 +63,8 @@ static int remote_c_refresh(server_t *s, remote_cmdargs_t* a);
 static int remote_c_status(server_t *s, remote_cmdargs_t* a);
 static int remote_c_zonestatus(server_t *s, remote_cmdargs_t* a);
 static int remote_c_flush(server_t *s, remote_cmdargs_t* a);
+static int remote_c_zone_add(server_t *s, remote_cmdargs_t* a);
+static int remote_c_zone_remove(server_t *s, remote_cmdargs_t* a);
 
 /*! \brief Table of remote commands. */
 struct remote_cmd_t remote_cmd_tbl[] = {
@@ -71,6 +73,8 @@ struct remote_cmd_t remote_cmd_tbl[] = {
 	{ "status",    &remote_c_status },
 	{ "zonestatus",&remote_c_zonestatus },
 	{ "flush",     &remote_c_flush },
+	{ "zone-add",  &remote_c_zone_add },
+	{ "zone-remove",&remote_c_zone_remove },
 	{ NULL,        NULL }
 };
 
@@ -111,6 +115,49 @@ static int remote_rdata_apply(server_t *s, remote_cmdargs_t* a, remote_zonef_t *
 	return ret;
 }
 
+/*!
+ * \brief Collect zone names from RDATA of NS RRs.
+ *
+ * \note Names point to the query RRs, caller frees only the array.
+ *
+ * \return Array of names, NULL if there are none (count is 0) or if out of
+ *         memory.
+ */
+static const knot_dname_t **remote_rdata_names(remote_cmdargs_t* a,
+                                               size_t *count)
+{
+	size_t total = 0;
+	for (unsigned i = 0; i < a->argc; ++i) {
+		if (knot_rrset_type(a->arg[i]) == KNOT_RRTYPE_NS) {
+			total += knot_rrset_rdata_rr_count(a->arg[i]);
+		}
+	}
+
+	*count = total;
+	if (total == 0) {
+		return NULL;
+	}
+
+	const knot_dname_t **names = malloc(total * sizeof(knot_dname_t *));
+	if (names == NULL) {
+		return NULL;
+	}
+
+	size_t n = 0;
+	for (unsigned i = 0; i < a->argc; ++i) {
+		const knot_rrset_t *rr = a->arg[i];
+		if (knot_rrset_type(rr) != KNOT_RRTYPE_NS) {
+			continue;
+		}
+
+		for (uint16_t j = 0; j < knot_rrset_rdata_rr_count(rr); j++) {
+			names[n++] = knot_rrset_rdata_ns_name(rr, j);
+		}
+	}
+
+	return names;
+}
+
 /*! \brief Zone refresh callback. */
 static int remote_zone_refresh(server_t *s, const knot_zone_t *z)
 {
@@ -246,12 +293,23 @@ static int remote_c_zonestatus(server_t *s, remote_cmdargs_t* a)
 			when = strdup("idle");
 		}
 
+		/* NSEC3 hash cache hit rate. */
+		char nsec3[64] = { '\0' };
+		const knot_nsec3_cache_t *cache =
+			knot_zone_contents_nsec3_cache(contents);
+		if (cache != NULL) {
+			unsigned hits = 0, misses = 0;
+			knot_nsec3_cache_stats(cache, &hits, &misses);
+			snprintf(nsec3, sizeof(nsec3), " | nsec3 hits=%u misses=%u",
+			         hits, misses);
+		}
+
 		/* Workaround, some platforms ignore 'size' with snprintf() */
 		char buf[256];
-		int n = snprintf(buf, sizeof(buf), "%s\ttype=%s | serial=%u | %s %s\n",
+		int n = snprintf(buf, sizeof(buf), "%s\ttype=%s | serial=%u%s | %s %s\n",
 		                 zd->conf->name,
 		                 zd->xfr_in.has_master ? "slave" : "master",
-		                 serial,
+		                 serial, nsec3,
 		                 state ? state : "",
 		                 when ? when : "");
 		free(when);
@@ -323,6 +381,85 @@ static int remote_c_flush(server_t *s, remote_cmdargs_t* a)
 	return remote_rdata_apply(s, a, &remote_zone_flush);
 }
 
+/*!
+ * \brief Remote command 'zone-add' handler.
+ *
+ * Zones are loaded from '<zone>.zone' in the storage directory, with
+ * default settings from the configuration.
+ *
+ * QNAME: zone-add
+ * DATA: NS RRs with zones in RDATA
+ */
+static int remote_c_zone_add(server_t *s, remote_cmdargs_t* a)
+{
+	dbg_server("remote: %s\n", __func__);
+	size_t count = 0;
+	const knot_dname_t **names = remote_rdata_names(a, &count);
+	if (names == NULL) {
+		return count == 0 ? KNOT_EINVAL : KNOT_ENOMEM;
+	}
+
+	/* Create zone configs. */
+	list zone_conf;
+	init_list(&zone_conf);
+	int ret = KNOT_EOK;
+	for (size_t i = 0; i < count; ++i) {
+		char *name = knot_dname_to_str(names[i]);
+		conf_zone_t *z = conf_zone_new(conf(), name);
+		free(name);
+		if (z == NULL) {
+			ret = KNOT_ENOMEM;
+			break;
+		}
+		add_tail(&zone_conf, &z->n);
+	}
+	free(names);
+
+	if (ret != KNOT_EOK) {
+		conf_zone_t *z = NULL, *nxt = NULL;
+		WALK_LIST_DELSAFE(z, nxt, zone_conf) {
+			conf_free_zone(z);
+		}
+		return ret;
+	}
+
+	ret = zones_db_add(conf(), s->nameserver, &zone_conf);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* Failed zones are logged by the server. */
+	a->rlen = snprintf(a->resp, sizeof(a->resp), "Added %d of %zu zones.",
+	                   ret, count);
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Remote command 'zone-remove' handler.
+ *
+ * QNAME: zone-remove
+ * DATA: NS RRs with zones in RDATA
+ */
+static int remote_c_zone_remove(server_t *s, remote_cmdargs_t* a)
+{
+	dbg_server("remote: %s\n", __func__);
+	size_t count = 0;
+	const knot_dname_t **names = remote_rdata_names(a, &count);
+	if (names == NULL) {
+		return count == 0 ? KNOT_EINVAL : KNOT_ENOMEM;
+	}
+
+	int ret = zones_db_remove(conf(), s->nameserver, names, count);
+	free(names);
+	if (ret < 0) {
+		return ret;
+	}
+
+	a->rlen = snprintf(a->resp, sizeof(a->resp),
+	                   "Removed %d of %zu zones.", ret, count);
+	return KNOT_EOK;
+}
+
 /*!
  * \brief Prepare and send error response.
  * \param c Client fd.
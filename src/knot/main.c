@@ -159,6 +159,11 @@ int main(int argc, char **argv)
 		log_levels_add(LOGT_STDOUT, LOG_ANY, mask);
 	}
 
+	// Write log from a separate thread (after daemonizing)
+	if (log_async_start() != KNOT_EOK) {
+		log_server_warning("Couldn't start asynchronous logging.\n");
+	}
+
 	// Initialize pseudorandom number generator
 	srand(time(0));
 
@@ -897,6 +897,21 @@ int journal_update(journal_t *journal, journal_node_t *n)
 	return KNOT_EOK;
 }
 
+int journal_sync(journal_t *journal)
+{
+	if (journal == NULL || journal->fd < 0) {
+		return KNOT_EINVAL;
+	}
+
+	if (fsync(journal->fd) != 0) {
+		dbg_journal("journal: failed to sync fd=%d %d\n",
+		            journal->fd, errno);
+		return KNOT_ERROR;
+	}
+
+	return KNOT_EOK;
+}
+
 int journal_trans_begin(journal_t *journal)
 {
 	if (journal == NULL) {
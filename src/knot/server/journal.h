@@ -293,6 +293,17 @@ int journal_walk(journal_t *journal, journal_apply_t apply);
  */
 int journal_update(journal_t *journal, journal_node_t *n);
 
+/*!
+ * \brief Flush journal entries and node states to permanent storage.
+ *
+ * \param journal Associated journal.
+ *
+ * \retval KNOT_EOK on success.
+ * \retval KNOT_EINVAL on invalid parameters.
+ * \retval KNOT_ERROR if the data couldn't be flushed.
+ */
+int journal_sync(journal_t *journal);
+
 /*!
  * \brief Begin transaction of multiple entries.
  *
@@ -97,7 +97,9 @@ static void xfr_task_set(xfrworker_t *w, int fd, knot_ns_xfr_t *rq)
 {
 	fdset_add(w->pool.fds, fd, OS_EV_READ);
 	value_t *val = ahtable_get(w->pool.t, (const char*)&fd, sizeof(int));
-	*val = rq;
+	if (val != NULL) {
+		*val = rq;
+	}
 }
 
 static void xfr_task_clear(xfrworker_t *w, int fd)
@@ -279,8 +281,9 @@ static void xfr_task_cleanup(knot_ns_xfr_t *rq)
 			knot_zone_contents_deep_free(&rq->new_contents);
 		} else if (rq->data) {
 			xfrin_constructed_zone_t *constr_zone = rq->data;
-			knot_zone_contents_deep_free(&(constr_zone->contents));
+			/* Orphans may be allocated from zone arena. */
 			xfrin_free_orphan_rrsigs(&(constr_zone->rrsigs));
+			knot_zone_contents_deep_free(&(constr_zone->contents));
 			free(rq->data);
 			rq->data = NULL;
 		}
@@ -519,6 +522,10 @@ static int xfr_task_finalize(xfrworker_t *w, knot_ns_xfr_t *rq)
 	int ret = KNOT_EINVAL;
 	knot_nameserver_t *ns = w->master->ns;
 
+	/* Transfer replaces contents, other updates of the zone must wait. */
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(rq->zone);
+	pthread_mutex_lock(&zd->update_lock);
+
 	if (rq->type == XFR_TYPE_AIN) {
 		ret = zones_save_zone(rq);
 		if (ret == KNOT_EOK) {
@@ -543,6 +550,8 @@ static int xfr_task_finalize(xfrworker_t *w, knot_ns_xfr_t *rq)
 		rq->data = NULL; /* Freed or applied in prev function. */
 	}
 
+	pthread_mutex_unlock(&zd->update_lock);
+
 	if (ret == KNOT_EOK) {
 		struct timeval t_end;
 		gettimeofday(&t_end, NULL);
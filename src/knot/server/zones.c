@@ -16,14 +16,18 @@
 
 #include <config.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "common/lists.h"
 #include "common/prng.h"
+#include "common/ref.h"
 #include "libknot/dname.h"
 #include "libknot/util/wire.h"
 #include "knot/zone/zone-dump.h"
 #include "knot/zone/zone-load.h"
+#include "knot/zone/zone-sign.h"
+#include "knot/zone/semantic-check.h"
 #include "libknot/zone/zone.h"
 #include "libknot/zone/zonedb.h"
 #include "knot/conf/conf.h"
@@ -50,6 +54,24 @@ static const size_t XFRIN_BOOTSTRAP_DELAY = 2000; /*!< AXFR bootstrap avg. delay
 /* Forward declarations. */
 static int zones_dump_zone_text(knot_zone_contents_t *zone,  const char *zf);
 
+/*!
+ * \brief Signing keys of the zone shared by concurrent signers.
+ */
+typedef struct zones_keyset {
+	ref_t ref;
+	zone_keyset_t keyset;
+	char *keydir;  /*!< Directory the keys were loaded from. */
+	time_t mtime;  /*!< Modification time of the directory. */
+} zones_keyset_t;
+
+static void zones_keyset_free(ref_t *ref)
+{
+	zones_keyset_t *keys = (zones_keyset_t *)ref;
+	zone_sign_free_keys(&keys->keyset);
+	free(keys->keydir);
+	free(keys);
+}
+
 /*! \brief Zone data destructor function. */
 static int zonedata_destroy(knot_zone_t *zone)
 {
@@ -88,12 +110,35 @@ static int zonedata_destroy(knot_zone_t *zone)
 		zd->ixfr_dbsync = 0;
 	}
 
+	/* Cancel DNSSEC refresh timer. */
+	if (zd->dnssec_timer) {
+		evsched_t *sch = zd->dnssec_timer->parent;
+		evsched_cancel(sch, zd->dnssec_timer);
+		evsched_event_free(sch, zd->dnssec_timer);
+		zd->dnssec_timer = 0;
+	}
+
+	/* Free signature expiry index. */
+	if (zd->dnssec_expiry) {
+		zone_expiry_free(zd->dnssec_expiry);
+		free(zd->dnssec_expiry);
+		zd->dnssec_expiry = 0;
+	}
+
+	/* Release cached signing keys. */
+	if (zd->dnssec_keys) {
+		ref_release(&zd->dnssec_keys->ref);
+		zd->dnssec_keys = 0;
+	}
+
 	acl_delete(&zd->xfr_in.acl);
 	acl_delete(&zd->xfr_out);
 	acl_delete(&zd->notify_in);
 	acl_delete(&zd->notify_out);
 	acl_delete(&zd->update_in);
 	pthread_mutex_destroy(&zd->lock);
+	pthread_mutex_destroy(&zd->sync_lock);
+	pthread_mutex_destroy(&zd->update_lock);
 
 	/* Close IXFR db. */
 	journal_release(zd->ixfr_db);
@@ -124,6 +169,8 @@ static int zonedata_init(conf_zone_t *cfg, knot_zone_t *zone)
 
 	/* Initialize mutex. */
 	pthread_mutex_init(&zd->lock, 0);
+	pthread_mutex_init(&zd->sync_lock, 0);
+	pthread_mutex_init(&zd->update_lock, 0);
 
 	/* Initialize ACLs. */
 	zd->xfr_out = NULL;
@@ -151,6 +198,7 @@ static int zonedata_init(conf_zone_t *cfg, knot_zone_t *zone)
 
 	/* Initialize IXFR database syncing event. */
 	zd->ixfr_dbsync = 0;
+	zd->zonefile_dumped = time(NULL);
 
 	/* Set and install destructor. */
 	zone->data = zd;
@@ -447,13 +495,37 @@ static int zones_zonefile_sync_ev(event_t *e)
 		return KNOT_EINVAL;
 	}
 
+	/* Rewrite zonefile only if compaction is due. */
+	rcu_read_lock();
+	int compact = zd->conf->dbsync_compact;
+	rcu_read_unlock();
+	pthread_mutex_lock(&zd->lock);
+	time_t dumped = zd->zonefile_dumped;
+	pthread_mutex_unlock(&zd->lock);
+	bool incremental = compact > 0 && time(NULL) - dumped < compact;
+
 	/* Execute zonefile sync. */
+	int ret = KNOT_EINVAL;
 	journal_t *j = journal_retain(zd->ixfr_db);
-	int ret = zones_zonefile_sync(zone, j);
+	if (incremental) {
+		/* Differences are replayed from journal on load. */
+		ret = journal_sync(j);
+	} else {
+		pthread_mutex_lock(&zd->update_lock);
+		ret = zones_zonefile_sync(zone, j);
+		pthread_mutex_unlock(&zd->update_lock);
+	}
 	journal_release(j);
 
 	rcu_read_lock();
-	if (ret == KNOT_EOK) {
+	if (incremental && ret == KNOT_EOK) {
+		dbg_zones("zones: kept differences of '%s' in journal, "
+		          "zonefile rewrite in %ld seconds\n", zd->conf->name,
+		          (long)(dumped + compact - time(NULL)));
+	} else if (incremental) {
+		log_zone_warning("Failed to sync differences of '%s' "
+		                 "to journal.\n", zd->conf->name);
+	} else if (ret == KNOT_EOK) {
 		log_zone_info("Applied differences of '%s' to zonefile.\n",
 		              zd->conf->name);
 	} else if (ret != KNOT_ERANGE) {
@@ -511,10 +583,8 @@ static int zones_set_acl(acl_t **acl, list* acl_list)
 
 		/* Load rule. */
 		if (ret > 0) {
-			/*! \todo Correct search for the longest prefix match.
-			 *        This just favorizes remotes with TSIG.
-			 *        (issue #1675)
-			 */
+			/* Remotes with TSIG are preferred, then the
+			 * longest prefix match is used. */
 			unsigned flags = 0;
 			if (cfg_if->key != NULL) {
 				flags = ACL_PREFER;
@@ -526,6 +596,60 @@ static int zones_set_acl(acl_t **acl, list* acl_list)
 	return KNOT_EOK;
 }
 
+/*!
+ * \brief Updates zone data referring to the zone configuration.
+ *
+ * The ACLs and the master address point to the configuration remotes, so
+ * they must be rebuilt whenever the configuration is replaced.
+ */
+static void zones_update_conf(knot_zone_t *zone, conf_zone_t *z,
+                              knot_nameserver_t *ns)
+{
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	assert(zd != NULL);
+
+	/* Update refs. */
+	if (zd->conf != z) {
+		conf_free_zone(zd->conf);
+		zd->conf = z;
+	}
+
+	/* Update ACLs. */
+	dbg_zones("Updating zone ACLs.\n");
+	zones_set_acl(&zd->xfr_in.acl, &z->acl.xfr_in);
+	zones_set_acl(&zd->xfr_out, &z->acl.xfr_out);
+	zones_set_acl(&zd->notify_in, &z->acl.notify_in);
+	zones_set_acl(&zd->notify_out, &z->acl.notify_out);
+	zones_set_acl(&zd->update_in, &z->acl.update_in);
+
+	/* Update server pointer. */
+	zd->server = (server_t *)knot_ns_get_data(ns);
+
+	/* Update master server address. */
+	zd->xfr_in.has_master = 0;
+	memset(&zd->xfr_in.tsig_key, 0, sizeof(knot_tsig_key_t));
+	sockaddr_init(&zd->xfr_in.master, -1);
+	sockaddr_init(&zd->xfr_in.via, -1);
+	if (!EMPTY_LIST(z->acl.xfr_in)) {
+		conf_remote_t *r = HEAD(z->acl.xfr_in);
+		conf_iface_t *cfg_if = r->remote;
+		sockaddr_set(&zd->xfr_in.master, cfg_if->family,
+		             cfg_if->address, cfg_if->port);
+		if (sockaddr_isvalid(&cfg_if->via)) {
+			sockaddr_copy(&zd->xfr_in.via, &cfg_if->via);
+		}
+		zd->xfr_in.has_master = 1;
+
+		if (cfg_if->key) {
+			memcpy(&zd->xfr_in.tsig_key, cfg_if->key,
+			       sizeof(knot_tsig_key_t));
+		}
+
+		dbg_zones("zones: using '%s@%d' as XFR master for '%s'\n",
+		          cfg_if->address, cfg_if->port, z->name);
+	}
+}
+
 /*!
  * \brief Load zone to zone database.
  *
@@ -653,6 +777,31 @@ static inline int ixfrdb_key_from_cmp(uint64_t k, uint64_t from)
 
 /*----------------------------------------------------------------------------*/
 
+/*!
+ * \brief Mark journal entries up to given serial as synced to zonefile.
+ *
+ * Entries stored after the serial remain dirty, so they are kept in the
+ * journal and replayed on next load. If the serial is not in the journal,
+ * all entries are marked.
+ */
+static void zones_ixfrdb_sync_to(journal_t *j, uint32_t serial)
+{
+	/* Find end of the entries contained in zonefile. */
+	size_t end = j->qtail;
+	size_t i = j->qhead;
+	for (; i != j->qtail; i = (i + 1) % j->max_nodes) {
+		if (ixfrdb_key_to(j->nodes[i].id) == serial) {
+			end = (i + 1) % j->max_nodes;
+		}
+	}
+
+	for (i = j->qhead; i != end; i = (i + 1) % j->max_nodes) {
+		zones_ixfrdb_sync_apply(j, j->nodes + i);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+
 /*! \brief Make key for journal from serials. */
 static inline uint64_t ixfrdb_key_make(uint32_t from, uint32_t to)
 {
@@ -923,12 +1072,19 @@ static int zones_journal_apply(knot_zone_t *zone)
 		return KNOT_EINVAL;
 	}
 
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	if (!zd) {
+		return KNOT_ENOENT;
+	}
+
+	/* Contents must not change until the changesets are applied. */
+	pthread_mutex_lock(&zd->update_lock);
 	rcu_read_lock();
 
 	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
-	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
-	if (!contents || !zd) {
+	if (!contents) {
 		rcu_read_unlock();
+		pthread_mutex_unlock(&zd->update_lock);
 		return KNOT_ENOENT;
 	}
 
@@ -940,6 +1096,7 @@ static int zones_journal_apply(knot_zone_t *zone)
 	int64_t serial_ret = knot_rrset_rdata_soa_serial(soa_rrs);
 	if (serial_ret < 0) {
 		rcu_read_unlock();
+		pthread_mutex_unlock(&zd->update_lock);
 		return KNOT_EINVAL;
 	}
 	uint32_t serial = (uint32_t)serial_ret;
@@ -1004,12 +1161,510 @@ static int zones_journal_apply(knot_zone_t *zone)
 
 	/* Free changesets and return. */
 	rcu_read_unlock();
+	pthread_mutex_unlock(&zd->update_lock);
 	knot_free_changesets(&chsets);
 	return ret;
 }
 
 /*----------------------------------------------------------------------------*/
 
+/*! \brief Returns nonzero if the zone is signed by the server. */
+static int zones_dnssec_enabled(const knot_zone_t *zone)
+{
+	const zonedata_t *zd = (const zonedata_t *)knot_zone_data(zone);
+	return zd != NULL && zd->conf->dnssec_enable;
+}
+
+/*!
+ * \brief Returns signing keys of the zone from the configured directory.
+ *
+ * Keys are cached in zone data and loaded again only if the directory
+ * changes, i.e. key files are added, removed or renamed. Returned keys
+ * are retained and must be released with ref_release().
+ */
+static int zones_dnssec_keys(const knot_zone_t *zone, zones_keyset_t **keys)
+{
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	if (zd == NULL || zd->conf->dnssec_keydir == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	const char *keydir = zd->conf->dnssec_keydir;
+	struct stat st;
+	if (stat(keydir, &st) != 0) {
+		return KNOT_ENOENT;
+	}
+
+	pthread_mutex_lock(&zd->lock);
+	zones_keyset_t *cached = zd->dnssec_keys;
+	if (cached != NULL && cached->mtime == st.st_mtime &&
+	    strcmp(cached->keydir, keydir) == 0) {
+		ref_retain(&cached->ref);
+		pthread_mutex_unlock(&zd->lock);
+		*keys = cached;
+		return KNOT_EOK;
+	}
+	pthread_mutex_unlock(&zd->lock);
+
+	zones_keyset_t *loaded = malloc(sizeof(zones_keyset_t));
+	if (loaded == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	memset(loaded, 0, sizeof(zones_keyset_t));
+	ref_init(&loaded->ref, zones_keyset_free);
+	loaded->mtime = st.st_mtime;
+	loaded->keydir = strdup(keydir);
+	if (loaded->keydir == NULL) {
+		free(loaded);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = zone_sign_load_keys(keydir, knot_zone_name(zone),
+	                              &loaded->keyset);
+	if (ret != KNOT_EOK) {
+		free(loaded->keydir);
+		free(loaded);
+		return ret;
+	}
+
+	dbg_zones("zones: loaded %zu signing keys of '%s'\n",
+	          loaded->keyset.count, zd->conf->name);
+
+	/* One reference for the cache, one for the caller. */
+	ref_retain(&loaded->ref);
+	ref_retain(&loaded->ref);
+
+	pthread_mutex_lock(&zd->lock);
+	cached = zd->dnssec_keys;
+	zd->dnssec_keys = loaded;
+	pthread_mutex_unlock(&zd->lock);
+
+	if (cached != NULL) {
+		ref_release(&cached->ref);
+	}
+
+	*keys = loaded;
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Sign zone with keys from the configured key directory.
+ *
+ * Resulting changeset is stored to journal and applied to the zone.
+ *
+ * \param zone Specified zone.
+ *
+ * \retval KNOT_EOK if successful.
+ * \retval KNOT_EINVAL on invalid parameters.
+ * \retval KNOT_ENOENT if zone has no contents or no keys were found.
+ * \retval KNOT_ERROR on unspecified error.
+ */
+static int zones_dnssec_sign(knot_zone_t *zone)
+{
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	if (zd == NULL) {
+		return KNOT_ENOENT;
+	}
+
+	conf_zone_t *z = zd->conf;
+	zones_keyset_t *keys = NULL;
+	int ret = zones_dnssec_keys(zone, &keys);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_changesets_t *chs = NULL;
+	ret = knot_changeset_allocate(&chs, KNOT_CHANGESET_TYPE_IXFR);
+	if (ret != KNOT_EOK) {
+		ref_release(&keys->ref);
+		return ret;
+	}
+
+	zone_sign_policy_t policy;
+	zone_sign_policy_init(&policy, ZONE_SIGN_VALIDITY, 0);
+
+	/* Signed contents must stay current until the changes are applied,
+	 * contents are not switched by others meanwhile. */
+	pthread_mutex_lock(&zd->update_lock);
+	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
+	if (contents == NULL) {
+		pthread_mutex_unlock(&zd->update_lock);
+		ref_release(&keys->ref);
+		knot_free_changesets(&chs);
+		return KNOT_ENOENT;
+	}
+
+	zone_sign_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	ret = zone_sign(contents, &keys->keyset, &policy, chs, &stats);
+	ref_release(&keys->ref);
+	if (ret != KNOT_EOK) {
+		pthread_mutex_unlock(&zd->update_lock);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	log_server_info("Signed zone '%s': %zu RRSets, %zu signatures in "
+	                "%.2lf s (%d threads, %.0lf signatures/s per core).\n",
+	                z->name, stats.rrsets, stats.signatures, stats.elapsed,
+	                stats.threads, zone_sign_rate(&stats));
+
+	char msgpref[256];
+	snprintf(msgpref, sizeof(msgpref), "DNSSEC of '%s':", z->name);
+
+	/* Changesets are consumed regardless of the result. */
+	knot_zone_contents_t *new_contents = NULL;
+	ret = zones_store_and_apply_chgsets(chs, zone, &new_contents,
+	                                    msgpref, XFR_TYPE_UPDATE);
+	pthread_mutex_unlock(&zd->update_lock);
+
+	return ret;
+}
+
+/*!
+ * \brief Checks if zone has missing or expiring signatures.
+ */
+static int zones_dnssec_sign_needed(knot_zone_t *zone)
+{
+	rcu_read_lock();
+	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
+	uint32_t refresh = time(NULL) + ZONE_SIGN_REFRESH;
+	int needed = contents != NULL && zone_sign_needed(contents, refresh);
+	rcu_read_unlock();
+
+	return needed;
+}
+
+/*!
+ * \brief Re-signs changes of an update applied to the zone copy.
+ *
+ * Only touched RRSets and changed NSEC/NSEC3 records are signed. The DNSSEC
+ * changes are applied to the zone copy and appended to the last changeset,
+ * so they are stored in the same journal entry as the update itself.
+ *
+ * \param zone Updated zone.
+ * \param chs Changesets of the update (intact, not consumed by apply).
+ * \param new_contents Zone copy with the changesets applied.
+ * \param changes Changes structure of the update in progress.
+ *
+ * \retval KNOT_EOK if successful.
+ * \retval KNOT_EINVAL on invalid parameters.
+ * \retval KNOT_ENOENT if no keys were found.
+ * \retval KNOT_ENOMEM
+ */
+static int zones_dnssec_update(knot_zone_t *zone, knot_changesets_t *chs,
+                               knot_zone_contents_t *new_contents,
+                               knot_changes_t *changes)
+{
+	if (chs == NULL || chs->count == 0 || new_contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	zones_keyset_t *keys = NULL;
+	int ret = zones_dnssec_keys(zone, &keys);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	zone_sign_policy_t policy;
+	zone_sign_policy_init(&policy, ZONE_SIGN_VALIDITY, 0);
+
+	knot_changeset_t *last = &chs->sets[chs->count - 1];
+	knot_changeset_t dnssec;
+	memset(&dnssec, 0, sizeof(knot_changeset_t));
+	dnssec.flags = last->flags;
+
+	zone_sign_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	ret = zone_sign_changesets(new_contents, chs, &keys->keyset, &policy,
+	                           &dnssec, &stats);
+	ref_release(&keys->ref);
+
+	/* Track expiration of the new signatures. */
+	if (ret == KNOT_EOK && zd->dnssec_expiry != NULL) {
+		ret = zone_expiry_add_changeset(zd->dnssec_expiry, &dnssec);
+	}
+
+	/* Copy is needed for journal, applying consumes the RRSets. */
+	if (ret == KNOT_EOK) {
+		ret = knot_changeset_append_copy(last, &dnssec);
+	}
+	if (ret == KNOT_EOK) {
+		ret = xfrin_apply_changeset_to_copy(new_contents, changes,
+		                                    &dnssec);
+	}
+
+	dbg_zones("zones: re-signed update, %zu RRSets, %zu signatures "
+	          "(%s)\n", stats.rrsets, stats.signatures, knot_strerror(ret));
+
+	knot_changeset_t *dnssec_ptr = &dnssec;
+	knot_free_changeset(&dnssec_ptr);
+
+	return ret;
+}
+
+/*!
+ * \brief Runs semantic checks on nodes changed by an update.
+ *
+ * Mandatory checks are always done, the full checks only if enabled
+ * for the zone.
+ */
+static int zones_sem_check_update(knot_zone_t *zone,
+                                  knot_zone_contents_t *new_contents,
+                                  const knot_changes_t *changes,
+                                  const char *msgpref)
+{
+	if (changes == NULL) {
+		return KNOT_EOK;
+	}
+
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	int check_level = 0;
+	if (zd != NULL && zd->conf->enable_checks) {
+		check_level = zone_sem_check_level(new_contents);
+	}
+
+	err_handler_t *handler = handler_new(1, 1, 1, 1, 1);
+	if (handler == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = zone_do_sem_checks_changes(new_contents, changes,
+	                                     check_level, handler);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Semantic checks failed - %s\n", msgpref,
+		               knot_strerror(ret));
+	}
+
+	free(handler);
+	return ret;
+}
+
+/*! \brief Creates deep copy of changesets. */
+static int zones_changesets_copy(const knot_changesets_t *src,
+                                 knot_changesets_t **dst)
+{
+	int ret = knot_changeset_allocate(dst, src->flags);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	for (size_t i = 0; i < src->count; ++i) {
+		ret = knot_changesets_check_size(*dst);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+
+		knot_changeset_t *ch = &(*dst)->sets[(*dst)->count];
+		memset(ch, 0, sizeof(knot_changeset_t));
+		ch->flags = src->sets[i].flags;
+		(*dst)->count += 1;
+
+		ret = knot_changeset_append_copy(ch, &src->sets[i]);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+	}
+
+	if (ret != KNOT_EOK) {
+		knot_free_changesets(dst);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief Re-signs one slice of signatures which are about to expire.
+ *
+ * \param zone Signed zone.
+ *
+ * \retval KNOT_EOK if successful or there was nothing to re-sign.
+ * \retval KNOT_ENOENT if the zone has no contents or no keys were found.
+ * \retval KNOT_ERROR on unspecified error.
+ */
+static int zones_dnssec_refresh(knot_zone_t *zone)
+{
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+
+	zones_keyset_t *keys = NULL;
+	int ret = zones_dnssec_keys(zone, &keys);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_changesets_t *chs = NULL;
+	ret = knot_changeset_allocate(&chs, KNOT_CHANGESET_TYPE_IXFR);
+	if (ret != KNOT_EOK) {
+		ref_release(&keys->ref);
+		return ret;
+	}
+
+	zone_sign_policy_t policy;
+	zone_sign_policy_init(&policy, ZONE_SIGN_VALIDITY, 0);
+	uint32_t refresh = (uint32_t)time(NULL) + ZONE_SIGN_REFRESH;
+
+	zone_sign_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+
+	/* Signed contents are not switched by others until applied. */
+	pthread_mutex_lock(&zd->update_lock);
+	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
+	if (contents != NULL) {
+		ret = zone_sign_expiring(contents, zd->dnssec_expiry, refresh,
+		                         ZONE_SIGN_SLICE, &keys->keyset,
+		                         &policy,
+		                         chs, &stats);
+	} else {
+		ret = KNOT_ENOENT;
+	}
+	ref_release(&keys->ref);
+
+	/* Nothing was due, zone and its serial are kept. */
+	if (ret != KNOT_EOK || chs->count == 0) {
+		pthread_mutex_unlock(&zd->update_lock);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	uint32_t serial = chs->sets[0].serial_to;
+
+	ret = zone_expiry_add_changeset(zd->dnssec_expiry, &chs->sets[0]);
+	if (ret != KNOT_EOK) {
+		pthread_mutex_unlock(&zd->update_lock);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	char msgpref[512];
+	snprintf(msgpref, sizeof(msgpref), "DNSSEC refresh of '%s':",
+	         zd->conf->name);
+
+	knot_zone_contents_t *new_contents = NULL;
+	ret = zones_store_and_apply_chgsets(chs, zone, &new_contents,
+	                                    msgpref, XFR_TYPE_UPDATE);
+	pthread_mutex_unlock(&zd->update_lock);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	log_zone_info("Refreshed %zu signatures of %zu RRSets in zone '%s', "
+	              "serial %u.\n", stats.signatures, stats.rrsets,
+	              zd->conf->name, serial);
+
+	return zones_schedule_notify(zone);
+}
+
+/*!
+ * \brief Re-signs a slice of expiring signatures and reschedules itself.
+ */
+static int zones_dnssec_refresh_ev(event_t *e)
+{
+	dbg_zones("zones: DNSSEC refresh timer event\n");
+
+	knot_zone_t *zone = (knot_zone_t *)e->data;
+	if (zone == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	zonedata_t *zd = (zonedata_t *)zone->data;
+	if (zd == NULL || zd->dnssec_expiry == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = zones_dnssec_refresh(zone);
+	if (ret != KNOT_EOK) {
+		log_zone_error("Failed to refresh signatures of zone '%s': "
+		               "%s\n", zd->conf->name, knot_strerror(ret));
+
+		/* Taken entries are lost, start over from the zone. */
+		rcu_read_lock();
+		knot_zone_contents_t *contents = knot_zone_get_contents(zone);
+		if (contents != NULL) {
+			zone_expiry_build(zd->dnssec_expiry, contents);
+		}
+		rcu_read_unlock();
+	}
+
+	/* Continue with next slice or wait for the next due signature. */
+	uint32_t tmr = DNSSEC_REFRESH_MAX;
+	uint32_t next = zone_expiry_next(zd->dnssec_expiry);
+	if (next > 0 && ret == KNOT_EOK) {
+		uint32_t now = (uint32_t)time(NULL);
+		uint32_t due = next - ZONE_SIGN_REFRESH;
+		if (due <= now) {
+			tmr = DNSSEC_REFRESH_SLICE;
+		} else if ((due - now) < DNSSEC_REFRESH_MAX / 1000) {
+			tmr = (due - now) * 1000;
+		}
+	}
+
+	evsched_schedule(e->parent, e, tmr);
+	dbg_zones("zones: next DNSSEC refresh of '%s' in %u ms\n",
+	          zd->conf->name, tmr);
+
+	return ret;
+}
+
+/*!
+ * \brief Builds signature expiry index and schedules continuous refresh.
+ *
+ * \param zone Zone to schedule refresh for.
+ * \param sch Event scheduler.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
+ */
+static int zones_schedule_dnssec(knot_zone_t *zone, evsched_t *sch)
+{
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+
+	if (zd->dnssec_timer != NULL) {
+		evsched_cancel(sch, zd->dnssec_timer);
+		evsched_event_free(sch, zd->dnssec_timer);
+		zd->dnssec_timer = NULL;
+	}
+
+	if (!zd->conf->dnssec_enable) {
+		return KNOT_EOK;
+	}
+
+	if (zd->dnssec_expiry == NULL) {
+		zd->dnssec_expiry = malloc(sizeof(zone_expiry_t));
+		if (zd->dnssec_expiry == NULL) {
+			return KNOT_ENOMEM;
+		}
+		int ret = zone_expiry_init(zd->dnssec_expiry);
+		if (ret != KNOT_EOK) {
+			free(zd->dnssec_expiry);
+			zd->dnssec_expiry = NULL;
+			return ret;
+		}
+	}
+
+	rcu_read_lock();
+	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
+	int ret = KNOT_EOK;
+	if (contents != NULL) {
+		ret = zone_expiry_build(zd->dnssec_expiry, contents);
+	}
+	rcu_read_unlock();
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* First check soon, the event computes the next due time itself. */
+	zd->dnssec_timer = evsched_schedule_cb(sch, zones_dnssec_refresh_ev,
+	                                       zone, DNSSEC_REFRESH_SLICE);
+	dbg_zones("zones: DNSSEC refresh of '%s' scheduled\n",
+	          zd->conf->name);
+
+	return zd->dnssec_timer != NULL ? KNOT_EOK : KNOT_ENOMEM;
+}
+
+/*----------------------------------------------------------------------------*/
+
 /*!
  * \brief Insert new zone to the database.
  *
@@ -1130,53 +1785,8 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 		zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
 		assert(zd != NULL);
 
-		/* Update refs. */
-		if (zd->conf != z) {
-			conf_free_zone(zd->conf);
-			zd->conf = z;
-		}
-
-		/* Update ACLs. */
-		dbg_zones("Updating zone ACLs.\n");
-		zones_set_acl(&zd->xfr_in.acl, &z->acl.xfr_in);
-		zones_set_acl(&zd->xfr_out, &z->acl.xfr_out);
-		zones_set_acl(&zd->notify_in, &z->acl.notify_in);
-		zones_set_acl(&zd->notify_out, &z->acl.notify_out);
-		zones_set_acl(&zd->update_in, &z->acl.update_in);
-
-		/* Update server pointer. */
-		zd->server = (server_t *)knot_ns_get_data(ns);
-
-		/* Update master server address. */
-		zd->xfr_in.has_master = 0;
-		memset(&zd->xfr_in.tsig_key, 0, sizeof(knot_tsig_key_t));
-		sockaddr_init(&zd->xfr_in.master, -1);
-		sockaddr_init(&zd->xfr_in.via, -1);
-		if (!EMPTY_LIST(z->acl.xfr_in)) {
-			conf_remote_t *r = HEAD(z->acl.xfr_in);
-			conf_iface_t *cfg_if = r->remote;
-			sockaddr_set(&zd->xfr_in.master,
-				     cfg_if->family,
-				     cfg_if->address,
-				     cfg_if->port);
-			if (sockaddr_isvalid(&cfg_if->via)) {
-				sockaddr_copy(&zd->xfr_in.via,
-				              &cfg_if->via);
-			}
-			zd->xfr_in.has_master = 1;
-
-			if (cfg_if->key) {
-				memcpy(&zd->xfr_in.tsig_key,
-				       cfg_if->key,
-				       sizeof(knot_tsig_key_t));
-			}
-
-			dbg_zones("zones: using '%s@%d' as XFR master "
-			          "for '%s'\n",
-			          cfg_if->address,
-			          cfg_if->port,
-			          z->name);
-		}
+		/* Update references to the configuration. */
+		zones_update_conf(zone, z, ns);
 
 		/* Apply changesets from journal. */
 		int ar = zones_journal_apply(zone);
@@ -1186,6 +1796,16 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 			                   z->name, knot_strerror(ar));
 		}
 
+		/* Sign freshly loaded zone unless its signatures are valid,
+		 * expiring ones are then refreshed from the expiry index. */
+		if (is_new && z->dnssec_enable &&
+		    zones_dnssec_sign_needed(zone)) {
+			int sr = zones_dnssec_sign(zone);
+			if (sr != KNOT_EOK) {
+				log_zone_error("Failed to sign zone '%s': %s\n",
+				               z->name, knot_strerror(sr));
+			}
+		}
 
 		/* Update events scheduled for zone. */
 		evsched_t *sch = ((server_t *)knot_ns_get_data(ns))->sched;
@@ -1218,6 +1838,14 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 			          "set to %d\n", z->name, sync_tmr);
 		}
 
+		/* Schedule continuous refresh of expiring signatures. */
+		int dr = zones_schedule_dnssec(zone, sch);
+		if (dr != KNOT_EOK) {
+			log_zone_error("Failed to schedule signature refresh "
+			               "of zone '%s': %s\n", z->name,
+			               knot_strerror(dr));
+		}
+
 		/* Update ANY queries policy */
 		if (zd->conf->disable_any) {
 			rcu_read_lock();
@@ -1230,14 +1858,37 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 			if (contents) {
 				knot_zone_contents_disable_any(contents);
 			}
-
+
+			rcu_read_unlock();
+		}
+
+		/* Keep RDATA in wire format. */
+		if (zd->conf->prerender_rdata) {
+			rcu_read_lock();
+			knot_zone_contents_t *contents =
+			                knot_zone_get_contents(zone);
+			int pr = KNOT_EOK;
+			if (contents) {
+				pr = knot_zone_contents_enable_wire(contents);
+			}
 			rcu_read_unlock();
+			if (pr != KNOT_EOK) {
+				log_zone_warning("Failed to pre-render RDATA "
+				                 "of zone '%s': %s\n", z->name,
+				                 knot_strerror(pr));
+			}
 		}
 
-		/* Calculate differences. */
-		rcu_read_lock();
+		/* Calculate differences, old zone is not updated meanwhile. */
 		knot_zone_t *z_old = knot_zonedb_find_zone(ns->zone_db,
 		                                              dname);
+		zonedata_t *zd_old = NULL;
+		if (z_old != NULL) {
+			zd_old = (zonedata_t *)knot_zone_data(z_old);
+		}
+		if (zd_old != NULL) {
+			pthread_mutex_lock(&zd_old->update_lock);
+		}
 		/* Ensure both new and old have zone contents. */
 		knot_zone_contents_t *zc = knot_zone_get_contents(zone);
 		knot_zone_contents_t *zc_old = knot_zone_get_contents(z_old);
@@ -1254,7 +1905,9 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 				                 "%s\n", knot_strerror(bd));
 			}
 		}
-		rcu_read_unlock();
+		if (zd_old != NULL) {
+			pthread_mutex_unlock(&zd_old->update_lock);
+		}
 	}
 
 	/* CLEANUP */
@@ -1265,6 +1918,65 @@ static int zones_insert_zone(conf_zone_t *z, knot_zone_t **dst,
 	return ret;
 }
 
+/*!
+ * \brief Finds zone in the current database if it needs no reload.
+ *
+ * The zone needs no reload if its configuration is the same and its zone
+ * file was not modified since the zone was loaded.
+ */
+static knot_zone_t *zones_find_unchanged(knot_nameserver_t *ns,
+                                         const conf_zone_t *z)
+{
+	/* Local allocation, will be discarded. */
+	knot_dname_t *dname = knot_dname_new_from_str(z->name, strlen(z->name),
+	                                              NULL);
+	if (dname == NULL) {
+		return NULL;
+	}
+
+	/* Doesn't need RCU, the database is switched by this thread. */
+	knot_zone_t *zone = knot_zonedb_find_zone(ns->zone_db, dname);
+	knot_dname_free(&dname);
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	zonedata_t *zd = (zonedata_t *)knot_zone_data(zone);
+	if (zd == NULL || !conf_zone_equal(zd->conf, z)) {
+		return NULL;
+	}
+
+	struct stat st;
+	if (stat(z->file, &st) == 0 && knot_zone_version(zone) < st.st_mtime) {
+		return NULL;
+	}
+
+	return zone;
+}
+
+/*!
+ * \brief Carries unchanged zone over to the new database.
+ *
+ * The zone is not reloaded and its scheduled events are kept, only the
+ * references to the new configuration are updated.
+ */
+static int zones_retain_zone(knot_zone_t *zone, conf_zone_t *z,
+                             knot_nameserver_t *ns, knot_zonedb_t *db_new)
+{
+	int ret = knot_zonedb_add_zone(db_new, zone);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	zones_update_conf(zone, z, ns);
+
+	/* Unlink zone config from conf(),
+	 * transferring ownership to zonedata. */
+	rem_node(&z->n);
+
+	return KNOT_EOK;
+}
+
 /*! \brief Structure for multithreaded zone loading. */
 struct zonewalk_t {
 	knot_nameserver_t *ns;
@@ -1341,8 +2053,9 @@ static int zonewalker(dthread_t *thread)
 /*!
  * \brief Fill the new database with zones.
  *
- * Zones that should be retained are just added from the old database to the
- * new. New zones are loaded.
+ * Zones with unchanged configuration and zone file are just added from the
+ * old database to the new. Only new and changed zones are passed to the
+ * loading threads.
  *
  * \param ns Name server instance.
  * \param zone_conf Zone configuration.
@@ -1356,7 +2069,7 @@ static int zones_insert_zones(knot_nameserver_t *ns,
 {
 	int ret = 0;
 	size_t zcount = 0;
-	conf_zone_t *z = NULL;
+	conf_zone_t *z = NULL, *nxt = NULL;
 	WALK_LIST(z, *zone_conf) {
 		++zcount;
 	}
@@ -1375,27 +2088,41 @@ static int zones_insert_zones(knot_nameserver_t *ns,
 		free(zw);
 		return KNOT_ENOMEM;
 	}
-	unsigned i = 0;
-	WALK_LIST(z, *zone_conf) {
-		zw->q[i++] = z;
+	/* Keep unchanged zones, queue the rest for loading. */
+	int retained = 0;
+	WALK_LIST_DELSAFE(z, nxt, *zone_conf) {
+		knot_zone_t *zone = zones_find_unchanged(ns, z);
+		if (zone != NULL &&
+		    zones_retain_zone(zone, z, ns, db_new) == KNOT_EOK) {
+			++retained;
+		} else {
+			zw->q[zw->qtail++] = z;
+		}
 	}
 	zw->qhead = 0;
-	zw->qtail = zcount;
+
+	if (retained > 0) {
+		log_server_info("Kept %d unchanged zones, loading %u "
+		                "zones.\n", retained, zw->qtail);
+	}
 
 	/* Initialize threads. */
+	ret = retained;
 	size_t thrs = dt_optimal_size();
-	if (thrs > zcount) thrs = zcount;
-	dt_unit_t *unit =  dt_create_coherent(thrs, &zonewalker, zw);
-	if (unit != NULL) {
-		/* Start loading. */
-		dt_start(unit);
-		dt_join(unit);
-		dt_delete(&unit);
-
-		/* Collect counts. */
-		ret = zw->inserted;
-	} else {
-		ret = KNOT_ENOMEM;
+	if (thrs > zw->qtail) thrs = zw->qtail;
+	if (thrs > 0) {
+		dt_unit_t *unit = dt_create_coherent(thrs, &zonewalker, zw);
+		if (unit != NULL) {
+			/* Start loading. */
+			dt_start(unit);
+			dt_join(unit);
+			dt_delete(&unit);
+
+			/* Collect counts. */
+			ret += zw->inserted;
+		} else {
+			ret = KNOT_ENOMEM;
+		}
 	}
 
 	pthread_mutex_destroy(&zw->lock);
@@ -1606,7 +2333,7 @@ static int zones_store_changesets_to_disk(knot_zone_t *zone,
  * and TSIG signature is verified.
  *
  * \note Set parameter 'rcode' according to answering procedure.
- * \note Function expects RCU to be locked.
+ * \note Function expects RCU to be locked and zone update lock held.
  *
  * \retval KNOT_EOK if successful.
  * \retval error if not.
@@ -1689,8 +2416,42 @@ static int zones_process_update_auth(knot_zone_t *zone,
 		return (ret < 0) ? ret : KNOT_EOK;
 	}
 
-	/* 2) Store changesets, (TODO: but do not commit???). */
+	/* 2) Re-sign changed records, stored in the same changeset. */
+	if (zones_dnssec_enabled(zone)) {
+		ret = zones_dnssec_update(zone, chgsets, new_contents,
+		                          chgsets->changes);
+		if (ret != KNOT_EOK) {
+			log_zone_error("%s Failed to sign the update - %s\n",
+			               msg, knot_strerror(ret));
+			*rcode = KNOT_RCODE_SERVFAIL;
+			xfrin_rollback_update(zone->contents, &new_contents,
+			                      &chgsets->changes);
+			knot_free_changesets(&chgsets);
+			free(msg);
+			return ret;
+		}
+	}
+
+	/* 3) Check the changed nodes. */
+	ret = zones_sem_check_update(zone, new_contents, chgsets->changes,
+	                             msg);
+	if (ret != KNOT_EOK) {
+		*rcode = KNOT_RCODE_SERVFAIL;
+		xfrin_rollback_update(zone->contents, &new_contents,
+		                      &chgsets->changes);
+		knot_free_changesets(&chgsets);
+		free(msg);
+		return ret;
+	}
+
+	/* 4) Store changesets, (TODO: but do not commit???).
+	 *    Full journal forces zone file sync, which is done outside
+	 *    of RCU, contents are kept by the update lock. */
+	knot_zone_retain(zone);
+	rcu_read_unlock();
 	ret = zones_store_changesets_to_disk(zone, chgsets);
+	rcu_read_lock();
+	knot_zone_release(zone);
 	if (ret != KNOT_EOK) {
 		log_zone_error("%s %s\n", msg, knot_strerror(ret));
 		xfrin_rollback_update(zone->contents, &new_contents,
@@ -1700,7 +2461,7 @@ static int zones_process_update_auth(knot_zone_t *zone,
 		return ret;
 	}
 
-	/* 3) Switch zone contents. */
+	/* 5) Switch zone contents. */
 	knot_zone_retain(zone); /* Retain pointer for safe RCU unlock. */
 	rcu_read_unlock();      /* Unlock for switch. */
 	ret = xfrin_switch_zone(zone, new_contents, XFR_TYPE_UPDATE);
@@ -1719,7 +2480,7 @@ static int zones_process_update_auth(knot_zone_t *zone,
 		return KNOT_ERROR;
 	}
 
-	/* 4) Cleanup. */
+	/* 6) Cleanup. */
 
 	xfrin_cleanup_successful_update(&chgsets->changes);
 
@@ -1881,6 +2642,154 @@ int zones_update_db_from_config(const conf_t *conf, knot_nameserver_t *ns,
 	return KNOT_EOK;
 }
 
+/*----------------------------------------------------------------------------*/
+
+/*! \brief Publish new zone database and free the old one (not the zones). */
+static void zones_db_switch(knot_nameserver_t *ns, knot_zonedb_t *db_new)
+{
+	/* Heal zonedb index. */
+	hattrie_build_index(db_new->zone_tree);
+
+	knot_zonedb_t *db_old = rcu_xchg_pointer(&ns->zone_db, db_new);
+
+	/* Wait until all readers finish with the old database. */
+	synchronize_rcu();
+	knot_zonedb_free(&db_old);
+}
+
+int zones_db_add(const conf_t *conf, knot_nameserver_t *ns, list *zone_conf)
+{
+	if (conf == NULL || ns == NULL || zone_conf == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* Only the index is copied, the zones stay in place. */
+	knot_zonedb_t *db_new = knot_zonedb_copy(ns->zone_db);
+	if (db_new == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int inserted = 0;
+	conf_zone_t *z = NULL, *nxt = NULL;
+	WALK_LIST_DELSAFE(z, nxt, *zone_conf) {
+		knot_dname_t *dname = knot_dname_new_from_str(z->name,
+		                                              strlen(z->name),
+		                                              NULL);
+		if (dname == NULL) {
+			rem_node(&z->n);
+			conf_free_zone(z);
+			continue;
+		}
+
+		knot_zone_t *found = knot_zonedb_find_zone(db_new, dname);
+		knot_dname_free(&dname);
+		if (found != NULL) {
+			log_server_warning("Zone '%s' is already present.\n",
+			                   z->name);
+			rem_node(&z->n);
+			conf_free_zone(z);
+			continue;
+		}
+
+		knot_zone_t *zone = NULL;
+		int ret = zones_insert_zone(z, &zone, ns);
+
+		/* Unlink zone config from the list,
+		 * transferring ownership to zonedata. */
+		rem_node(&z->n);
+		if (ret != KNOT_EOK) {
+			log_server_error("Failed to load zone '%s': %s\n",
+			                 z->name, knot_strerror(ret));
+			conf_free_zone(z);
+			continue;
+		}
+
+		if (knot_zonedb_add_zone(db_new, zone) != KNOT_EOK) {
+			log_server_error("Failed to insert zone '%s' "
+			                 "into database.\n", z->name);
+			knot_zone_deep_free(&zone);
+			continue;
+		}
+
+		/* Keep the zone after reload and restart. */
+		int sr = conf_zone_state_save(conf, z->name, CONF_ZONE_ADDED);
+		if (sr != KNOT_EOK) {
+			log_server_warning("Failed to save added zone '%s': "
+			                   "%s\n", z->name, knot_strerror(sr));
+		}
+
+		++inserted;
+	}
+
+	if (inserted == 0) {
+		knot_zonedb_free(&db_new);
+		return 0;
+	}
+
+	zones_db_switch(ns, db_new);
+
+	return inserted;
+}
+
+int zones_db_remove(const conf_t *conf, knot_nameserver_t *ns,
+                    const knot_dname_t **names, size_t count)
+{
+	if (conf == NULL || ns == NULL || names == NULL) {
+		return KNOT_EINVAL;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	knot_zone_t **removed = malloc(count * sizeof(knot_zone_t *));
+	if (removed == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	knot_zonedb_t *db_new = knot_zonedb_copy(ns->zone_db);
+	if (db_new == NULL) {
+		free(removed);
+		return KNOT_ENOMEM;
+	}
+
+	size_t rcount = 0;
+	for (size_t i = 0; i < count; ++i) {
+		knot_zone_t *zone = knot_zonedb_remove_zone(db_new, names[i]);
+		if (zone != NULL) {
+			removed[rcount++] = zone;
+		} else {
+			char *name = knot_dname_to_str(names[i]);
+			log_server_warning("Zone '%s' not found.\n", name);
+			free(name);
+		}
+	}
+
+	if (rcount == 0) {
+		knot_zonedb_free(&db_new);
+		free(removed);
+		return 0;
+	}
+
+	zones_db_switch(ns, db_new);
+
+	/* No reader can reach the zones now, release them. */
+	for (size_t i = 0; i < rcount; ++i) {
+		char *name = knot_dname_to_str(knot_zone_name(removed[i]));
+		log_server_info("Removed zone '%s'.\n", name);
+		int sr = conf_zone_state_save(conf, name, CONF_ZONE_REMOVED);
+		if (sr != KNOT_EOK) {
+			log_server_warning("Failed to save removed zone '%s': "
+			                   "%s\n", name, knot_strerror(sr));
+		}
+		free(name);
+		knot_zone_set_flag(removed[i], KNOT_ZONE_DISCARDED, 1);
+		knot_zone_release(removed[i]);
+	}
+
+	free(removed);
+	return rcount;
+}
+
 int zones_zonefile_sync(knot_zone_t *zone, journal_t *journal)
 {
 	if (!zone) {
@@ -1897,16 +2806,14 @@ int zones_zonefile_sync(knot_zone_t *zone, journal_t *journal)
 	int ret = KNOT_EOK;
 	zonedata_t *zd = (zonedata_t *)zone->data;
 
-	/* Lock zone data. */
-	pthread_mutex_lock(&zd->lock);
-
-	/* Lock RCU for zone contents. */
-	rcu_read_lock();
+	/* Only one writer of the zonefile at a time. */
+	pthread_mutex_lock(&zd->sync_lock);
 
+	/* Contents are not switched while the caller holds the update lock,
+	 * they are read without RCU. Updates of the zone wait for the dump. */
 	knot_zone_contents_t *contents = knot_zone_get_contents(zone);
 	if (!contents) {
-		rcu_read_unlock();
-		pthread_mutex_unlock(&zd->lock);
+		pthread_mutex_unlock(&zd->sync_lock);
 		return KNOT_EINVAL;
 	}
 
@@ -1918,50 +2825,56 @@ int zones_zonefile_sync(knot_zone_t *zone, journal_t *journal)
 
 	int64_t serial_ret = knot_rrset_rdata_soa_serial(soa_rrs);
 	if (serial_ret < 0) {
-		rcu_read_unlock();
-		pthread_mutex_unlock(&zd->lock);
+		pthread_mutex_unlock(&zd->sync_lock);
 		return KNOT_EINVAL;
 	}
 	uint32_t serial_to = (uint32_t)serial_ret;
 
 	/* Check for difference against zonefile serial. */
-	if (zd->zonefile_serial != serial_to) {
-
-		/* Save zone to zonefile. */
-		dbg_zones("zones: syncing '%s' differences to '%s' "
-		          "(SOA serial %u)\n",
-		          zd->conf->name, zd->conf->file, serial_to);
-		ret = zones_dump_zone_text(contents, zd->conf->file);
-		if (ret != KNOT_EOK) {
-			log_zone_warning("Failed to apply differences "
-			                 "'%s' to '%s'\n",
-			                 zd->conf->name, zd->conf->file);
-			rcu_read_unlock();
-			pthread_mutex_unlock(&zd->lock);
-			return ret;
-		}
-
-		/* Update journal entries. */
-		dbg_zones_verb("zones: unmarking all dirty nodes "
-		               "in '%s' journal\n",
-		               zd->conf->name);
-		journal_walk(journal, zones_ixfrdb_sync_apply);
-
-		/* Update zone file serial. */
-		dbg_zones("zones: new '%s' zonefile serial is %u\n",
-		          zd->conf->name, serial_to);
-		zd->zonefile_serial = serial_to;
-	} else {
+	pthread_mutex_lock(&zd->lock);
+	if (zd->zonefile_serial == serial_to) {
 		dbg_zones("zones: '%s' zonefile is in sync "
 		          "with differences\n", zd->conf->name);
-		ret = KNOT_ERANGE;
+		pthread_mutex_unlock(&zd->lock);
+		pthread_mutex_unlock(&zd->sync_lock);
+		return KNOT_ERANGE;
 	}
+	pthread_mutex_unlock(&zd->lock);
 
-	/* Unlock RCU. */
-	rcu_read_unlock();
+	/* Save zone to zonefile. */
+	dbg_zones("zones: syncing '%s' differences to '%s' "
+	          "(SOA serial %u)\n",
+	          zd->conf->name, zd->conf->file, serial_to);
+	ret = zones_dump_zone_text(contents, zd->conf->file);
+	if (ret != KNOT_EOK) {
+		log_zone_warning("Failed to apply differences "
+		                 "'%s' to '%s'\n",
+		                 zd->conf->name, zd->conf->file);
+		pthread_mutex_unlock(&zd->sync_lock);
+		return ret;
+	}
+
+	/* Update journal entries contained in the zonefile. */
+	pthread_mutex_lock(&zd->lock);
+	dbg_zones_verb("zones: unmarking dirty nodes up to serial %u "
+	               "in '%s' journal\n", serial_to, zd->conf->name);
+	zones_ixfrdb_sync_to(journal, serial_to);
+
+	/* Update zone file serial. */
+	dbg_zones("zones: new '%s' zonefile serial is %u\n",
+	          zd->conf->name, serial_to);
+	zd->zonefile_serial = serial_to;
+	zd->zonefile_dumped = time(NULL);
+
+	/* Zone file matches the zone, don't reload it. */
+	struct stat st;
+	if (stat(zd->conf->file, &st) == 0) {
+		knot_zone_set_version(zone, st.st_mtime);
+	}
 
 	/* Unlock zone data. */
 	pthread_mutex_unlock(&zd->lock);
+	pthread_mutex_unlock(&zd->sync_lock);
 
 	return ret;
 }
@@ -2364,6 +3277,23 @@ int zones_process_update(knot_nameserver_t *nameserver,
 		}
 	}
 
+	/* Updates of the zone are serialized, the lock must be taken outside
+	 * of RCU. Zone is retained meanwhile and its contents fetched again,
+	 * prerequisities are checked against the contents being updated. */
+	zonedata_t *update_zd = NULL;
+	if (ret == KNOT_EOK) {
+		update_zd = (zonedata_t *)knot_zone_data(zone);
+		knot_zone_retain(zone);
+		rcu_read_unlock();
+		pthread_mutex_lock(&update_zd->update_lock);
+		rcu_read_lock();
+		contents = knot_zone_contents(zone);
+		if (contents == NULL) {
+			rcode = KNOT_RCODE_SERVFAIL;
+			ret = KNOT_ENOZONE;
+		}
+	}
+
 	/*
 	 * 1) DDNS Zone Section check (RFC2136, Section 3.1).
 	 */
@@ -2400,6 +3330,11 @@ int zones_process_update(knot_nameserver_t *nameserver,
 		dbg_zones_verb("Auth, update_proc = %s\n", knot_strerror(ret));
 	}
 
+	if (update_zd != NULL) {
+		pthread_mutex_unlock(&update_zd->update_lock);
+		knot_zone_release(zone);
+	}
+
 	/* Create error query if processing failed. */
 	if (ret != KNOT_EOK) {
 		ret = knot_ns_error_response_from_query(nameserver,
@@ -3098,6 +4033,101 @@ int zones_create_and_save_changesets(const knot_zone_t *old_zone,
 
 /*----------------------------------------------------------------------------*/
 
+/*!
+ * \brief Applies incoming changesets to a signed zone and re-signs them.
+ *
+ * Applying consumes the changesets, so a copy is kept for the journal and
+ * the DNSSEC changes are appended to it before storing.
+ */
+static int zones_dnssec_store_and_apply(knot_changesets_t *chs,
+                                        knot_zone_t *zone,
+                                        knot_zone_contents_t **new_contents,
+                                        const char *msgpref, int type)
+{
+	knot_changesets_t *journal_chs = NULL;
+	int ret = zones_changesets_copy(chs, &journal_chs);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Failed to copy changesets - %s\n",
+		               msgpref, knot_strerror(ret));
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	/* Apply the changesets to the zone copy. */
+	ret = xfrin_apply_changesets(zone, chs, new_contents);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Failed to apply changesets - %s\n",
+		               msgpref, knot_strerror(ret));
+		knot_free_changesets(&journal_chs);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	/* Re-sign changed records, changes are added to the journal copy. */
+	ret = zones_dnssec_update(zone, journal_chs, *new_contents,
+	                          chs->changes);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Failed to sign changesets - %s\n",
+		               msgpref, knot_strerror(ret));
+		xfrin_rollback_update(zone->contents, new_contents,
+		                      &chs->changes);
+		knot_free_changesets(&journal_chs);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	/* Check the changed nodes before the update is stored. */
+	ret = zones_sem_check_update(zone, *new_contents, chs->changes,
+	                             msgpref);
+	if (ret != KNOT_EOK) {
+		xfrin_rollback_update(zone->contents, new_contents,
+		                      &chs->changes);
+		knot_free_changesets(&journal_chs);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	/* Serialize and store changesets including signatures. */
+	journal_t *transaction = zones_store_changesets_begin(zone);
+	if (transaction != NULL) {
+		ret = zones_store_changesets(zone, journal_chs);
+	} else {
+		ret = KNOT_ERROR;
+	}
+	if (ret == KNOT_EOK) {
+		ret = zones_store_changesets_commit(transaction);
+		transaction = NULL;
+	}
+	knot_free_changesets(&journal_chs);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Failed to serialize and store "
+		               "changesets - %s\n", msgpref,
+		               knot_strerror(ret));
+		if (transaction != NULL) {
+			zones_store_changesets_rollback(transaction);
+		}
+		xfrin_rollback_update(zone->contents, new_contents,
+		                      &chs->changes);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
+	/* Switch zone contents. */
+	ret = xfrin_switch_zone(zone, *new_contents, type);
+	if (ret != KNOT_EOK) {
+		log_zone_error("%s Failed to replace current zone - %s\n",
+		               msgpref, knot_strerror(ret));
+		xfrin_rollback_update(zone->contents, new_contents,
+		                      &chs->changes);
+		knot_free_changesets(&chs);
+		return KNOT_ERROR;
+	}
+
+	xfrin_cleanup_successful_update(&chs->changes);
+	knot_free_changesets(&chs);
+	return KNOT_EOK;
+}
+
 int zones_store_and_apply_chgsets(knot_changesets_t *chs,
                                   knot_zone_t *zone,
                                   knot_zone_contents_t **new_contents,
@@ -3107,6 +4137,12 @@ int zones_store_and_apply_chgsets(knot_changesets_t *chs,
 	int apply_ret = KNOT_EOK;
 	int switch_ret = KNOT_EOK;
 
+	/* Incoming changes to a signed zone must be re-signed. */
+	if (type == XFR_TYPE_IIN && zones_dnssec_enabled(zone)) {
+		return zones_dnssec_store_and_apply(chs, zone, new_contents,
+		                                    msgpref, type);
+	}
+
 	/* Serialize and store changesets. */
 	dbg_xfr("xfr: IXFR/IN serializing and saving changesets\n");
 	journal_t *transaction = zones_store_changesets_begin(zone);
@@ -3138,6 +4174,17 @@ int zones_store_and_apply_chgsets(knot_changesets_t *chs,
 		return apply_ret;  // propagate the error above
 	}
 
+	/* Check the changed nodes before the transaction is committed. */
+	ret = zones_sem_check_update(zone, *new_contents, chs->changes,
+	                             msgpref);
+	if (ret != KNOT_EOK) {
+		zones_store_changesets_rollback(transaction);
+		xfrin_rollback_update(zone->contents, new_contents,
+		                      &chs->changes);
+		knot_free_changesets(&chs);
+		return ret;
+	}
+
 	/* Commit transaction. */
 	ret = zones_store_changesets_commit(transaction);
 	if (ret != KNOT_EOK) {
@@ -28,6 +28,7 @@
 #define _KNOTD_ZONES_H_
 
 #include <stddef.h>
+#include <time.h>
 
 #include "common/lists.h"
 #include "common/acl.h"
@@ -45,6 +46,8 @@
 #define ZONES_JITTER_PCT    10 /*!< +-N% jitter to timers. */
 #define IXFR_DBSYNC_TIMEOUT (60*1000) /*!< Database sync timeout = 60s. */
 #define AXFR_BOOTSTRAP_RETRY (30*1000) /*!< Interval between AXFR BS retries. */
+#define DNSSEC_REFRESH_SLICE (1000) /*!< Interval between re-sign slices. */
+#define DNSSEC_REFRESH_MAX (3600*1000) /*!< Max. interval of re-sign check. */
 
 /*!
  * \brief Zone-related data.
@@ -60,6 +63,17 @@ typedef struct zonedata_t
 	/*! \brief Zone data lock for exclusive access. */
 	pthread_mutex_t lock;
 
+	/*! \brief Serializes writers of the zonefile. */
+	pthread_mutex_t sync_lock;
+
+	/*! \brief Serializes changes of zone contents.
+	 *
+	 * Held from reading the contents to be changed until the new
+	 * contents are switched. Must not be taken in RCU read-side
+	 * critical section, its holder waits for readers on switch.
+	 */
+	pthread_mutex_t update_lock;
+
 	/*! \brief Access control lists. */
 	acl_t *xfr_out;    /*!< ACL for xfr-out.*/
 	acl_t *notify_in;  /*!< ACL for notify-in.*/
@@ -83,6 +97,12 @@ typedef struct zonedata_t
 	journal_t *ixfr_db;
 	struct event_t *ixfr_dbsync;   /*!< Syncing IXFR db to zonefile. */
 	uint32_t zonefile_serial;
+	time_t zonefile_dumped;        /*!< Last zonefile rewrite. */
+
+	/*! \brief DNSSEC signature refresh. */
+	struct zone_expiry *dnssec_expiry; /*!< Signature expiry index. */
+	struct event_t *dnssec_timer;      /*!< Timer for re-signing. */
+	struct zones_keyset *dnssec_keys;  /*!< Cached signing keys. */
 } zonedata_t;
 
 /*!
@@ -110,13 +130,55 @@ typedef struct zonedata_t
 int zones_update_db_from_config(const conf_t *conf, knot_nameserver_t *ns,
                                knot_zonedb_t **db_old);
 
+/*!
+ * \brief Load zones and add them to the running name server.
+ *
+ * The zone index is copied, new zones are inserted into the copy and the
+ * copy replaces the database inside the nameserver. Zones already present
+ * in the database are left untouched and are not reloaded.
+ *
+ * \note Zone configs are removed from the list, loaded zones take over their
+ *       ownership and the rest is freed.
+ * \note Added zones are recorded in the zone state file, so they are kept
+ *       after reload and restart (see conf_zone_state_save()).
+ *
+ * \param conf Configuration with the storage directory.
+ * \param ns Nameserver which holds the zone database.
+ * \param zone_conf List of zone configs to add.
+ *
+ * \return Number of added zones or error code (negative).
+ */
+int zones_db_add(const conf_t *conf, knot_nameserver_t *ns, list *zone_conf);
+
+/*!
+ * \brief Remove zones from the running name server.
+ *
+ * Same as zones_db_add(), the database is replaced by a copy without the
+ * removed zones. The zones are discarded once no reader can access them.
+ *
+ * Removed zones are recorded in the zone state file as well.
+ *
+ * \param conf Configuration with the storage directory.
+ * \param ns Nameserver which holds the zone database.
+ * \param names Names of the zones to remove.
+ * \param count Number of zone names.
+ *
+ * \return Number of removed zones or error code (negative).
+ */
+int zones_db_remove(const conf_t *conf, knot_nameserver_t *ns,
+                    const knot_dname_t **names, size_t count);
+
 /*!
  * \brief Sync zone data back to text zonefile.
  *
  * In case when SOA serial of the zonefile differs from the SOA serial of the
  * loaded zone, zonefile needs to be updated.
  *
- * \note Current implementation rewrites the zone file.
+ * \note Current implementation rewrites the zone file. Caller must hold
+ *       the zone update lock (see zonedata_t), which keeps the contents
+ *       from being switched while they are written. The zone is written
+ *       outside of RCU read-side section, so switches of other zones
+ *       don't wait for it.
  *
  * \param zone Evaluated zone.
  * \param journal Journal to sync.
@@ -279,6 +341,9 @@ int zones_xfr_load_changesets(knot_ns_xfr_t *xfr, uint32_t serial_from,
  *
  * Also saves changesets to journal, which is taken from old zone.
  *
+ * \note Caller must hold the update lock of the old zone, full journal
+ *       forces its zone file sync (see zones_zonefile_sync()).
+ *
  * \param old_zone Old zone, previously served by server.
  * \param new_zone New zone, to be served by server, after creating changesets.
  *
@@ -291,6 +356,14 @@ int zones_xfr_load_changesets(knot_ns_xfr_t *xfr, uint32_t serial_from,
 int zones_create_and_save_changesets(const knot_zone_t *old_zone,
                                      const knot_zone_t *new_zone);
 
+/*!
+ * \brief Stores changesets to journal, applies them and switches the zone.
+ *
+ * Changesets are consumed regardless of the result.
+ *
+ * \note Caller must hold the zone update lock (see zonedata_t), changesets
+ *       must be made against the current zone contents.
+ */
 int zones_store_and_apply_chgsets(knot_changesets_t *chs,
                                   knot_zone_t *zone,
                                   knot_zone_contents_t **new_contents,
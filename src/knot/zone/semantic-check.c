@@ -30,6 +30,7 @@
 #include "common/crc.h"
 #include "common/descriptor.h"
 #include "common/mempattern.h"
+#include "knot/server/dthreads.h"
 
 #include "semantic-check.h"
 
@@ -122,6 +123,9 @@ static char *error_messages[(-ZC_ERR_UNKNOWN) + 1] = {
 
 static const uint MAX_CNAME_CYCLE_DEPTH = 15;
 
+/*! \brief Number of nodes checked as one unit by a checking thread. */
+#define SEM_CHECK_CHUNK 1024
+
 err_handler_t *handler_new(int log_cname, int log_glue, int log_rrsigs,
                            int log_nsec, int log_nsec3)
 {
@@ -135,10 +139,48 @@ err_handler_t *handler_new(int log_cname, int log_glue, int log_rrsigs,
 	handler->options.log_rrsigs = log_rrsigs;
 	handler->options.log_nsec = log_nsec;
 	handler->options.log_nsec3 = log_nsec3;
+	handler->deferred = NULL;
+	handler->deferred_count = 0;
+	handler->deferred_size = 0;
+	handler->defer = 0;
 
 	return handler;
 }
 
+/*!
+ * \brief Records error to be handled later by err_handler_merge().
+ */
+static int err_handler_defer(err_handler_t *handler, const knot_node_t *node,
+                             int error, const char *data)
+{
+	if (handler->deferred_count == handler->deferred_size) {
+		size_t size = handler->deferred_size > 0 ?
+		              2 * handler->deferred_size : 16;
+		err_deferred_t *deferred =
+			realloc(handler->deferred, size * sizeof(err_deferred_t));
+		if (deferred == NULL) {
+			return KNOT_ENOMEM;
+		}
+		handler->deferred = deferred;
+		handler->deferred_size = size;
+	}
+
+	char *copy = NULL;
+	if (data != NULL) {
+		copy = strdup(data);
+		if (copy == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	err_deferred_t *item = &handler->deferred[handler->deferred_count++];
+	item->node = node;
+	item->error = error;
+	item->data = copy;
+
+	return KNOT_EOK;
+}
+
 /*!
  * \brief Prints error message with node information.
  *
@@ -197,6 +239,10 @@ int err_handler_handle_error(err_handler_t *handler, const knot_node_t *node,
 		return KNOT_EINVAL;
 	}
 
+	if (handler->defer) {
+		return err_handler_defer(handler, node, error, data);
+	}
+
 	/* 
 	 * A missing SOA can only occur once, so there needn't be 
 	 * an option for it.
@@ -237,6 +283,22 @@ int err_handler_handle_error(err_handler_t *handler, const knot_node_t *node,
 	return KNOT_EOK;
 }
 
+void err_handler_merge(err_handler_t *handler, err_handler_t *from)
+{
+	assert(handler && from);
+	for (size_t i = 0; i < from->deferred_count; ++i) {
+		err_deferred_t *item = &from->deferred[i];
+		err_handler_handle_error(handler, item->node, item->error,
+		                         item->data);
+		free(item->data);
+	}
+
+	free(from->deferred);
+	from->deferred = NULL;
+	from->deferred_count = 0;
+	from->deferred_size = 0;
+}
+
 void err_handler_log_all(err_handler_t *handler)
 {
 	if (handler == NULL) {
@@ -792,6 +854,71 @@ static int rdata_nsec_to_type_array(const knot_rrset_t *rrset, size_t pos,
 	return KNOT_EOK;
 }
 
+/*!
+ * \brief Semantic check - check that NSEC3 next hashed owner is in the zone.
+ *
+ * \param zone Current zone.
+ * \param node Node the error is reported for.
+ * \param nsec3_rrset NSEC3 RRSet to be checked.
+ * \param handler Error handler
+ *
+ * \retval KNOT_EOK if the check was done.
+ * \retval KNOT_ERROR if the next owner could not be constructed.
+ */
+static int check_nsec3_next(knot_zone_contents_t *zone, knot_node_t *node,
+                            const knot_rrset_t *nsec3_rrset,
+                            err_handler_t *handler)
+{
+	uint8_t *next_dname_str = NULL;
+	uint8_t next_dname_size = 0;
+	uint8_t *next_dname_decoded = NULL;
+	knot_rrset_rdata_nsec3_next_hashed(nsec3_rrset, 0, &next_dname_str,
+	                                   &next_dname_size);
+	size_t real_size =
+		base32hex_encode_alloc(next_dname_str,
+	                               next_dname_size, &next_dname_decoded);
+	if (real_size <= 0 || next_dname_decoded == NULL) {
+		dbg_semcheck("Could not encode base32 string!\n");
+		free(next_dname_decoded);
+		return KNOT_ERROR;
+	}
+
+	/* This is why we allocate maximum length of decoded string + 1 */
+//	memmove(next_dname_decoded + 1, next_dname_decoded, real_size);
+//	next_dname_decoded[0] = real_size;
+	
+	/* Local allocation, will be discarded. */
+	knot_dname_t *next_dname =
+		knot_dname_new_from_str((char *)next_dname_decoded,
+					   real_size, NULL);
+	if (next_dname == NULL) {
+		free(next_dname_decoded);
+		log_zone_warning("Could not create new dname!\n");
+		return KNOT_ERROR;
+	}
+	
+	free(next_dname_decoded);
+	knot_dname_to_lower(next_dname);
+	
+	if (knot_dname_cat(next_dname,
+		     knot_node_owner(knot_zone_contents_apex(zone))) == NULL) {
+		log_zone_warning("Could not concatenate dnames!\n");
+		knot_dname_free(&next_dname);
+		return KNOT_ERROR;
+
+	}
+
+	if (knot_zone_contents_find_nsec3_node(zone, next_dname) == NULL) {
+		err_handler_handle_error(handler, node,
+					 ZC_ERR_NSEC3_RDATA_CHAIN, NULL);
+	}
+
+	/* Directly discard. */
+	knot_dname_free(&next_dname);
+
+	return KNOT_EOK;
+}
+
 /* should write error, not return values !!! */
 
 /*!
@@ -876,57 +1003,15 @@ static int check_nsec3_node_in_zone(knot_zone_contents_t *zone,
 	}
 
 	/* check that next dname is in the zone */
-	uint8_t *next_dname_str = NULL;
-	uint8_t next_dname_size = 0;
-	uint8_t *next_dname_decoded = NULL;
-	knot_rrset_rdata_nsec3_next_hashed(nsec3_rrset, 0, &next_dname_str,
-	                                   &next_dname_size);
-	size_t real_size =
-		base32hex_encode_alloc(next_dname_str,
-	                               next_dname_size, &next_dname_decoded);
-	if (real_size <= 0 || next_dname_decoded == NULL) {
-		dbg_semcheck("Could not encode base32 string!\n");
-		free(next_dname_decoded);
-		return KNOT_ERROR;
-	}
-
-	/* This is why we allocate maximum length of decoded string + 1 */
-//	memmove(next_dname_decoded + 1, next_dname_decoded, real_size);
-//	next_dname_decoded[0] = real_size;
-	
-	/* Local allocation, will be discarded. */
-	knot_dname_t *next_dname =
-		knot_dname_new_from_str((char *)next_dname_decoded,
-					   real_size, NULL);
-	if (next_dname == NULL) {
-		free(next_dname_decoded);
-		log_zone_warning("Could not create new dname!\n");
-		return KNOT_ERROR;
-	}
-	
-	free(next_dname_decoded);
-	knot_dname_to_lower(next_dname);
-	
-	if (knot_dname_cat(next_dname,
-		     knot_node_owner(knot_zone_contents_apex(zone))) == NULL) {
-		log_zone_warning("Could not concatenate dnames!\n");
-		knot_dname_free(&next_dname);
-		return KNOT_ERROR;
-
-	}
-
-	if (knot_zone_contents_find_nsec3_node(zone, next_dname) == NULL) {
-		err_handler_handle_error(handler, node,
-					 ZC_ERR_NSEC3_RDATA_CHAIN, NULL);
+	int ret = check_nsec3_next(zone, node, nsec3_rrset, handler);
+	if (ret != KNOT_EOK) {
+		return ret;
 	}
-
-	/* Directly discard. */
-	knot_dname_free(&next_dname);
 	
 	size_t arr_size;
 	uint16_t *array = NULL;
 	/* TODO only works for one NSEC3 RR. */
-	int ret = rdata_nsec_to_type_array(nsec3_rrset, 0, &array, &arr_size);
+	ret = rdata_nsec_to_type_array(nsec3_rrset, 0, &array, &arr_size);
 	if (ret != KNOT_EOK) {
 		dbg_semcheck("semchecks: check_nsec3_node: Could not "
 		             "convert NSEC to type array. Reason: %s\n",
@@ -1354,56 +1439,106 @@ static int semantic_checks_dnssec(knot_zone_contents_t *zone,
 	return KNOT_EOK;
 }
 
+/*! \brief Range of nodes checked as one unit. */
+typedef struct {
+	err_handler_t handler;  /*!< Deferring handler of the range. */
+	knot_node_t *last_node; /*!< Last node in the NSEC chain or NULL. */
+	int fatal_error;        /*!< Fatal error found in the range. */
+} sem_check_chunk_t;
+
+/*! \brief Semantic check job shared by checking threads. */
+typedef struct {
+	knot_zone_contents_t *zone;
+	int do_checks;
+	knot_node_t **nodes;
+	size_t count;
+	size_t size;
+	sem_check_chunk_t *chunks;
+	size_t nchunks;
+	size_t next; /*!< Next chunk to check. */
+	int ret;
+} sem_check_job_t;
+
+/*! \brief Collects nodes in the tree order. */
+static void sem_check_collect(knot_node_t *node, void *data)
+{
+	sem_check_job_t *job = (sem_check_job_t *)data;
+	if (job->ret != KNOT_EOK) {
+		return;
+	}
+
+	if (job->count == job->size) {
+		size_t size = job->size > 0 ? 2 * job->size : 1024;
+		knot_node_t **nodes = realloc(job->nodes,
+		                              size * sizeof(knot_node_t *));
+		if (nodes == NULL) {
+			job->ret = KNOT_ENOMEM;
+			return;
+		}
+		job->nodes = nodes;
+		job->size = size;
+	}
+
+	job->nodes[job->count++] = node;
+}
+
 /*!
- * \brief Function called by zone traversal function. Used to call
- *        knot_zone_save_enclosers.
+ * \brief Runs all checks on one node.
  *
- * \param node Node to be searched.
- * \param data Arguments.
+ * \param zone Checked zone.
+ * \param node Node to be checked.
+ * \param do_checks Level of semantic checks.
+ * \param handler Error handler.
+ * \param last_node Set to the last node in the NSEC chain if found.
+ * \param fatal_error Set if a fatal error was found.
  */
-static void do_checks_in_tree(knot_node_t *node, void *data)
+static void do_checks_in_node(knot_zone_contents_t *zone, knot_node_t *node,
+                              int do_checks, err_handler_t *handler,
+                              knot_node_t **last_node, int *fatal_error)
 {
-	dbg_semcheck_verb("semcheck: do_check_in_tree: Checking node: %s\n",
+	dbg_semcheck_verb("semcheck: do_check_in_node: Checking node: %s\n",
 	                  knot_dname_to_str(node->owner));
-	assert(data != NULL);
-	arg_t *args = (arg_t *)data;
-
-	knot_rrset_t **rrsets = knot_node_get_rrsets(node);
-	short count = knot_node_rrset_count(node);
-
-	assert(count == 0 || rrsets != NULL);
-
-	knot_zone_contents_t *zone = (knot_zone_contents_t *)args->arg1;
-
-	assert(zone);
 
-	knot_node_t *first_node = (knot_node_t *)args->arg4;
-	knot_node_t **last_node = (knot_node_t **)args->arg5;
-
-	err_handler_t *handler = (err_handler_t *)args->arg6;
-	
-	char do_checks = *((char *)(args->arg3));
-
-	if (do_checks) {
-		sem_check_node_plain(zone, node, do_checks, handler, 0,
-		                      (int *)args->arg7);
-	} else {
-		assert(handler);
+	if (!do_checks) {
 		/* All CNAME/DNAME checks are mandatory. */
-		handler->options.log_cname = 1;
 		int check_level = 1 + (zone_is_secure(zone) ? 1 : 0);
 		sem_check_node_plain(zone, node, check_level, handler, 1,
-		                      (int *)args->arg7);
-		free(rrsets);
+		                     fatal_error);
 		return;
 	}
 
+	sem_check_node_plain(zone, node, do_checks, handler, 0, fatal_error);
+
 	if (do_checks > 1) {
-		semantic_checks_dnssec(zone, node, first_node, last_node,
-				       handler, do_checks == 3);
+		semantic_checks_dnssec(zone, node, NULL, last_node, handler,
+		                       do_checks == 3);
+	}
+}
+
+/*! \brief Checks ranges of nodes until none is left. */
+static int sem_check_worker_run(dthread_t *thread)
+{
+	sem_check_job_t *job = (sem_check_job_t *)thread->data;
+
+	while (1) {
+		size_t i = __sync_fetch_and_add(&job->next, 1);
+		if (i >= job->nchunks) {
+			break;
+		}
+
+		size_t end = (i + 1) * SEM_CHECK_CHUNK;
+		if (end > job->count) {
+			end = job->count;
+		}
+		sem_check_chunk_t *chunk = &job->chunks[i];
+		for (size_t n = i * SEM_CHECK_CHUNK; n < end; ++n) {
+			do_checks_in_node(job->zone, job->nodes[n],
+			                  job->do_checks, &chunk->handler,
+			                  &chunk->last_node, &chunk->fatal_error);
+		}
 	}
 
-	free(rrsets);
+	return KNOT_EOK;
 }
 
 int zone_do_sem_checks(knot_zone_contents_t *zone, int do_checks,
@@ -1413,20 +1548,77 @@ int zone_do_sem_checks(knot_zone_contents_t *zone, int do_checks,
 	if (!handler) {
 		return KNOT_EINVAL;
 	}
+
+	if (!do_checks) {
+		/* All CNAME/DNAME checks are mandatory. */
+		handler->options.log_cname = 1;
+	}
+
+	sem_check_job_t job;
+	memset(&job, 0, sizeof(job));
+	job.zone = zone;
+	job.do_checks = do_checks;
+	job.ret = KNOT_EOK;
+
+	knot_zone_contents_tree_apply_inorder(zone, sem_check_collect, &job);
+	if (job.ret != KNOT_EOK) {
+		free(job.nodes);
+		return job.ret;
+	}
+
+	job.nchunks = (job.count + SEM_CHECK_CHUNK - 1) / SEM_CHECK_CHUNK;
+	job.chunks = calloc(job.nchunks, sizeof(sem_check_chunk_t));
+	if (job.chunks == NULL && job.nchunks > 0) {
+		free(job.nodes);
+		return KNOT_ENOMEM;
+	}
+
+	/* Errors of each range wait for the ranges before it. */
+	for (size_t i = 0; i < job.nchunks; ++i) {
+		job.chunks[i].handler.options = handler->options;
+		job.chunks[i].handler.defer = 1;
+	}
+
+	/* Do not spawn threads that would have nothing to do. */
+	int threads = dt_optimal_size();
+	if (threads < 1) {
+		threads = 1;
+	}
+	if ((size_t)threads > job.nchunks) {
+		threads = job.nchunks;
+	}
+
+	dt_unit_t *unit = NULL;
+	if (threads > 1) {
+		unit = dt_create_coherent(threads, sem_check_worker_run, &job);
+	}
+	if (unit != NULL) {
+		dt_start(unit);
+		dt_join(unit);
+		dt_delete(&unit);
+	} else if (job.nchunks > 0) {
+		/* Check in this thread. */
+		dthread_t thread;
+		memset(&thread, 0, sizeof(thread));
+		thread.data = &job;
+		sem_check_worker_run(&thread);
+	}
+
+	/* Handle errors in the zone order, the last NSEC node found wins. */
 	knot_node_t *last_node = NULL;
-	arg_t arguments;
-	arguments.arg1 = zone;
-	arguments.arg3 = &do_checks;
-	arguments.arg4 = NULL;
-	arguments.arg5 = &last_node;
-	arguments.arg6 = handler;
 	int fatal_error = 0;
-	arguments.arg7 = (void *)&fatal_error;
+	for (size_t i = 0; i < job.nchunks; ++i) {
+		sem_check_chunk_t *chunk = &job.chunks[i];
+		err_handler_merge(handler, &chunk->handler);
+		if (chunk->last_node != NULL) {
+			last_node = chunk->last_node;
+		}
+		fatal_error |= chunk->fatal_error;
+	}
+
+	free(job.chunks);
+	free(job.nodes);
 
-	knot_zone_contents_tree_apply_inorder(zone,
-			   do_checks_in_tree,
-			   (void *)&arguments);
-	
 	if (fatal_error) {
 		return KNOT_ERROR;
 	}
@@ -1437,6 +1629,258 @@ int zone_do_sem_checks(knot_zone_contents_t *zone, int do_checks,
 	return KNOT_EOK;
 }
 
+/*! \brief Nodes touched by an update. */
+typedef struct {
+	knot_node_t **nodes;
+	size_t count;
+	size_t size;
+} sem_check_nodes_t;
+
+/*! \brief Adds node to the set, NULL is ignored. */
+static int sem_check_nodes_add(sem_check_nodes_t *set, const knot_node_t *node)
+{
+	if (node == NULL) {
+		return KNOT_EOK;
+	}
+
+	if (set->count == set->size) {
+		size_t size = set->size > 0 ? 2 * set->size : 64;
+		knot_node_t **nodes = realloc(set->nodes,
+		                              size * sizeof(knot_node_t *));
+		if (nodes == NULL) {
+			return KNOT_ENOMEM;
+		}
+		set->nodes = nodes;
+		set->size = size;
+	}
+
+	set->nodes[set->count++] = (knot_node_t *)node;
+	return KNOT_EOK;
+}
+
+/*! \brief Compares nodes by owner in canonical order. */
+static int sem_check_nodes_cmp(const void *a, const void *b)
+{
+	const knot_node_t *n1 = *(const knot_node_t **)a;
+	const knot_node_t *n2 = *(const knot_node_t **)b;
+	return knot_dname_compare(knot_node_owner(n1), knot_node_owner(n2));
+}
+
+/*! \brief Sorts nodes in the zone order and drops duplicates. */
+static void sem_check_nodes_unique(sem_check_nodes_t *set)
+{
+	if (set->count == 0) {
+		return;
+	}
+
+	qsort(set->nodes, set->count, sizeof(knot_node_t *),
+	      sem_check_nodes_cmp);
+
+	size_t count = 1;
+	for (size_t i = 1; i < set->count; ++i) {
+		if (set->nodes[i] != set->nodes[count - 1]) {
+			set->nodes[count++] = set->nodes[i];
+		}
+	}
+	set->count = count;
+}
+
+/*!
+ * \brief Adds nodes affected by a change of the given owner.
+ *
+ * The node itself is added if it is still in the zone, together with its
+ * parent (delegation and glue checks) and its predecessor in canonical
+ * order, whose NSEC or NSEC3 record points to the changed name.
+ */
+static int sem_check_owner(knot_zone_contents_t *zone,
+                           const knot_dname_t *owner, int nsec3,
+                           sem_check_nodes_t *nodes,
+                           sem_check_nodes_t *nsec3_nodes)
+{
+	if (owner == NULL) {
+		return KNOT_EOK;
+	}
+
+	/* Removed NSEC3 nodes are recognized by their records only. */
+	const knot_node_t *nsec3_node =
+		knot_zone_contents_find_nsec3_node(zone, owner);
+	if (nsec3 || nsec3_node != NULL) {
+		int ret = sem_check_nodes_add(nsec3_nodes, nsec3_node);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		return sem_check_nodes_add(nsec3_nodes,
+			knot_zone_contents_get_previous_nsec3(zone, owner));
+	}
+
+	const knot_node_t *node = NULL;
+	const knot_node_t *encloser = NULL;
+	const knot_node_t *previous = NULL;
+	int ret = knot_zone_contents_find_dname(zone, owner, &node, &encloser,
+	                                        &previous);
+	if (ret < 0) {
+		/* Not in the zone, nothing to check. */
+		return KNOT_EOK;
+	}
+
+	ret = sem_check_nodes_add(nodes, node);
+	if (ret == KNOT_EOK && node != NULL) {
+		ret = sem_check_nodes_add(nodes, knot_node_parent(node));
+	}
+	if (ret == KNOT_EOK) {
+		ret = sem_check_nodes_add(nodes, encloser);
+	}
+	if (ret == KNOT_EOK) {
+		ret = sem_check_nodes_add(nodes, previous);
+	}
+
+	return ret;
+}
+
+/*! \brief Checks whether the RRSet belongs to the NSEC3 tree. */
+static int sem_check_rrset_is_nsec3(const knot_rrset_t *rrset)
+{
+	uint16_t type = knot_rrset_type(rrset);
+	if (type == KNOT_RRTYPE_NSEC3) {
+		return 1;
+	}
+
+	return type == KNOT_RRTYPE_RRSIG &&
+	       knot_rrset_rdata_rr_count(rrset) > 0 &&
+	       knot_rrset_rdata_rrsig_type_covered(rrset) ==
+	       KNOT_RRTYPE_NSEC3;
+}
+
+/*! \brief Collects nodes affected by the update. */
+static int sem_check_collect_changes(knot_zone_contents_t *zone,
+                                     const knot_changes_t *changes,
+                                     sem_check_nodes_t *nodes,
+                                     sem_check_nodes_t *nsec3_nodes)
+{
+	int ret = KNOT_EOK;
+
+	/* Modified and new RRSets. */
+	for (int i = 0; ret == KNOT_EOK && i < changes->new_rrsets_count; ++i) {
+		const knot_rrset_t *rrset = changes->new_rrsets[i];
+		if (rrset == NULL) {
+			continue;
+		}
+		ret = sem_check_owner(zone, knot_rrset_owner(rrset),
+		                      sem_check_rrset_is_nsec3(rrset),
+		                      nodes, nsec3_nodes);
+	}
+
+	/* Removed RRSets. */
+	for (int i = 0; ret == KNOT_EOK && i < changes->old_rrsets_count; ++i) {
+		const knot_rrset_t *rrset = changes->old_rrsets[i];
+		if (rrset == NULL) {
+			continue;
+		}
+		ret = sem_check_owner(zone, knot_rrset_owner(rrset),
+		                      sem_check_rrset_is_nsec3(rrset),
+		                      nodes, nsec3_nodes);
+	}
+
+	/* Removed nodes. */
+	for (int i = 0; ret == KNOT_EOK && i < changes->old_nodes_count; ++i) {
+		ret = sem_check_owner(zone,
+		                      knot_node_owner(changes->old_nodes[i]), 0,
+		                      nodes, nsec3_nodes);
+	}
+	for (int i = 0; ret == KNOT_EOK && i < changes->old_nsec3_count; ++i) {
+		ret = sem_check_owner(zone,
+		                      knot_node_owner(changes->old_nsec3[i]), 1,
+		                      nodes, nsec3_nodes);
+	}
+
+	return ret;
+}
+
+int zone_do_sem_checks_changes(knot_zone_contents_t *zone,
+                               const knot_changes_t *changes, int do_checks,
+                               err_handler_t *handler)
+{
+	if (zone == NULL || changes == NULL || handler == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (!do_checks) {
+		/* All CNAME/DNAME checks are mandatory. */
+		handler->options.log_cname = 1;
+	}
+
+	sem_check_nodes_t nodes, nsec3_nodes;
+	memset(&nodes, 0, sizeof(nodes));
+	memset(&nsec3_nodes, 0, sizeof(nsec3_nodes));
+
+	int ret = sem_check_collect_changes(zone, changes, &nodes,
+	                                    &nsec3_nodes);
+	if (ret != KNOT_EOK) {
+		free(nodes.nodes);
+		free(nsec3_nodes.nodes);
+		return ret;
+	}
+
+	sem_check_nodes_unique(&nodes);
+	sem_check_nodes_unique(&nsec3_nodes);
+
+	/* The chain as a whole is checked on load only. */
+	knot_node_t *last_node = NULL;
+	int fatal_error = 0;
+	for (size_t i = 0; i < nodes.count; ++i) {
+		/* Updates are not parsed, do the mandatory checks here. */
+		if (do_checks) {
+			sem_check_node_plain(zone, nodes.nodes[i], do_checks,
+			                     handler, 1, &fatal_error);
+		}
+		do_checks_in_node(zone, nodes.nodes[i], do_checks, handler,
+		                  &last_node, &fatal_error);
+	}
+
+	/* Links of NSEC3 nodes nobody points at are checked directly. */
+	for (size_t i = 0; do_checks == 3 && i < nsec3_nodes.count; ++i) {
+		knot_node_t *nsec3_node = nsec3_nodes.nodes[i];
+		const knot_rrset_t *nsec3_rrset =
+			knot_node_rrset(nsec3_node, KNOT_RRTYPE_NSEC3);
+		if (nsec3_rrset == NULL ||
+		    knot_rrset_rdata_rr_count(nsec3_rrset) == 0) {
+			continue;
+		}
+		ret = check_nsec3_next(zone, nsec3_node, nsec3_rrset, handler);
+		if (ret != KNOT_EOK) {
+			break;
+		}
+	}
+
+	dbg_semcheck("semcheck: checked %zu nodes and %zu NSEC3 nodes of "
+	             "the update\n", nodes.count, nsec3_nodes.count);
+
+	free(nodes.nodes);
+	free(nsec3_nodes.nodes);
+
+	if (fatal_error) {
+		return KNOT_ERROR;
+	}
+
+	return ret;
+}
+
+int zone_sem_check_level(const knot_zone_contents_t *zone)
+{
+	const knot_node_t *apex = knot_zone_contents_apex(zone);
+	const knot_rrset_t *soa_rr = knot_node_rrset(apex, KNOT_RRTYPE_SOA);
+	if (soa_rr == NULL || soa_rr->rrsigs == NULL) {
+		return 1;
+	}
+
+	/* Signed zone, NSEC3PARAM selects NSEC3 chain checks. */
+	if (knot_node_rrset(apex, KNOT_RRTYPE_NSEC3PARAM) == NULL) {
+		return 2;
+	}
+
+	return 3;
+}
+
 void log_cyclic_errors_in_zone(err_handler_t *handler,
                                knot_zone_contents_t *zone,
                                knot_node_t *last_node,
@@ -29,6 +29,7 @@
 
 #include "libknot/zone/node.h"
 #include "libknot/zone/zone-contents.h"
+#include "libknot/updates/changesets.h"
 
 /*!
  *\brief Internal error constants. General errors are added for convenience,
@@ -130,10 +131,25 @@ struct err_handler {
 	struct handler_options options; /*!< Handler options. */
 	uint errors[(-ZC_ERR_UNKNOWN) + 1]; /*!< Array with error messages */
 	uint error_count; /*!< Total error count */
+	struct err_deferred *deferred; /*!< Errors waiting to be handled. */
+	size_t deferred_count; /*!< Number of errors waiting. */
+	size_t deferred_size; /*!< Allocated size of the deferred array. */
+	char defer; /*!< Record errors instead of handling them. */
 };
 
 typedef struct err_handler err_handler_t;
 
+/*!
+ * \brief Semantic error recorded by a deferring handler.
+ */
+struct err_deferred {
+	const knot_node_t *node; /*!< Node with semantic error in it. */
+	int error; /*!< Type of error. */
+	char *data; /*!< Copy of additional info or NULL. */
+};
+
+typedef struct err_deferred err_deferred_t;
+
 /*!
  * \brief Creates new semantic error handler.
  *
@@ -165,6 +181,17 @@ int err_handler_handle_error(err_handler_t *handler,
 				    const knot_node_t *node,
 				    int error, const char *data);
 
+/*!
+ * \brief Handles errors recorded by a deferring handler.
+ *
+ * Errors are handled in the order they were recorded, as if they were
+ * passed to \a handler directly. The recorded errors are released.
+ *
+ * \param handler Error handler.
+ * \param from Deferring error handler.
+ */
+void err_handler_merge(err_handler_t *handler, err_handler_t *from);
+
 /*!
  * \brief Checks if last node in NSEC/NSEC3 chain points to first node in the
  *        chain and prints possible errors.
@@ -189,8 +216,11 @@ void log_cyclic_errors_in_zone(err_handler_t *handler,
 void err_handler_log_all(err_handler_t *handler);
 
 /*!
- * \brief Helper function - wraps its arguments into arg_t structure and
- *        calls function that does the actual work.
+ * \brief Runs semantic checks on all zone nodes.
+ *
+ * Nodes are split into ranges checked by a set of threads. Each range
+ * records its errors in a private handler, the errors are then handled by
+ * \a handler in the zone order, so the output equals a serial run.
  *
  * \param zone Zone to be searched / checked
  * \param check_level Level of semantic checks.
@@ -201,6 +231,36 @@ int zone_do_sem_checks(knot_zone_contents_t *zone, int check_level,
                        err_handler_t *handler, knot_node_t *first_nsec3_node,
                        knot_node_t *last_nsec3_node);
 
+/*!
+ * \brief Runs semantic checks on nodes affected by an applied update.
+ *
+ * Checked are the nodes owning changed records, their parents and their
+ * predecessors in the NSEC and NSEC3 chains. Whole-chain checks done on
+ * load are not repeated.
+ *
+ * \param zone Updated and adjusted zone contents.
+ * \param changes Changes done by applying the changesets to \a zone.
+ * \param do_checks Level of semantic checks, 0 for mandatory checks only.
+ * \param handler Semantic error handler.
+ *
+ * \retval KNOT_EOK if no fatal error was found.
+ * \retval KNOT_ERROR if a fatal error was found.
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_do_sem_checks_changes(knot_zone_contents_t *zone,
+                               const knot_changes_t *changes, int do_checks,
+                               err_handler_t *handler);
+
+/*!
+ * \brief Returns level of semantic checks suitable for the zone.
+ *
+ * \retval 1 for unsigned zone.
+ * \retval 2 for zone signed with NSEC.
+ * \retval 3 for zone signed with NSEC3.
+ */
+int zone_sem_check_level(const knot_zone_contents_t *zone);
+
 int sem_check_node_plain(knot_zone_contents_t *zone,
                          knot_node_t *node,
                          int do_checks,
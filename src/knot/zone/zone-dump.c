@@ -15,137 +15,351 @@
  */
 
 #include <config.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/uio.h>
 
 #include "knot/zone/zone-dump.h"
 #include "common/descriptor.h"
 #include "knot/conf/conf.h"
+#include "knot/server/dthreads.h"
 #include "knot/server/zones.h"
 #include "libknot/libknot.h"
 
 /*! \brief Size of auxiliary buffer. */
 #define DUMP_BUF_LEN (70 * 1024)
 
-/*! \brief Dump parameters. */
+/*! \brief Number of nodes formatted by a thread at once. */
+#define DUMP_CHUNK 512
+
+/*! \brief Maximum number of formatted chunks waiting for write per thread. */
+#define DUMP_WINDOW 4
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*! \brief Text of a range of nodes. */
 typedef struct {
-	int      ret;
-	FILE     *file;
 	char     *buf;
-	size_t   buflen;
+	size_t   len;
+	size_t   size;
 	uint64_t rr_count;
+	int      done;
+} dump_chunk_t;
+
+/*! \brief Dump job shared by formatting threads and the writer. */
+typedef struct {
+	knot_node_t **nodes;
+	size_t       count;
+	size_t       size;
+	dump_chunk_t *chunks;
+	size_t       nchunks;
+	size_t       next;    /*!< Next chunk to format. */
+	size_t       written; /*!< Number of chunks written. */
+	size_t       window;  /*!< Maximum of chunks ahead of the writer. */
+	int          ret;
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
 	const knot_dname_t *origin;
 	const knot_dump_style_t *style;
-} dump_params_t;
+} dump_job_t;
 
-static void apex_node_dump_text(knot_node_t *node, dump_params_t *params)
+/*! \brief Collects nodes in the tree order. */
+static void node_collect(knot_node_t *node, void *data)
 {
-	knot_rrset_t *rr = knot_node_get_rrset(node, KNOT_RRTYPE_SOA);
-
-	// Dump SOA record as a first.
-	if (knot_rrset_txt_dump(rr, params->buf, params->buflen,
-	                        params->style) < 0) {
-		params->ret = KNOT_ENOMEM;
+	dump_job_t *job = (dump_job_t *)data;
+	if (job->ret != KNOT_EOK) {
 		return;
 	}
-	params->rr_count += rr->rdata_count;
+
+	if (job->count == job->size) {
+		size_t size = job->size > 0 ? 2 * job->size : 1024;
+		knot_node_t **nodes = realloc(job->nodes,
+		                              size * sizeof(knot_node_t *));
+		if (nodes == NULL) {
+			job->ret = KNOT_ENOMEM;
+			return;
+		}
+		job->nodes = nodes;
+		job->size = size;
+	}
+
+	job->nodes[job->count++] = node;
+}
+
+/*! \brief Appends RRSet text to the chunk buffer. */
+static int rrset_dump_text(const knot_rrset_t *rr, dump_chunk_t *chunk,
+                           const knot_dump_style_t *style)
+{
+	/* Keep room for the largest RRSet dumped in place. */
+	if (chunk->size - chunk->len < DUMP_BUF_LEN) {
+		size_t size = chunk->size > 0 ? chunk->size : DUMP_BUF_LEN;
+		while (size - chunk->len < DUMP_BUF_LEN) {
+			size *= 2;
+		}
+		char *buf = realloc(chunk->buf, size);
+		if (buf == NULL) {
+			return KNOT_ENOMEM;
+		}
+		chunk->buf = buf;
+		chunk->size = size;
+	}
+
+	int ret = knot_rrset_txt_dump(rr, chunk->buf + chunk->len,
+	                              DUMP_BUF_LEN, style);
+	if (ret < 0) {
+		return KNOT_ENOMEM;
+	}
+	chunk->len += ret;
+
+	chunk->rr_count += rr->rdata_count;
 	if (rr->rrsigs != NULL) {
-		params->rr_count += rr->rrsigs->rdata_count;
+		chunk->rr_count += rr->rrsigs->rdata_count;
+	}
+
+	return KNOT_EOK;
+}
+
+static int node_dump_text(const knot_node_t *node, dump_chunk_t *chunk,
+                          const dump_job_t *job)
+{
+	int ret = KNOT_EOK;
+
+	// Dump SOA record as a first.
+	int apex = (node->owner == job->origin);
+	if (apex) {
+		knot_rrset_t *rr = knot_node_get_rrset(node,
+		                                       KNOT_RRTYPE_SOA);
+		ret = rrset_dump_text(rr, chunk, job->style);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
 	}
-	fprintf(params->file, "%s", params->buf);
 
 	const knot_rrset_t **rrsets = knot_node_rrsets(node);
 
 	// Dump other records.
 	for (uint16_t i = 0; i < node->rrset_count; i++) {
-		if (rrsets[i]->type != KNOT_RRTYPE_SOA) {
-			if (knot_rrset_txt_dump(rrsets[i], params->buf,
-			                        params->buflen, params->style)
-			    < 0) {
-				params->ret = KNOT_ENOMEM;
-				free(rrsets);
-				return;
-			}
-			params->rr_count += rrsets[i]->rdata_count;
-			if (rrsets[i]->rrsigs != NULL) {
-				params->rr_count +=
-					rrsets[i]->rrsigs->rdata_count;
-			}
-			fprintf(params->file, "%s", params->buf);
+		if (apex && rrsets[i]->type == KNOT_RRTYPE_SOA) {
+			continue;
+		}
+		ret = rrset_dump_text(rrsets[i], chunk, job->style);
+		if (ret != KNOT_EOK) {
+			break;
 		}
 	}
 
 	free(rrsets);
 
-	params->ret = KNOT_EOK;
+	return ret;
 }
 
-static void node_dump_text(knot_node_t *node, void *data)
+/*! \brief Formatting thread, formats chunks in the order of the tree. */
+static int dump_worker_run(dthread_t *thread)
 {
-	dump_params_t *params = (dump_params_t *)data;
+	dump_job_t *job = thread->data;
+
+	while (1) {
+		/* Take next chunk unless too far ahead of the writer. */
+		pthread_mutex_lock(&job->lock);
+		while (job->ret == KNOT_EOK && job->next < job->nchunks &&
+		       job->next >= job->written + job->window) {
+			pthread_cond_wait(&job->cond, &job->lock);
+		}
+		if (job->ret != KNOT_EOK || job->next >= job->nchunks) {
+			pthread_mutex_unlock(&job->lock);
+			break;
+		}
+		size_t i = job->next++;
+		pthread_mutex_unlock(&job->lock);
+
+		/* Format nodes of the chunk. */
+		dump_chunk_t *chunk = &job->chunks[i];
+		size_t end = (i + 1) * DUMP_CHUNK;
+		if (end > job->count) {
+			end = job->count;
+		}
+		int ret = KNOT_EOK;
+		for (size_t n = i * DUMP_CHUNK; ret == KNOT_EOK && n < end; ++n) {
+			ret = node_dump_text(job->nodes[n], chunk, job);
+		}
 
-	// Zone apex rrsets.
-	if (node->owner == params->origin) {
-		apex_node_dump_text(node, params);
-		return;
+		pthread_mutex_lock(&job->lock);
+		chunk->done = 1;
+		if (ret != KNOT_EOK && job->ret == KNOT_EOK) {
+			job->ret = ret;
+		}
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->lock);
 	}
 
-	const knot_rrset_t **rrsets = knot_node_rrsets(node);
+	return KNOT_EOK;
+}
 
-	// Dump non-apex rrsets.
-	for (uint16_t i = 0; i < node->rrset_count; i++) {
-		if (knot_rrset_txt_dump(rrsets[i], params->buf, params->buflen,
-		                        params->style) < 0) {
-			params->ret = KNOT_ENOMEM;
-			free(rrsets);
-			return;
+/*! \brief Writes all the vectors, possibly in several calls. */
+static int dump_writev(int fd, struct iovec *iov, int iovcnt)
+{
+	while (iovcnt > 0) {
+		ssize_t n = writev(fd, iov, iovcnt);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return KNOT_ERROR;
+		}
+
+		/* Skip written vectors. */
+		while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			++iov;
+			--iovcnt;
 		}
-		params->rr_count += rrsets[i]->rdata_count;
-		if (rrsets[i]->rrsigs != NULL) {
-			params->rr_count += rrsets[i]->rrsigs->rdata_count;
+		if (iovcnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
 		}
-		fprintf(params->file, "%s", params->buf);
 	}
 
-	free(rrsets);
+	return KNOT_EOK;
+}
+
+/*! \brief Writes formatted chunks in order as they are completed. */
+static int dump_write(dump_job_t *job, int fd, uint64_t *rr_count)
+{
+	struct iovec iov[IOV_MAX];
+	size_t i = 0;
+	while (i < job->nchunks) {
+		/* Wait for the next chunk, take all completed behind it. */
+		pthread_mutex_lock(&job->lock);
+		while (job->ret == KNOT_EOK && !job->chunks[i].done) {
+			pthread_cond_wait(&job->cond, &job->lock);
+		}
+		int ret = job->ret;
+		size_t last = i;
+		while (last < job->nchunks && last - i < IOV_MAX &&
+		       job->chunks[last].done) {
+			++last;
+		}
+		pthread_mutex_unlock(&job->lock);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		int iovcnt = 0;
+		for (size_t c = i; c < last; ++c) {
+			iov[iovcnt].iov_base = job->chunks[c].buf;
+			iov[iovcnt].iov_len = job->chunks[c].len;
+			*rr_count += job->chunks[c].rr_count;
+			++iovcnt;
+		}
+		ret = dump_writev(fd, iov, iovcnt);
+
+		/* Release written chunks and let the threads continue. */
+		for (size_t c = i; c < last; ++c) {
+			free(job->chunks[c].buf);
+			job->chunks[c].buf = NULL;
+		}
+		pthread_mutex_lock(&job->lock);
+		if (ret != KNOT_EOK) {
+			job->ret = ret;
+		}
+		job->written = last;
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->lock);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		i = last;
+	}
 
-	params->ret = KNOT_EOK;
+	return KNOT_EOK;
 }
 
-int zone_dump_text(knot_zone_contents_t *zone, FILE *file)
+/*!
+ * \brief Dumps the zone nodes to the file descriptor.
+ *
+ * Nodes are split into chunks formatted by a set of threads into private
+ * buffers. Buffers are written in the zone order by the calling thread.
+ */
+static int zone_dump_nodes(knot_zone_contents_t *zone, int fd,
+                           uint64_t *rr_count)
 {
-	if (zone == NULL || file == NULL) {
-		return KNOT_EINVAL;
+	dump_job_t job;
+	memset(&job, 0, sizeof(job));
+	job.ret = KNOT_EOK;
+	job.origin = knot_node_owner(knot_zone_contents_apex(zone));
+	job.style = &KNOT_DUMP_STYLE_DEFAULT;
+
+	// Collect standard zone nodes followed by NSEC3 nodes.
+	knot_zone_contents_tree_apply_inorder(zone, node_collect, &job);
+	knot_zone_contents_nsec3_apply_inorder(zone, node_collect, &job);
+	if (job.ret != KNOT_EOK || job.count == 0) {
+		free(job.nodes);
+		return job.ret;
 	}
 
-	// Allocate auxiliary buffer for dumping operations.
-	char *buf = malloc(DUMP_BUF_LEN);
-	if (buf == NULL) {
-		ERR_ALLOC_FAILED;
+	job.nchunks = (job.count + DUMP_CHUNK - 1) / DUMP_CHUNK;
+	job.chunks = calloc(job.nchunks, sizeof(dump_chunk_t));
+	if (job.chunks == NULL) {
+		free(job.nodes);
 		return KNOT_ENOMEM;
 	}
 
-	fprintf(file, ";; Zone dump (Knot DNS %s)\n", PACKAGE_VERSION);
+	/* Do not spawn threads that would have nothing to do. */
+	int threads = dt_optimal_size();
+	if (threads < 1) {
+		threads = 1;
+	}
+	if ((size_t)threads > job.nchunks) {
+		threads = job.nchunks;
+	}
+	job.window = threads * DUMP_WINDOW;
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.cond, NULL);
+
+	int ret = KNOT_EOK;
+	dt_unit_t *unit = dt_create_coherent(threads, dump_worker_run, &job);
+	if (unit == NULL) {
+		ret = KNOT_ENOMEM;
+	} else {
+		dt_start(unit);
+		ret = dump_write(&job, fd, rr_count);
+		dt_join(unit);
+		dt_delete(&unit);
+	}
 
-	// Set structure with parameters.
-	dump_params_t params;
-	params.ret = KNOT_ERROR;
-	params.file = file;
-	params.buf = buf;
-	params.buflen = DUMP_BUF_LEN;
-	params.rr_count = 0;
-	params.origin = knot_node_owner(knot_zone_contents_apex(zone));
-	params.style = &KNOT_DUMP_STYLE_DEFAULT;
+	for (size_t i = 0; i < job.nchunks; ++i) {
+		free(job.chunks[i].buf);
+	}
+	pthread_cond_destroy(&job.cond);
+	pthread_mutex_destroy(&job.lock);
+	free(job.chunks);
+	free(job.nodes);
 
-	// Dump standard zone records.
-	knot_zone_contents_tree_apply_inorder(zone, node_dump_text, &params);
-	if (params.ret != KNOT_EOK) {
-		return params.ret;
+	return ret;
+}
+
+int zone_dump_text(knot_zone_contents_t *zone, FILE *file)
+{
+	if (zone == NULL || file == NULL) {
+		return KNOT_EINVAL;
 	}
 
-	// Dump NSEC3 zone records.
-	knot_zone_contents_nsec3_apply_inorder(zone, node_dump_text, &params);
-	if (params.ret != KNOT_EOK) {
-		return params.ret;
+	fprintf(file, ";; Zone dump (Knot DNS %s)\n", PACKAGE_VERSION);
+
+	// Nodes are written directly to the descriptor.
+	if (fflush(file) != 0) {
+		return KNOT_ERROR;
+	}
+
+	uint64_t rr_count = 0;
+	int ret = zone_dump_nodes(zone, fileno(file), &rr_count);
+	if (ret != KNOT_EOK) {
+		return ret;
 	}
 
 	// Create formated date-time string.
@@ -158,7 +372,7 @@ int zone_dump_text(knot_zone_contents_t *zone, FILE *file)
 	// Dump trailing statistics.
 	fprintf(file, ";; Written %"PRIu64" records\n"
 	              ";; Time %s\n",
-	        params.rr_count, date);
+	        rr_count, date);
 
 	// Get master information.
 	sockaddr_t *master = &((zonedata_t *)zone->zone->data)->xfr_in.master;
@@ -173,7 +387,5 @@ int zone_dump_text(knot_zone_contents_t *zone, FILE *file)
 		fprintf(file, ";; Transfered from %s#%i\n", addr, port);
 	}
 
-	free(buf);
-
 	return KNOT_EOK;
 }
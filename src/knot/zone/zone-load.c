@@ -31,6 +31,7 @@
 #include "libknot/common.h"
 #include "knot/zone/semantic-check.h"
 #include "libknot/zone/zone-contents.h"
+#include "libknot/util/tolower.h"
 #include "knot/other/debug.h"
 #include "knot/zone/zone-load.h"
 #include "zscanner/file_loader.h"
@@ -228,6 +229,51 @@ static size_t calculate_item_size(const knot_rrset_t *rrset,
 	return size;
 }
 
+/*!
+ * \brief Returns domain name from the lookup table or creates a new one.
+ *
+ * Names are looked up in lowercase before being allocated, so every distinct
+ * name in the zone is allocated only once and all its users share it.
+ *
+ * \param parser Parser context with the lookup table.
+ * \param wire Domain name in wire format.
+ * \param size Size of the domain name.
+ *
+ * \return Canonical domain name (referenced) or NULL.
+ */
+static knot_dname_t *parser_dname(parser_context_t *parser,
+                                  const uint8_t *wire, size_t size)
+{
+	uint8_t lower[KNOT_MAX_DNAME_LENGTH];
+	if (size > sizeof(lower)) {
+		return NULL;
+	}
+	knot_tolower_buf(lower, wire, size);
+
+	if (parser->lookup_tree != NULL) {
+		value_t *val = hattrie_tryget(parser->lookup_tree,
+		                              (char *)lower, size);
+		if (val != NULL) {
+			knot_dname_t *found = (knot_dname_t *)(*val);
+			knot_dname_retain(found);
+			return found;
+		}
+	}
+
+	knot_dname_t *dname = knot_dname_new_from_wire(lower, size, NULL);
+	if (dname == NULL) {
+		return NULL;
+	}
+
+	/* Already in lowercase, marks the name canonical. */
+	knot_dname_to_lower(dname);
+	if (parser->lookup_tree != NULL) {
+		hattrie_insert_dname(parser->lookup_tree, dname);
+	}
+
+	return dname;
+}
+
 static int add_rdata_to_rr(knot_rrset_t *rrset, const scanner_t *scanner)
 {
 	if (rrset == NULL) {
@@ -256,14 +302,14 @@ static int add_rdata_to_rr(knot_rrset_t *rrset, const scanner_t *scanner)
 		int item = desc->block_types[i];
 		if (descriptor_item_is_dname(item)) {
 			knot_dname_t *dname =
-				knot_dname_new_from_wire(scanner->r_data +
-			                                 scanner->r_data_blocks[i],
-			                                 scanner->r_data_blocks[i + 1] - scanner->r_data_blocks[i],
-			                                 NULL);
+				parser_dname(parser,
+				             scanner->r_data +
+				             scanner->r_data_blocks[i],
+				             scanner->r_data_blocks[i + 1] -
+				             scanner->r_data_blocks[i]);
 			if (dname == NULL) {
 				return KNOT_ERROR;
 			}
-			knot_dname_to_lower(dname);
 dbg_zp_exec_detail(
 			char *name = knot_dname_to_str(dname);
 			dbg_zp_detail("zp: arr_rdata_to_rr: "
@@ -271,9 +317,6 @@ dbg_zp_exec_detail(
 			              offset, name, dname);
 			free(name);
 );
-			/* Handle DNAME duplications. */
-			knot_zone_contents_insert_dname_into_table(&dname,
-							parser->lookup_tree);
 			memcpy(rdata + offset, &dname, sizeof(knot_dname_t *));
 			offset += sizeof(knot_dname_t *);
 		} else if (descriptor_item_is_fixed(item)) {
@@ -318,21 +361,12 @@ static void process_rr(const scanner_t *scanner)
     		current_owner = parser->last_node->owner;
 		knot_dname_retain(current_owner);
     	} else {
-    		current_owner = 
-    			knot_dname_new_from_wire(scanner->r_owner,
-    			                         scanner->r_owner_length,
-    			                         NULL);
-	    	if (current_owner == NULL) {
+		current_owner = parser_dname(parser, scanner->r_owner,
+		                             scanner->r_owner_length);
+		if (current_owner == NULL) {
 			parser->ret = KNOT_ERROR;
 			return;
 		}
-        	knot_dname_to_lower(current_owner);
-		/*!< \todo
-		 * If name is already in the table, we might not need to create
-		 * dname object, just compare wires.
-		 */
-		knot_zone_contents_insert_dname_into_table(&current_owner,
-		                                           parser->lookup_tree);
 	}
 	
 	/*!< \todo Do not create RRSet each time - merging needs to be sorted though. */
@@ -614,6 +648,8 @@ int knot_zload_open(zloader_t **dst, const char *source, const char *origin,
 	knot_dname_release(context->origin_from_config);
 	knot_zone_t *zone = knot_zone_new(context->last_node);
 	context->current_zone = knot_zone_get_contents(zone);
+	/* Nodes and RRSets are allocated from the heap if this fails. */
+	knot_zone_contents_create_arena(context->current_zone);
 	context->node_rrsigs = NULL;
 	context->ret = KNOT_EOK;
 	
@@ -663,10 +699,12 @@ knot_zone_t *knot_zload_load(zloader_t *loader)
 	
 	parser_context_t *c = loader->context;
 	assert(c);
+	arena_enter(c->current_zone->arena);
 	file_loader_process(loader->file_loader);
 	if (c->last_node && c->node_rrsigs) {
 		process_rrsigs_in_node(c, c->current_zone, c->last_node);
 	}
+	arena_leave();
 
 	if (c->ret != KNOT_EOK) {
 		log_zone_error("Zone could not be loaded (%d).", c->ret);
@@ -702,20 +740,11 @@ knot_zone_t *knot_zload_load(zloader_t *loader)
 	                          &last_nsec3_node, 0);
 	
 	if (loader->semantic_checks) {
-		int check_level = 1;
 		const knot_rrset_t *soa_rr =
 			knot_node_rrset(knot_zone_contents_apex(c->current_zone),
 		                        KNOT_RRTYPE_SOA);
 		assert(soa_rr); // In this point, SOA has to exist
-		const knot_rrset_t *nsec3param_rr =
-			knot_node_rrset(knot_zone_contents_apex(c->current_zone),
-		                        KNOT_RRTYPE_NSEC3PARAM);
-		if (soa_rr->rrsigs && nsec3param_rr == NULL) {
-			/* Set check level to DNSSEC. */
-			check_level = 2;
-		} else if (soa_rr->rrsigs && nsec3param_rr) {
-			check_level = 3;
-		}
+		int check_level = zone_sem_check_level(c->current_zone);
 		zone_do_sem_checks(c->current_zone, check_level,
 		                   loader->err_handler, first_nsec3_node,
 		                   last_nsec3_node);
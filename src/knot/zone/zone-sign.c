@@ -0,0 +1,2674 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <assert.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "knot/zone/zone-sign.h"
+#include "knot/server/dthreads.h"
+#include "knot/other/debug.h"
+#include "libknot/libknot.h"
+#include "libknot/sign/key.h"
+#include "libknot/util/wire.h"
+#include "common/descriptor.h"
+#include "common/base32hex.h"
+
+/*! \brief Number of RRSets taken by a worker at once. */
+#define SIGN_CHUNK 64
+
+/*! \brief Size of RRSIG RDATA fields preceding the signer name. */
+#define RRSIG_FIXED_SIZE 18
+
+/*! \brief Maximum size of one RR in canonical wire format. */
+#define RR_MAX_SIZE (KNOT_MAX_DNAME_LENGTH + 10 + 65535)
+
+/*----------------------------------------------------------------------------*/
+/* Key management                                                             */
+/*----------------------------------------------------------------------------*/
+
+static int keyset_add_file(zone_keyset_t *keyset, const char *path,
+                           const knot_dname_t *apex)
+{
+	knot_key_params_t params;
+	memset(&params, 0, sizeof(params));
+
+	int ret = knot_load_key_params(path, &params);
+	if (ret != KNOT_EOK) {
+		knot_free_key_params(&params);
+		return ret;
+	}
+
+	if (knot_get_key_type(&params) != KNOT_KEY_DNSSEC ||
+	    knot_dname_compare(params.name, apex) != 0) {
+		knot_free_key_params(&params);
+		return KNOT_EINVAL;
+	}
+
+	knot_dnssec_key_t *keys = realloc(keyset->keys, (keyset->count + 1)
+	                                                * sizeof(*keys));
+	if (keys == NULL) {
+		knot_free_key_params(&params);
+		return KNOT_ENOMEM;
+	}
+	keyset->keys = keys;
+
+	knot_dnssec_key_t *key = &keyset->keys[keyset->count];
+	memset(key, 0, sizeof(*key));
+	ret = knot_dnssec_key_from_params(&params, key);
+	knot_free_key_params(&params);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	keyset->count += 1;
+	return KNOT_EOK;
+}
+
+int zone_sign_load_keys(const char *keydir, const knot_dname_t *apex,
+                        zone_keyset_t *keyset)
+{
+	if (keydir == NULL || apex == NULL || keyset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	memset(keyset, 0, sizeof(*keyset));
+
+	DIR *dir = opendir(keydir);
+	if (dir == NULL) {
+		return KNOT_ENOENT;
+	}
+
+	struct dirent *entry = NULL;
+	while ((entry = readdir(dir)) != NULL) {
+		const char *name = entry->d_name;
+		const char *suffix = strrchr(name, '.');
+		if (name[0] != 'K' || suffix == NULL ||
+		    strcmp(suffix, ".private") != 0) {
+			continue;
+		}
+
+		size_t path_len = strlen(keydir) + strlen(name) + 2;
+		char *path = malloc(path_len);
+		if (path == NULL) {
+			closedir(dir);
+			zone_sign_free_keys(keyset);
+			return KNOT_ENOMEM;
+		}
+		snprintf(path, path_len, "%s/%s", keydir, name);
+
+		int ret = keyset_add_file(keyset, path, apex);
+		if (ret != KNOT_EOK) {
+			dbg_zones("zone-sign: skipping key '%s' (%s)\n",
+			          path, knot_strerror(ret));
+		}
+		free(path);
+	}
+
+	closedir(dir);
+
+	return keyset->count > 0 ? KNOT_EOK : KNOT_ENOENT;
+}
+
+void zone_sign_free_keys(zone_keyset_t *keyset)
+{
+	if (keyset == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < keyset->count; ++i) {
+		knot_dnssec_key_free(&keyset->keys[i]);
+	}
+
+	free(keyset->keys);
+	keyset->keys = NULL;
+	keyset->count = 0;
+}
+
+void zone_sign_policy_init(zone_sign_policy_t *policy, uint32_t validity,
+                           int threads)
+{
+	if (policy == NULL) {
+		return;
+	}
+
+	uint32_t now = (uint32_t)time(NULL);
+	policy->inception = now - ZONE_SIGN_SKEW;
+	policy->expiration = now + validity;
+	policy->threads = threads;
+}
+
+double zone_sign_rate(const zone_sign_stats_t *stats)
+{
+	if (stats == NULL || stats->threads < 1 || stats->elapsed <= 0.0) {
+		return 0.0;
+	}
+
+	return stats->signatures / stats->elapsed / stats->threads;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Signing workers                                                            */
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \brief Data shared by all signing threads.
+ */
+typedef struct sign_job {
+	const knot_rrset_t **rrsets;   /*!< Input RRSets. */
+	size_t count;                  /*!< Number of input RRSets. */
+	knot_rrset_t **signed_rrsigs;  /*!< Output RRSIGs, per input RRSet. */
+	knot_rrset_t **old_rrsigs;     /*!< Copies of replaced RRSIGs. */
+	const zone_keyset_t *keyset;
+	const zone_sign_policy_t *policy;
+	size_t next;                   /*!< Next RRSet to be taken. */
+	size_t signatures;             /*!< Created signatures. */
+	int ret;                       /*!< First error encountered. */
+} sign_job_t;
+
+/*!
+ * \brief One RR of signed RRSet in canonical wire format.
+ */
+typedef struct canonical_rr {
+	const uint8_t *rdata; /*!< RDATA. */
+	size_t rdata_size;    /*!< RDATA length. */
+	size_t offset;        /*!< Offset of the RR in the worker buffer. */
+	size_t size;          /*!< Total RR size. */
+} canonical_rr_t;
+
+/*!
+ * \brief Thread-private state of a signing worker.
+ */
+typedef struct sign_worker {
+	knot_dnssec_sign_context_t **contexts; /*!< One context per key. */
+	uint8_t *buffer;                       /*!< Canonical RRs. */
+	size_t buffer_size;
+	canonical_rr_t *rrs;                   /*!< RR index into buffer. */
+	size_t rrs_size;
+} sign_worker_t;
+
+static int canonical_rr_cmp(const void *a, const void *b)
+{
+	const canonical_rr_t *rr1 = a;
+	const canonical_rr_t *rr2 = b;
+
+	size_t len = rr1->rdata_size < rr2->rdata_size ? rr1->rdata_size
+	                                               : rr2->rdata_size;
+	int cmp = memcmp(rr1->rdata, rr2->rdata, len);
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	if (rr1->rdata_size == rr2->rdata_size) {
+		return 0;
+	}
+
+	return rr1->rdata_size < rr2->rdata_size ? -1 : 1;
+}
+
+/*!
+ * \brief Writes all RRs of the RRSet to worker buffer in canonical order.
+ */
+static int worker_canonicalize(sign_worker_t *w, const knot_rrset_t *rrset)
+{
+	if (w->rrs_size < rrset->rdata_count) {
+		canonical_rr_t *rrs = realloc(w->rrs, rrset->rdata_count
+		                                      * sizeof(canonical_rr_t));
+		if (rrs == NULL) {
+			return KNOT_ENOMEM;
+		}
+		w->rrs = rrs;
+		w->rrs_size = rrset->rdata_count;
+	}
+
+	size_t used = 0;
+	for (uint16_t i = 0; i < rrset->rdata_count; ++i) {
+		if (w->buffer_size - used < RR_MAX_SIZE) {
+			size_t size = w->buffer_size * 2 + RR_MAX_SIZE;
+			uint8_t *buffer = realloc(w->buffer, size);
+			if (buffer == NULL) {
+				return KNOT_ENOMEM;
+			}
+			w->buffer = buffer;
+			w->buffer_size = size;
+		}
+
+		size_t size = 0;
+		int ret = knot_rrset_rr_to_canonical(rrset, i,
+		                                     w->buffer + used,
+		                                     w->buffer_size - used,
+		                                     &size);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		w->rrs[i].offset = used;
+		w->rrs[i].size = size;
+		used += size;
+	}
+
+	/* Buffer is stable now, RDATA follows owner and fixed header. */
+	size_t header = knot_dname_size(rrset->owner) + 10;
+	for (uint16_t i = 0; i < rrset->rdata_count; ++i) {
+		w->rrs[i].rdata = w->buffer + w->rrs[i].offset + header;
+		w->rrs[i].rdata_size = w->rrs[i].size - header;
+	}
+
+	qsort(w->rrs, rrset->rdata_count, sizeof(canonical_rr_t),
+	      canonical_rr_cmp);
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Creates one RRSIG RR for the RRSet and appends it to \a rrsigs.
+ */
+static int worker_sign_key(sign_worker_t *w, const knot_rrset_t *rrset,
+                           const knot_dnssec_key_t *key,
+                           knot_dnssec_sign_context_t *ctx,
+                           const zone_sign_policy_t *policy,
+                           knot_rrset_t *rrsigs)
+{
+	knot_dname_t *signer = knot_dname_deep_copy(key->name);
+	if (signer == NULL) {
+		return KNOT_ENOMEM;
+	}
+	knot_dname_to_lower(signer);
+
+	size_t sig_size = knot_dnssec_sign_size(key);
+	uint8_t *rdata = knot_rrset_create_rdata(rrsigs, RRSIG_FIXED_SIZE
+	                                         + sizeof(knot_dname_t *)
+	                                         + sig_size);
+	if (rdata == NULL) {
+		knot_dname_release(signer);
+		return KNOT_ENOMEM;
+	}
+
+	int labels = knot_dname_label_count(rrset->owner);
+	if (knot_dname_is_wildcard(rrset->owner)) {
+		labels -= 1;
+	}
+
+	knot_wire_write_u16(rdata, rrset->type);
+	rdata[2] = key->algorithm;
+	rdata[3] = labels;
+	knot_wire_write_u32(rdata + 4, rrset->ttl);
+	knot_wire_write_u32(rdata + 8, policy->expiration);
+	knot_wire_write_u32(rdata + 12, policy->inception);
+	knot_wire_write_u16(rdata + 16, key->keytag);
+	memcpy(rdata + RRSIG_FIXED_SIZE, &signer, sizeof(knot_dname_t *));
+
+	/* Signed data: RRSIG RDATA without signature, then the RRSet. */
+	int ret = knot_dnssec_sign_new(ctx);
+	if (ret == KNOT_EOK) {
+		ret = knot_dnssec_sign_add(ctx, rdata, RRSIG_FIXED_SIZE);
+	}
+	if (ret == KNOT_EOK) {
+		ret = knot_dnssec_sign_add(ctx, knot_dname_name(signer),
+		                           knot_dname_size(signer));
+	}
+
+	const canonical_rr_t *prev = NULL;
+	for (uint16_t i = 0; ret == KNOT_EOK && i < rrset->rdata_count; ++i) {
+		const canonical_rr_t *rr = &w->rrs[i];
+		/* Duplicate RRs are not part of canonical RRSet. */
+		if (prev != NULL && canonical_rr_cmp(prev, rr) == 0) {
+			continue;
+		}
+		ret = knot_dnssec_sign_add(ctx, w->buffer + rr->offset,
+		                           rr->size);
+		prev = rr;
+	}
+
+	if (ret == KNOT_EOK) {
+		ret = knot_dnssec_sign_write(ctx, rdata + RRSIG_FIXED_SIZE
+		                                  + sizeof(knot_dname_t *));
+	}
+
+	/* Signer is owned by the RRSIG RDATA even on failure. */
+	return ret;
+}
+
+/*!
+ * \brief Signs one RRSet with all keys, result is stored into job.
+ */
+static int worker_sign_rrset(sign_worker_t *w, sign_job_t *job, size_t pos)
+{
+	const knot_rrset_t *rrset = job->rrsets[pos];
+	if (rrset->rdata_count == 0) {
+		return KNOT_EOK;
+	}
+
+	int ret = worker_canonicalize(w, rrset);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Owner is copied, shared names must not be retained concurrently. */
+	knot_dname_t *owner = knot_dname_deep_copy(rrset->owner);
+	if (owner == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	knot_rrset_t *rrsigs = knot_rrset_new(owner, KNOT_RRTYPE_RRSIG,
+	                                      rrset->rclass, rrset->ttl);
+	knot_dname_release(owner);
+	if (rrsigs == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; i < job->keyset->count; ++i) {
+		ret = worker_sign_key(w, rrset, &job->keyset->keys[i],
+		                      w->contexts[i], job->policy, rrsigs);
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&rrsigs, 1, 1);
+			return ret;
+		}
+	}
+
+	if (rrset->rrsigs != NULL) {
+		ret = knot_rrset_deep_copy(rrset->rrsigs,
+		                           &job->old_rrsigs[pos], 1);
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&rrsigs, 1, 1);
+			return ret;
+		}
+	}
+
+	job->signed_rrsigs[pos] = rrsigs;
+	__sync_add_and_fetch(&job->signatures, job->keyset->count);
+
+	return KNOT_EOK;
+}
+
+static void worker_free(sign_worker_t *w, size_t key_count)
+{
+	if (w->contexts != NULL) {
+		for (size_t i = 0; i < key_count; ++i) {
+			knot_dnssec_sign_free(w->contexts[i]);
+		}
+	}
+
+	free(w->contexts);
+	free(w->buffer);
+	free(w->rrs);
+	memset(w, 0, sizeof(*w));
+}
+
+static int worker_init(sign_worker_t *w, const zone_keyset_t *keyset)
+{
+	memset(w, 0, sizeof(*w));
+
+	w->contexts = calloc(keyset->count, sizeof(*w->contexts));
+	if (w->contexts == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; i < keyset->count; ++i) {
+		w->contexts[i] = knot_dnssec_sign_init(&keyset->keys[i]);
+		if (w->contexts[i] == NULL) {
+			worker_free(w, keyset->count);
+			return KNOT_ENOMEM;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Takes chunks of the job and signs them until all are done.
+ */
+static void sign_job_run(sign_job_t *job)
+{
+	sign_worker_t worker;
+	int ret = worker_init(&worker, job->keyset);
+
+	while (ret == KNOT_EOK && job->ret == KNOT_EOK) {
+		size_t begin = __sync_fetch_and_add(&job->next, SIGN_CHUNK);
+		if (begin >= job->count) {
+			break;
+		}
+
+		size_t end = begin + SIGN_CHUNK;
+		if (end > job->count) {
+			end = job->count;
+		}
+
+		for (size_t i = begin; ret == KNOT_EOK && i < end; ++i) {
+			ret = worker_sign_rrset(&worker, job, i);
+		}
+	}
+
+	if (ret != KNOT_EOK) {
+		__sync_bool_compare_and_swap(&job->ret, KNOT_EOK, ret);
+	}
+
+	worker_free(&worker, job->keyset->count);
+}
+
+static int sign_worker_run(dthread_t *thread)
+{
+	sign_job_run(thread->data);
+	return KNOT_EOK;
+}
+
+static double elapsed_since(const struct timeval *begin)
+{
+	struct timeval end;
+	gettimeofday(&end, NULL);
+
+	return (end.tv_sec - begin->tv_sec)
+	       + (end.tv_usec - begin->tv_usec) / 1000000.0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* API functions                                                              */
+/*----------------------------------------------------------------------------*/
+
+int zone_sign_rrsets(const knot_rrset_t **rrsets, size_t count,
+                     const zone_keyset_t *keyset,
+                     const zone_sign_policy_t *policy,
+                     knot_changeset_t *changeset, zone_sign_stats_t *stats)
+{
+	if ((rrsets == NULL && count > 0) || keyset == NULL ||
+	    keyset->count == 0 || policy == NULL || changeset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	struct timeval begin;
+	gettimeofday(&begin, NULL);
+
+	sign_job_t job;
+	memset(&job, 0, sizeof(job));
+	job.rrsets = rrsets;
+	job.count = count;
+	job.keyset = keyset;
+	job.policy = policy;
+	job.ret = KNOT_EOK;
+	job.signed_rrsigs = calloc(count + 1, sizeof(knot_rrset_t *));
+	job.old_rrsigs = calloc(count + 1, sizeof(knot_rrset_t *));
+	if (job.signed_rrsigs == NULL || job.old_rrsigs == NULL) {
+		free(job.signed_rrsigs);
+		free(job.old_rrsigs);
+		return KNOT_ENOMEM;
+	}
+
+	/* Do not spawn threads that would have nothing to do. */
+	int threads = policy->threads > 0 ? policy->threads
+	                                  : dt_optimal_size();
+	size_t max_threads = (count + SIGN_CHUNK - 1) / SIGN_CHUNK;
+	if (max_threads < 1) {
+		max_threads = 1;
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+	if ((size_t)threads > max_threads) {
+		threads = max_threads;
+	}
+
+	/* Small jobs (e.g. updates) are signed in the calling thread. */
+	int ret = KNOT_EOK;
+	if (threads == 1) {
+		sign_job_run(&job);
+		ret = job.ret;
+	} else {
+		dt_unit_t *unit = dt_create_coherent(threads, sign_worker_run,
+		                                     &job);
+		if (unit == NULL) {
+			ret = KNOT_ENOMEM;
+		} else {
+			dt_start(unit);
+			dt_join(unit);
+			dt_delete(&unit);
+			ret = job.ret;
+		}
+	}
+
+	/* Store results in the input order, ownership passes to changeset. */
+	size_t signed_rrsets = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (ret == KNOT_EOK && job.old_rrsigs[i] != NULL) {
+			ret = knot_changeset_add_new_rr(changeset,
+			                                job.old_rrsigs[i],
+			                                KNOT_CHANGESET_REMOVE);
+			if (ret == KNOT_EOK) {
+				job.old_rrsigs[i] = NULL;
+			}
+		}
+		if (ret == KNOT_EOK && job.signed_rrsigs[i] != NULL) {
+			ret = knot_changeset_add_new_rr(changeset,
+			                                job.signed_rrsigs[i],
+			                                KNOT_CHANGESET_ADD);
+			if (ret == KNOT_EOK) {
+				job.signed_rrsigs[i] = NULL;
+				signed_rrsets += 1;
+			}
+		}
+
+		knot_rrset_deep_free(&job.old_rrsigs[i], 1, 1);
+		knot_rrset_deep_free(&job.signed_rrsigs[i], 1, 1);
+	}
+
+	free(job.signed_rrsigs);
+	free(job.old_rrsigs);
+
+	if (stats != NULL) {
+		stats->rrsets += signed_rrsets;
+		stats->signatures += job.signatures;
+		stats->threads = threads;
+		stats->elapsed += elapsed_since(&begin);
+	}
+
+	dbg_zones("zone-sign: %zu RRSets, %zu signatures, %d threads (%s)\n",
+	          signed_rrsets, job.signatures, threads, knot_strerror(ret));
+
+	return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \brief List of RRSets collected for signing.
+ */
+typedef struct rrset_list {
+	const knot_rrset_t **rrsets;
+	size_t count;
+	size_t allocated;
+	int ret;
+} rrset_list_t;
+
+static int rrset_list_add(rrset_list_t *list, const knot_rrset_t *rrset)
+{
+	if (list->count == list->allocated) {
+		size_t allocated = list->allocated ? list->allocated * 2 : 256;
+		const knot_rrset_t **rrsets = realloc(list->rrsets, allocated
+		                                      * sizeof(knot_rrset_t *));
+		if (rrsets == NULL) {
+			return KNOT_ENOMEM;
+		}
+		list->rrsets = rrsets;
+		list->allocated = allocated;
+	}
+
+	list->rrsets[list->count++] = rrset;
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Collects all RRSets from the node which have to be signed.
+ *
+ * Non-authoritative data are not signed, at delegation points only DS and
+ * NSEC records are authoritative. SOA and NSEC/NSEC3 chain are signed
+ * separately.
+ */
+static void collect_node_rrsets(knot_node_t *node, void *data)
+{
+	rrset_list_t *list = data;
+	if (list->ret != KNOT_EOK || knot_node_is_non_auth(node)) {
+		return;
+	}
+
+	int deleg = knot_node_is_deleg_point(node);
+	const knot_rrset_t **rrsets = knot_node_rrsets_no_copy(node);
+	short count = knot_node_rrset_count(node);
+	for (short i = 0; i < count; ++i) {
+		uint16_t type = knot_rrset_type(rrsets[i]);
+		if (type == KNOT_RRTYPE_SOA || type == KNOT_RRTYPE_RRSIG ||
+		    type == KNOT_RRTYPE_NSEC || type == KNOT_RRTYPE_NSEC3) {
+			continue;
+		}
+		if (deleg && type != KNOT_RRTYPE_DS) {
+			continue;
+		}
+
+		list->ret = rrset_list_add(list, rrsets[i]);
+		if (list->ret != KNOT_EOK) {
+			return;
+		}
+	}
+}
+
+/*!
+ * \brief Stores SOA change into changeset, new SOA serial is incremented.
+ */
+static int sign_prepare_soa(const knot_rrset_t *soa, knot_changeset_t *ch)
+{
+	int ret = knot_rrset_deep_copy(soa, &ch->soa_from, 1);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	knot_rrset_deep_free(&ch->soa_from->rrsigs, 1, 1);
+
+	ret = knot_rrset_deep_copy(soa, &ch->soa_to, 1);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+	knot_rrset_deep_free(&ch->soa_to->rrsigs, 1, 1);
+
+	ch->serial_from = knot_rrset_rdata_soa_serial(soa);
+	ch->serial_to = ch->serial_from + 1;
+	knot_rrset_rdata_soa_serial_set(ch->soa_to, ch->serial_to);
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Creates new changeset with SOA serial bump.
+ *
+ * Old SOA signatures are put into the REMOVE section, the new SOA is signed
+ * by the caller.
+ */
+static int sign_changeset_new(const knot_rrset_t *soa,
+                              knot_changesets_t *changesets,
+                              knot_changeset_t **out)
+{
+	int ret = knot_changesets_check_size(changesets);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_changeset_t *changeset = &changesets->sets[changesets->count];
+	memset(changeset, 0, sizeof(knot_changeset_t));
+	changeset->flags = KNOT_CHANGESET_TYPE_IXFR;
+	changesets->count += 1;
+
+	ret = sign_prepare_soa(soa, changeset);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Old SOA signatures are replaced as well. */
+	if (soa->rrsigs != NULL) {
+		knot_rrset_t *old = NULL;
+		ret = knot_rrset_deep_copy(soa->rrsigs, &old, 1);
+		if (ret == KNOT_EOK) {
+			ret = knot_changeset_add_new_rr(changeset, old,
+			                                KNOT_CHANGESET_REMOVE);
+		}
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&old, 1, 1);
+			return ret;
+		}
+	}
+
+	*out = changeset;
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+/* NSEC/NSEC3 chain and zone signing                                          */
+/*----------------------------------------------------------------------------*/
+
+/*! \brief Maximum size of NSEC/NSEC3 type bitmap (256 full windows). */
+#define BITMAP_MAX_SIZE (256 * (2 + 32))
+
+/*! \brief Maximum number of types at one node (incl. RRSIG and NSEC). */
+#define NODE_MAX_TYPES (UINT16_MAX + 1)
+
+/*!
+ * \brief RRSet touched by a changeset.
+ */
+typedef struct touched_rrset {
+	const knot_dname_t *owner;
+	uint16_t type;
+} touched_rrset_t;
+
+static int touched_rrset_cmp(const void *a, const void *b)
+{
+	const touched_rrset_t *t1 = a;
+	const touched_rrset_t *t2 = b;
+
+	int cmp = knot_dname_compare(t1->owner, t2->owner);
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	return (int)t1->type - (int)t2->type;
+}
+
+/*!
+ * \brief Checks if the RRSet type is maintained by the signer itself.
+ */
+static int type_is_dnssec_managed(uint16_t type)
+{
+	return type == KNOT_RRTYPE_RRSIG || type == KNOT_RRTYPE_NSEC ||
+	       type == KNOT_RRTYPE_NSEC3 || type == KNOT_RRTYPE_ANY;
+}
+
+/*!
+ * \brief Adds RRSets from the changeset part to the list of touched RRSets.
+ *
+ * If \a owners is set, all names touched by the changeset are collected
+ * (types are not distinguished), including names cleared by type ANY.
+ */
+static void collect_touched_part(knot_rrset_t *const *rrsets, size_t count,
+                                 int owners, touched_rrset_t *touched,
+                                 size_t *n)
+{
+	for (size_t i = 0; i < count; ++i) {
+		const knot_rrset_t *rr = rrsets[i];
+		if (rr == NULL) {
+			continue;
+		}
+		if (owners) {
+			if (rr->type == KNOT_RRTYPE_RRSIG ||
+			    rr->type == KNOT_RRTYPE_NSEC3) {
+				continue;
+			}
+		} else if (type_is_dnssec_managed(rr->type) ||
+		           rr->type == KNOT_RRTYPE_SOA) {
+			continue;
+		}
+		touched[*n].owner = rr->owner;
+		touched[*n].type = owners ? 0 : rr->type;
+		*n += 1;
+	}
+}
+
+/*!
+ * \brief Collects unique (owner, type) pairs touched by the changesets.
+ *
+ * \param in Changesets.
+ * \param owners Collect unique owners only.
+ * \param out Sorted list of touched RRSets.
+ * \param count Number of items in the list.
+ */
+static int collect_touched(const knot_changesets_t *in, int owners,
+                           touched_rrset_t **out, size_t *count)
+{
+	size_t total = 0;
+	for (size_t i = 0; i < in->count; ++i) {
+		total += in->sets[i].remove_count + in->sets[i].add_count;
+	}
+
+	touched_rrset_t *touched = malloc((total + 1) * sizeof(*touched));
+	if (touched == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	size_t n = 0;
+	for (size_t i = 0; i < in->count; ++i) {
+		const knot_changeset_t *ch = &in->sets[i];
+		collect_touched_part(ch->remove, ch->remove_count, owners,
+		                     touched, &n);
+		collect_touched_part(ch->add, ch->add_count, owners, touched,
+		                     &n);
+	}
+
+	qsort(touched, n, sizeof(*touched), touched_rrset_cmp);
+
+	/* Remove duplicates. */
+	size_t unique = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (unique > 0 &&
+		    touched_rrset_cmp(&touched[unique - 1], &touched[i]) == 0) {
+			continue;
+		}
+		touched[unique++] = touched[i];
+	}
+
+	*out = touched;
+	*count = unique;
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Checks if RRSet of given type at the node is signed.
+ */
+static int node_type_is_signed(const knot_node_t *node, uint16_t type)
+{
+	if (knot_node_is_non_auth(node)) {
+		return 0;
+	}
+
+	if (knot_node_is_deleg_point(node)) {
+		return type == KNOT_RRTYPE_DS || type == KNOT_RRTYPE_NSEC;
+	}
+
+	return 1;
+}
+
+/*!
+ * \brief Lists types of RRSets at the node for NSEC/NSEC3 type bitmap.
+ *
+ * \param node Node.
+ * \param types Output array (at least NODE_MAX_TYPES items).
+ * \param nsec Type of the denial record to be included (NSEC only).
+ *
+ * \return Number of types.
+ */
+static size_t node_types(const knot_node_t *node, uint16_t *types,
+                         uint16_t nsec)
+{
+	size_t count = 0;
+	int has_signed = 0;
+
+	const knot_rrset_t **rrsets = knot_node_rrsets_no_copy(node);
+	for (short i = 0; i < knot_node_rrset_count(node); ++i) {
+		uint16_t type = knot_rrset_type(rrsets[i]);
+		if (type == KNOT_RRTYPE_NSEC || type == KNOT_RRTYPE_RRSIG) {
+			continue;
+		}
+		types[count++] = type;
+		has_signed |= node_type_is_signed(node, type);
+	}
+
+	/* NSEC itself is signed and stored at the node. */
+	if (nsec == KNOT_RRTYPE_NSEC) {
+		types[count++] = KNOT_RRTYPE_NSEC;
+		has_signed = 1;
+	}
+
+	if (has_signed) {
+		types[count++] = KNOT_RRTYPE_RRSIG;
+	}
+
+	/* Insertion sort, nodes have only a few types. */
+	for (size_t i = 1; i < count; ++i) {
+		uint16_t type = types[i];
+		size_t j = i;
+		for (; j > 0 && types[j - 1] > type; --j) {
+			types[j] = types[j - 1];
+		}
+		types[j] = type;
+	}
+
+	return count;
+}
+
+/*!
+ * \brief Writes type bitmap in NSEC/NSEC3 format (RFC 4034, Section 4.1.2).
+ *
+ * \param types Sorted list of types.
+ * \param count Number of types.
+ * \param bitmap Output buffer (at least BITMAP_MAX_SIZE bytes).
+ *
+ * \return Bitmap size.
+ */
+static size_t type_bitmap_write(const uint16_t *types, size_t count,
+                                uint8_t *bitmap)
+{
+	size_t size = 0;
+	size_t i = 0;
+	while (i < count) {
+		uint8_t window = types[i] >> 8;
+		uint8_t *block = bitmap + size;
+		memset(block, 0, 34);
+		block[0] = window;
+
+		uint8_t length = 0;
+		for (; i < count && (types[i] >> 8) == window; ++i) {
+			uint8_t bit = types[i] & 0xff;
+			block[2 + bit / 8] |= 0x80 >> (bit % 8);
+			length = bit / 8 + 1;
+		}
+
+		block[1] = length;
+		size += 2 + length;
+	}
+
+	return size;
+}
+
+/*!
+ * \brief Puts copy of the chain record and its RRSIGs into REMOVE section.
+ */
+static int chain_remove_rrset(knot_changeset_t *out, const knot_rrset_t *old)
+{
+	knot_rrset_t *copy = NULL;
+	int ret = knot_rrset_deep_copy(old, &copy, 1);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	knot_rrset_t *rrsigs = copy->rrsigs;
+	copy->rrsigs = NULL;
+
+	ret = knot_changeset_add_new_rr(out, copy, KNOT_CHANGESET_REMOVE);
+	if (ret != KNOT_EOK) {
+		knot_rrset_deep_free(&copy, 1, 1);
+		knot_rrset_deep_free(&rrsigs, 1, 1);
+		return ret;
+	}
+
+	if (rrsigs != NULL) {
+		ret = knot_changeset_add_new_rr(out, rrsigs,
+		                                KNOT_CHANGESET_REMOVE);
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&rrsigs, 1, 1);
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief List of nodes and created chain records.
+ */
+typedef struct chain_ctx {
+	const knot_zone_contents_t *zone;
+	const knot_node_t **nodes; /*!< Nodes covered by the chain. */
+	size_t count;
+	size_t allocated;
+	knot_changeset_t *out;     /*!< Output changeset. */
+	const knot_rrset_t **added; /*!< Chain records to be signed. */
+	size_t added_count;
+	size_t added_allocated;
+	int sign_unchanged;        /*!< Sign kept chain records as well. */
+	uint32_t ttl;              /*!< TTL of chain records. */
+	uint16_t rclass;           /*!< Zone class. */
+	int ret;
+} chain_ctx_t;
+
+static int ptr_list_add(const void ***list, size_t *count, size_t *allocated,
+                        const void *item)
+{
+	if (*count == *allocated) {
+		size_t new_size = *allocated ? *allocated * 2 : 64;
+		const void **new_list = realloc(*list, new_size * sizeof(void *));
+		if (new_list == NULL) {
+			return KNOT_ENOMEM;
+		}
+		*list = new_list;
+		*allocated = new_size;
+	}
+
+	(*list)[(*count)++] = item;
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Keeps existing chain record, it is signed again on full zone sign.
+ */
+static int chain_keep_rrset(chain_ctx_t *ctx, const knot_rrset_t *old)
+{
+	if (!ctx->sign_unchanged) {
+		return KNOT_EOK;
+	}
+
+	return ptr_list_add((const void ***)&ctx->added, &ctx->added_count,
+	                    &ctx->added_allocated, old);
+}
+
+/*!
+ * \brief Stores new chain record into ADD section (without merging).
+ */
+static int chain_add_rrset(chain_ctx_t *ctx, knot_rrset_t *rrset)
+{
+	int ret = knot_changeset_add_rrset(&ctx->out->add, &ctx->out->add_count,
+	                                   &ctx->out->add_allocated, rrset);
+	if (ret != KNOT_EOK) {
+		knot_rrset_deep_free(&rrset, 1, 1);
+		return ret;
+	}
+
+	return ptr_list_add((const void ***)&ctx->added, &ctx->added_count,
+	                    &ctx->added_allocated, rrset);
+}
+
+/*!
+ * \brief Creates empty chain record RRSet.
+ */
+static knot_rrset_t *chain_rrset_new(const chain_ctx_t *ctx,
+                                     const knot_dname_t *owner, uint16_t type)
+{
+	knot_dname_t *owner_copy = knot_dname_deep_copy(owner);
+	if (owner_copy == NULL) {
+		return NULL;
+	}
+
+	knot_rrset_t *rrset = knot_rrset_new(owner_copy, type, ctx->rclass,
+	                                     ctx->ttl);
+	knot_dname_release(owner_copy);
+
+	return rrset;
+}
+
+/*!
+ * \brief Replaces NSEC record of the node if its next name or types differ.
+ *
+ * \param ctx Chain context.
+ * \param node Node covered by the record.
+ * \param old Existing NSEC record in the zone or NULL.
+ * \param next Next owner name in the chain.
+ * \param types Buffer for types (at least NODE_MAX_TYPES items).
+ * \param bitmap Buffer for the type bitmap (at least BITMAP_MAX_SIZE bytes).
+ */
+static int chain_nsec_replace(chain_ctx_t *ctx, const knot_node_t *node,
+                              const knot_rrset_t *old,
+                              const knot_dname_t *next, uint16_t *types,
+                              uint8_t *bitmap)
+{
+	size_t type_count = node_types(node, types, KNOT_RRTYPE_NSEC);
+	size_t bitmap_size = type_bitmap_write(types, type_count, bitmap);
+
+	if (old != NULL && old->rdata_count == 1) {
+		uint8_t *old_bitmap = NULL;
+		uint16_t old_size = 0;
+		knot_rrset_rdata_nsec_bitmap(old, 0, &old_bitmap, &old_size);
+		const knot_dname_t *old_next = knot_rrset_rdata_nsec_next(old, 0);
+		if (old_size == bitmap_size &&
+		    memcmp(old_bitmap, bitmap, bitmap_size) == 0 &&
+		    knot_dname_compare(old_next, next) == 0) {
+			return chain_keep_rrset(ctx, old);
+		}
+	}
+
+	if (old != NULL) {
+		int ret = chain_remove_rrset(ctx->out, old);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	knot_rrset_t *nsec = chain_rrset_new(ctx, knot_node_owner(node),
+	                                     KNOT_RRTYPE_NSEC);
+	knot_dname_t *next_copy = knot_dname_deep_copy(next);
+	uint8_t *rdata = NULL;
+	if (nsec != NULL && next_copy != NULL) {
+		rdata = knot_rrset_create_rdata(nsec, sizeof(knot_dname_t *)
+		                                      + bitmap_size);
+	}
+	if (rdata == NULL) {
+		knot_rrset_deep_free(&nsec, 1, 1);
+		knot_dname_release(next_copy);
+		return KNOT_ENOMEM;
+	}
+
+	memcpy(rdata, &next_copy, sizeof(knot_dname_t *));
+	memcpy(rdata + sizeof(knot_dname_t *), bitmap, bitmap_size);
+
+	return chain_add_rrset(ctx, nsec);
+}
+
+/*!
+ * \brief Checks if the node is covered by NSEC chain.
+ *
+ * Node left with NSEC only, i.e. all data were removed, is not covered.
+ */
+static int nsec_node_covered(const knot_node_t *node)
+{
+	if (knot_node_is_non_auth(node)) {
+		return 0;
+	}
+
+	const knot_rrset_t *nsec = knot_node_rrset(node, KNOT_RRTYPE_NSEC);
+	return knot_node_rrset_count(node) - (nsec ? 1 : 0) > 0;
+}
+
+static void chain_collect_nsec(knot_node_t *node, void *data)
+{
+	chain_ctx_t *ctx = data;
+	if (ctx->ret != KNOT_EOK || knot_node_is_non_auth(node)) {
+		return;
+	}
+
+	if (!nsec_node_covered(node)) {
+		const knot_rrset_t *nsec = knot_node_rrset(node,
+		                                           KNOT_RRTYPE_NSEC);
+		if (nsec != NULL) {
+			ctx->ret = chain_remove_rrset(ctx->out, nsec);
+		}
+		return;
+	}
+
+	ctx->ret = ptr_list_add((const void ***)&ctx->nodes, &ctx->count,
+	                        &ctx->allocated, node);
+}
+
+/*!
+ * \brief Fixes NSEC chain of the whole zone, only records which changed
+ *        are replaced.
+ */
+static int chain_update_nsec(chain_ctx_t *ctx, knot_zone_contents_t *zone)
+{
+	knot_zone_contents_tree_apply_inorder(zone, chain_collect_nsec, ctx);
+	if (ctx->ret != KNOT_EOK) {
+		return ctx->ret;
+	}
+
+	uint16_t *types = malloc(NODE_MAX_TYPES * sizeof(uint16_t));
+	uint8_t *bitmap = malloc(BITMAP_MAX_SIZE);
+	if (types == NULL || bitmap == NULL) {
+		free(types);
+		free(bitmap);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	for (size_t i = 0; ret == KNOT_EOK && i < ctx->count; ++i) {
+		const knot_node_t *node = ctx->nodes[i];
+		const knot_dname_t *next =
+			knot_node_owner(ctx->nodes[(i + 1) % ctx->count]);
+		const knot_rrset_t *old = knot_node_rrset(node,
+		                                          KNOT_RRTYPE_NSEC);
+
+		ret = chain_nsec_replace(ctx, node, old, next, types, bitmap);
+	}
+
+	free(types);
+	free(bitmap);
+
+	return ret;
+}
+
+/*!
+ * \brief Node covered by NSEC3 chain.
+ */
+typedef struct nsec3_entry {
+	const knot_dname_t *hashed; /*!< Hashed owner name. */
+	knot_dname_t *hashed_new;   /*!< Hashed name created here. */
+	const knot_node_t *node;    /*!< Node in the normal tree. */
+	const knot_node_t *nsec3;   /*!< Existing NSEC3 node or NULL. */
+} nsec3_entry_t;
+
+static int nsec3_entry_cmp(const void *a, const void *b)
+{
+	const nsec3_entry_t *e1 = a;
+	const nsec3_entry_t *e2 = b;
+
+	return knot_dname_compare(e1->hashed, e2->hashed);
+}
+
+static int ptr_cmp(const void *a, const void *b)
+{
+	const void *p1 = *(const void **)a;
+	const void *p2 = *(const void **)b;
+
+	return p1 < p2 ? -1 : (p1 > p2 ? 1 : 0);
+}
+
+/*!
+ * \brief Checks if the node is covered by NSEC3 chain.
+ *
+ * Empty non-terminals are covered as well (RFC 5155, Section 7.1).
+ */
+static int nsec3_node_covered(const knot_node_t *node)
+{
+	return !knot_node_is_non_auth(node) &&
+	       (knot_node_rrset_count(node) > 0 ||
+	        knot_node_children(node) > 0);
+}
+
+static void chain_collect_nsec3(knot_node_t *node, void *data)
+{
+	chain_ctx_t *ctx = data;
+	if (ctx->ret != KNOT_EOK || !nsec3_node_covered(node)) {
+		return;
+	}
+
+	ctx->ret = ptr_list_add((const void ***)&ctx->nodes, &ctx->count,
+	                        &ctx->allocated, node);
+}
+
+typedef struct nsec3_stale {
+	const knot_node_t **covered; /*!< Sorted NSEC3 nodes still in use. */
+	size_t count;
+	knot_changeset_t *out;
+	int ret;
+} nsec3_stale_t;
+
+static void chain_remove_stale_nsec3(knot_node_t *node, void *data)
+{
+	nsec3_stale_t *stale = data;
+	if (stale->ret != KNOT_EOK) {
+		return;
+	}
+
+	const knot_node_t *key = node;
+	if (bsearch(&key, stale->covered, stale->count, sizeof(knot_node_t *),
+	            ptr_cmp) != NULL) {
+		return;
+	}
+
+	const knot_rrset_t *nsec3 = knot_node_rrset(node, KNOT_RRTYPE_NSEC3);
+	if (nsec3 != NULL) {
+		stale->ret = chain_remove_rrset(stale->out, nsec3);
+	}
+}
+
+/*!
+ * \brief Checks whether existing NSEC3 record matches the expected one.
+ */
+static int nsec3_matches(const knot_rrset_t *old,
+                         const knot_nsec3_params_t *params,
+                         const uint8_t *next, size_t next_size,
+                         const uint8_t *bitmap, size_t bitmap_size)
+{
+	if (old == NULL || old->rdata_count != 1) {
+		return 0;
+	}
+
+	if (knot_rrset_rdata_nsec3_algorithm(old, 0) != params->algorithm ||
+	    knot_rrset_rdata_nsec3_iterations(old, 0) != params->iterations ||
+	    knot_rrset_rdata_nsec3_salt_length(old, 0) != params->salt_length ||
+	    memcmp(knot_rrset_rdata_nsec3_salt(old, 0), params->salt,
+	           params->salt_length) != 0) {
+		return 0;
+	}
+
+	uint8_t *old_next = NULL;
+	uint8_t old_next_size = 0;
+	knot_rrset_rdata_nsec3_next_hashed(old, 0, &old_next, &old_next_size);
+	if (old_next_size != next_size ||
+	    memcmp(old_next, next, next_size) != 0) {
+		return 0;
+	}
+
+	uint8_t *old_bitmap = NULL;
+	uint16_t old_bitmap_size = 0;
+	knot_rrset_rdata_nsec3_bitmap(old, 0, &old_bitmap, &old_bitmap_size);
+
+	return old_bitmap_size == bitmap_size &&
+	       memcmp(old_bitmap, bitmap, bitmap_size) == 0;
+}
+
+/*!
+ * \brief Creates NSEC3 record for the chain entry.
+ */
+static knot_rrset_t *nsec3_create(const chain_ctx_t *ctx,
+                                  const knot_dname_t *owner,
+                                  const knot_rrset_t *old,
+                                  const knot_nsec3_params_t *params,
+                                  const uint8_t *next, size_t next_size,
+                                  const uint8_t *bitmap, size_t bitmap_size)
+{
+	knot_rrset_t *nsec3 = chain_rrset_new(ctx, owner, KNOT_RRTYPE_NSEC3);
+	if (nsec3 == NULL) {
+		return NULL;
+	}
+
+	size_t size = 6 + params->salt_length + next_size + bitmap_size;
+	uint8_t *rdata = knot_rrset_create_rdata(nsec3, size);
+	if (rdata == NULL) {
+		knot_rrset_deep_free(&nsec3, 1, 1);
+		return NULL;
+	}
+
+	/* Keep Opt-Out flag of the replaced record. */
+	uint8_t flags = old ? knot_rrset_rdata_nsec3_flags(old, 0) : 0;
+
+	rdata[0] = params->algorithm;
+	rdata[1] = flags;
+	knot_wire_write_u16(rdata + 2, params->iterations);
+	rdata[4] = params->salt_length;
+	memcpy(rdata + 5, params->salt, params->salt_length);
+	rdata += 5 + params->salt_length;
+	rdata[0] = next_size;
+	memcpy(rdata + 1, next, next_size);
+	memcpy(rdata + 1 + next_size, bitmap, bitmap_size);
+
+	return nsec3;
+}
+
+/*!
+ * \brief Replaces NSEC3 record if its next hashed owner or types differ.
+ */
+static int chain_nsec3_replace(chain_ctx_t *ctx,
+                               const knot_nsec3_params_t *params,
+                               const knot_dname_t *owner,
+                               const knot_rrset_t *old,
+                               const uint8_t *next, size_t next_size,
+                               const uint8_t *bitmap, size_t bitmap_size)
+{
+	if (nsec3_matches(old, params, next, next_size, bitmap,
+	                  bitmap_size)) {
+		return chain_keep_rrset(ctx, old);
+	}
+
+	if (old != NULL) {
+		int ret = chain_remove_rrset(ctx->out, old);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	knot_rrset_t *nsec3 = nsec3_create(ctx, owner, old, params, next,
+	                                   next_size, bitmap, bitmap_size);
+	if (nsec3 == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	return chain_add_rrset(ctx, nsec3);
+}
+
+/*!
+ * \brief Decodes next hashed owner from the first label of the name.
+ *
+ * \return Hash size or error code.
+ */
+static int nsec3_hash_decode(const knot_dname_t *hashed, uint8_t *hash,
+                             size_t size)
+{
+	const uint8_t *label = knot_dname_name(hashed);
+	int32_t ret = base32hex_decode(label + 1, label[0], hash, size);
+	return ret > 0 ? ret : KNOT_EMALF;
+}
+
+/*!
+ * \brief Fixes NSEC3 chain of the whole zone, only records which changed
+ *        are replaced.
+ *
+ * Hashes are taken from the NSEC3 nodes linked during zone adjusting, only
+ * names without NSEC3 record are hashed here.
+ */
+static int chain_update_nsec3(chain_ctx_t *ctx, knot_zone_contents_t *zone)
+{
+	/* Chain may not exist yet, use the parameters from NSEC3PARAM. */
+	const knot_nsec3_params_t *params = &zone->nsec3_params;
+
+	knot_zone_contents_tree_apply_inorder(zone, chain_collect_nsec3, ctx);
+	if (ctx->ret != KNOT_EOK || ctx->count == 0) {
+		return ctx->ret;
+	}
+
+	nsec3_entry_t *entries = calloc(ctx->count, sizeof(nsec3_entry_t));
+	const knot_node_t **covered = calloc(ctx->count, sizeof(knot_node_t *));
+	uint16_t *types = malloc(NODE_MAX_TYPES * sizeof(uint16_t));
+	uint8_t *bitmap = malloc(BITMAP_MAX_SIZE);
+	if (entries == NULL || covered == NULL || types == NULL ||
+	    bitmap == NULL) {
+		free(entries);
+		free(covered);
+		free(types);
+		free(bitmap);
+		return KNOT_ENOMEM;
+	}
+
+	int ret = KNOT_EOK;
+	size_t covered_count = 0;
+	for (size_t i = 0; ret == KNOT_EOK && i < ctx->count; ++i) {
+		nsec3_entry_t *entry = &entries[i];
+		entry->node = ctx->nodes[i];
+		entry->nsec3 = knot_node_nsec3_node(entry->node);
+		if (entry->nsec3 != NULL) {
+			entry->hashed = knot_node_owner(entry->nsec3);
+			covered[covered_count++] = entry->nsec3;
+		} else {
+			const knot_dname_t *owner = knot_node_owner(entry->node);
+			ret = knot_zone_contents_nsec3_name(zone, owner,
+			                                    &entry->hashed_new);
+			entry->hashed = entry->hashed_new;
+		}
+	}
+
+	qsort(entries, ctx->count, sizeof(nsec3_entry_t), nsec3_entry_cmp);
+
+	for (size_t i = 0; ret == KNOT_EOK && i < ctx->count; ++i) {
+		const nsec3_entry_t *entry = &entries[i];
+		const nsec3_entry_t *next = &entries[(i + 1) % ctx->count];
+
+		/* Next hashed owner is the first label, Base32hex encoded. */
+		uint8_t next_hash[255];
+		int next_size = nsec3_hash_decode(next->hashed, next_hash,
+		                                  sizeof(next_hash));
+		if (next_size < 0) {
+			ret = next_size;
+			break;
+		}
+
+		size_t type_count = node_types(entry->node, types,
+		                               KNOT_RRTYPE_NSEC3);
+		size_t bitmap_size = type_bitmap_write(types, type_count,
+		                                       bitmap);
+
+		const knot_rrset_t *old = entry->nsec3
+		        ? knot_node_rrset(entry->nsec3, KNOT_RRTYPE_NSEC3)
+		        : NULL;
+		ret = chain_nsec3_replace(ctx, params, entry->hashed, old,
+		                          next_hash, next_size, bitmap,
+		                          bitmap_size);
+	}
+
+	/* NSEC3 records of names which disappeared. */
+	if (ret == KNOT_EOK) {
+		qsort(covered, covered_count, sizeof(knot_node_t *), ptr_cmp);
+		nsec3_stale_t stale = { covered, covered_count, ctx->out,
+		                        KNOT_EOK };
+		knot_zone_contents_nsec3_apply_inorder(zone,
+		                                       chain_remove_stale_nsec3,
+		                                       &stale);
+		ret = stale.ret;
+	}
+
+	for (size_t i = 0; i < ctx->count; ++i) {
+		knot_dname_release(entries[i].hashed_new);
+	}
+
+	free(entries);
+	free(covered);
+	free(types);
+	free(bitmap);
+
+	return ret;
+}
+
+/*!
+ * \brief Name listed for the incremental chain fix-up.
+ *
+ * Only names touched by the changesets, empty non-terminals above them and
+ * their predecessors in the chain are listed. The rest of the chain is
+ * reached through next owner fields of the existing records.
+ */
+typedef struct chain_entry {
+	const knot_dname_t *key;  /*!< Owner of the chain record. */
+	knot_dname_t *key_new;    /*!< Owner created here (released). */
+	const knot_node_t *node;  /*!< Covered node, NULL if not known. */
+	const knot_rrset_t *old;  /*!< Existing chain record or NULL. */
+	knot_dname_t *next;       /*!< New next owner (retained). */
+	uint8_t covered;          /*!< Name is covered by the updated chain. */
+	uint8_t in_zone;          /*!< Existing record is still in the zone. */
+} chain_entry_t;
+
+typedef struct chain_list {
+	chain_entry_t *entries;
+	size_t count;
+	size_t allocated;
+} chain_list_t;
+
+/*!
+ * \brief Returns next owner of the existing chain record (retained).
+ */
+typedef knot_dname_t *(*chain_next_cb)(const knot_zone_contents_t *zone,
+                                       const knot_rrset_t *old);
+
+static int chain_list_add(chain_list_t *list, const chain_entry_t *entry)
+{
+	if (list->count == list->allocated) {
+		size_t allocated = list->allocated ? list->allocated * 2 : 64;
+		chain_entry_t *entries = realloc(list->entries, allocated
+		                                 * sizeof(chain_entry_t));
+		if (entries == NULL) {
+			return KNOT_ENOMEM;
+		}
+		list->entries = entries;
+		list->allocated = allocated;
+	}
+
+	list->entries[list->count++] = *entry;
+	return KNOT_EOK;
+}
+
+static void chain_list_free(chain_list_t *list)
+{
+	for (size_t i = 0; i < list->count; ++i) {
+		knot_dname_release(list->entries[i].key_new);
+		knot_dname_release(list->entries[i].next);
+	}
+
+	free(list->entries);
+	memset(list, 0, sizeof(*list));
+}
+
+static int chain_entry_key_cmp(const void *a, const void *b)
+{
+	const chain_entry_t *e1 = a;
+	const chain_entry_t *e2 = b;
+
+	return knot_dname_compare(e1->key, e2->key);
+}
+
+/*! \brief Orders entries by owner, entries with known node go first. */
+static int chain_entry_cmp(const void *a, const void *b)
+{
+	const chain_entry_t *e1 = a;
+	const chain_entry_t *e2 = b;
+
+	int cmp = chain_entry_key_cmp(a, b);
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	return (e1->node == NULL) - (e2->node == NULL);
+}
+
+/*! \brief Sorts the list and removes duplicate names. */
+static void chain_list_sort(chain_list_t *list)
+{
+	qsort(list->entries, list->count, sizeof(chain_entry_t),
+	      chain_entry_cmp);
+
+	size_t unique = 0;
+	for (size_t i = 0; i < list->count; ++i) {
+		chain_entry_t *entry = &list->entries[i];
+		if (unique > 0 &&
+		    chain_entry_key_cmp(&list->entries[unique - 1], entry) == 0) {
+			knot_dname_release(entry->key_new);
+			continue;
+		}
+		list->entries[unique++] = *entry;
+	}
+
+	list->count = unique;
+}
+
+static chain_entry_t *chain_list_find(const chain_list_t *list,
+                                      const knot_dname_t *key)
+{
+	chain_entry_t search = { 0 };
+	search.key = key;
+
+	return bsearch(&search, list->entries, list->count,
+	               sizeof(chain_entry_t), chain_entry_key_cmp);
+}
+
+/*!
+ * \brief Checks if the name is covered by the updated chain.
+ *
+ * Names which are not listed were not touched and stay in the chain.
+ */
+static int chain_list_covered(const chain_list_t *list,
+                              const knot_dname_t *key)
+{
+	const chain_entry_t *entry = chain_list_find(list, key);
+	return entry == NULL || entry->covered;
+}
+
+/*!
+ * \brief Returns the name closer after \a from in the circular chain order.
+ */
+static const knot_dname_t *chain_closer(const knot_dname_t *from,
+                                        const knot_dname_t *a,
+                                        const knot_dname_t *b)
+{
+	if (a == NULL || b == NULL) {
+		return a ? a : b;
+	}
+
+	int a_after = knot_dname_compare(a, from) > 0;
+	int b_after = knot_dname_compare(b, from) > 0;
+	if (a_after != b_after) {
+		return a_after ? a : b;
+	}
+
+	return knot_dname_compare(a, b) <= 0 ? a : b;
+}
+
+/*!
+ * \brief Finds first name after the listed name which stays in the chain
+ *        and was covered by the existing chain.
+ *
+ * The search starts from the closest listed name with existing record and
+ * follows the existing records over names removed from the chain.
+ *
+ * \retval KNOT_EOK if found, \a next is NULL if there is no existing chain.
+ * \retval KNOT_ENOENT if the existing chain cannot be followed.
+ */
+static int chain_old_next(const knot_zone_contents_t *zone,
+                          const chain_list_t *list, size_t pos,
+                          chain_next_cb next_cb, knot_dname_t **next)
+{
+	*next = NULL;
+
+	size_t base = pos;
+	for (size_t i = 0; list->entries[base].old == NULL; ++i) {
+		if (i == list->count) {
+			return KNOT_EOK;
+		}
+		base = (base + list->count - 1) % list->count;
+	}
+
+	knot_dname_t *name = next_cb(zone, list->entries[base].old);
+	for (size_t i = 0; name != NULL && i <= list->count; ++i) {
+		const chain_entry_t *entry = chain_list_find(list, name);
+		if (entry == NULL || entry->covered) {
+			*next = name;
+			return KNOT_EOK;
+		}
+
+		knot_dname_release(name);
+		if (entry->old == NULL) {
+			break;
+		}
+		name = next_cb(zone, entry->old);
+	}
+
+	knot_dname_release(name);
+	return KNOT_ENOENT;
+}
+
+/*!
+ * \brief Finds next owner for all listed names covered by the chain.
+ *
+ * Nothing is changed if the next owner of any name cannot be determined.
+ */
+static int chain_list_link(const knot_zone_contents_t *zone,
+                           chain_list_t *list, chain_next_cb next_cb)
+{
+	/* Walk backwards twice to link over the end of the list. */
+	const chain_entry_t *listed_next = NULL;
+	for (size_t i = 2 * list->count; i > 0; --i) {
+		chain_entry_t *entry = &list->entries[(i - 1) % list->count];
+		if (!entry->covered) {
+			continue;
+		}
+
+		if (i <= list->count) {
+			knot_dname_t *old_next = NULL;
+			int ret = chain_old_next(zone, list, i - 1, next_cb,
+			                         &old_next);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+
+			const knot_dname_t *next =
+				chain_closer(entry->key, listed_next->key,
+				             old_next);
+			entry->next = (knot_dname_t *)next;
+			knot_dname_retain(entry->next);
+			knot_dname_release(old_next);
+		}
+
+		listed_next = entry;
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Returns NSEC record removed from the name by the changesets.
+ */
+static const knot_rrset_t *changesets_removed_nsec(const knot_changesets_t *in,
+                                                   const knot_dname_t *owner)
+{
+	for (size_t i = 0; i < in->count; ++i) {
+		const knot_changeset_t *ch = &in->sets[i];
+		for (size_t j = 0; j < ch->remove_count; ++j) {
+			const knot_rrset_t *rr = ch->remove[j];
+			if (rr->type == KNOT_RRTYPE_NSEC &&
+			    knot_dname_compare(rr->owner, owner) == 0) {
+				return rr;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static knot_dname_t *nsec_old_next(const knot_zone_contents_t *zone,
+                                   const knot_rrset_t *old)
+{
+	UNUSED(zone);
+
+	if (old->rdata_count != 1) {
+		return NULL;
+	}
+
+	knot_dname_t *next = (knot_dname_t *)knot_rrset_rdata_nsec_next(old, 0);
+	knot_dname_retain(next);
+
+	return next;
+}
+
+/*!
+ * \brief Lists names touched by the changesets for the NSEC chain fix-up.
+ */
+static int chain_list_nsec(const knot_zone_contents_t *zone,
+                           const knot_changesets_t *in,
+                           const touched_rrset_t *touched, size_t count,
+                           chain_list_t *list)
+{
+	for (size_t i = 0; i < count; ++i) {
+		const knot_node_t *node =
+			knot_zone_contents_find_node(zone, touched[i].owner);
+
+		chain_entry_t entry = { 0 };
+		entry.key = node ? knot_node_owner(node) : touched[i].owner;
+		entry.node = node;
+		entry.covered = node != NULL && nsec_node_covered(node);
+		entry.old = node ? knot_node_rrset(node, KNOT_RRTYPE_NSEC) : NULL;
+		entry.in_zone = entry.old != NULL;
+		if (entry.old == NULL) {
+			entry.old = changesets_removed_nsec(in, entry.key);
+		}
+
+		int ret = chain_list_add(list, &entry);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	chain_list_sort(list);
+
+	/* Predecessors of names added to or removed from the chain. */
+	size_t listed = list->count;
+	for (size_t i = 0; i < listed; ++i) {
+		const chain_entry_t *entry = &list->entries[i];
+		if (entry->covered == (entry->old != NULL)) {
+			continue;
+		}
+
+		const knot_node_t *prev = entry->node
+		        ? knot_node_previous(entry->node)
+		        : knot_zone_contents_find_previous(zone, entry->key);
+		for (size_t j = 0; prev != NULL && j <= listed; ++j) {
+			if (nsec_node_covered(prev) &&
+			    chain_list_covered(list, knot_node_owner(prev))) {
+				break;
+			}
+			prev = knot_node_previous(prev);
+		}
+		if (prev == NULL) {
+			return KNOT_ENOENT;
+		}
+
+		chain_entry_t pred = { 0 };
+		pred.key = knot_node_owner(prev);
+		pred.node = prev;
+		pred.covered = 1;
+		pred.old = knot_node_rrset(prev, KNOT_RRTYPE_NSEC);
+		pred.in_zone = pred.old != NULL;
+
+		int ret = chain_list_add(list, &pred);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	chain_list_sort(list);
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Fixes NSEC chain around names touched by the changesets.
+ *
+ * \retval KNOT_ENOENT if the existing chain is not consistent with the zone,
+ *         nothing is changed in that case.
+ */
+static int chain_fix_nsec(chain_ctx_t *ctx, const knot_changesets_t *in,
+                          const touched_rrset_t *touched, size_t count)
+{
+	chain_list_t list;
+	memset(&list, 0, sizeof(list));
+
+	int ret = chain_list_nsec(ctx->zone, in, touched, count, &list);
+	if (ret == KNOT_EOK && list.count > 0) {
+		ret = chain_list_link(ctx->zone, &list, nsec_old_next);
+	}
+	if (ret != KNOT_EOK) {
+		chain_list_free(&list);
+		return ret;
+	}
+
+	uint16_t *types = malloc(NODE_MAX_TYPES * sizeof(uint16_t));
+	uint8_t *bitmap = malloc(BITMAP_MAX_SIZE);
+	if (types == NULL || bitmap == NULL) {
+		ret = KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; ret == KNOT_EOK && i < list.count; ++i) {
+		const chain_entry_t *entry = &list.entries[i];
+		const knot_rrset_t *old = entry->in_zone ? entry->old : NULL;
+		if (entry->covered) {
+			ret = chain_nsec_replace(ctx, entry->node, old,
+			                         entry->next, types, bitmap);
+		} else if (old != NULL) {
+			ret = chain_remove_rrset(ctx->out, old);
+		}
+	}
+
+	dbg_zones("zone-sign: NSEC chain fixed around %zu names (%s)\n",
+	          list.count, knot_strerror(ret));
+
+	free(types);
+	free(bitmap);
+	chain_list_free(&list);
+
+	return ret;
+}
+
+/*!
+ * \brief Creates hashed owner name, Base32hex encoded hash prepended to
+ *        the zone name.
+ */
+static knot_dname_t *nsec3_hash_owner(const knot_zone_contents_t *zone,
+                                      const uint8_t *hash, size_t size)
+{
+	const knot_dname_t *apex = knot_node_owner(knot_zone_contents_apex(zone));
+	uint8_t wire[KNOT_MAX_DNAME_LENGTH];
+	int32_t label = base32hex_encode(hash, size, wire + 1,
+	                                 sizeof(wire) - 1);
+	if (label <= 0 || label > 63 ||
+	    1 + label + knot_dname_size(apex) > sizeof(wire)) {
+		return NULL;
+	}
+
+	wire[0] = label;
+	memcpy(wire + 1 + label, knot_dname_name(apex), knot_dname_size(apex));
+
+	return knot_dname_new_from_wire(wire, 1 + label + knot_dname_size(apex),
+	                                NULL);
+}
+
+static knot_dname_t *nsec3_old_next(const knot_zone_contents_t *zone,
+                                    const knot_rrset_t *old)
+{
+	if (old->rdata_count != 1) {
+		return NULL;
+	}
+
+	uint8_t *hash = NULL;
+	uint8_t hash_size = 0;
+	knot_rrset_rdata_nsec3_next_hashed(old, 0, &hash, &hash_size);
+
+	return nsec3_hash_owner(zone, hash, hash_size);
+}
+
+/*!
+ * \brief Finds NSEC3 node preceding the hashed name, wraps over the end.
+ */
+static const knot_node_t *nsec3_previous(knot_zone_contents_t *zone,
+                                         const knot_dname_t *hashed)
+{
+	knot_zone_tree_t *tree = knot_zone_contents_get_nsec3_nodes(zone);
+	const knot_node_t *found = NULL;
+	const knot_node_t *prev = NULL;
+	knot_zone_tree_find_less_or_equal(tree, hashed, &found, &prev);
+	if (prev != NULL) {
+		return prev;
+	}
+
+	/* Name precedes the first hashed name, the last one is previous. */
+	uint8_t hash[255];
+	int size = nsec3_hash_decode(hashed, hash, sizeof(hash));
+	if (size < 0) {
+		return NULL;
+	}
+
+	memset(hash, 0xff, size);
+	knot_dname_t *last = nsec3_hash_owner(zone, hash, size);
+	if (last == NULL) {
+		return NULL;
+	}
+
+	knot_zone_tree_find_less_or_equal(tree, last, &found, &prev);
+	knot_dname_release(last);
+
+	return found ? found : prev;
+}
+
+/*!
+ * \brief Lists name for the NSEC3 chain fix-up with its hashed owner.
+ */
+static int chain_list_nsec3_name(const knot_zone_contents_t *zone,
+                                 const knot_dname_t *name,
+                                 chain_list_t *list)
+{
+	const knot_node_t *node = knot_zone_contents_find_node(zone, name);
+
+	chain_entry_t entry = { 0 };
+	entry.node = node;
+	entry.covered = node != NULL && nsec3_node_covered(node);
+	entry.in_zone = 1;
+
+	const knot_node_t *nsec3 = node ? knot_node_nsec3_node(node) : NULL;
+	if (nsec3 != NULL) {
+		entry.key = knot_node_owner(nsec3);
+	} else {
+		int ret = knot_zone_contents_nsec3_name(zone, name,
+		                                        &entry.key_new);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		entry.key = entry.key_new;
+		nsec3 = knot_zone_contents_find_nsec3_node(zone, entry.key);
+	}
+
+	entry.old = nsec3 ? knot_node_rrset(nsec3, KNOT_RRTYPE_NSEC3) : NULL;
+
+	int ret = chain_list_add(list, &entry);
+	if (ret != KNOT_EOK) {
+		knot_dname_release(entry.key_new);
+	}
+
+	return ret;
+}
+
+/*!
+ * \brief Lists names touched by the changesets for the NSEC3 chain fix-up.
+ *
+ * Empty non-terminals above touched names are listed as well, they appear
+ * and disappear together with the names below them.
+ */
+static int chain_list_nsec3(knot_zone_contents_t *zone,
+                            const touched_rrset_t *touched, size_t count,
+                            chain_list_t *list)
+{
+	const knot_dname_t *apex = knot_node_owner(knot_zone_contents_apex(zone));
+
+	int ret = KNOT_EOK;
+	for (size_t i = 0; ret == KNOT_EOK && i < count; ++i) {
+		ret = chain_list_nsec3_name(zone, touched[i].owner, list);
+		if (ret != KNOT_EOK ||
+		    knot_dname_compare(touched[i].owner, apex) == 0) {
+			continue;
+		}
+
+		knot_dname_t *parent = knot_dname_left_chop(touched[i].owner);
+		while (ret == KNOT_EOK && parent != NULL &&
+		       knot_dname_compare(parent, apex) != 0) {
+			const knot_node_t *node =
+				knot_zone_contents_find_node(zone, parent);
+			if (node != NULL && knot_node_rrset_count(node) > 0) {
+				break;
+			}
+
+			ret = chain_list_nsec3_name(zone, parent, list);
+
+			knot_dname_t *chopped = knot_dname_left_chop(parent);
+			knot_dname_release(parent);
+			parent = chopped;
+		}
+		knot_dname_release(parent);
+	}
+
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	chain_list_sort(list);
+
+	/* Predecessors of hashed names added to or removed from the chain. */
+	size_t listed = list->count;
+	for (size_t i = 0; i < listed; ++i) {
+		const chain_entry_t *entry = &list->entries[i];
+		if (entry->covered == (entry->old != NULL)) {
+			continue;
+		}
+
+		const knot_node_t *prev = nsec3_previous(zone, entry->key);
+		for (size_t j = 0; prev != NULL && j <= listed; ++j) {
+			if (chain_list_covered(list, knot_node_owner(prev))) {
+				break;
+			}
+			prev = knot_node_previous(prev);
+		}
+		if (prev == NULL) {
+			return KNOT_ENOENT;
+		}
+
+		chain_entry_t pred = { 0 };
+		pred.key = knot_node_owner(prev);
+		pred.covered = 1;
+		pred.old = knot_node_rrset(prev, KNOT_RRTYPE_NSEC3);
+		pred.in_zone = 1;
+
+		ret = chain_list_add(list, &pred);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
+	chain_list_sort(list);
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Fixes NSEC3 chain around names touched by the changesets.
+ *
+ * Type bitmaps of predecessors which were not touched are kept.
+ *
+ * \retval KNOT_ENOENT if the existing chain is not consistent with the zone,
+ *         nothing is changed in that case.
+ */
+static int chain_fix_nsec3(chain_ctx_t *ctx, knot_zone_contents_t *zone,
+                           const touched_rrset_t *touched, size_t count)
+{
+	if (knot_zone_tree_weight(knot_zone_contents_get_nsec3_nodes(zone))
+	    == 0) {
+		return KNOT_ENOENT;
+	}
+
+	chain_list_t list;
+	memset(&list, 0, sizeof(list));
+
+	int ret = chain_list_nsec3(zone, touched, count, &list);
+	if (ret == KNOT_EOK && list.count > 0) {
+		ret = chain_list_link(zone, &list, nsec3_old_next);
+	}
+	if (ret != KNOT_EOK) {
+		chain_list_free(&list);
+		return ret;
+	}
+
+	const knot_nsec3_params_t *params = knot_zone_contents_nsec3params(zone);
+	uint16_t *types = malloc(NODE_MAX_TYPES * sizeof(uint16_t));
+	uint8_t *bitmap = malloc(BITMAP_MAX_SIZE);
+	if (types == NULL || bitmap == NULL) {
+		ret = KNOT_ENOMEM;
+	}
+
+	for (size_t i = 0; ret == KNOT_EOK && i < list.count; ++i) {
+		const chain_entry_t *entry = &list.entries[i];
+		if (!entry->covered) {
+			if (entry->old != NULL) {
+				ret = chain_remove_rrset(ctx->out, entry->old);
+			}
+			continue;
+		}
+
+		uint8_t next_hash[255];
+		int next_size = nsec3_hash_decode(entry->next, next_hash,
+		                                  sizeof(next_hash));
+		if (next_size < 0) {
+			ret = next_size;
+			break;
+		}
+
+		const uint8_t *types_bitmap = bitmap;
+		size_t bitmap_size = 0;
+		if (entry->node != NULL) {
+			size_t type_count = node_types(entry->node, types,
+			                               KNOT_RRTYPE_NSEC3);
+			bitmap_size = type_bitmap_write(types, type_count,
+			                                bitmap);
+		} else if (entry->old != NULL) {
+			uint8_t *old_bitmap = NULL;
+			uint16_t old_size = 0;
+			knot_rrset_rdata_nsec3_bitmap(entry->old, 0,
+			                              &old_bitmap, &old_size);
+			types_bitmap = old_bitmap;
+			bitmap_size = old_size;
+		}
+
+		ret = chain_nsec3_replace(ctx, params, entry->key, entry->old,
+		                          next_hash, next_size, types_bitmap,
+		                          bitmap_size);
+	}
+
+	dbg_zones("zone-sign: NSEC3 chain fixed around %zu names (%s)\n",
+	          list.count, knot_strerror(ret));
+
+	free(types);
+	free(bitmap);
+	chain_list_free(&list);
+
+	return ret;
+}
+
+int zone_sign(knot_zone_contents_t *zone, const zone_keyset_t *keyset,
+              const zone_sign_policy_t *policy, knot_changesets_t *changesets,
+              zone_sign_stats_t *stats)
+{
+	if (zone == NULL || keyset == NULL || policy == NULL ||
+	    changesets == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	const knot_node_t *apex = knot_zone_contents_apex(zone);
+	const knot_rrset_t *soa = knot_node_rrset(apex, KNOT_RRTYPE_SOA);
+	if (soa == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_changeset_t *changeset = NULL;
+	int ret = sign_changeset_new(soa, changesets, &changeset);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Collect RRSets in zone order, new SOA goes first. */
+	rrset_list_t list;
+	memset(&list, 0, sizeof(list));
+	ret = rrset_list_add(&list, changeset->soa_to);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	list.ret = KNOT_EOK;
+	knot_zone_contents_tree_apply_inorder(zone, collect_node_rrsets,
+	                                      &list);
+	if (list.ret != KNOT_EOK) {
+		free(list.rrsets);
+		return list.ret;
+	}
+
+	ret = zone_sign_rrsets(list.rrsets, list.count, keyset, policy,
+	                       changeset, stats);
+	free(list.rrsets);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* Build NSEC3 chain if NSEC3PARAM is present, NSEC chain otherwise.
+	 * Changed records are replaced, all of them are signed. */
+	chain_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.zone = zone;
+	ctx.out = changeset;
+	ctx.ttl = knot_rrset_rdata_soa_minimum(soa);
+	ctx.rclass = knot_rrset_class(soa);
+	ctx.sign_unchanged = 1;
+	ctx.ret = KNOT_EOK;
+
+	if (zone->nsec3_params.algorithm != 0) {
+		ret = chain_update_nsec3(&ctx, zone);
+	} else {
+		ret = chain_update_nsec(&ctx, zone);
+	}
+
+	if (ret == KNOT_EOK && ctx.added_count > 0) {
+		ret = zone_sign_rrsets(ctx.added, ctx.added_count, keyset,
+		                       policy, changeset, stats);
+	}
+
+	free(ctx.nodes);
+	free(ctx.added);
+
+	return ret;
+}
+
+/*!
+ * \brief Checks if changes of delegations or NSEC3 parameters require
+ *        the chain to be rebuilt from the whole zone.
+ *
+ * Adding or removing a delegation changes authority of the whole subtree,
+ * which is not tracked by the incremental fix-up.
+ */
+static int chain_rebuild_needed(const knot_zone_contents_t *zone,
+                                const knot_changesets_t *in)
+{
+	const knot_dname_t *apex = knot_node_owner(knot_zone_contents_apex(zone));
+
+	for (size_t i = 0; i < in->count; ++i) {
+		const knot_changeset_t *ch = &in->sets[i];
+		knot_rrset_t *const *parts[] = { ch->remove, ch->add };
+		size_t counts[] = { ch->remove_count, ch->add_count };
+		for (size_t p = 0; p < 2; ++p) {
+			for (size_t j = 0; j < counts[p]; ++j) {
+				const knot_rrset_t *rr = parts[p][j];
+				if (rr->type == KNOT_RRTYPE_NSEC3PARAM ||
+				    rr->type == KNOT_RRTYPE_ANY ||
+				    (rr->type == KNOT_RRTYPE_NS &&
+				     knot_dname_compare(rr->owner, apex) != 0)) {
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+int zone_sign_changesets(knot_zone_contents_t *zone,
+                         const knot_changesets_t *in,
+                         const zone_keyset_t *keyset,
+                         const zone_sign_policy_t *policy,
+                         knot_changeset_t *out, zone_sign_stats_t *stats)
+{
+	if (zone == NULL || in == NULL || keyset == NULL || policy == NULL ||
+	    out == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	const knot_node_t *apex = knot_zone_contents_apex(zone);
+	const knot_rrset_t *soa = knot_node_rrset(apex, KNOT_RRTYPE_SOA);
+	if (soa == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* 1. Re-sign RRSets touched by the changesets and the new SOA. */
+	touched_rrset_t *touched = NULL;
+	size_t touched_count = 0;
+	int ret = collect_touched(in, 0, &touched, &touched_count);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	const knot_rrset_t **rrsets = malloc((touched_count + 1)
+	                                     * sizeof(knot_rrset_t *));
+	if (rrsets == NULL) {
+		free(touched);
+		return KNOT_ENOMEM;
+	}
+
+	size_t count = 0;
+	rrsets[count++] = soa;
+	for (size_t i = 0; i < touched_count; ++i) {
+		const knot_node_t *node =
+			knot_zone_contents_find_node(zone, touched[i].owner);
+		if (node == NULL ||
+		    !node_type_is_signed(node, touched[i].type)) {
+			continue;
+		}
+
+		const knot_rrset_t *rrset = knot_node_rrset(node,
+		                                            touched[i].type);
+		if (rrset != NULL && rrset->rdata_count > 0) {
+			rrsets[count++] = rrset;
+		}
+	}
+
+	ret = zone_sign_rrsets(rrsets, count, keyset, policy, out, stats);
+	free(rrsets);
+	free(touched);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	/* 2. Fix NSEC/NSEC3 chain and sign the replaced records. */
+	chain_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.zone = zone;
+	ctx.out = out;
+	ctx.ttl = knot_rrset_rdata_soa_minimum(soa);
+	ctx.rclass = knot_rrset_class(soa);
+	ctx.ret = KNOT_EOK;
+
+	int nsec3 = knot_zone_contents_nsec3_enabled(zone);
+	int nsec = !nsec3 && knot_node_rrset(apex, KNOT_RRTYPE_NSEC) != NULL;
+
+	/* Fix the chain around touched names, walk the zone only if the
+	 * update changes authority of whole subtrees or the chain itself. */
+	ret = KNOT_ENOENT;
+	if ((nsec || nsec3) && !chain_rebuild_needed(zone, in)) {
+		ret = collect_touched(in, 1, &touched, &touched_count);
+		if (ret == KNOT_EOK) {
+			ret = nsec3 ? chain_fix_nsec3(&ctx, zone, touched,
+			                              touched_count)
+			            : chain_fix_nsec(&ctx, in, touched,
+			                             touched_count);
+			free(touched);
+		}
+	}
+
+	if (ret == KNOT_ENOENT) {
+		ret = KNOT_EOK;
+		if (nsec3) {
+			ret = chain_update_nsec3(&ctx, zone);
+		} else if (nsec) {
+			ret = chain_update_nsec(&ctx, zone);
+		}
+	}
+
+	if (ret == KNOT_EOK && ctx.added_count > 0) {
+		ret = zone_sign_rrsets(ctx.added, ctx.added_count, keyset,
+		                       policy, out, stats);
+	}
+
+	dbg_zones("zone-sign: changeset re-signed, %zu chain records "
+	          "replaced (%s)\n", ctx.added_count, knot_strerror(ret));
+
+	free(ctx.nodes);
+	free(ctx.added);
+
+	return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Signature expiry index                                                     */
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \brief Signed RRSet in the expiry index.
+ */
+typedef struct expiry_entry {
+	knot_dname_t *owner;  /*!< Owner (retained). */
+	uint16_t type;        /*!< Type of the signed RRSet. */
+	uint32_t expiration;  /*!< Earliest expiration of its signatures. */
+} expiry_entry_t;
+
+static int expiry_entry_cmp(void *a, void *b)
+{
+	const expiry_entry_t *e1 = a;
+	const expiry_entry_t *e2 = b;
+
+	/* Serial number arithmetic is not needed until 2106. */
+	if (e1->expiration < e2->expiration) {
+		return -1;
+	}
+
+	return e1->expiration > e2->expiration ? 1 : 0;
+}
+
+static void expiry_entry_free(expiry_entry_t *entry)
+{
+	knot_dname_release(entry->owner);
+	free(entry);
+}
+
+/*! \brief Returns the earliest expiration of RRSIGs in given set or 0. */
+static uint32_t rrsigs_expiration(const knot_rrset_t *rrsigs)
+{
+	uint32_t expiration = 0;
+	for (uint16_t i = 0; rrsigs != NULL && i < rrsigs->rdata_count; ++i) {
+		uint32_t e = knot_rrset_rdata_rrsig_sig_expiration(rrsigs, i);
+		if (expiration == 0 || e < expiration) {
+			expiration = e;
+		}
+	}
+
+	return expiration;
+}
+
+/*!
+ * \brief Context for checking if the zone needs to be signed.
+ */
+typedef struct sign_check {
+	uint32_t refresh;
+	int needed;
+} sign_check_t;
+
+static void sign_check_node(knot_node_t *node, void *data)
+{
+	sign_check_t *ctx = data;
+	if (ctx->needed || knot_node_is_non_auth(node)) {
+		return;
+	}
+
+	const knot_rrset_t **rrsets = knot_node_rrsets_no_copy(node);
+	short count = knot_node_rrset_count(node);
+	for (short i = 0; i < count; ++i) {
+		uint16_t type = knot_rrset_type(rrsets[i]);
+		if (type == KNOT_RRTYPE_RRSIG ||
+		    !node_type_is_signed(node, type)) {
+			continue;
+		}
+
+		uint32_t expiration = rrsigs_expiration(rrsets[i]->rrsigs);
+		if (expiration == 0 || expiration < ctx->refresh) {
+			ctx->needed = 1;
+			return;
+		}
+	}
+}
+
+int zone_sign_needed(knot_zone_contents_t *zone, uint32_t refresh)
+{
+	if (zone == NULL || zone->apex == NULL) {
+		return 0;
+	}
+
+	sign_check_t ctx = { refresh, 0 };
+	knot_zone_contents_tree_apply_inorder(zone, sign_check_node, &ctx);
+	if (!ctx.needed) {
+		knot_zone_contents_nsec3_apply_inorder(zone, sign_check_node,
+		                                       &ctx);
+	}
+
+	dbg_zones("zone-sign: zone %s signing\n",
+	          ctx.needed ? "needs" : "does not need");
+
+	return ctx.needed;
+}
+
+/*! \brief Inserts new entry into the index, caller holds the lock. */
+static int expiry_insert(zone_expiry_t *exp, const knot_dname_t *owner,
+                         uint16_t type, uint32_t expiration)
+{
+	expiry_entry_t *entry = malloc(sizeof(expiry_entry_t));
+	if (entry == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	entry->owner = (knot_dname_t *)owner;
+	knot_dname_retain(entry->owner);
+	entry->type = type;
+	entry->expiration = expiration;
+
+	if (!heap_insert(&exp->heap, entry)) {
+		expiry_entry_free(entry);
+		return KNOT_ENOMEM;
+	}
+
+	return KNOT_EOK;
+}
+
+/*! \brief Removes all entries from the index, caller holds the lock. */
+static void expiry_clear(zone_expiry_t *exp)
+{
+	while (!EMPTY_HEAP(&exp->heap)) {
+		expiry_entry_t *entry = *((expiry_entry_t **)HHEAD(&exp->heap));
+		heap_delmin(&exp->heap);
+		expiry_entry_free(entry);
+	}
+}
+
+int zone_expiry_init(zone_expiry_t *exp)
+{
+	if (exp == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (!heap_init(&exp->heap, expiry_entry_cmp, 0)) {
+		return KNOT_ENOMEM;
+	}
+
+	pthread_mutex_init(&exp->lock, NULL);
+	return KNOT_EOK;
+}
+
+void zone_expiry_free(zone_expiry_t *exp)
+{
+	if (exp == NULL) {
+		return;
+	}
+
+	expiry_clear(exp);
+	free(exp->heap.data);
+	exp->heap.data = NULL;
+	pthread_mutex_destroy(&exp->lock);
+}
+
+/*!
+ * \brief Context for building the expiry index from the zone.
+ */
+typedef struct expiry_build {
+	zone_expiry_t *exp;
+	int ret;
+} expiry_build_t;
+
+static void expiry_build_node(knot_node_t *node, void *data)
+{
+	expiry_build_t *ctx = data;
+	if (ctx->ret != KNOT_EOK || knot_node_is_non_auth(node)) {
+		return;
+	}
+
+	const knot_rrset_t **rrsets = knot_node_rrsets_no_copy(node);
+	short count = knot_node_rrset_count(node);
+	for (short i = 0; i < count; ++i) {
+		uint32_t expiration = rrsigs_expiration(rrsets[i]->rrsigs);
+		if (expiration == 0) {
+			continue;
+		}
+
+		ctx->ret = expiry_insert(ctx->exp, knot_rrset_owner(rrsets[i]),
+		                         knot_rrset_type(rrsets[i]),
+		                         expiration);
+		if (ctx->ret != KNOT_EOK) {
+			return;
+		}
+	}
+}
+
+int zone_expiry_build(zone_expiry_t *exp, knot_zone_contents_t *zone)
+{
+	if (exp == NULL || zone == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	expiry_build_t ctx = { exp, KNOT_EOK };
+
+	pthread_mutex_lock(&exp->lock);
+	expiry_clear(exp);
+	knot_zone_contents_tree_apply_inorder(zone, expiry_build_node, &ctx);
+	knot_zone_contents_nsec3_apply_inorder(zone, expiry_build_node, &ctx);
+	dbg_zones("zone-sign: expiry index built, %d signed RRSets (%s)\n",
+	          exp->heap.num, knot_strerror(ctx.ret));
+	pthread_mutex_unlock(&exp->lock);
+
+	return ctx.ret;
+}
+
+int zone_expiry_add_changeset(zone_expiry_t *exp,
+                              const knot_changeset_t *changeset)
+{
+	if (exp == NULL || changeset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	int ret = KNOT_EOK;
+	pthread_mutex_lock(&exp->lock);
+	for (size_t i = 0; i < changeset->add_count; ++i) {
+		const knot_rrset_t *rrset = changeset->add[i];
+		if (knot_rrset_type(rrset) != KNOT_RRTYPE_RRSIG ||
+		    rrset->rdata_count == 0) {
+			continue;
+		}
+
+		ret = expiry_insert(exp, knot_rrset_owner(rrset),
+		                    knot_rrset_rdata_rrsig_type_covered(rrset),
+		                    rrsigs_expiration(rrset));
+		if (ret != KNOT_EOK) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&exp->lock);
+
+	return ret;
+}
+
+uint32_t zone_expiry_next(zone_expiry_t *exp)
+{
+	if (exp == NULL) {
+		return 0;
+	}
+
+	uint32_t expiration = 0;
+	pthread_mutex_lock(&exp->lock);
+	if (!EMPTY_HEAP(&exp->heap)) {
+		expiry_entry_t *entry = *((expiry_entry_t **)HHEAD(&exp->heap));
+		expiration = entry->expiration;
+	}
+	pthread_mutex_unlock(&exp->lock);
+
+	return expiration;
+}
+
+/*!
+ * \brief Finds signed RRSet for the index entry in the current zone.
+ *
+ * \retval RRSet if it still exists, is signed at its node (e.g. not glue)
+ *         and its signatures match the entry.
+ * \retval NULL if the entry is stale.
+ */
+static const knot_rrset_t *expiry_lookup(const knot_zone_contents_t *zone,
+                                         const expiry_entry_t *entry)
+{
+	const knot_node_t *node = knot_zone_contents_find_node(zone,
+	                                                       entry->owner);
+	if (node == NULL) {
+		node = knot_zone_contents_find_nsec3_node(zone, entry->owner);
+	}
+	if (node == NULL) {
+		return NULL;
+	}
+
+	const knot_rrset_t *rrset = knot_node_rrset(node, entry->type);
+	if (rrset == NULL || !node_type_is_signed(node, entry->type) ||
+	    rrsigs_expiration(rrset->rrsigs) != entry->expiration) {
+		return NULL;
+	}
+
+	return rrset;
+}
+
+int zone_sign_expiring(knot_zone_contents_t *zone, zone_expiry_t *exp,
+                       uint32_t refresh, size_t max_rrsets,
+                       const zone_keyset_t *keyset,
+                       const zone_sign_policy_t *policy,
+                       knot_changesets_t *changesets, zone_sign_stats_t *stats)
+{
+	if (zone == NULL || exp == NULL || max_rrsets == 0 || keyset == NULL ||
+	    policy == NULL || changesets == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	const knot_node_t *apex = knot_zone_contents_apex(zone);
+	const knot_rrset_t *soa = knot_node_rrset(apex, KNOT_RRTYPE_SOA);
+	if (soa == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* SOA is always re-signed, it takes the first slot. */
+	const knot_rrset_t **rrsets = malloc((max_rrsets + 1)
+	                                     * sizeof(knot_rrset_t *));
+	expiry_entry_t **taken = malloc(max_rrsets * sizeof(expiry_entry_t *));
+	if (rrsets == NULL || taken == NULL) {
+		free(rrsets);
+		free(taken);
+		return KNOT_ENOMEM;
+	}
+
+	/* Take a slice of due entries, drop the stale ones. */
+	size_t count = 1;
+	size_t taken_count = 0;
+	size_t stale_count = 0;
+	pthread_mutex_lock(&exp->lock);
+	while (taken_count < max_rrsets && !EMPTY_HEAP(&exp->heap)) {
+		expiry_entry_t *entry = *((expiry_entry_t **)HHEAD(&exp->heap));
+		if (entry->expiration > refresh) {
+			break;
+		}
+		heap_delmin(&exp->heap);
+
+		const knot_rrset_t *rrset = expiry_lookup(zone, entry);
+		if (rrset == NULL) {
+			expiry_entry_free(entry);
+			stale_count += 1;
+			continue;
+		}
+
+		taken[taken_count++] = entry;
+		if (entry->type != KNOT_RRTYPE_SOA) {
+			rrsets[count++] = rrset;
+		}
+	}
+	pthread_mutex_unlock(&exp->lock);
+
+	dbg_zones("zone-sign: %zu RRSets to refresh, %zu stale entries\n",
+	          taken_count, stale_count);
+
+	/* Only stale entries, keep the SOA serial. */
+	int ret = KNOT_EOK;
+	if (taken_count > 0) {
+		knot_changeset_t *changeset = NULL;
+		ret = sign_changeset_new(soa, changesets, &changeset);
+		if (ret == KNOT_EOK) {
+			rrsets[0] = changeset->soa_to;
+			ret = zone_sign_rrsets(rrsets, count, keyset, policy,
+			                       changeset, stats);
+		}
+	}
+
+	for (size_t i = 0; i < taken_count; ++i) {
+		expiry_entry_free(taken[i]);
+	}
+	free(taken);
+	free(rrsets);
+
+	return ret;
+}
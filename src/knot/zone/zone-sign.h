@@ -0,0 +1,310 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*!
+ * \file zone-sign.h
+ *
+ * \brief Bulk DNSSEC zone signing.
+ *
+ * Signatures are computed in parallel by a pool of worker threads, each
+ * holding its own signing contexts. The result is an IXFR-style changeset
+ * (old RRSIGs removed, new RRSIGs added, SOA serial incremented) which is
+ * applied to the zone the same way as any other incoming change.
+ *
+ * \addtogroup zone-load-dump
+ * @{
+ */
+
+#ifndef _KNOTD_ZONESIGN_H_
+#define _KNOTD_ZONESIGN_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "common/heap.h"
+#include "libknot/zone/zone-contents.h"
+#include "libknot/updates/changesets.h"
+#include "libknot/sign/dnssec.h"
+
+/*! \brief Default signature validity period (30 days). */
+#define ZONE_SIGN_VALIDITY (30 * 24 * 3600)
+
+/*! \brief Signature inception is moved back to tolerate clock skew. */
+#define ZONE_SIGN_SKEW 3600
+
+/*! \brief Signatures expiring within this period are refreshed (7 days). */
+#define ZONE_SIGN_REFRESH (7 * 24 * 3600)
+
+/*! \brief Maximum number of RRSets re-signed in one refresh slice. */
+#define ZONE_SIGN_SLICE 256
+
+/*!
+ * \brief Set of DNSSEC keys used to sign a zone.
+ */
+typedef struct zone_keyset {
+	knot_dnssec_key_t *keys; /*!< Signing keys. */
+	size_t count;            /*!< Number of keys. */
+} zone_keyset_t;
+
+/*!
+ * \brief Signing policy.
+ */
+typedef struct zone_sign_policy {
+	uint32_t inception;  /*!< Signature inception (UNIX time). */
+	uint32_t expiration; /*!< Signature expiration (UNIX time). */
+	int threads;         /*!< Number of signing threads, 0 for automatic. */
+} zone_sign_policy_t;
+
+/*!
+ * \brief Signing statistics.
+ */
+typedef struct zone_sign_stats {
+	size_t rrsets;     /*!< Number of signed RRSets. */
+	size_t signatures; /*!< Number of created signatures. */
+	int threads;       /*!< Number of threads used. */
+	double elapsed;    /*!< Wall clock time in seconds. */
+} zone_sign_stats_t;
+
+/*!
+ * \brief Index of signature expirations in a zone.
+ *
+ * Min-heap of signed RRSets ordered by the earliest expiration of their
+ * RRSIGs. Entries are checked against the zone when taken out, entries made
+ * stale by later changes are dropped.
+ */
+typedef struct zone_expiry {
+	struct heap heap;     /*!< Heap of signed RRSets. */
+	pthread_mutex_t lock; /*!< Index lock. */
+} zone_expiry_t;
+
+/*!
+ * \brief Loads all private keys for given zone from the key directory.
+ *
+ * Only keys in BIND format (K<zone>+<alg>+<tag>.private) with owner equal
+ * to the zone apex are loaded.
+ *
+ * \param keydir Key directory.
+ * \param apex Zone apex name.
+ * \param keyset Key set to be filled.
+ *
+ * \retval KNOT_EOK if at least one key was loaded.
+ * \retval KNOT_ENOENT if no usable key was found.
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_sign_load_keys(const char *keydir, const knot_dname_t *apex,
+                        zone_keyset_t *keyset);
+
+/*!
+ * \brief Frees keys in the key set.
+ *
+ * \param keyset Key set to be cleared.
+ */
+void zone_sign_free_keys(zone_keyset_t *keyset);
+
+/*!
+ * \brief Initializes signing policy with validity period starting now.
+ *
+ * \param policy Policy to be initialized.
+ * \param validity Signature validity period in seconds.
+ * \param threads Number of signing threads, 0 for automatic.
+ */
+void zone_sign_policy_init(zone_sign_policy_t *policy, uint32_t validity,
+                           int threads);
+
+/*!
+ * \brief Signs given RRSets and stores the changes into changeset.
+ *
+ * Existing RRSIGs of the RRSets are put into the REMOVE section, new RRSIGs
+ * (one per key) into the ADD section, in the order of input RRSets.
+ *
+ * \note Input RRSets are only read, workers never modify shared data.
+ *
+ * \param rrsets RRSets to be signed.
+ * \param count Number of RRSets.
+ * \param keyset Signing keys.
+ * \param policy Signing policy.
+ * \param changeset Changeset to store the changes to.
+ * \param stats Signing statistics (may be NULL).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ * \retval KNOT_DNSSEC_E* on signing failure.
+ */
+int zone_sign_rrsets(const knot_rrset_t **rrsets, size_t count,
+                     const zone_keyset_t *keyset,
+                     const zone_sign_policy_t *policy,
+                     knot_changeset_t *changeset, zone_sign_stats_t *stats);
+
+/*!
+ * \brief Signs whole zone.
+ *
+ * All authoritative RRSets are (re-)signed, SOA serial is incremented.
+ * NSEC3 chain is built if the zone has NSEC3PARAM, NSEC chain otherwise.
+ * Only chain records which differ from the existing ones are replaced.
+ *
+ * \param zone Zone contents to be signed.
+ * \param keyset Signing keys.
+ * \param policy Signing policy.
+ * \param changesets Changesets to store the resulting changeset to.
+ * \param stats Signing statistics (may be NULL).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ * \retval KNOT_DNSSEC_E* on signing failure.
+ */
+int zone_sign(knot_zone_contents_t *zone, const zone_keyset_t *keyset,
+              const zone_sign_policy_t *policy, knot_changesets_t *changesets,
+              zone_sign_stats_t *stats);
+
+/*!
+ * \brief Re-signs RRSets touched by changesets already applied to the zone.
+ *
+ * Only RRSets changed by \a in and the SOA are signed. NSEC or NSEC3 chain
+ * is fixed up around the touched names and their predecessors in the chain,
+ * only records which changed (new or removed names, changed type bitmaps)
+ * are replaced and signed. The whole zone is walked only if the changesets
+ * add or remove delegations or change NSEC3 parameters.
+ *
+ * \param zone Zone contents with the changesets applied (not switched yet).
+ * \param in Applied changesets.
+ * \param keyset Signing keys.
+ * \param policy Signing policy.
+ * \param out Changeset to store DNSSEC changes to.
+ * \param stats Signing statistics (may be NULL).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ * \retval KNOT_DNSSEC_E* on signing failure.
+ */
+int zone_sign_changesets(knot_zone_contents_t *zone,
+                         const knot_changesets_t *in,
+                         const zone_keyset_t *keyset,
+                         const zone_sign_policy_t *policy,
+                         knot_changeset_t *out, zone_sign_stats_t *stats);
+
+/*!
+ * \brief Checks if loaded zone has to be signed.
+ *
+ * Zone has to be signed if any authoritative RRSet is not signed or if any
+ * signature expires before \a refresh.
+ *
+ * \param zone Zone contents.
+ * \param refresh Signatures expiring before this time are refreshed.
+ *
+ * \retval 1 if the zone has to be signed.
+ * \retval 0 if existing signatures are sufficient.
+ */
+int zone_sign_needed(knot_zone_contents_t *zone, uint32_t refresh);
+
+/*!
+ * \brief Initializes empty expiry index.
+ *
+ * \param exp Index to be initialized.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_expiry_init(zone_expiry_t *exp);
+
+/*!
+ * \brief Frees all entries of the expiry index.
+ *
+ * \param exp Index to be freed.
+ */
+void zone_expiry_free(zone_expiry_t *exp);
+
+/*!
+ * \brief Rebuilds the expiry index from signatures in the zone.
+ *
+ * \param exp Expiry index.
+ * \param zone Zone contents.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_expiry_build(zone_expiry_t *exp, knot_zone_contents_t *zone);
+
+/*!
+ * \brief Adds signatures from the ADD section of changeset to the index.
+ *
+ * Must be called before the changeset is applied, applying consumes it.
+ *
+ * \param exp Expiry index.
+ * \param changeset Changeset with new signatures.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int zone_expiry_add_changeset(zone_expiry_t *exp,
+                              const knot_changeset_t *changeset);
+
+/*!
+ * \brief Returns the earliest signature expiration in the index.
+ *
+ * \param exp Expiry index.
+ *
+ * \return Expiration (UNIX time) or 0 if the index is empty.
+ */
+uint32_t zone_expiry_next(zone_expiry_t *exp);
+
+/*!
+ * \brief Re-signs a slice of RRSets with signatures expiring soon.
+ *
+ * At most \a max_rrsets RRSets with signatures expiring before \a refresh
+ * are taken from the index and re-signed together with the SOA. A changeset
+ * with a new SOA serial is added to \a changesets only if there was anything
+ * to re-sign, stale entries (RRSet removed, no longer signed or re-signed
+ * meanwhile) are dropped. Taken entries are removed from the index, the new
+ * signatures should be added back with zone_expiry_add_changeset().
+ *
+ * \param zone Zone contents.
+ * \param exp Expiry index of the zone.
+ * \param refresh Re-sign signatures expiring before this time.
+ * \param max_rrsets Maximum number of RRSets to re-sign.
+ * \param keyset Signing keys.
+ * \param policy Signing policy.
+ * \param changesets Changesets to store the resulting changeset to.
+ * \param stats Signing statistics (may be NULL).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ * \retval KNOT_DNSSEC_E* on signing failure.
+ */
+int zone_sign_expiring(knot_zone_contents_t *zone, zone_expiry_t *exp,
+                       uint32_t refresh, size_t max_rrsets,
+                       const zone_keyset_t *keyset,
+                       const zone_sign_policy_t *policy,
+                       knot_changesets_t *changesets, zone_sign_stats_t *stats);
+
+/*!
+ * \brief Returns signing throughput in signatures per second per core.
+ *
+ * \param stats Signing statistics.
+ *
+ * \return Signatures per second per thread.
+ */
+double zone_sign_rate(const zone_sign_stats_t *stats);
+
+#endif // _KNOTD_ZONESIGN_H_
+
+/*! @} */
@@ -31,75 +31,42 @@
 #include "util/utils.h"
 #include "util/wire.h"
 
-/*! \todo dnames allocated from TLS cache will be discarded after thread
- *        termination. This shouldn't happpen.
- */
-#if 0
 /*
  * Memory cache.
  */
 #include "common/slab/slab.h"
-#include <stdio.h>
 #include <pthread.h>
 
-/*! \brief TLS unique key for each thread cache. */
-static pthread_key_t dname_ckey;
+/*!
+ * \brief Shared dname cache.
+ *
+ * Dnames are allocated and released by different threads (e.g. zone loaded
+ * by one thread, released by another after update), per-thread magazines
+ * keep that cheap. The cache lives until the process exits.
+ */
+static slab_mcache_t dname_cache;
+static int dname_cache_ok = 0;
 static pthread_once_t dname_once = PTHREAD_ONCE_INIT;
 
-/*! \brief Destroy thread dname cache (automatically called). */
-static void knot_dname_cache_free(void *ptr)
-{
-	slab_cache_t* cache = (slab_cache_t*)ptr;
-	if (cache) {
-		slab_cache_destroy(cache);
-		free(cache);
-	}
-}
-
-/*! \brief Cleanup for main() TLS. */
-static void knot_dname_cache_main_free()
-{
-	knot_dname_cache_free(pthread_getspecific(dname_ckey));
-}
-
 static void knot_dname_cache_init()
 {
-	(void) pthread_key_create(&dname_ckey, knot_dname_cache_free);
-	atexit(knot_dname_cache_main_free); // Main thread cleanup
+	dname_cache_ok = (slab_mcache_init(&dname_cache,
+	                                   sizeof(knot_dname_t)) == 0);
 }
-#endif
 
 /*!
- * \brief Allocate item from thread cache.
+ * \brief Allocate item from shared cache.
  * \retval Allocated dname instance on success.
  * \retval NULL on error.
  */
 static knot_dname_t* knot_dname_alloc()
 {
-	return malloc(sizeof(knot_dname_t));
-
-	/*! \todo dnames allocated from TLS cache will be discarded after thread
-	 *        termination. This shouldn't happpen.
-	 */
-#if 0
-	/* Initialize dname cache TLS key. */
 	(void)pthread_once(&dname_once, knot_dname_cache_init);
-
-	/* Create cache if not exists. */
-	slab_cache_t* cache = pthread_getspecific(dname_ckey);
-	if (knot_unlikely(!cache)) {
-		cache = malloc(sizeof(slab_cache_t));
-		if (!cache) {
-			return 0;
-		}
-
-		/* Initialize cache. */
-		slab_cache_init(cache, sizeof(knot_dname_t));
-		(void)pthread_setspecific(dname_ckey, cache);
+	if (knot_unlikely(!dname_cache_ok)) {
+		return NULL;
 	}
 
-	return slab_cache_alloc(cache);
-#endif
+	return slab_mcache_alloc(&dname_cache);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -227,9 +194,23 @@ static int knot_dname_str_to_wire(const char *name, uint size,
 
 /*----------------------------------------------------------------------------*/
 
-static inline int knot_dname_tolower(uint8_t c, int cs)
+/*!
+ * \brief Computes FNV-1a hash of the domain name in lowercase.
+ */
+static uint32_t knot_dname_hash_wire(const uint8_t *name, uint size)
 {
-	return (cs) ? c : knot_tolower(c);
+	uint32_t hash = 2166136261U;
+	for (uint i = 0; i < size; ++i) {
+		hash ^= knot_tolower(name[i]);
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static inline int knot_dname_is_canonical(const knot_dname_t *dname)
+{
+	return dname->flags & KNOT_DNAME_CANONICAL;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -237,21 +218,22 @@ static inline int knot_dname_tolower(uint8_t c, int cs)
 static int knot_dname_compare_labels(const uint8_t *label1,
                                        const uint8_t *label2, int cs)
 {
-	const uint8_t *pos1 = label1;
-	const uint8_t *pos2 = label2;
+	int label_length = (*label1 < *label2) ? *label1 : *label2;
+	int res = 0;
 
-	int label_length = (*pos1 < *pos2) ? *pos1 : *pos2;
-	int i = 0;
-
-	while (i < label_length
-	       && knot_dname_tolower(*(++pos1), cs)
-	          == knot_dname_tolower(*(++pos2), cs)) {
-		++i;
+	if (cs) {
+		res = memcmp(label1 + 1, label2 + 1, label_length);
+	} else if (label_length >= 16) {
+		res = knot_tolower_cmp(label1 + 1, label2 + 1, label_length);
+	} else {
+		/* Short labels are faster compared inline. */
+		for (int i = 1; i <= label_length && res == 0; ++i) {
+			res = knot_tolower(label1[i]) - knot_tolower(label2[i]);
+		}
 	}
 
-	if (i < label_length) {  // difference in some octet
-		return (knot_dname_tolower(*pos1, cs)
-		        - knot_dname_tolower(*pos2, cs));
+	if (res != 0) {  // difference in some octet
+		return res;
 	}
 
 	return (label1[0] - label2[0]);
@@ -332,6 +314,15 @@ dbg_dname_exec_verb(
 		return 0;
 	}
 
+	/* Canonical names are in lowercase, no need to fold case. */
+	if (!cs && knot_dname_is_canonical(d1) && knot_dname_is_canonical(d2)) {
+		if (d1->hash == d2->hash && d1->size == d2->size
+		    && memcmp(d1->name, d2->name, d1->size) == 0) {
+			return 0;
+		}
+		cs = 1;
+	}
+
 	int l1 = d1->label_count;
 	int l2 = d2->label_count;
 	dbg_dname_detail("Label counts: %d and %d\n", l1, l2);
@@ -372,13 +363,18 @@ dbg_dname_exec_verb(
 knot_dname_t *knot_dname_new()
 {
 	knot_dname_t *dname = knot_dname_alloc();
+	if (dname == NULL) {
+		return NULL;
+	}
 
 	dname->name = NULL;
 	dname->labels = NULL;
 	dname->node = NULL;
 	dname->count = 1;
+	dname->hash = 0;
 	dname->size = 0;
 	dname->label_count = 0;
+	dname->flags = 0;
 
 	return dname;
 }
@@ -535,6 +531,10 @@ knot_dname_t *knot_dname_parse_from_wire(const uint8_t *wire,
 			if (i + length + 2 > KNOT_MAX_DNAME_LENGTH) {
 				return NULL;
 			}
+			/* Check that the label fits into the wire. */
+			if (p + length + 1 > size) {
+				return NULL;
+			}
 			//printf("Label %d (max %d), length: %u.\n", l, KNOT_MAX_DNAME_LABELS, length);
 			memcpy(name + i, wire + p, length + 1);
 			p += length + 1;
@@ -579,6 +579,7 @@ knot_dname_t *knot_dname_parse_from_wire(const uint8_t *wire,
 	dname->size = i + 1;
 	dname->label_count = l;
 	dname->node = node;
+	dname->flags = 0;
 
 	return dname;
 }
@@ -616,6 +617,8 @@ knot_dname_t *knot_dname_deep_copy(const knot_dname_t *dname)
 
 	memcpy(copy->name, dname->name, dname->size);
 	copy->size = dname->size;
+	copy->hash = dname->hash;
+	copy->flags = dname->flags;
 
 	copy->node = dname->node;
 
@@ -709,9 +712,9 @@ int knot_dname_to_lower(knot_dname_t *dname)
 		return KNOT_EINVAL;
 	}
 
-	for (int i = 0; i < dname->size; ++i) {
-		dname->name[i] = knot_tolower(dname->name[i]);
-	}
+	knot_tolower_buf(dname->name, dname->name, dname->size);
+	dname->hash = knot_dname_hash_wire(dname->name, dname->size);
+	dname->flags |= KNOT_DNAME_CANONICAL;
 	return KNOT_EOK;
 }
 
@@ -724,14 +727,23 @@ int knot_dname_to_lower_copy(const knot_dname_t *dname, char *name,
 		return KNOT_EINVAL;
 	}
 
-	for (int i = 0; i < dname->size; ++i) {
-		name[i] = knot_tolower(dname->name[i]);
-	}
+	knot_tolower_buf((uint8_t *)name, dname->name, dname->size);
 	return KNOT_EOK;
 }
 
 /*----------------------------------------------------------------------------*/
 
+uint32_t knot_dname_hash(const knot_dname_t *dname)
+{
+	if (knot_dname_is_canonical(dname)) {
+		return dname->hash;
+	}
+
+	return knot_dname_hash_wire(dname->name, dname->size);
+}
+
+/*----------------------------------------------------------------------------*/
+
 const uint8_t *knot_dname_name(const knot_dname_t *dname)
 {
 	return dname->name;
@@ -910,6 +922,8 @@ knot_dname_t *knot_dname_left_chop(const knot_dname_t *dname)
 
 void knot_dname_left_chop_no_copy(knot_dname_t *dname)
 {
+	dname->flags &= ~KNOT_DNAME_CANONICAL;
+
 	// copy the name
 	if (dname->label_count > 1) {
 		short first_label_length = dname->labels[1];
@@ -1092,8 +1106,7 @@ void knot_dname_free(knot_dname_t **dname)
 	free((*dname)->labels);
 
 
-//	slab_free(*dname);
-	free(*dname);
+	slab_free(*dname);
 	*dname = NULL;
 }
 
@@ -1111,6 +1124,26 @@ int knot_dname_compare_cs(const knot_dname_t *d1, const knot_dname_t *d2)
 	return knot_dname_cmp(d1, d2, 1);
 }
 
+int knot_dname_is_equal(const knot_dname_t *d1, const knot_dname_t *d2)
+{
+	if (d1 == d2) {
+		return 1;
+	}
+
+	if (d1->size != d2->size) {
+		return 0;
+	}
+
+	if (knot_dname_is_canonical(d1) && knot_dname_is_canonical(d2)) {
+		return d1->hash == d2->hash
+		       && memcmp(d1->name, d2->name, d1->size) == 0;
+	}
+
+	return knot_tolower_cmp(d1->name, d2->name, d1->size) == 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
 int knot_dname_compare_non_canon(const knot_dname_t *d1, const knot_dname_t *d2)
 {
 	int ret = memcmp(d1->name, d2->name,
@@ -1172,6 +1205,7 @@ knot_dname_t *knot_dname_cat(knot_dname_t *d1, const knot_dname_t *d2)
 	free(old_name);
 
 	d1->size += d2->size;
+	d1->flags &= ~KNOT_DNAME_CANONICAL;
 
 	return d1;
 }
@@ -46,12 +46,27 @@ struct knot_dname {
 	uint8_t *labels;	/*!< Array of labels positions in name. */
 	struct knot_node *node;	/*!< Zone node the domain name belongs to. */
 	uint32_t count;		/*!< Reference counter. */
+	uint32_t hash;		/*!< Hash of the name (if canonical). */
 	uint8_t size;		/*!< Length of the domain name. */
 	uint8_t label_count;	/*!< Number of labels. */
+	uint8_t flags;		/*!< Domain name flags. */
 };
 
 typedef struct knot_dname knot_dname_t;
 
+/*!
+ * \brief Domain name flags.
+ */
+enum knot_dname_flags {
+	/*!
+	 * \brief Name is in lowercase and its hash is computed.
+	 *
+	 * Set by knot_dname_to_lower(), cleared when the name is modified.
+	 * Canonical names are compared without case folding.
+	 */
+	KNOT_DNAME_CANONICAL = 1 << 0
+};
+
 /*----------------------------------------------------------------------------*/
 
 /*!
@@ -171,11 +186,32 @@ knot_dname_t *knot_dname_deep_copy(const knot_dname_t *dname);
  */
 char *knot_dname_to_str(const knot_dname_t *dname);
 
+/*!
+ * \brief Converts the domain name to lowercase and computes its hash.
+ *
+ * The name is marked canonical, see KNOT_DNAME_CANONICAL.
+ *
+ * \param dname Domain name to be converted.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ */
 int knot_dname_to_lower(knot_dname_t *dname);
 
 int knot_dname_to_lower_copy(const knot_dname_t *dname, char *name,
                              size_t size);
 
+/*!
+ * \brief Returns hash of the domain name in lowercase.
+ *
+ * The hash is precomputed for canonical names, computed otherwise.
+ *
+ * \param dname Domain name.
+ *
+ * \return Hash of the lowercase wire format.
+ */
+uint32_t knot_dname_hash(const knot_dname_t *dname);
+
 /*!
  * \brief Returns the domain name in wire format.
  *
@@ -355,6 +391,20 @@ int knot_dname_compare(const knot_dname_t *d1, const knot_dname_t *d2);
  * \retval 0 if the domain names are identical.
  */
 int knot_dname_compare_cs(const knot_dname_t *d1, const knot_dname_t *d2);
+
+/*!
+ * \brief Checks if the domain names are equal (case insensitive).
+ *
+ * Faster than knot_dname_compare() for canonical names, names with different
+ * hashes or sizes are rejected without comparing their labels.
+ *
+ * \param d1 First domain name.
+ * \param d2 Second domain name.
+ *
+ * \retval <> 0 if the domain names are equal.
+ * \retval 0 otherwise.
+ */
+int knot_dname_is_equal(const knot_dname_t *d1, const knot_dname_t *d2);
 int knot_dname_compare_non_canon(const knot_dname_t *d1,
                                  const knot_dname_t *d2);
 
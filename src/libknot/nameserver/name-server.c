@@ -118,18 +118,26 @@ static const knot_zone_t *ns_get_zone_for_qname(knot_zonedb_t *zdb,
  * \brief Synthetizes RRSet from a wildcard RRSet using the given QNAME.
  *
  * The synthetized RRSet is identical to the wildcard RRSets, except that the
- * owner name is replaced by \a qname.
+ * owner name is replaced by \a qname. It is stored in the response and shares
+ * RDATA with the wildcard RRSet. Only if the response has no space left for
+ * synthetized RRSets, the wildcard RRSet is copied and the copy is stored as
+ * a temporary RRSet of the response.
  *
+ * \param resp Response to store the synthetized RRSet to.
  * \param wildcard_rrset Wildcard RRSet to synthetize from.
  * \param qname Domain name to be used as the owner of the synthetized RRset.
  *
- * \return The synthetized RRSet (this is a newly created RRSet, remember to
- *         free it).
+ * \return The synthetized RRSet (freed with the response) or NULL.
  */
-static knot_rrset_t *ns_synth_from_wildcard(
+static knot_rrset_t *ns_synth_from_wildcard(knot_packet_t *resp,
 	const knot_rrset_t *wildcard_rrset, const knot_dname_t *qname)
 {
-	knot_rrset_t *rrset = NULL;
+	knot_rrset_t *rrset = knot_packet_synth_rrset(resp, wildcard_rrset,
+	                                              qname);
+	if (rrset != NULL) {
+		return rrset;
+	}
+
 	int ret = knot_rrset_deep_copy(wildcard_rrset, &rrset, 1);
 	if (ret != KNOT_EOK) {
 		dbg_ns("ns: ns_synth_from_wildcard: Could not copy RRSet.\n");
@@ -140,6 +148,13 @@ static knot_rrset_t *ns_synth_from_wildcard(
 	knot_rrset_set_owner(rrset, dname_copy);
 	knot_dname_release(dname_copy);
 
+	ret = knot_packet_add_tmp_rrset(resp, rrset);
+	if (ret != KNOT_EOK) {
+		dbg_ns("Failed to add sythetized RRSet to tmp list.\n");
+		knot_rrset_deep_free(&rrset, 1, 1);
+		return NULL;
+	}
+
 	return rrset;
 }
 
@@ -165,7 +180,7 @@ static int ns_check_wildcard(const knot_dname_t *name, knot_packet_t *resp,
 	if (knot_dname_is_wildcard((*rrset)->owner)) {
 		resp->flags |= KNOT_PF_WILDCARD; /* Mark */
 		knot_rrset_t *synth_rrset =
-			ns_synth_from_wildcard(*rrset, name);
+			ns_synth_from_wildcard(resp, *rrset, name);
 		if (synth_rrset == NULL) {
 			dbg_ns("Failed to synthetize RRSet from wildcard.\n");
 			return KNOT_ERROR;
@@ -176,12 +191,6 @@ dbg_ns_exec_verb(
 		knot_rrset_dump(synth_rrset);
 );
 
-		int ret = knot_packet_add_tmp_rrset(resp, synth_rrset);
-		if (ret != KNOT_EOK) {
-			dbg_ns("Failed to add sythetized RRSet to tmp list.\n");
-			knot_rrset_deep_free(&synth_rrset, 1, 1);
-			return ret;
-		}
 		*rrset = synth_rrset;
 	}
 
@@ -289,22 +298,14 @@ static int ns_follow_cname(const knot_node_t **node,
 		if (knot_dname_is_wildcard(knot_node_owner(*node))) {
 			/* if wildcard node, we must copy the RRSet and
 			   replace its owner */
-			rrset = ns_synth_from_wildcard(cname_rrset, *qname);
+			rrset = ns_synth_from_wildcard(resp, cname_rrset,
+			                               *qname);
 			if (rrset == NULL) {
 				dbg_ns("Failed to synthetize RRSet from "
 				       "wildcard RRSet followed from CNAME.\n");
 				return KNOT_ERROR; /*! \todo Better error. */
 			}
 
-			ret = knot_packet_add_tmp_rrset(resp, rrset);
-			if (ret != KNOT_EOK) {
-				dbg_ns("Failed to add synthetized RRSet (CNAME "
-				       "follow) to the tmp RRSets in response."
-				       "\n");
-				knot_rrset_deep_free(&rrset, 1, 1);
-				return ret;
-			}
-
 			ret = add_rrset_to_resp(resp, rrset, tc, 0, 1);
 			if (ret != KNOT_EOK) {
 				dbg_ns("Failed to add synthetized RRSet (CNAME "
@@ -1582,7 +1583,7 @@ static int ns_put_nsec_nsec3_wildcard_answer(const knot_node_t *node,
 	if (DNSSEC_ENABLED
 	    && knot_query_dnssec_requested(knot_packet_query(resp))
 	    && knot_dname_is_wildcard(knot_node_owner(node))
-	    && knot_dname_compare(qname, knot_node_owner(node)) != 0) {
+	    && !knot_dname_is_equal(qname, knot_node_owner(node))) {
 		dbg_ns_verb("Adding NSEC/NSEC3 for wildcard answer.\n");
 		if (knot_zone_contents_nsec3_enabled(zone)) {
 			ret = ns_put_nsec3_wildcard(zone, closest_encloser,
@@ -1834,7 +1835,7 @@ static int ns_answer_from_node(const knot_node_t *node,
 		assert(previous == NULL);
 		assert(closest_encloser == knot_node_parent(node)
 		      || !knot_dname_is_wildcard(knot_node_owner(node))
-		      || knot_dname_compare(qname, knot_node_owner(node)) == 0);
+		      || knot_dname_is_equal(qname, knot_node_owner(node)));
 
 		ret = ns_put_nsec_nsec3_wildcard_answer(node, closest_encloser,
 		                                  previous, zone, qname, resp);
@@ -2892,7 +2893,7 @@ static int ns_ixfr(knot_ns_xfr_t *xfr)
 	// check if XFR QNAME and SOA correspond
 	if (knot_packet_qtype(xfr->query) != KNOT_RRTYPE_IXFR
 	    || knot_rrset_type(soa) != KNOT_RRTYPE_SOA
-	    || knot_dname_compare(qname, knot_rrset_owner(soa)) != 0) {
+	    || !knot_dname_is_equal(qname, knot_rrset_owner(soa))) {
 		// malformed packet
 		dbg_ns("IXFR query is malformed.\n");
 		knot_response_set_rcode(xfr->response, KNOT_RCODE_FORMERR);
@@ -80,20 +80,58 @@ int knot_nsec3_params_from_wire(knot_nsec3_params_t *params,
 	return KNOT_EOK;
 }
 
+int knot_nsec3_hash(const knot_nsec3_params_t *params, const uint8_t *data,
+                    size_t size, uint8_t *digest)
+{
+	if (params == NULL || data == NULL || digest == NULL
+	    || size > KNOT_MAX_DNAME_LENGTH) {
+		return KNOT_EINVAL;
+	}
+
+	/* Names are hashed in lowercase. */
+	uint8_t data_low[KNOT_MAX_DNAME_LENGTH];
+	knot_tolower_buf(data_low, data, size);
+
+	const uint8_t *in = data_low;
+	size_t in_size = size;
+
+	SHA_CTX ctx;
+	for (int i = 0; i <= params->iterations; ++i) {
+		int res = SHA1_Init(&ctx);
+		res &= SHA1_Update(&ctx, in, in_size);
+		if (params->salt_length > 0) {
+			res &= SHA1_Update(&ctx, params->salt,
+			                   params->salt_length);
+		}
+		res &= SHA1_Final(digest, &ctx);
+
+		if (res != 1) {
+			dbg_nsec3("Error calculating SHA-1 hash.\n");
+			return KNOT_ECRYPTO;
+		}
+
+		in = digest;
+		in_size = SHA_DIGEST_LENGTH;
+	}
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+#if KNOT_NSEC3_SHA_USE_EVP
+
 static uint8_t *knot_nsec3_to_lowercase(const uint8_t *data, size_t size)
 {
 	uint8_t *out = (uint8_t *)malloc(size);
 	CHECK_ALLOC_LOG(out, NULL);
 
-	for (int i = 0; i < size; ++i) {
-		out[i] = knot_tolower(data[i]);
-	}
+	knot_tolower_buf(out, data, size);
 
 	return out;
 }
 
 /*----------------------------------------------------------------------------*/
-#if KNOT_NSEC3_SHA_USE_EVP
+
 int knot_nsec3_sha1(const knot_nsec3_params_t *params,
                       const uint8_t *data, size_t size, uint8_t **digest,
                       size_t *digest_size)
@@ -184,79 +222,176 @@ int knot_nsec3_sha1(const knot_nsec3_params_t *params,
 		return KNOT_EINVAL;
 	}
 
-	uint8_t *salt = params->salt;
-	uint8_t salt_length = params->salt_length;
-	uint16_t iterations = params->iterations;
-
-	dbg_nsec3_verb("Hashing: \n");
-	dbg_nsec3_verb("  Data: %.*s \n", (int)size, data);
-	dbg_nsec3_hex_verb((const char *)data, size);
-	dbg_nsec3_verb(" (size %d)\n  Iterations: %u\n", (int)size, iterations);
-	dbg_nsec3_verb("  Salt length: %u\n", salt_length);
-	dbg_nsec3_verb("  Salt: \n");
-	if (salt_length > 0) {
-		dbg_nsec3_hex_verb((char *)salt, salt_length);
-		dbg_nsec3_verb("\n");
-	} else {
-		dbg_nsec3_verb("none\n");
-	}
-
-	SHA_CTX ctx;
-
 	*digest = (uint8_t *)malloc(SHA_DIGEST_LENGTH);
 	if (*digest == NULL) {
 		ERR_ALLOC_FAILED;
 		return KNOT_ENOMEM;
 	}
 
-	uint8_t *data_low = knot_nsec3_to_lowercase(data, size);
-	if (data_low == NULL) {
+	int ret = knot_nsec3_hash(params, data, size, *digest);
+	if (ret != KNOT_EOK) {
 		free(*digest);
-		return KNOT_ENOMEM;
+		*digest = NULL;
+		return ret;
 	}
 
-	const uint8_t *in = data_low;
-	unsigned in_size = size;
+	*digest_size = SHA_DIGEST_LENGTH;
+	return KNOT_EOK;
+}
+#endif
 
-	int res = 0;
+/*----------------------------------------------------------------------------*/
 
-	// other iterations
-	for (int i = 0; i <= iterations; ++i) {
-		SHA1_Init(&ctx);
+void knot_nsec3_params_free(knot_nsec3_params_t *params)
+{
+	free(params->salt);
+}
 
-		res = SHA1_Update(&ctx, in, in_size);
+/*----------------------------------------------------------------------------*/
+/* NSEC3 hash cache                                                           */
+/*----------------------------------------------------------------------------*/
 
-		if (salt_length > 0) {
-			res = SHA1_Update(&ctx, salt, salt_length);
-		}
+/*! \brief FNV-1a hash of the name, selects cache slot. */
+static uint32_t knot_nsec3_cache_slot(const uint8_t *name, size_t size)
+{
+	uint32_t h = 2166136261U;
+	for (size_t i = 0; i < size; ++i) {
+		h = (h ^ name[i]) * 16777619U;
+	}
 
-		SHA1_Final(*digest, &ctx);
+	return h & (KNOT_NSEC3_CACHE_SLOTS - 1);
+}
 
-		in = *digest;
-		in_size = SHA_DIGEST_LENGTH;
+/*!
+ * \brief Reads hash from the slot if it holds given name.
+ *
+ * Slot is read without locking, the result is valid only if the sequence
+ * number did not change during the read.
+ */
+static int knot_nsec3_cache_read(const knot_nsec3_cache_slot_t *slot,
+                                 const uint8_t *name, size_t size,
+                                 uint8_t *digest)
+{
+	unsigned int seq = *(volatile const unsigned int *)&slot->seq;
+	if (seq & 1) {
+		return 0; /* Being written. */
+	}
+	__sync_synchronize();
 
-		if (res != 1) {
-			dbg_nsec3("Error calculating SHA-1 hash.\n");
-			free(data_low);
-			free(*digest);
-			return KNOT_ECRYPTO;
-		}
+	int match = (slot->name_size == size
+	             && memcmp(slot->name, name, size) == 0);
+	if (match) {
+		memcpy(digest, slot->hash, KNOT_NSEC3_HASH_LENGTH);
 	}
 
-	*digest_size = SHA_DIGEST_LENGTH;
+	__sync_synchronize();
+	return match && *(volatile const unsigned int *)&slot->seq == seq;
+}
 
-	dbg_nsec3_verb("Hash: %.*s\n", (int)*digest_size, *digest);
-	dbg_nsec3_hex_verb((const char *)*digest, *digest_size);
-	dbg_nsec3_verb("\n");
+/*!
+ * \brief Stores name and its hash to the slot.
+ *
+ * \param wait Wait for concurrent writer instead of giving up.
+ */
+static void knot_nsec3_cache_write(knot_nsec3_cache_slot_t *slot,
+                                   const uint8_t *name, size_t size,
+                                   const uint8_t *digest, int wait)
+{
+	unsigned int seq = 0;
+	int locked = 0;
+	do {
+		seq = *(volatile unsigned int *)&slot->seq;
+		locked = !(seq & 1)
+		         && __sync_bool_compare_and_swap(&slot->seq, seq,
+		                                         seq + 1);
+	} while (!locked && wait);
+
+	if (!locked) {
+		return; /* Other writer is active, skip. */
+	}
 
-	free(data_low);
-	return KNOT_EOK;
+	slot->name_size = size;
+	if (size > 0) {
+		memcpy(slot->name, name, size);
+		memcpy(slot->hash, digest, KNOT_NSEC3_HASH_LENGTH);
+	}
+
+	__sync_synchronize();
+	*(volatile unsigned int *)&slot->seq = seq + 2;
 }
-#endif
 
-/*----------------------------------------------------------------------------*/
+knot_nsec3_cache_t *knot_nsec3_cache_new()
+{
+	knot_nsec3_cache_t *cache = calloc(1, sizeof(knot_nsec3_cache_t));
+	CHECK_ALLOC_LOG(cache, NULL);
 
-void knot_nsec3_params_free(knot_nsec3_params_t *params)
+	return cache;
+}
+
+void knot_nsec3_cache_free(knot_nsec3_cache_t **cache)
 {
-	free(params->salt);
+	if (cache == NULL || *cache == NULL) {
+		return;
+	}
+
+	dbg_nsec3("NSEC3 cache: %u hits, %u misses.\n", (*cache)->hits,
+	          (*cache)->misses);
+
+	free(*cache);
+	*cache = NULL;
+}
+
+void knot_nsec3_cache_clear(knot_nsec3_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	for (unsigned i = 0; i < KNOT_NSEC3_CACHE_SLOTS; ++i) {
+		knot_nsec3_cache_write(&cache->slots[i], NULL, 0, NULL, 1);
+	}
+}
+
+int knot_nsec3_cache_hash(knot_nsec3_cache_t *cache,
+                          const knot_nsec3_params_t *params,
+                          const uint8_t *data, size_t size, uint8_t *digest)
+{
+	if (cache == NULL) {
+		return knot_nsec3_hash(params, data, size, digest);
+	}
+
+	if (params == NULL || data == NULL || digest == NULL
+	    || size == 0 || size > KNOT_MAX_DNAME_LENGTH) {
+		return KNOT_EINVAL;
+	}
+
+	uint8_t name[KNOT_MAX_DNAME_LENGTH];
+	knot_tolower_buf(name, data, size);
+
+	knot_nsec3_cache_slot_t *slot =
+		&cache->slots[knot_nsec3_cache_slot(name, size)];
+	if (knot_nsec3_cache_read(slot, name, size, digest)) {
+		__sync_fetch_and_add(&cache->hits, 1);
+		return KNOT_EOK;
+	}
+
+	__sync_fetch_and_add(&cache->misses, 1);
+	int ret = knot_nsec3_hash(params, name, size, digest);
+	if (ret == KNOT_EOK) {
+		knot_nsec3_cache_write(slot, name, size, digest, 0);
+	}
+
+	return ret;
+}
+
+void knot_nsec3_cache_stats(const knot_nsec3_cache_t *cache,
+                            unsigned *hits, unsigned *misses)
+{
+	if (cache == NULL) {
+		*hits = *misses = 0;
+		return;
+	}
+
+	*hits = cache->hits;
+	*misses = cache->misses;
 }
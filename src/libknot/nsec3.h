@@ -31,9 +31,16 @@
 #include <string.h>
 
 #include "rrset.h"
+#include "consts.h"
 
 #define KNOT_NSEC3_SHA_USE_EVP 0
 
+/*! \brief Size of NSEC3 hash (SHA-1 digest) in octets. */
+#define KNOT_NSEC3_HASH_LENGTH 20
+
+/*! \brief Number of slots in the NSEC3 hash cache (power of 2). */
+#define KNOT_NSEC3_CACHE_SLOTS 1024
+
 /*----------------------------------------------------------------------------*/
 /*!
  * \brief Structure representing the NSEC3PARAM resource record.
@@ -60,6 +67,30 @@ typedef struct knot_nsec3_params knot_nsec3_params_t;
 int knot_nsec3_params_from_wire(knot_nsec3_params_t *params,
                                   const knot_rrset_t *nsec3param);
 
+/*----------------------------------------------------------------------------*/
+/*!
+ * \brief Slot of the NSEC3 hash cache.
+ */
+typedef struct knot_nsec3_cache_slot {
+	unsigned int seq;  /*!< Sequence number, odd while being written. */
+	uint8_t name_size; /*!< Size of the name, 0 if empty. */
+	uint8_t name[KNOT_MAX_DNAME_LENGTH];  /*!< Lowercase owner name. */
+	uint8_t hash[KNOT_NSEC3_HASH_LENGTH]; /*!< Hash of the name. */
+} knot_nsec3_cache_slot_t;
+
+/*!
+ * \brief Direct-mapped cache of NSEC3 hashes of owner names.
+ *
+ * Lookups do not lock, slots are protected by sequence numbers. Writers never
+ * wait, slot being written by another thread is simply not updated.
+ */
+typedef struct knot_nsec3_cache {
+	knot_nsec3_cache_slot_t slots[KNOT_NSEC3_CACHE_SLOTS]; /*!< Slots. */
+	unsigned int hits;   /*!< Number of cache hits. */
+	unsigned int misses; /*!< Number of cache misses. */
+} knot_nsec3_cache_t;
+
+/*----------------------------------------------------------------------------*/
 /*!
  * \brief Hashes the given data using the SHA1 hash and the given parameters.
  *
@@ -78,6 +109,22 @@ int knot_nsec3_params_from_wire(knot_nsec3_params_t *params,
 int knot_nsec3_sha1(const knot_nsec3_params_t *params, const uint8_t *data,
                       size_t size, uint8_t **digest, size_t *digest_size);
 
+/*!
+ * \brief Hashes the given name using SHA1 without allocating memory.
+ *
+ * \param[in] params NSEC3PARAM structure with the required parameters for
+ *                   hashing.
+ * \param[in] data Domain name in wire format.
+ * \param[in] size Size of the name in octets.
+ * \param[out] digest Buffer of KNOT_NSEC3_HASH_LENGTH octets for the result.
+ *
+ * \retval KNOT_EOK if successful.
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ECRYPTO
+ */
+int knot_nsec3_hash(const knot_nsec3_params_t *params, const uint8_t *data,
+                    size_t size, uint8_t *digest);
+
 /*!
  * \brief Properly cleans up (but does not deallocate) the NSEC3PARAM structure.
  *
@@ -85,6 +132,54 @@ int knot_nsec3_sha1(const knot_nsec3_params_t *params, const uint8_t *data,
  */
 void knot_nsec3_params_free(knot_nsec3_params_t *params);
 
+/*!
+ * \brief Creates empty NSEC3 hash cache.
+ *
+ * \return New cache or NULL if out of memory.
+ */
+knot_nsec3_cache_t *knot_nsec3_cache_new();
+
+/*!
+ * \brief Destroys NSEC3 hash cache.
+ *
+ * \param cache Cache to be destroyed.
+ */
+void knot_nsec3_cache_free(knot_nsec3_cache_t **cache);
+
+/*!
+ * \brief Removes all names from the cache (e.g. on NSEC3PARAM change).
+ *
+ * \param cache Cache to be cleared.
+ */
+void knot_nsec3_cache_clear(knot_nsec3_cache_t *cache);
+
+/*!
+ * \brief Returns NSEC3 hash of the name, from cache if possible.
+ *
+ * \param cache Hash cache (may be NULL to compute the hash only).
+ * \param params NSEC3 parameters, must be the same for all names cached.
+ * \param data Domain name in wire format.
+ * \param size Size of the name in octets.
+ * \param digest Buffer of KNOT_NSEC3_HASH_LENGTH octets for the result.
+ *
+ * \retval KNOT_EOK if successful.
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ECRYPTO
+ */
+int knot_nsec3_cache_hash(knot_nsec3_cache_t *cache,
+                          const knot_nsec3_params_t *params,
+                          const uint8_t *data, size_t size, uint8_t *digest);
+
+/*!
+ * \brief Returns hit and miss counters of the cache.
+ *
+ * \param cache Hash cache.
+ * \param hits Number of cache hits.
+ * \param misses Number of cache misses.
+ */
+void knot_nsec3_cache_stats(const knot_nsec3_cache_t *cache,
+                            unsigned *hits, unsigned *misses);
+
 /*----------------------------------------------------------------------------*/
 
 #endif /* _KNOT_NSEC3_H_ */
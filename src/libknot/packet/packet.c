@@ -1405,6 +1405,50 @@ dbg_packet_exec(
 
 /*----------------------------------------------------------------------------*/
 
+knot_rrset_t *knot_packet_synth_rrset(knot_packet_t *packet,
+                                      const knot_rrset_t *rrset,
+                                      const knot_dname_t *owner)
+{
+	if (packet == NULL || rrset == NULL || owner == NULL ||
+	    packet->synth_rrsets_count == KNOT_PACKET_SYNTH_MAX) {
+		return NULL;
+	}
+
+	if (packet->synth_rrsets == NULL) {
+		packet->synth_rrsets = packet->mm.alloc(packet->mm.ctx,
+			KNOT_PACKET_SYNTH_MAX * sizeof(knot_rrset_t));
+		if (packet->synth_rrsets == NULL) {
+			return NULL;
+		}
+	}
+
+	knot_rrset_t *synth = &packet->synth_rrsets[packet->synth_rrsets_count];
+	memcpy(synth, rrset, sizeof(knot_rrset_t));
+
+	/* Only the owner is different. */
+	synth->owner = (knot_dname_t *)owner;
+	knot_dname_retain(synth->owner);
+	++packet->synth_rrsets_count;
+
+	return synth;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void knot_packet_free_synth_rrsets(knot_packet_t *pkt)
+{
+	if (pkt == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < pkt->synth_rrsets_count; ++i) {
+		knot_dname_release(pkt->synth_rrsets[i].owner);
+	}
+	pkt->synth_rrsets_count = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
 void knot_packet_header_to_wire(const knot_header_t *header,
                                   uint8_t **pos, size_t *size)
 {
@@ -1526,6 +1570,7 @@ void knot_packet_free(knot_packet_t **packet)
 	// free temporary domain names
 	dbg_packet("Freeing tmp RRSets...\n");
 	knot_packet_free_tmp_rrsets(*packet);
+	knot_packet_free_synth_rrsets(*packet);
 
 	// check if some additional space was allocated for the packet
 	dbg_packet("Freeing additional allocated space...\n");
@@ -1540,6 +1585,12 @@ void knot_packet_free(knot_packet_t **packet)
 	// free EDNS options
 	knot_edns_free_options(&(*packet)->opt_rr);
 
+	// free compression dictionary and space for synthesized RRSets
+	if ((*packet)->mm.free) {
+		(*packet)->mm.free((*packet)->compression);
+		(*packet)->mm.free((*packet)->synth_rrsets);
+	}
+
 	dbg_packet("Freeing packet structure\n");
 	if ((*packet)->mm.free)
 		(*packet)->mm.free(*packet);
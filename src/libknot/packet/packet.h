@@ -83,18 +83,33 @@ enum knot_packet_prealloc_type {
 
 typedef enum knot_packet_prealloc_type knot_packet_prealloc_type_t;
 
-/* Maximum number of compressed names. */
-#define COMPR_MAXLEN 64
-/* Volatile portion of the compression table. */
-#define COMPR_VOLATILE (COMPR_MAXLEN / 4)
-#define COMPR_FIXEDLEN (COMPR_MAXLEN - COMPR_VOLATILE)
+/* Number of slots in the compression dictionary (power of 2). */
+#define COMPR_DICT_SIZE 1024
+/* Number of slots probed for one name suffix. */
+#define COMPR_DICT_PROBES 8
 
-/* Compression table pointer. */
+/* Number of RRSets synthesized from wildcards stored in the packet. */
+#define KNOT_PACKET_SYNTH_MAX 8
+
+/* Compression dictionary entry (name suffix written in the packet). */
 typedef struct {
 	uint16_t off;		/*!< Packet data offset. */
-	uint8_t lbcount;	/*!< Dname label count. */
+	uint16_t gen;		/*!< Generation (message) of the entry. */
+	uint8_t lbcount;	/*!< Suffix label count. */
+	uint8_t tag;		/*!< Upper bits of the suffix hash. */
 } knot_compr_ptr_t;
 
+/*!
+ * \brief Compression dictionary keyed by hashes of name suffixes.
+ *
+ * Entries from older generations are ignored, so the dictionary is reset
+ * by incrementing the generation.
+ */
+typedef struct {
+	uint16_t gen;                            /*!< Current generation. */
+	knot_compr_ptr_t table[COMPR_DICT_SIZE]; /*!< Entries. */
+} knot_compr_dict_t;
+
 /*----------------------------------------------------------------------------*/
 /*!
  * \brief Structure representing a DNS packet.
@@ -139,8 +154,12 @@ struct knot_packet {
 	size_t size;      /*!< Current wire size of the packet. */
 	size_t max_size;  /*!< Maximum allowed size of the packet. */
 
-	/*! \brief Information needed for compressing domain names in packet. */
-	knot_compr_ptr_t compression[COMPR_MAXLEN];
+	/*!
+	 * \brief Information needed for compressing domain names in packet.
+	 *
+	 * Allocated on first use, so only responses pay for it.
+	 */
+	knot_compr_dict_t *compression;
 
 	/*! \brief Wildcard nodes to be processed for NSEC/NSEC3. */
 	knot_wildcard_nodes_t wildcard_nodes;
@@ -150,6 +169,14 @@ struct knot_packet {
 	short tmp_rrsets_count;  /*!< Count of temporary RRSets. */
 	short tmp_rrsets_max;    /*!< Allocated space for temporary RRSets. */
 
+	/*!
+	 * \brief RRSets synthesized from wildcards (sharing zone RDATA).
+	 *
+	 * Space for KNOT_PACKET_SYNTH_MAX RRSets, allocated on first use.
+	 */
+	knot_rrset_t *synth_rrsets;
+	short synth_rrsets_count; /*!< Count of synthesized RRSets. */
+
 	struct knot_packet *query; /*!< Associated query. */
 
 	knot_packet_prealloc_type_t prealloc_type;
@@ -515,6 +542,33 @@ int knot_packet_add_tmp_rrset(knot_packet_t *response,
 
 void knot_packet_free_tmp_rrsets(knot_packet_t *pkt);
 
+/*!
+ * \brief Synthesizes RRSet with given owner from the given RRSet.
+ *
+ * The synthesized RRSet is stored in the packet and shares RDATA, RRSIGs and
+ * pre-rendered RDATA with the original RRSet. Space for the synthesized RRSets
+ * is allocated from the packet memory context on first use. The RRSet is
+ * valid until the packet is cleared or freed, the original RRSet must not be
+ * freed before.
+ *
+ * \param packet Packet to store the synthesized RRSet to.
+ * \param rrset Original RRSet.
+ * \param owner Owner of the synthesized RRSet.
+ *
+ * \return Synthesized RRSet or NULL if there is no more space in the packet
+ *         or the space could not be allocated.
+ */
+knot_rrset_t *knot_packet_synth_rrset(knot_packet_t *packet,
+                                      const knot_rrset_t *rrset,
+                                      const knot_dname_t *owner);
+
+/*!
+ * \brief Drops all RRSets synthesized in the packet.
+ *
+ * \param pkt Packet.
+ */
+void knot_packet_free_synth_rrsets(knot_packet_t *pkt);
+
 /*!
  * \brief Converts the header structure to wire format.
  *
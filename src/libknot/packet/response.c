@@ -29,56 +29,150 @@
 /*----------------------------------------------------------------------------*/
 
 /*!
- * \brief Compare suffixes and calculate score (number of matching labels).
+ * \brief Computes hashes of all suffixes of the name.
  *
- * Update current best score.
+ * \param name Name in wire format (no compression pointers).
+ * \param labels Offsets of the labels in the name.
+ * \param hashes Hashes of the suffixes starting at corresponding label.
+ *
+ * \return Number of labels (excluding root).
  */
-static bool knot_response_compr_score(uint8_t *n, uint8_t *p, uint8_t labels,
-                                      uint8_t *wire, knot_compr_ptr_t *match)
+static unsigned knot_response_compr_hash(const uint8_t *name, uint8_t *labels,
+                                         uint32_t *hashes)
 {
-	uint16_t score = 0;
-	uint16_t off = 0;
-	while (*n != '\0') {
-		/* Can't exceed current best coverage. */
-		if (score + labels <= match->lbcount)
-			return false; /* Early cut. */
-		/* Keep track of contiguous matches. */
-		if (*n == *p && memcmp(n + 1, p + 1, *n) == 0) {
-			if (score == 0)
-				off = (p - wire);
-			++score;
-		} else {
-			score = 0; /* Non-contiguous match. */
+	unsigned count = 0;
+	const uint8_t *lp = name;
+	while (*lp != '\0' && count < KNOT_MAX_DNAME_LABELS) {
+		labels[count++] = lp - name;
+		lp += *lp + 1;
+	}
+
+	/* FNV-1a from the rightmost label, suffix hash seeds the next one. */
+	uint32_t h = 2166136261U;
+	for (unsigned i = count; i > 0; --i) {
+		lp = name + labels[i - 1];
+		for (unsigned j = 0; j <= *lp; ++j) {
+			h = (h ^ lp[j]) * 16777619U;
 		}
-		n = knot_wire_next_label(n, wire);
-		p = knot_wire_next_label(p, wire);
-		--labels;
+		hashes[i - 1] = h;
 	}
 
-	/* New best score. */
-	if (score > match->lbcount && off <= KNOT_WIRE_PTR_MAX) {
-		match->lbcount = score;
-		match->off = off;
-		return true;
+	return count;
+}
+
+/*!
+ * \brief Checks if the name in packet at given offset equals the suffix.
+ *
+ * Compression pointers in the packet are followed, only pointers to lower
+ * offsets are accepted and no data beyond \a limit are read.
+ */
+static bool knot_response_compr_match(const uint8_t *suffix,
+                                      const uint8_t *wire, uint16_t off,
+                                      size_t limit)
+{
+	const uint8_t *p = wire + off;
+	while (true) {
+		if (p >= wire + limit) {
+			return false;
+		}
+		if (knot_wire_is_pointer(p)) {
+			uint16_t ptr = knot_wire_get_pointer(p);
+			if (ptr >= p - wire) {
+				return false; /* Not a backward pointer. */
+			}
+			p = wire + ptr;
+		}
+		if (*suffix == '\0' || *p == '\0') {
+			return *suffix == *p; /* Both must end here. */
+		}
+		if (p + *p + 1 > wire + limit || *p != *suffix ||
+		    memcmp(p + 1, suffix + 1, *p) != 0) {
+			return false;
+		}
+		suffix += *suffix + 1;
+		p += *p + 1;
 	}
+}
 
-	return false;
+/*!
+ * \brief Inserts name suffix into the dictionary.
+ *
+ * If all probed slots are taken, entry with the most labels is replaced, as
+ * short suffixes (zone names) are shared by most of the names.
+ */
+static void knot_response_compr_insert(knot_compr_dict_t *dict, uint32_t hash,
+                                       uint16_t off, uint8_t lbcount)
+{
+	knot_compr_ptr_t *victim = NULL;
+	for (unsigned i = 0; i < COMPR_DICT_PROBES; ++i) {
+		knot_compr_ptr_t *e = dict->table + ((hash + i)
+		                                     & (COMPR_DICT_SIZE - 1));
+		if (e->off == 0 || e->gen != dict->gen) {
+			victim = e;
+			break;
+		}
+		if (e->lbcount >= lbcount &&
+		    (victim == NULL || e->lbcount >= victim->lbcount)) {
+			victim = e;
+		}
+	}
+
+	if (victim != NULL) {
+		victim->off = off;
+		victim->gen = dict->gen;
+		victim->lbcount = lbcount;
+		victim->tag = hash >> 24;
+	}
 }
 
 /*!
- * \brief Align name and reference to a common number of suffix labels.
+ * \brief Inserts all suffixes of the name written at given offset.
  */
-static uint8_t knot_response_compr_align(uint8_t **name, uint8_t nlabels,
-                                         uint8_t **ref, uint8_t reflabels,
-                                         uint8_t *wire)
+static void knot_response_compr_insert_name(knot_compr_dict_t *dict,
+                                            const uint8_t *name, uint16_t off)
+{
+	uint8_t labels[KNOT_MAX_DNAME_LABELS];
+	uint32_t hashes[KNOT_MAX_DNAME_LABELS];
+	unsigned count = knot_response_compr_hash(name, labels, hashes);
+	for (unsigned i = 0; i < count; ++i) {
+		if (off + labels[i] > KNOT_WIRE_PTR_MAX) {
+			break;
+		}
+		knot_response_compr_insert(dict, hashes[i], off + labels[i],
+		                           count - i);
+	}
+}
+
+void knot_response_compr_reset(knot_compr_dict_t *dict)
 {
-	for (unsigned j = nlabels; j < reflabels; ++j)
-		*ref = knot_wire_next_label(*ref, wire);
+	if (dict == NULL) {
+		return;
+	}
 
-	for (unsigned j = reflabels; j < nlabels; ++j)
-		*name = knot_wire_next_label(*name, wire);
+	/* Generation 0 is never used, entries are zeroed on wraparound. */
+	dict->gen += 1;
+	if (dict->gen == 0) {
+		memset(dict->table, 0, sizeof(dict->table));
+		dict->gen = 1;
+	}
+}
 
-	return (nlabels < reflabels) ? nlabels : reflabels;
+/*!
+ * \brief Returns compression dictionary of the response, allocates it from
+ *        the packet memory context on first use.
+ */
+static knot_compr_dict_t *knot_response_compr_dict(knot_packet_t *resp)
+{
+	if (resp->compression == NULL) {
+		resp->compression = resp->mm.alloc(resp->mm.ctx,
+		                                   sizeof(knot_compr_dict_t));
+		if (resp->compression == NULL) {
+			return NULL;
+		}
+		memset(resp->compression, 0, sizeof(knot_compr_dict_t));
+	}
+
+	return resp->compression;
 }
 
 int knot_response_compress_dname(const knot_dname_t *dname, knot_compr_t *compr,
@@ -97,73 +191,65 @@ int knot_response_compress_dname(const knot_dname_t *dname, knot_compr_t *compr,
                 return dname->size;
 	}
 
-	/* Align and compare name and pointer in the compression table. */
-	unsigned i = 0;
-	unsigned lbcount = 0;
-	unsigned match_id = 0;
-	knot_compr_ptr_t match = { 0, 0 };
-	for (; i < COMPR_MAXLEN && compr->table[i].off > 0; ++i) {
-		uint8_t *name = dname->name;
-		uint8_t *ref = compr->wire + compr->table[i].off;
-		lbcount = knot_response_compr_align(&name, dname->label_count,
-		                                    &ref, compr->table[i].lbcount,
-		                                    compr->wire);
-
-		if (knot_response_compr_score(name, ref, lbcount, compr->wire,
-		                              &match)) {
-			match_id = i;
-			if (match.lbcount == dname->label_count)
-				break; /* Best match, break. */
+	knot_compr_dict_t *dict = compr->dict;
+	if (dict->gen == 0) {
+		knot_response_compr_reset(dict);
+	}
+
+	/* Find the longest suffix already written in the packet. */
+	uint8_t labels[KNOT_MAX_DNAME_LABELS];
+	uint32_t hashes[KNOT_MAX_DNAME_LABELS];
+	unsigned count = knot_response_compr_hash(name, labels, hashes);
+	unsigned match = count; /* First label of the matched suffix. */
+	uint16_t match_off = 0;
+	for (unsigned i = 0; i < count && match == count; ++i) {
+		for (unsigned j = 0; j < COMPR_DICT_PROBES; ++j) {
+			const knot_compr_ptr_t *e = dict->table +
+				((hashes[i] + j) & (COMPR_DICT_SIZE - 1));
+			if (e->off == 0 || e->gen != dict->gen) {
+				break; /* Free slot ends the probe sequence. */
+			}
+			if (e->tag != (uint8_t)(hashes[i] >> 24) ||
+			    e->lbcount != count - i ||
+			    e->off >= compr->wire_pos) {
+				continue;
+			}
+			if (knot_response_compr_match(name + labels[i],
+			                              compr->wire, e->off,
+			                              compr->wire_pos)) {
+				match = i;
+				match_off = e->off;
+				break;
+			}
 		}
 	}
 
 	/* Write non-matching prefix. */
-	unsigned written = 0;
-	for (unsigned j = match.lbcount; j < dname->label_count; ++j) {
-		if (written + *name + 1 > max)
-			return KNOT_ESPACE;
-		memcpy(dst + written, name, *name + 1);
-		written += *name + 1;
-		name = knot_wire_next_label(name, compr->wire);
-	}
+	unsigned written = (match < count) ? labels[match] : dname->size - 1;
+	if (written + 1 > max)
+		return KNOT_ESPACE;
+	memcpy(dst, name, written);
 
 	/* Write out pointer covering suffix. */
-	if (*name != '\0') {
+	if (match < count) {
 		if (written + sizeof(uint16_t) > max)
 			return KNOT_ESPACE;
-		knot_wire_put_pointer(dst + written, match.off);
+		knot_wire_put_pointer(dst + written, match_off);
 		written += sizeof(uint16_t);
 	} else {
 		/* Not covered by compression table, write terminal. */
-		if (written + 1 > max)
-			return KNOT_ESPACE;
 		*(dst + written) = '\0';
 		written += 1;
 	}
 
-	/* Promote good matches. */
-	if (match_id > 1) {
-		match = compr->table[match_id];
-		compr->table[match_id] = compr->table[match_id - 1];
-		compr->table[match_id - 1] = match;
-	}
-
-	/* Do not insert if exceeds bounds or full match. */
-	if (match.lbcount == dname->label_count ||
-	    compr->wire_pos > KNOT_WIRE_PTR_MAX)
-		return written;
-
-	/* If table is full, elect name from the lower 1/4 of the table
-	 * and replace it. */
-	if (i == COMPR_MAXLEN - 1) {
-		i = COMPR_FIXEDLEN + rand() % COMPR_VOLATILE;
-		compr->table[i].off = 0;
-	}
-
-	/* Store in dname table. */
-	if (compr->table[i].off == 0) {
-		compr->table[i].off = (uint16_t)compr->wire_pos;
-		compr->table[i].lbcount = dname->label_count;
+	/* Store suffixes written as labels in the dictionary. */
+	for (unsigned i = 0; i < match; ++i) {
+		if (compr->wire_pos + labels[i] > KNOT_WIRE_PTR_MAX) {
+			break;
+		}
+		knot_response_compr_insert(dict, hashes[i],
+		                           compr->wire_pos + labels[i],
+		                           count - i);
 	}
 
 	return written;
@@ -187,8 +273,8 @@ int knot_response_compress_dname(const knot_dname_t *dname, knot_compr_t *compr,
  * \param tc Set to <> 0 if omitting the RRSet should cause the TC bit to be
  *           set in the response.
  *
- * \return Count of RRs added to the response or KNOT_ESPACE if the RRSet did
- *         not fit in the available space.
+ * \return Count of RRs added to the response, KNOT_ESPACE if the RRSet did
+ *         not fit in the available space or KNOT_ENOMEM.
  */
 static int knot_response_try_add_rrset(const knot_rrset_t **rrsets,
                                         short *rrset_count,
@@ -196,7 +282,7 @@ static int knot_response_try_add_rrset(const knot_rrset_t **rrsets,
                                         size_t max_size,
                                         const knot_rrset_t *rrset, int tc)
 {
-	//short size = knot_response_rrset_size(rrset, &resp->compression);
+	//short size = knot_response_rrset_size(rrset, resp->compression);
 
 dbg_response_exec(
 	char *name = knot_dname_to_str(rrset->owner);
@@ -204,10 +290,15 @@ dbg_response_exec(
 	                  name, rrset->type);
 	free(name);
 );
+	knot_compr_dict_t *dict = knot_response_compr_dict(resp);
+	if (dict == NULL) {
+		return KNOT_ENOMEM;
+	}
+
 	uint8_t *pos = resp->wireformat + resp->size;
 	size_t size = max_size;
 	compression_param_t param;
-	param.compressed_dnames = resp->compression;
+	param.compressed_dnames = dict;
 	param.wire_pos = resp->size;
 	param.wire = resp->wireformat;
 	uint16_t rr_count = 0;
@@ -365,8 +456,14 @@ int knot_response_init_from_query(knot_packet_t *response,
 		       sizeof(knot_question_t));
 
 		/* Insert QNAME into compression table. */
-		response->compression[0].off = KNOT_WIRE_HEADER_SIZE;
-		response->compression[0].lbcount = response->question.qname->label_count;
+		knot_compr_dict_t *dict = knot_response_compr_dict(response);
+		if (dict == NULL) {
+			return KNOT_ENOMEM;
+		}
+		knot_response_compr_reset(dict);
+		knot_response_compr_insert_name(dict,
+		                         knot_dname_name(response->question.qname),
+		                         KNOT_WIRE_HEADER_SIZE);
 
 
 		/*! \todo Constant. */
@@ -427,7 +524,7 @@ void knot_response_clear(knot_packet_t *resp, int clear_question)
 	resp->ar_rrsets = 0;
 
 	/* Clear compression table. */
-	memset(resp->compression, 0, COMPR_MAXLEN * sizeof(knot_compr_ptr_t));
+	knot_response_compr_reset(resp->compression);
 
 	/*! \todo Temporary RRSets are not deallocated, which may potentially
 	 *        lead to memory leaks should this function be used in other
@@ -435,6 +532,7 @@ void knot_response_clear(knot_packet_t *resp, int clear_question)
 	 */
 	knot_packet_free_tmp_rrsets(resp);
 	resp->tmp_rrsets_count = 0;
+	knot_packet_free_synth_rrsets(resp);
 
 	/*! \todo If this function is used in other cases than with XFR-out,
 	 *        the list of wildcard nodes should be cleared here.
@@ -566,7 +664,7 @@ int knot_response_add_rrset_answer(knot_packet_t *response,
 		return KNOT_EOK;
 	}
 
-	return KNOT_ESPACE;
+	return rrs;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -615,7 +713,7 @@ int knot_response_add_rrset_authority(knot_packet_t *response,
 		return KNOT_EOK;
 	}
 
-	return KNOT_ESPACE;
+	return rrs;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -670,7 +768,7 @@ int knot_response_add_rrset_additional(knot_packet_t *response,
 		return KNOT_EOK;
 	}
 
-	return KNOT_ESPACE;
+	return rrs;
 }
 
 /*----------------------------------------------------------------------------*/
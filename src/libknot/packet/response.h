@@ -64,7 +64,7 @@ typedef struct knot_compr_owner knot_compr_owner_t;
  * \todo This description should be revised and clarified.
  */
 struct knot_compr {
-	knot_compr_ptr_t *table;  /*!< Compression table. */
+	knot_compr_dict_t *dict;  /*!< Compression dictionary. */
 	uint8_t *wire;
 	size_t wire_pos;            /*!< Current position in the wire format. */
 	knot_compr_owner_t owner; /*!< Information about the current name. */
@@ -75,7 +75,7 @@ typedef struct knot_compr knot_compr_t;
 struct compression_param {
 	uint8_t *wire;
 	size_t wire_pos;
-	knot_compr_ptr_t *compressed_dnames;
+	knot_compr_dict_t *compressed_dnames;
 };
 
 typedef struct compression_param compression_param_t;
@@ -104,6 +104,7 @@ int knot_response_init(knot_packet_t *response);
  * \param query Packet structure representing the query.
  *
  * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
  */
 int knot_response_init_from_query(knot_packet_t *response,
                                   knot_packet_t *query,
@@ -255,6 +256,16 @@ int knot_response_add_wildcard_node(knot_packet_t *response,
 int knot_response_compress_dname(const knot_dname_t *dname,
 	knot_compr_t *compr, uint8_t *dst, size_t max);
 
+/*!
+ * \brief Clears compression dictionary for a new message.
+ *
+ * Dictionary entries are invalidated by incrementing the dictionary
+ * generation, the table itself is cleared only on generation wraparound.
+ *
+ * \param dict Compression dictionary.
+ */
+void knot_response_compr_reset(knot_compr_dict_t *dict);
+
 
 #endif /* _KNOT_response_H_ */
 
@@ -28,6 +28,9 @@
 #include <sys/socket.h>			// AF_INET (BSD)
 #include <netinet/in.h>			// in_addr (BSD)
 #include <arpa/inet.h>			// ntohs
+#ifdef HAVE_SSE2
+#include <emmintrin.h>			// SSE2
+#endif
 
 #include "common/errcode.h"		// KNOT_EOK
 #include "common/base64.h"		// base64
@@ -328,7 +331,34 @@ static int hex_encode(const uint8_t  *in,
 		return -1;
 	}
 
-	for (uint32_t i = 0; i < in_len; i++) {
+	uint32_t i = 0;
+
+#ifdef HAVE_SSE2
+	// Split 16 bytes to nibbles and map 10-15 right after '9' to 'A'-'F'.
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i zero = _mm_set1_epi8('0');
+	const __m128i gap = _mm_set1_epi8('A' - '9' - 1);
+
+	for (; i + 16 <= in_len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+		__m128i lo = _mm_and_si128(v, mask);
+
+		// Interleave to keep the high nibble first.
+		__m128i n1 = _mm_unpacklo_epi8(hi, lo);
+		__m128i n2 = _mm_unpackhi_epi8(hi, lo);
+		n1 = _mm_add_epi8(_mm_add_epi8(n1, zero),
+		                  _mm_and_si128(_mm_cmpgt_epi8(n1, nine), gap));
+		n2 = _mm_add_epi8(_mm_add_epi8(n2, zero),
+		                  _mm_and_si128(_mm_cmpgt_epi8(n2, nine), gap));
+
+		_mm_storeu_si128((__m128i *)(out + 2 * i), n1);
+		_mm_storeu_si128((__m128i *)(out + 2 * i + 16), n2);
+	}
+#endif
+
+	for (; i < in_len; i++) {
 		out[2 * i]     = hex[in[i] / 16];
 		out[2 * i + 1] = hex[in[i] % 16];
 	}
@@ -30,11 +30,31 @@
 #include "util/utils.h"
 #include "packet/response.h"
 #include "util/wire.h"
+#include "util/tolower.h"
+#include "common/atomic.h"
+#include "common/arena.h"
 
 /*----------------------------------------------------------------------------*/
 /* Non-API functions                                                          */
 /*----------------------------------------------------------------------------*/
 
+/*!
+ * \brief Reallocates RRSet memory, which may come from a zone arena.
+ *
+ * Aborts on failure like xrealloc(). New blocks are allocated from the
+ * current arena, if there is one, arena blocks that grow move to the heap.
+ */
+static void *rrset_realloc(void *ptr, size_t old_size, size_t size)
+{
+	void *ret = arena_realloc(ptr, old_size, size);
+	if (ret == NULL) {
+		ERR_ALLOC_FAILED;
+		abort();
+	}
+
+	return ret;
+}
+
 static int rrset_retain_dnames_in_rr(knot_dname_t **dname, void *data)
 {
 	UNUSED(data);
@@ -443,6 +463,100 @@ dbg_rrset_exec_detail(
 	return KNOT_EOK;
 }
 
+static size_t rrset_wire_dname_size(const uint8_t *name)
+{
+	size_t size = 1;
+	while (*name != 0) {
+		size += *name + 1;
+		name += *name + 1;
+	}
+
+	return size;
+}
+
+/*!
+ * \brief Converts one RR to wire format using pre-rendered RDATA.
+ *
+ * \param rrset RRSet the RR belongs to.
+ * \param rwire Pre-rendered RDATA of the RRSet.
+ * \param src_pos Position of the RR in pre-rendered RDATA, moved to the next.
+ * \param compr_idx Index of the next compressible name, moved past the RR.
+ */
+static int knot_rrset_wire_to_wire_one(const knot_rrset_t *rrset,
+                                       const knot_rrset_wire_t *rwire,
+                                       size_t *src_pos, size_t *compr_idx,
+                                       uint8_t **pos, size_t max_size,
+                                       size_t *rr_size, knot_compr_t *compr)
+{
+	/* Put RR header to wire. */
+	size_t size = 0;
+	int ret = knot_rrset_header_to_wire(rrset, pos, max_size,
+	                                    compr, &size);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	size_t done = *src_pos + sizeof(uint16_t);
+	size_t end = done + knot_wire_read_u16(rwire->data + *src_pos);
+	*src_pos = end;
+
+	// save space for RDLENGTH
+	uint8_t *rdlength_pos = *pos;
+	*pos += sizeof(uint16_t);
+	size += sizeof(uint16_t);
+
+	if (compr) {
+		compr->wire_pos += size;
+	}
+
+	size_t rdlength = 0;
+	while (done < end) {
+		/* Copy everything up to the next compressible name. */
+		size_t next = end;
+		if (compr && *compr_idx < rwire->compr_count &&
+		    rwire->compr[*compr_idx] < end) {
+			next = rwire->compr[*compr_idx];
+		}
+		size_t chunk = next - done;
+		if (size + rdlength + chunk > max_size) {
+			return KNOT_ESPACE;
+		}
+		memcpy(*pos, rwire->data + done, chunk);
+		*pos += chunk;
+		rdlength += chunk;
+		done = next;
+		if (compr) {
+			compr->wire_pos += chunk;
+		}
+		if (done == end) {
+			break;
+		}
+
+		/* Compress the name. */
+		knot_dname_t dname;
+		memset(&dname, 0, sizeof(knot_dname_t));
+		dname.name = rwire->data + done;
+		dname.size = rrset_wire_dname_size(dname.name);
+		ret = knot_response_compress_dname(&dname, compr, *pos,
+		                                   max_size - size - rdlength);
+		if (ret < 0) {
+			return KNOT_ESPACE;
+		}
+		*pos += ret;
+		rdlength += ret;
+		done += dname.size;
+		compr->wire_pos += ret;
+		*compr_idx += 1;
+	}
+
+	knot_wire_write_u16(rdlength_pos, rdlength);
+	size += rdlength;
+
+	*rr_size = size;
+	assert(size <= max_size);
+	return KNOT_EOK;
+}
+
 static int knot_rrset_to_wire_aux(const knot_rrset_t *rrset, uint8_t **pos,
                                   size_t max_size, compression_param_t *comp)
 {
@@ -461,7 +575,7 @@ static int knot_rrset_to_wire_aux(const knot_rrset_t *rrset, uint8_t **pos,
 	if (comp) {
 		dbg_response_detail("Compressing RR owner: %s.\n",
 		                    rrset->owner->name);
-		compr_info.table = comp->compressed_dnames;
+		compr_info.dict = comp->compressed_dnames;
 		compr_info.wire = comp->wire;
 		compr_info.wire_pos = comp->wire_pos;
 		int ret = knot_response_compress_dname(rrset->owner, &compr_info,
@@ -498,14 +612,29 @@ static int knot_rrset_to_wire_aux(const knot_rrset_t *rrset, uint8_t **pos,
 		return header_size;
 	}
 
+	// Use pre-rendered RDATA if available.
+	const knot_rrset_wire_t *rwire =
+		read_ptr((void **)&rrset->wire, __ATOMIC_ACQUIRE);
+	knot_compr_t *compr = comp ? &compr_info : NULL;
+	size_t src_pos = 0;
+	size_t compr_idx = 0;
+
 	// Save rrset records.
 	for (uint16_t i = 0; i < rrset->rdata_count; ++i) {
 		dbg_rrset_detail("rrset: to_wire: Current max_size=%zu\n",
 			         max_size);
 		size_t rr_size = 0;
-		int ret = knot_rrset_rdata_to_wire_one(rrset, i, pos, max_size,
-		                                       &rr_size,
-		                                       comp ? &compr_info : NULL);
+		int ret = KNOT_EOK;
+		if (rwire) {
+			ret = knot_rrset_wire_to_wire_one(rrset, rwire,
+			                                  &src_pos, &compr_idx,
+			                                  pos, max_size,
+			                                  &rr_size, compr);
+		} else {
+			ret = knot_rrset_rdata_to_wire_one(rrset, i, pos,
+			                                   max_size, &rr_size,
+			                                   compr);
+		}
 		if (ret != KNOT_EOK) {
 			dbg_rrset("rrset: to_wire: Cannot convert RR. "
 			          "Reason: %s.\n", knot_strerror(ret));
@@ -740,6 +869,8 @@ int knot_rrset_remove_rdata_pos(knot_rrset_t *rrset, size_t pos)
 		return KNOT_EINVAL;
 	}
 
+	knot_rrset_wire_clear(rrset);
+
 	/* Handle DNAMEs inside RDATA. */
 	int ret = rrset_rr_dnames_apply(rrset, pos, rrset_release_dnames_in_rr,
 	                                NULL);
@@ -773,16 +904,17 @@ int knot_rrset_remove_rdata_pos(knot_rrset_t *rrset, size_t pos)
 	/*! \todo Realloc might not be needed. Only if the RRSet is large. */
 	if (new_size == 0) {
 		assert(rrset->rdata_count == 1);
-		free(rrset->rdata);
+		arena_free(rrset->rdata);
 		rrset->rdata = NULL;
-		free(rrset->rdata_indices);
+		arena_free(rrset->rdata_indices);
 		rrset->rdata_indices = NULL;
 	} else {
 		/* [code-review] Should not be done always - as said in the TODO
 		 *               above. But also, why here and not in the part
 		 *               handling the RDATA array?
 		 */
-		rrset->rdata = xrealloc(rrset->rdata, new_size);
+		rrset->rdata = rrset_realloc(rrset->rdata,
+		                             new_size + removed_size, new_size);
 		/*
 		 * Handle RDATA indices. All indices larger than the removed one
 		 * have to be adjusted. Last index will be changed later.
@@ -798,9 +930,10 @@ int knot_rrset_remove_rdata_pos(knot_rrset_t *rrset, size_t pos)
 		rrset->rdata_indices[rrset->rdata_count - 2] = new_size;
 
 		/* Resize indices, might not be needed, but we'll do it to be proper. */
-		rrset->rdata_indices =
-			xrealloc(rrset->rdata_indices,
-		                 (rrset->rdata_count - 1) * sizeof(uint32_t));
+		size_t old_len = rrset->rdata_count * sizeof(uint32_t);
+		rrset->rdata_indices = rrset_realloc(rrset->rdata_indices,
+		                                     old_len,
+		                                     old_len - sizeof(uint32_t));
 	}
 
 	--rrset->rdata_count;
@@ -829,11 +962,12 @@ uint32_t rrset_rdata_size_total(const knot_rrset_t *rrset)
 knot_rrset_t *knot_rrset_new(knot_dname_t *owner, uint16_t type,
                              uint16_t rclass, uint32_t ttl)
 {
-	knot_rrset_t *ret = xmalloc(sizeof(knot_rrset_t));
+	knot_rrset_t *ret = rrset_realloc(NULL, 0, sizeof(knot_rrset_t));
 
 	ret->rdata = NULL;
 	ret->rdata_count = 0;
 	ret->rdata_indices = NULL;
+	ret->wire = NULL;
 
 	/* Retain reference to owner. */
 	knot_dname_retain(owner);
@@ -868,16 +1002,22 @@ uint8_t* knot_rrset_create_rdata(knot_rrset_t *rrset, uint16_t size)
 		return NULL;
 	}
 
+	knot_rrset_wire_clear(rrset);
+
 	uint32_t total_size = rrset_rdata_size_total(rrset);
 
 	/* Realloc indices. We will allocate exact size to save space. */
 	/* TODO this sucks big time - allocation of length 1. */
 	/* But another variable holding allocated count is out of question. What now?*/
-	rrset->rdata_indices = xrealloc(rrset->rdata_indices,
-	                                (rrset->rdata_count + 1) * sizeof(uint32_t));
+	rrset->rdata_indices = rrset_realloc(rrset->rdata_indices,
+	                                     rrset->rdata_count *
+	                                     sizeof(uint32_t),
+	                                     (rrset->rdata_count + 1) *
+	                                     sizeof(uint32_t));
 
 	/* Realloc actual data. */
-	rrset->rdata = xrealloc(rrset->rdata, total_size + size);
+	rrset->rdata = rrset_realloc(rrset->rdata, total_size,
+	                             total_size + size);
 
 	/* Pointer to new memory. */
 	uint8_t *dst = rrset->rdata + total_size;
@@ -1101,6 +1241,135 @@ int knot_rrset_rdata_equal(const knot_rrset_t *r1, const knot_rrset_t *r2)
 
 /*----------------------------------------------------------------------------*/
 
+/*!
+ * \brief Writes uncompressed RDATA of one RR (without RDLENGTH).
+ *
+ * Only the size is computed if \a dst is NULL. Offsets of compressible names
+ * (relative to \a base) are stored to \a compr if not NULL, \a compr_count
+ * is incremented for each of them.
+ *
+ * \return Size of the RDATA.
+ */
+static size_t rrset_wire_write_rr(const knot_rrset_t *rrset, size_t rdata_pos,
+                                  uint8_t *dst, size_t base, uint16_t *compr,
+                                  uint16_t *compr_count)
+{
+	const rdata_descriptor_t *desc = get_rdata_descriptor(rrset->type);
+	const uint8_t *rdata = rrset_rdata_pointer(rrset, rdata_pos);
+	size_t offset = 0;
+	size_t size = 0;
+
+	for (int i = 0; desc->block_types[i] != KNOT_RDATA_WF_END; i++) {
+		int item = desc->block_types[i];
+		const uint8_t *src = rdata + offset;
+		size_t len = 0;
+		if (descriptor_item_is_dname(item)) {
+			knot_dname_t *dname;
+			memcpy(&dname, rdata + offset, sizeof(knot_dname_t *));
+			assert(dname);
+			src = knot_dname_name(dname);
+			len = knot_dname_size(dname);
+			offset += sizeof(knot_dname_t *);
+			if (descriptor_item_is_compr_dname(item)) {
+				if (compr) {
+					compr[*compr_count] = base + size;
+				}
+				*compr_count += 1;
+			}
+		} else if (descriptor_item_is_fixed(item)) {
+			len = item;
+			offset += len;
+		} else if (descriptor_item_is_remainder(item)) {
+			len = rrset_rdata_remainder_size(rrset, offset,
+			                                 rdata_pos);
+			offset += len;
+		} else {
+			assert(rrset->type == KNOT_RRTYPE_NAPTR);
+			len = rrset_rdata_naptr_bin_chunk_size(rrset,
+			                                       rdata_pos);
+			offset += len;
+		}
+
+		if (dst) {
+			memcpy(dst + size, src, len);
+		}
+		size += len;
+	}
+
+	return size;
+}
+
+int knot_rrset_wire_prepare(knot_rrset_t *rrset)
+{
+	if (rrset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	if (rrset->rdata_count == 0 ||
+	    read_ptr((void **)&rrset->wire, __ATOMIC_ACQUIRE) != NULL) {
+		return KNOT_EOK;
+	}
+
+	/* Measure the wire format. */
+	size_t size = 0;
+	uint16_t compr_count = 0;
+	for (uint16_t i = 0; i < rrset->rdata_count; ++i) {
+		size += sizeof(uint16_t);
+		size += rrset_wire_write_rr(rrset, i, NULL, 0, NULL,
+		                            &compr_count);
+	}
+	if (size > UINT16_MAX) {
+		return KNOT_ESPACE;
+	}
+
+	/* Structure, name offsets and data in one block. */
+	knot_rrset_wire_t *rwire = malloc(sizeof(knot_rrset_wire_t) +
+	                                  compr_count * sizeof(uint16_t) +
+	                                  size);
+	if (rwire == NULL) {
+		return KNOT_ENOMEM;
+	}
+	rwire->size = size;
+	rwire->compr_count = 0;
+	rwire->compr = (uint16_t *)(rwire + 1);
+	rwire->data = (uint8_t *)(rwire->compr + compr_count);
+
+	size_t pos = 0;
+	for (uint16_t i = 0; i < rrset->rdata_count; ++i) {
+		uint8_t *rr = rwire->data + pos;
+		pos += sizeof(uint16_t);
+		size_t rdlength = rrset_wire_write_rr(rrset, i,
+		                                      rwire->data + pos, pos,
+		                                      rwire->compr,
+		                                      &rwire->compr_count);
+		knot_wire_write_u16(rr, rdlength);
+		pos += rdlength;
+	}
+	assert(pos == size);
+	assert(rwire->compr_count == compr_count);
+
+	/* Publish complete structure, someone else may have been faster. */
+	if (!__sync_bool_compare_and_swap(&rrset->wire, NULL, rwire)) {
+		free(rwire);
+	}
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void knot_rrset_wire_clear(knot_rrset_t *rrset)
+{
+	if (rrset == NULL) {
+		return;
+	}
+
+	free(rrset->wire);
+	rrset->wire = NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
 int knot_rrset_to_wire(const knot_rrset_t *rrset, uint8_t *wire, size_t *size,
                        size_t max_size, uint16_t *rr_count, void *data)
 {
@@ -1140,6 +1409,107 @@ dbg_rrset_exec_detail(
 
 /*----------------------------------------------------------------------------*/
 
+static int rrset_write_canonical_dname(const knot_dname_t *dname, int lower,
+                                       uint8_t **pos, size_t *size,
+                                       size_t max_size)
+{
+	assert(dname);
+
+	if (*size + knot_dname_size(dname) > max_size) {
+		return KNOT_ESPACE;
+	}
+
+	/* Label lengths are never affected by case folding. */
+	const uint8_t *name = knot_dname_name(dname);
+	if (lower) {
+		knot_tolower_buf(*pos, name, knot_dname_size(dname));
+	} else {
+		memcpy(*pos, name, knot_dname_size(dname));
+	}
+
+	*pos += knot_dname_size(dname);
+	*size += knot_dname_size(dname);
+
+	return KNOT_EOK;
+}
+
+int knot_rrset_rr_to_canonical(const knot_rrset_t *rrset, size_t rdata_pos,
+                               uint8_t *wire, size_t max_size, size_t *size)
+{
+	if (rrset == NULL || rrset->owner == NULL || wire == NULL ||
+	    size == NULL || rdata_pos >= rrset->rdata_count) {
+		return KNOT_EINVAL;
+	}
+
+	uint8_t *pos = wire;
+	size_t written = 0;
+
+	/* Owner, type, class, TTL and space for RDLENGTH. */
+	int ret = rrset_write_canonical_dname(rrset->owner, 1, &pos, &written,
+	                                      max_size);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	const size_t header_len = 3 * sizeof(uint16_t) + sizeof(uint32_t);
+	if (written + header_len > max_size) {
+		return KNOT_ESPACE;
+	}
+
+	knot_wire_write_u16(pos, rrset->type);
+	knot_wire_write_u16(pos + 2, rrset->rclass);
+	knot_wire_write_u32(pos + 4, rrset->ttl);
+	uint8_t *rdlength_pos = pos + 8;
+	pos += header_len;
+	written += header_len;
+
+	const size_t rdata_begin = written;
+	const uint8_t *rdata = rrset_rdata_pointer(rrset, rdata_pos);
+	size_t offset = 0;
+
+	const rdata_descriptor_t *desc = get_rdata_descriptor(rrset->type);
+	for (int i = 0; desc->block_types[i] != KNOT_RDATA_WF_END; i++) {
+		int item = desc->block_types[i];
+		size_t chunk = 0;
+		if (descriptor_item_is_dname(item)) {
+			knot_dname_t *dname = NULL;
+			memcpy(&dname, rdata + offset, sizeof(knot_dname_t *));
+			int lower = (item != KNOT_RDATA_WF_LITERAL_DNAME);
+			ret = rrset_write_canonical_dname(dname, lower, &pos,
+			                                  &written, max_size);
+			if (ret != KNOT_EOK) {
+				return ret;
+			}
+			offset += sizeof(knot_dname_t *);
+			continue;
+		} else if (descriptor_item_is_fixed(item)) {
+			chunk = item;
+		} else if (descriptor_item_is_remainder(item)) {
+			chunk = rrset_rdata_remainder_size(rrset, offset,
+			                                   rdata_pos);
+		} else {
+			assert(rrset->type == KNOT_RRTYPE_NAPTR);
+			chunk = rrset_rdata_naptr_bin_chunk_size(rrset,
+			                                         rdata_pos);
+		}
+
+		if (written + chunk > max_size) {
+			return KNOT_ESPACE;
+		}
+		memcpy(pos, rdata + offset, chunk);
+		pos += chunk;
+		written += chunk;
+		offset += chunk;
+	}
+
+	knot_wire_write_u16(rdlength_pos, written - rdata_begin);
+	*size = written;
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+
 int knot_rrset_rdata_from_wire_one(knot_rrset_t *rrset,
                                    const uint8_t *wire, size_t *pos,
                                    size_t total_size, size_t rdlength)
@@ -1329,6 +1699,7 @@ int knot_rrset_deep_copy(const knot_rrset_t *from, knot_rrset_t **to,
 	                 from->type);
 
 	*to = xmalloc(sizeof(knot_rrset_t));
+	(*to)->wire = NULL;
 
 	(*to)->owner = knot_dname_deep_copy(from->owner);
 	if ((*to)->owner == NULL) {
@@ -1404,6 +1775,7 @@ int knot_rrset_shallow_copy(const knot_rrset_t *from, knot_rrset_t **to)
 	CHECK_ALLOC_LOG(*to, KNOT_ENOMEM);
 
 	memcpy(*to, from, sizeof(knot_rrset_t));
+	(*to)->wire = NULL;
 
 	/* Retain owner. */
 	knot_dname_retain((*to)->owner);
@@ -1430,7 +1802,7 @@ void knot_rrset_free(knot_rrset_t **rrset)
 	/*! \todo Shouldn't we always release owner reference? */
 	knot_dname_release((*rrset)->owner);
 
-	free(*rrset);
+	arena_free(*rrset);
 	*rrset = NULL;
 }
 
@@ -1450,14 +1822,15 @@ void knot_rrset_deep_free(knot_rrset_t **rrset, int free_owner,
 	                           NULL);
 	}
 
-	free((*rrset)->rdata);
-	free((*rrset)->rdata_indices);
+	arena_free((*rrset)->rdata);
+	arena_free((*rrset)->rdata_indices);
+	knot_rrset_wire_clear(*rrset);
 
 	if (free_owner) {
 		knot_dname_release((*rrset)->owner);
 	}
 
-	free(*rrset);
+	arena_free(*rrset);
 	*rrset = NULL;
 }
 
@@ -1476,14 +1849,15 @@ void knot_rrset_deep_free_no_sig(knot_rrset_t **rrset, int free_owner,
 		}
 	}
 
-	free((*rrset)->rdata);
-	free((*rrset)->rdata_indices);
+	arena_free((*rrset)->rdata);
+	arena_free((*rrset)->rdata_indices);
+	knot_rrset_wire_clear(*rrset);
 
 	if (free_owner) {
 		knot_dname_release((*rrset)->owner);
 	}
 
-	free(*rrset);
+	arena_free(*rrset);
 	*rrset = NULL;
 }
 
@@ -1505,6 +1879,8 @@ int knot_rrset_merge(knot_rrset_t *rrset1, const knot_rrset_t *rrset2)
 		return KNOT_EOK;
 	}
 
+	knot_rrset_wire_clear(rrset1);
+
 	/* Add all RDATAs from rrset2 to rrset1 (i.e. concatenate two arrays) */
 
 	/*! \note The following code should work for
@@ -1512,8 +1888,10 @@ int knot_rrset_merge(knot_rrset_t *rrset1, const knot_rrset_t *rrset2)
 	 */
 
 	/* Reallocate actual RDATA array. */
-	rrset1->rdata = xrealloc(rrset1->rdata, rrset_rdata_size_total(rrset1) +
-	                         rrset_rdata_size_total(rrset2));
+	rrset1->rdata = rrset_realloc(rrset1->rdata,
+	                              rrset_rdata_size_total(rrset1),
+	                              rrset_rdata_size_total(rrset1) +
+	                              rrset_rdata_size_total(rrset2));
 
 	/* The space is ready, copy the actual data. */
 	memcpy(rrset1->rdata + rrset_rdata_size_total(rrset1),
@@ -1521,9 +1899,10 @@ int knot_rrset_merge(knot_rrset_t *rrset1, const knot_rrset_t *rrset2)
 
 	/* Indices have to be readjusted. But space has to be made first. */
 	rrset1->rdata_indices =
-		xrealloc(rrset1->rdata_indices,
-	        (rrset1->rdata_count + rrset2->rdata_count) *
-	         sizeof(uint32_t));
+		rrset_realloc(rrset1->rdata_indices,
+		              rrset1->rdata_count * sizeof(uint32_t),
+		              (rrset1->rdata_count + rrset2->rdata_count) *
+		              sizeof(uint32_t));
 
 	uint32_t rrset1_total_size = rrset_rdata_size_total(rrset1);
 	uint32_t rrset2_total_size = rrset_rdata_size_total(rrset2);
@@ -1705,6 +2084,8 @@ void knot_rrset_rdata_soa_serial_set(knot_rrset_t *rrset, uint32_t serial)
 		return;
 	}
 
+	knot_rrset_wire_clear(rrset);
+
 	// the number is in network byte order, transform it
 	knot_wire_write_u32(rrset->rdata + sizeof(knot_dname_t *) * 2,
 	                    serial);
@@ -2442,6 +2823,69 @@ int knot_rrset_find_rr_pos(const knot_rrset_t *rr_search_in,
 	return found ? KNOT_EOK : KNOT_ENOENT;
 }
 
+int knot_rrset_rdata_compare_one(const knot_rrset_t *rrset1,
+                                 const knot_rrset_t *rrset2,
+                                 size_t pos1, size_t pos2)
+{
+	if (rrset1 == NULL || rrset2 == NULL ||
+	    pos1 >= rrset1->rdata_count || pos2 >= rrset2->rdata_count) {
+		return KNOT_EINVAL;
+	}
+
+	return rrset_rdata_compare_one(rrset1, rrset2, pos1, pos2);
+}
+
+static uint32_t rrset_hash_bytes(uint32_t hash, const uint8_t *data,
+                                 size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+uint32_t knot_rrset_rdata_hash(const knot_rrset_t *rrset, size_t pos)
+{
+	uint32_t hash = 2166136261U;
+	if (rrset == NULL || pos >= rrset->rdata_count) {
+		return hash;
+	}
+
+	/* Same blocks as in rrset_rdata_compare_one(). */
+	uint8_t *rdata = rrset_rdata_pointer(rrset, pos);
+	const rdata_descriptor_t *desc = get_rdata_descriptor(rrset->type);
+	size_t offset = 0;
+	for (int i = 0; desc->block_types[i] != KNOT_RDATA_WF_END; i++) {
+		int type = desc->block_types[i];
+		if (descriptor_item_is_dname(type)) {
+			/* Names are compared case-insensitively. */
+			knot_dname_t *dname = NULL;
+			memcpy(&dname, rdata + offset, sizeof(knot_dname_t *));
+			uint32_t dhash = knot_dname_hash(dname);
+			hash = rrset_hash_bytes(hash, (uint8_t *)&dhash,
+			                        sizeof(dhash));
+			offset += sizeof(knot_dname_t *);
+		} else if (descriptor_item_is_fixed(type)) {
+			hash = rrset_hash_bytes(hash, rdata + offset, type);
+			offset += type;
+		} else if (descriptor_item_is_remainder(type)) {
+			size_t size = rrset_rdata_remainder_size(rrset, offset,
+			                                         pos);
+			hash = rrset_hash_bytes(hash, rdata + offset, size);
+		} else {
+			assert(rrset->type == KNOT_RRTYPE_NAPTR);
+			uint16_t size =
+				rrset_rdata_naptr_bin_chunk_size(rrset, pos);
+			hash = rrset_hash_bytes(hash, rdata + offset, size);
+			offset += size;
+		}
+	}
+
+	return hash;
+}
+
 int knot_rrset_remove_rr(knot_rrset_t *rrset,
                          const knot_rrset_t *rr_from, size_t rdata_pos)
 {
@@ -2482,6 +2926,7 @@ int knot_rrset_rdata_reset(knot_rrset_t *rrset)
 	rrset->rdata = NULL;
 	rrset->rdata_indices = NULL;
 	rrset->rdata_count = 0;
+	rrset->wire = NULL;
 
 	return KNOT_EOK;
 }
@@ -63,10 +63,29 @@ struct knot_rrset {
 	uint32_t *rdata_indices; /*!< Indices to beginnings of RRs (without 0)*/
 	uint16_t rdata_count; /*!< Count of RRs in this RRSet. */
 	struct knot_rrset *rrsigs; /*!< Set of RRSIGs covering this RRSet. */
+	/*! \brief Pre-rendered RDATA (see knot_rrset_wire_prepare()). */
+	struct knot_rrset_wire *wire;
 };
 
 typedef struct knot_rrset knot_rrset_t;
 
+/*!
+ * \brief Pre-rendered wire format of RRSet RDATA.
+ *
+ * RRs follow one after another, each prefixed with its RDLENGTH, all domain
+ * names are stored uncompressed. Offsets of names which may be compressed
+ * in responses are kept in ascending order, so rendering an RR is a copy
+ * of the wire data with compression applied only at the known positions.
+ */
+struct knot_rrset_wire {
+	uint16_t size;        /*!< Size of the wire data. */
+	uint16_t compr_count; /*!< Count of compressible names. */
+	uint16_t *compr;      /*!< Offsets of compressible names in data. */
+	uint8_t *data;        /*!< RDLENGTH and RDATA of all RRs. */
+};
+
+typedef struct knot_rrset_wire knot_rrset_wire_t;
+
 /*----------------------------------------------------------------------------*/
 
 typedef enum {
@@ -326,9 +345,54 @@ void knot_rrset_deep_free(knot_rrset_t **rrset, int free_owner,
 void knot_rrset_deep_free_no_sig(knot_rrset_t **rrset, int free_owner,
                                  int free_rdata_dnames);
 
+/*!
+ * \brief Creates pre-rendered RDATA of the RRSet used by knot_rrset_to_wire().
+ *
+ * Nothing is done if the RRSet already has it. Pre-rendered RDATA is
+ * dropped by every function modifying RDATA of the RRSet.
+ *
+ * \note The RRSet may be rendered by other threads at the same time, the
+ *       pre-rendered RDATA is published only once it is complete.
+ *
+ * \param rrset RRSet.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ESPACE if the RDATA are too large to be pre-rendered.
+ * \retval KNOT_ENOMEM
+ */
+int knot_rrset_wire_prepare(knot_rrset_t *rrset);
+
+/*!
+ * \brief Frees pre-rendered RDATA of the RRSet.
+ *
+ * \param rrset RRSet.
+ */
+void knot_rrset_wire_clear(knot_rrset_t *rrset);
+
 int knot_rrset_to_wire(const knot_rrset_t *rrset, uint8_t *wire, size_t *size,
                        size_t max_size, uint16_t *rr_count, void *comp_data);
 
+/*!
+ * \brief Converts one RR of the RRSet to canonical wire format.
+ *
+ * Canonical form is defined in RFC 4034, Section 6.2. Owner and domain names
+ * in RDATA are written uncompressed and in lowercase (except for names with
+ * preserved letter case, see RFC 6840, Section 5.1).
+ *
+ * \param rrset RRSet containing the RR.
+ * \param rdata_pos Position of the RR in the RRSet.
+ * \param wire Output buffer.
+ * \param max_size Size of the output buffer.
+ * \param size Output size of the RR in canonical wire format.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ESPACE if the RR does not fit into the buffer.
+ */
+int knot_rrset_rr_to_canonical(const knot_rrset_t *rrset, size_t rdata_pos,
+                               uint8_t *wire, size_t max_size, size_t *size);
+
 /*!
  * \brief Merges two RRSets.
  *
@@ -524,6 +588,34 @@ int knot_rrset_find_rr_pos(const knot_rrset_t *rr_search_in,
                            const knot_rrset_t *rr_reference, size_t pos,
                            size_t *pos_out);
 
+/*!
+ * \brief Compares RDATA of two RRs.
+ *
+ * \param rrset1 First RRSet.
+ * \param rrset2 Second RRSet.
+ * \param pos1 Position of the RR in the first RRSet.
+ * \param pos2 Position of the RR in the second RRSet.
+ *
+ * \retval 0 if RDATA are equal.
+ * \retval != 0 otherwise.
+ */
+int knot_rrset_rdata_compare_one(const knot_rrset_t *rrset1,
+                                 const knot_rrset_t *rrset2,
+                                 size_t pos1, size_t pos2);
+
+/*!
+ * \brief Computes hash of RR RDATA.
+ *
+ * RRs with equal RDATA (see knot_rrset_rdata_compare_one()) have equal
+ * hashes, domain names are hashed in lowercase.
+ *
+ * \param rrset RRSet.
+ * \param pos Position of the RR in the RRSet.
+ *
+ * \return Hash of the RDATA.
+ */
+uint32_t knot_rrset_rdata_hash(const knot_rrset_t *rrset, size_t pos);
+
 int rrset_rr_dnames_apply(knot_rrset_t *rrset, size_t rdata_pos,
                           int (*func)(knot_dname_t **, void *), void *data);
 
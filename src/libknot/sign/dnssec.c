@@ -719,10 +719,28 @@ void knot_dnssec_sign_free(knot_dnssec_sign_context_t *context)
 	free(context);
 }
 
+/*!
+ * \brief Reinitialize DNSSEC signing context to start a new signature.
+ */
+int knot_dnssec_sign_new(knot_dnssec_sign_context_t *context)
+{
+	if (!context || !context->key)
+		return KNOT_EINVAL;
+
+	const EVP_MD *digest_type = get_digest_type(context->key->algorithm);
+	if (digest_type == NULL)
+		return KNOT_DNSSEC_ENOTSUP;
+
+	if (!EVP_SignInit_ex(context->digest_context, digest_type, NULL))
+		return KNOT_DNSSEC_ECREATE_DIGEST_CONTEXT;
+
+	return KNOT_EOK;
+}
+
 /*!
  * \brief Get DNSSEC signature size.
  */
-size_t knot_dnssec_sign_size(knot_dnssec_key_t *key)
+size_t knot_dnssec_sign_size(const knot_dnssec_key_t *key)
 {
 	if (!key)
 		return 0;
@@ -94,6 +94,17 @@ knot_dnssec_sign_context_t *knot_dnssec_sign_init(const knot_dnssec_key_t *key);
  */
 void knot_dnssec_sign_free(knot_dnssec_sign_context_t *context);
 
+/*!
+ * \brief Reinitialize DNSSEC signing context to start a new signature.
+ *
+ * Allows reusing one context for multiple signatures with the same key.
+ *
+ * \param context  DNSSEC signing context.
+ *
+ * \return Error code, KNOT_EOK if successful.
+ */
+int knot_dnssec_sign_new(knot_dnssec_sign_context_t *context);
+
 /*!
  * \brief Get DNSSEC signature size.
  *
@@ -101,7 +112,7 @@ void knot_dnssec_sign_free(knot_dnssec_sign_context_t *context);
  *
  * \return DNSSEC signature size. Zero in case of error.
  */
-size_t knot_dnssec_sign_size(knot_dnssec_key_t *key);
+size_t knot_dnssec_sign_size(const knot_dnssec_key_t *key);
 
 /*!
  * \brief Add data into DNSSEC signature.
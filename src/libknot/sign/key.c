@@ -32,6 +32,7 @@
 #include "sign/key.h"
 #include "sign/sig0.h"
 #include "tsig.h"
+#include "tsig-op.h"
 #include "zscanner/scanner.h"
 
 /*!
@@ -506,6 +507,10 @@ static int knot_tsig_create_key_from_args(knot_dname_t *name, int algorithm,
 	key->name = name;
 	key->secret = secret;
 	key->algorithm = algorithm;
+	key->hmac = NULL;
+
+	/* Not fatal, digest is computed from the secret if this fails. */
+	knot_tsig_key_prepare(key);
 
 	return KNOT_EOK;
 }
@@ -553,6 +558,7 @@ int knot_tsig_key_free(knot_tsig_key_t *key)
 
 	knot_dname_release(key->name);
 
+	knot_tsig_key_unprepare(key);
 	knot_binary_free(&key->secret);
 	memset(key, '\0', sizeof(knot_tsig_key_t));
 
@@ -72,7 +72,7 @@ static int knot_tsig_check_key(const knot_rrset_t *tsig_rr,
 		return KNOT_EMALF;
 	}
 
-	if (knot_dname_compare(tsig_name, tsig_key->name) != 0) {
+	if (!knot_dname_is_equal(tsig_name, tsig_key->name)) {
 		/*!< \todo which error. */
 		dbg_tsig("TSIG: unknown key: %s\n", name);
 		free(name);
@@ -83,6 +83,159 @@ static int knot_tsig_check_key(const knot_rrset_t *tsig_rr,
 	return KNOT_EOK;
 }
 
+/*!
+ * \brief Keyed HMAC state precomputed from the shared secret.
+ *
+ * Holds the hash contexts after processing (K ^ ipad) and (K ^ opad) blocks,
+ * so that computing the digest of a message only requires cloning these
+ * contexts instead of redoing the whole key schedule (RFC 2104).
+ */
+struct knot_tsig_hmac {
+	EVP_MD_CTX inner; /*!< Hash state after the inner padded key block. */
+	EVP_MD_CTX outer; /*!< Hash state after the outer padded key block. */
+};
+
+/*! \brief Largest hash block size of supported algorithms (SHA-384/512). */
+#define KNOT_TSIG_MAX_BLOCK_SIZE 128
+
+static const EVP_MD *knot_tsig_digest_method(knot_tsig_algorithm_t alg)
+{
+	switch (alg) {
+	case KNOT_TSIG_ALG_HMAC_MD5:    return EVP_md5();
+	case KNOT_TSIG_ALG_HMAC_SHA1:   return EVP_sha1();
+	case KNOT_TSIG_ALG_HMAC_SHA224: return EVP_sha224();
+	case KNOT_TSIG_ALG_HMAC_SHA256: return EVP_sha256();
+	case KNOT_TSIG_ALG_HMAC_SHA384: return EVP_sha384();
+	case KNOT_TSIG_ALG_HMAC_SHA512: return EVP_sha512();
+	default:                        return NULL;
+	}
+}
+
+static int knot_tsig_hmac_init_ctx(EVP_MD_CTX *ctx, const EVP_MD *md,
+                                   const uint8_t *key, int block_size,
+                                   uint8_t pad)
+{
+	uint8_t block[KNOT_TSIG_MAX_BLOCK_SIZE];
+	for (int i = 0; i < block_size; ++i) {
+		block[i] = key[i] ^ pad;
+	}
+
+	int ret = EVP_DigestInit_ex(ctx, md, NULL) &&
+	          EVP_DigestUpdate(ctx, block, block_size);
+
+	memset(block, 0, sizeof(block));
+
+	return ret ? KNOT_EOK : KNOT_ECRYPTO;
+}
+
+int knot_tsig_key_prepare(knot_tsig_key_t *key)
+{
+	if (key == NULL || key->secret.data == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	knot_tsig_key_unprepare(key);
+
+	const EVP_MD *md = knot_tsig_digest_method(key->algorithm);
+	if (md == NULL) {
+		return KNOT_ENOTSUP;
+	}
+
+	int block_size = EVP_MD_block_size(md);
+	if (block_size <= 0 || block_size > KNOT_TSIG_MAX_BLOCK_SIZE) {
+		return KNOT_ENOTSUP;
+	}
+
+	/* Keys longer than the block size are hashed first (RFC 2104). */
+	uint8_t padded_key[KNOT_TSIG_MAX_BLOCK_SIZE];
+	memset(padded_key, 0, sizeof(padded_key));
+	if (key->secret.size > (size_t)block_size) {
+		if (!EVP_Digest(key->secret.data, key->secret.size,
+		                padded_key, NULL, md, NULL)) {
+			return KNOT_ECRYPTO;
+		}
+	} else {
+		memcpy(padded_key, key->secret.data, key->secret.size);
+	}
+
+	struct knot_tsig_hmac *hmac = malloc(sizeof(struct knot_tsig_hmac));
+	if (hmac == NULL) {
+		memset(padded_key, 0, sizeof(padded_key));
+		ERR_ALLOC_FAILED;
+		return KNOT_ENOMEM;
+	}
+
+	EVP_MD_CTX_init(&hmac->inner);
+	EVP_MD_CTX_init(&hmac->outer);
+
+	int ret = knot_tsig_hmac_init_ctx(&hmac->inner, md, padded_key,
+	                                  block_size, 0x36);
+	if (ret == KNOT_EOK) {
+		ret = knot_tsig_hmac_init_ctx(&hmac->outer, md, padded_key,
+		                              block_size, 0x5c);
+	}
+
+	memset(padded_key, 0, sizeof(padded_key));
+
+	if (ret != KNOT_EOK) {
+		EVP_MD_CTX_cleanup(&hmac->inner);
+		EVP_MD_CTX_cleanup(&hmac->outer);
+		free(hmac);
+		return ret;
+	}
+
+	key->hmac = hmac;
+
+	return KNOT_EOK;
+}
+
+void knot_tsig_key_unprepare(knot_tsig_key_t *key)
+{
+	if (key == NULL || key->hmac == NULL) {
+		return;
+	}
+
+	EVP_MD_CTX_cleanup(&key->hmac->inner);
+	EVP_MD_CTX_cleanup(&key->hmac->outer);
+	free(key->hmac);
+	key->hmac = NULL;
+}
+
+/*!
+ * \brief Computes HMAC digest by cloning the precomputed keyed state.
+ */
+static int knot_tsig_compute_digest_prepared(const struct knot_tsig_hmac *hmac,
+                                             const uint8_t *wire,
+                                             size_t wire_len,
+                                             uint8_t *digest,
+                                             size_t *digest_len)
+{
+	uint8_t inner_digest[EVP_MAX_MD_SIZE];
+	unsigned inner_len = 0;
+	unsigned tmp_dig_len = 0;
+
+	EVP_MD_CTX ctx;
+	EVP_MD_CTX_init(&ctx);
+
+	int ret = EVP_MD_CTX_copy_ex(&ctx, &hmac->inner) &&
+	          EVP_DigestUpdate(&ctx, wire, wire_len) &&
+	          EVP_DigestFinal_ex(&ctx, inner_digest, &inner_len) &&
+	          EVP_MD_CTX_copy_ex(&ctx, &hmac->outer) &&
+	          EVP_DigestUpdate(&ctx, inner_digest, inner_len) &&
+	          EVP_DigestFinal_ex(&ctx, digest, &tmp_dig_len);
+
+	EVP_MD_CTX_cleanup(&ctx);
+
+	if (!ret) {
+		dbg_tsig("TSIG: digest: failed to use precomputed state\n");
+		return KNOT_ECRYPTO;
+	}
+
+	*digest_len = tmp_dig_len;
+
+	return KNOT_EOK;
+}
+
 static int knot_tsig_compute_digest(const uint8_t *wire, size_t wire_len,
                                     uint8_t *digest, size_t *digest_len,
                                     const knot_tsig_key_t *key)
@@ -108,37 +261,21 @@ static int knot_tsig_compute_digest(const uint8_t *wire, size_t wire_len,
 	dbg_tsig_hex_detail((char *)key->secret.data, key->secret.size);
 	dbg_tsig_detail("Wire for signing is %zu bytes long.\n", wire_len);
 
+	/* Reuse the keyed state if the key was prepared. */
+	if (key->hmac != NULL) {
+		return knot_tsig_compute_digest_prepared(key->hmac, wire,
+		                                         wire_len, digest,
+		                                         digest_len);
+	}
+
 	/* Compute digest. */
-	HMAC_CTX ctx;
+	const EVP_MD *md = knot_tsig_digest_method(tsig_alg);
+	if (md == NULL) {
+		return KNOT_ENOTSUP;
+	}
 
-	switch (tsig_alg) {
-		case KNOT_TSIG_ALG_HMAC_MD5:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_md5());
-			break;
-		case KNOT_TSIG_ALG_HMAC_SHA1:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_sha1());
-			break;
-		case KNOT_TSIG_ALG_HMAC_SHA224:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_sha224());
-			break;
-		case KNOT_TSIG_ALG_HMAC_SHA256:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_sha256());
-			break;
-		case KNOT_TSIG_ALG_HMAC_SHA384:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_sha384());
-			break;
-		case KNOT_TSIG_ALG_HMAC_SHA512:
-			HMAC_Init(&ctx, key->secret.data,
-			          key->secret.size, EVP_sha512());
-			break;
-		default:
-			return KNOT_ENOTSUP;
-	} /* switch */
+	HMAC_CTX ctx;
+	HMAC_Init(&ctx, key->secret.data, key->secret.size, md);
 
 	unsigned tmp_dig_len = *digest_len;
 	HMAC_Update(&ctx, (const unsigned char *)wire, wire_len);
@@ -33,6 +33,35 @@
 #include "rrset.h"
 #include "sign/key.h"
 
+/*!
+ * \brief Precomputes keyed HMAC state of the TSIG key.
+ *
+ * The HMAC inner and outer padded key blocks are hashed once and the resulting
+ * hash contexts are stored in the key. Signing and verification then only
+ * clone these contexts instead of redoing the key schedule for each message.
+ * Keys without precomputed state are still usable, just slower.
+ *
+ * \note Copies of the key structure share the precomputed state, which is
+ *       read-only after this call. Only the owner of the key should release
+ *       it (done by knot_tsig_key_free()).
+ *
+ * \param key TSIG key with algorithm and shared secret set.
+ *
+ * \retval KNOT_EOK if successful.
+ * \retval KNOT_EINVAL if the key has no secret.
+ * \retval KNOT_ENOTSUP if the algorithm is not supported.
+ * \retval KNOT_ENOMEM
+ * \retval KNOT_ECRYPTO
+ */
+int knot_tsig_key_prepare(knot_tsig_key_t *key);
+
+/*!
+ * \brief Releases precomputed HMAC state of the TSIG key (if any).
+ *
+ * \param key TSIG key.
+ */
+void knot_tsig_key_unprepare(knot_tsig_key_t *key);
+
 /*!
  * \brief Generate TSIG signature of a message.
  *
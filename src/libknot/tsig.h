@@ -34,10 +34,13 @@
 #include "util/utils.h"
 #include "libknot/consts.h"
 
+struct knot_tsig_hmac;
+
 struct knot_tsig_key {
 	knot_dname_t *name;
 	knot_tsig_algorithm_t algorithm;
 	knot_binary_t secret;
+	struct knot_tsig_hmac *hmac; /*!< Precomputed HMAC state (optional). */
 };
 
 typedef struct knot_tsig_key knot_tsig_key_t;
@@ -296,6 +296,66 @@ int knot_changeset_is_empty(const knot_changeset_t *changeset)
 
 /*----------------------------------------------------------------------------*/
 
+static int knot_changeset_copy_rrsets(knot_rrset_t ***dst, size_t *count,
+                                      size_t *allocated,
+                                      knot_rrset_t *const *src,
+                                      size_t src_count)
+{
+	for (size_t i = 0; i < src_count; ++i) {
+		knot_rrset_t *copy = NULL;
+		int ret = knot_rrset_deep_copy(src[i], &copy, 1);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+
+		ret = knot_changeset_add_rrset(dst, count, allocated, copy);
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&copy, 1, 1);
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+int knot_changeset_append_copy(knot_changeset_t *dst,
+                               const knot_changeset_t *src)
+{
+	if (dst == NULL || src == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* SOAs are taken over only if the target has none. */
+	int ret = KNOT_EOK;
+	if (dst->soa_from == NULL && src->soa_from != NULL) {
+		ret = knot_rrset_deep_copy(src->soa_from, &dst->soa_from, 1);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		dst->serial_from = src->serial_from;
+	}
+	if (dst->soa_to == NULL && src->soa_to != NULL) {
+		ret = knot_rrset_deep_copy(src->soa_to, &dst->soa_to, 1);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+		dst->serial_to = src->serial_to;
+	}
+
+	ret = knot_changeset_copy_rrsets(&dst->remove, &dst->remove_count,
+	                                 &dst->remove_allocated, src->remove,
+	                                 src->remove_count);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	return knot_changeset_copy_rrsets(&dst->add, &dst->add_count,
+	                                  &dst->add_allocated, src->add,
+	                                  src->add_count);
+}
+
+/*----------------------------------------------------------------------------*/
+
 void knot_free_changeset(knot_changeset_t **changeset)
 {
 	assert((*changeset)->add_allocated >= (*changeset)->add_count);
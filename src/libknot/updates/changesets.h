@@ -162,6 +162,21 @@ uint32_t knot_changeset_flags(knot_changeset_t *changeset);
 
 int knot_changeset_is_empty(const knot_changeset_t *changeset);
 
+/*!
+ * \brief Appends deep copies of all RRSets from one changeset to another.
+ *
+ * SOA records are copied only if the target changeset has none.
+ *
+ * \param dst Target changeset.
+ * \param src Source changeset.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int knot_changeset_append_copy(knot_changeset_t *dst,
+                               const knot_changeset_t *src);
+
 void knot_free_changeset(knot_changeset_t **changeset);
 
 void knot_free_changesets(knot_changesets_t **changesets);
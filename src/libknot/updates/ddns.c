@@ -616,7 +616,7 @@ static int knot_ddns_check_update(const knot_rrset_t *rrset,
 	const knot_dname_t *owner = knot_rrset_owner(rrset);
 	const knot_dname_t *qname = knot_packet_qname(query);
 	int is_sub = knot_dname_is_subdomain(owner, qname);
-	if (!is_sub && knot_dname_compare(owner, qname) != 0) {
+	if (!is_sub && !knot_dname_is_equal(owner, qname)) {
 		*rcode = KNOT_RCODE_NOTZONE;
 		return KNOT_EBADZONE;
 	}
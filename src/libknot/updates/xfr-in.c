@@ -32,6 +32,7 @@
 #include "tsig.h"
 #include "tsig-op.h"
 #include "common/descriptor.h"
+#include "common/arena.h"
 
 /*----------------------------------------------------------------------------*/
 /* Non-API functions                                                          */
@@ -468,7 +469,7 @@ static int xfrin_check_tsig(knot_packet_t *packet, knot_ns_xfr_t *xfr,
 
 /*----------------------------------------------------------------------------*/
 
-int xfrin_process_axfr_packet(knot_ns_xfr_t *xfr)
+static int xfrin_process_axfr_rrs(knot_ns_xfr_t *xfr)
 {
 	const uint8_t *pkt = xfr->wire;
 	size_t size = xfr->wire_size;
@@ -906,6 +907,40 @@ dbg_xfrin_exec_verb(
 
 /*----------------------------------------------------------------------------*/
 
+int xfrin_process_axfr_packet(knot_ns_xfr_t *xfr)
+{
+	if (xfr == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/* Nodes and RRSets of the new zone are allocated from its arena. */
+	xfrin_constructed_zone_t *constr = xfr->data;
+	arena_t *arena = NULL;
+	if (constr == NULL) {
+		arena = arena_new(); /* Heap is used if this fails. */
+	} else {
+		arena = constr->contents->arena;
+		arena_retain(arena);
+	}
+
+	arena_enter(arena);
+	int ret = xfrin_process_axfr_rrs(xfr);
+	arena_leave();
+
+	/* New zone takes over the reference. */
+	constr = xfr->data;
+	if (constr != NULL && constr->contents != NULL &&
+	    constr->contents->arena == NULL) {
+		constr->contents->arena = arena;
+	} else {
+		arena_release(arena);
+	}
+
+	return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
 static int xfrin_parse_first_rr(knot_packet_t **packet, const uint8_t *pkt,
                                 size_t size, knot_rrset_t **rr)
 {
@@ -1278,6 +1313,8 @@ static void xfrin_zone_contents_free(knot_zone_contents_t **contents)
 	knot_zone_tree_deep_free(&(*contents)->nsec3_nodes);
 
 	knot_nsec3_params_free(&(*contents)->nsec3_params);
+	knot_nsec3_cache_free(&(*contents)->nsec3_cache);
+	arena_release((*contents)->arena);
 
 	free(*contents);
 	*contents = NULL;
@@ -2468,6 +2505,8 @@ static void xfrin_zone_contents_free2(knot_zone_contents_t **contents)
 	knot_zone_tree_deep_free(&(*contents)->nsec3_nodes);
 
 	knot_nsec3_params_free(&(*contents)->nsec3_params);
+	knot_nsec3_cache_free(&(*contents)->nsec3_cache);
+	arena_release((*contents)->arena);
 
 	free(*contents);
 	*contents = NULL;
@@ -3207,6 +3246,35 @@ int xfrin_finalize_updated_zone(knot_zone_contents_t *contents_copy,
 
 /*----------------------------------------------------------------------------*/
 
+int xfrin_apply_changeset_to_copy(knot_zone_contents_t *contents_copy,
+                                  knot_changes_t *changes,
+                                  knot_changeset_t *chset)
+{
+	if (contents_copy == NULL || changes == NULL || chset == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	/*
+	 * The copy was already updated by a previous changeset, so the SOA
+	 * serials are not checked and the SOA is not replaced here. Only the
+	 * RRSets are applied and the contents are finalized again.
+	 */
+	dbg_xfrin("Applying additional changes to updated zone copy.\n");
+	int ret = xfrin_apply_remove(contents_copy, chset, changes);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	ret = xfrin_apply_add(contents_copy, chset, changes);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	return xfrin_finalize_updated_zone(contents_copy, changes);
+}
+
+/*----------------------------------------------------------------------------*/
+
 int xfrin_apply_changesets(knot_zone_t *zone,
                            knot_changesets_t *chsets,
                            knot_zone_contents_t **new_contents)
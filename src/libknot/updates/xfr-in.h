@@ -192,6 +192,23 @@ int xfrin_prepare_zone_copy(knot_zone_contents_t *old_contents,
 int xfrin_finalize_updated_zone(knot_zone_contents_t *contents_copy,
                                 knot_changes_t *changes);
 
+/*!
+ * \brief Applies RRSet changes to the zone copy created by previous update.
+ *
+ * SOA of the changeset is ignored, the zone copy is finalized again.
+ *
+ * \param contents_copy Updated zone copy (not switched yet).
+ * \param changes Changes structure of the update in progress.
+ * \param chset Changeset to apply (RRSets are consumed as in regular apply).
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int xfrin_apply_changeset_to_copy(knot_zone_contents_t *contents_copy,
+                                  knot_changes_t *changes,
+                                  knot_changeset_t *chset);
+
 int xfrin_switch_zone(knot_zone_t *zone,
                       knot_zone_contents_t *new_contents,
                       int deep_free);
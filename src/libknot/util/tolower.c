@@ -17,6 +17,16 @@
 #include <config.h>
 #include "util/tolower.h"
 
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+/* AVX2 code is compiled separately and enabled at runtime. */
+#if defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define KNOT_TOLOWER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 const uint8_t char_table[CHAR_TABLE_SIZE] = {
 	'\x00',
 	'\x01',
@@ -275,3 +285,226 @@ const uint8_t char_table[CHAR_TABLE_SIZE] = {
 	'\xFE',
 	'\xFF',
 };
+
+/*----------------------------------------------------------------------------*/
+/* Case folding kernels                                                       */
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Vector kernels map 'A'..'Z' to the lowest signed values by adding 0x3f,
+ * so a single signed comparison selects uppercase letters. Names are short,
+ * so only whole vectors are processed this way, the rest goes to the scalar
+ * code (loads never read past the buffer).
+ */
+
+static size_t tolower_buf_scalar(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		dst[i] = knot_tolower(src[i]);
+	}
+	return len;
+}
+
+static int tolower_cmp_scalar(const uint8_t *s1, const uint8_t *s2, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		int diff = knot_tolower(s1[i]) - knot_tolower(s2[i]);
+		if (diff != 0) {
+			return diff;
+		}
+	}
+	return 0;
+}
+
+#ifdef HAVE_SSE2
+
+static inline __attribute__((always_inline))
+__m128i tolower_sse2(__m128i v)
+{
+	const __m128i shift = _mm_set1_epi8(0x3f);
+	const __m128i limit = _mm_set1_epi8(-128 + 26);
+	const __m128i flip = _mm_set1_epi8(0x20);
+
+	__m128i upper = _mm_cmpgt_epi8(limit, _mm_add_epi8(v, shift));
+	return _mm_or_si128(v, _mm_and_si128(upper, flip));
+}
+
+static size_t tolower_buf_sse2(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), tolower_sse2(v));
+	}
+	return i;
+}
+
+static size_t tolower_cmp_sse2(const uint8_t *s1, const uint8_t *s2,
+                               size_t len)
+{
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i v1 = tolower_sse2(
+			_mm_loadu_si128((const __m128i *)(s1 + i)));
+		__m128i v2 = tolower_sse2(
+			_mm_loadu_si128((const __m128i *)(s2 + i)));
+		int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+		if (eq != 0xffff) {
+			return i + __builtin_ctz(~eq);
+		}
+	}
+	return i;
+}
+
+#endif /* HAVE_SSE2 */
+
+#ifdef KNOT_TOLOWER_AVX2
+
+__attribute__((target("avx2"), always_inline))
+static inline __m256i tolower_avx2(__m256i v)
+{
+	const __m256i shift = _mm256_set1_epi8(0x3f);
+	const __m256i limit = _mm256_set1_epi8(-128 + 26);
+	const __m256i flip = _mm256_set1_epi8(0x20);
+
+	__m256i upper = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+	return _mm256_or_si256(v, _mm256_and_si256(upper, flip));
+}
+
+__attribute__((target("avx2")))
+static size_t tolower_buf_avx2(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		_mm256_storeu_si256((__m256i *)(dst + i), tolower_avx2(v));
+	}
+	/* Inlined SSE2 code is VEX encoded here, no transition penalty. */
+	if (i + 16 <= len) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), tolower_sse2(v));
+		i += 16;
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t tolower_cmp_avx2(const uint8_t *s1, const uint8_t *s2,
+                               size_t len)
+{
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i v1 = tolower_avx2(
+			_mm256_loadu_si256((const __m256i *)(s1 + i)));
+		__m256i v2 = tolower_avx2(
+			_mm256_loadu_si256((const __m256i *)(s2 + i)));
+		unsigned eq = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2));
+		if (eq != 0xffffffffU) {
+			return i + __builtin_ctz(~eq);
+		}
+	}
+	if (i + 16 <= len) {
+		__m128i v1 = tolower_sse2(
+			_mm_loadu_si128((const __m128i *)(s1 + i)));
+		__m128i v2 = tolower_sse2(
+			_mm_loadu_si128((const __m128i *)(s2 + i)));
+		int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+		if (eq != 0xffff) {
+			return i + __builtin_ctz(~eq);
+		}
+		i += 16;
+	}
+	return i;
+}
+
+#endif /* KNOT_TOLOWER_AVX2 */
+
+/*!
+ * \brief Vector kernels, process a prefix and return its length.
+ *
+ * Compare kernel stops at the first difference.
+ */
+typedef struct {
+	size_t (*buf)(uint8_t *, const uint8_t *, size_t);
+	size_t (*cmp)(const uint8_t *, const uint8_t *, size_t);
+	const char *name;
+} tolower_impl_t;
+
+static size_t tolower_cmp_none(const uint8_t *s1, const uint8_t *s2,
+                               size_t len)
+{
+	return 0;
+}
+
+static size_t tolower_buf_none(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	return 0;
+}
+
+static const tolower_impl_t *tolower_impl = NULL;
+
+/*!
+ * \brief Selects the best implementation for the running CPU.
+ *
+ * Concurrent callers may both select, but they store the same value.
+ */
+static const tolower_impl_t *tolower_select()
+{
+	static const tolower_impl_t impl_scalar = {
+		tolower_buf_none, tolower_cmp_none, "scalar"
+	};
+#ifdef HAVE_SSE2
+	static const tolower_impl_t impl_sse2 = {
+		tolower_buf_sse2, tolower_cmp_sse2, "sse2"
+	};
+#endif
+#ifdef KNOT_TOLOWER_AVX2
+	static const tolower_impl_t impl_avx2 = {
+		tolower_buf_avx2, tolower_cmp_avx2, "avx2"
+	};
+#endif
+
+	const tolower_impl_t *impl = tolower_impl;
+	if (impl != NULL) {
+		return impl;
+	}
+
+	impl = &impl_scalar;
+#ifdef HAVE_SSE2
+	impl = &impl_sse2;
+#endif
+#ifdef KNOT_TOLOWER_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		impl = &impl_avx2;
+	}
+#endif
+	tolower_impl = impl;
+	return impl;
+}
+
+/*! \brief Shorter buffers are not worth the vector kernel call. */
+#define TOLOWER_VECTOR_MIN 16
+
+void knot_tolower_buf(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t done = 0;
+	if (len >= TOLOWER_VECTOR_MIN) {
+		done = tolower_select()->buf(dst, src, len);
+	}
+	tolower_buf_scalar(dst + done, src + done, len - done);
+}
+
+int knot_tolower_cmp(const uint8_t *s1, const uint8_t *s2, size_t len)
+{
+	size_t same = 0;
+	if (len >= TOLOWER_VECTOR_MIN) {
+		same = tolower_select()->cmp(s1, s2, len);
+	}
+	return tolower_cmp_scalar(s1 + same, s2 + same, len - same);
+}
+
+const char *knot_tolower_impl()
+{
+	return tolower_select()->name;
+}
@@ -28,6 +28,7 @@
 #define _KNOT_TOLOWER_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 /*! \brief Size of the character conversion table. */
 #define KNOT_CHAR_TABLE_SIZE 256
@@ -54,6 +55,38 @@ static inline uint8_t knot_tolower(uint8_t c) {
 	return char_table[c];
 }
 
+/*!
+ * \brief Converts ASCII characters in buffer to lowercase.
+ *
+ * Uses SSE2 or AVX2 if available on the running CPU.
+ *
+ * \param dst Destination buffer (may be the same as \a src).
+ * \param src Source buffer.
+ * \param len Number of characters to convert.
+ */
+void knot_tolower_buf(uint8_t *dst, const uint8_t *src, size_t len);
+
+/*!
+ * \brief Compares ASCII characters in two buffers, case insensitive.
+ *
+ * Uses SSE2 or AVX2 if available on the running CPU.
+ *
+ * \param s1 First buffer.
+ * \param s2 Second buffer.
+ * \param len Number of characters to compare.
+ *
+ * \return Difference of the first differing characters in lowercase, 0 if
+ *         the buffers are equal.
+ */
+int knot_tolower_cmp(const uint8_t *s1, const uint8_t *s2, size_t len);
+
+/*!
+ * \brief Returns name of the case folding implementation in use.
+ *
+ * \return "avx2", "sse2" or "scalar".
+ */
+const char *knot_tolower_impl();
+
 #endif /* _KNOT_TOLOWER_H_ */
 
 /*! @} */
@@ -25,6 +25,7 @@
 #include "zone/node.h"
 #include "rrset.h"
 #include "common/skip-list.h"
+#include "common/arena.h"
 #include "util/debug.h"
 
 /*----------------------------------------------------------------------------*/
@@ -125,6 +126,70 @@ static inline uint8_t knot_node_flags_get_empty(uint8_t flags)
 	return flags & KNOT_NODE_FLAGS_EMPTY;
 }
 
+/*----------------------------------------------------------------------------*/
+/*!
+ * \brief Makes room for given number of RRSets in the node.
+ *
+ * The block of RRSet pointers and types grows at least twice, so that adding
+ * RRSets one by one doesn't leave a trail of abandoned blocks in the zone
+ * arena. The block is never shrunk.
+ *
+ * \param node Node.
+ * \param count Requested RRSet count.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENOMEM
+ */
+static int knot_node_reserve_rrsets(knot_node_t *node, uint16_t count)
+{
+	if (count <= node->rrset_max) {
+		return KNOT_EOK;
+	}
+
+	uint16_t max = count;
+	if (node->rrset_max > 0 && node->rrset_max <= UINT16_MAX / 2 &&
+	    2 * node->rrset_max > count) {
+		max = 2 * node->rrset_max;
+	}
+
+	knot_rrset_t **block = arena_malloc(max * (sizeof(knot_rrset_t *) +
+	                                           sizeof(uint16_t)));
+	if (block == NULL) {
+		return KNOT_ENOMEM;
+	}
+	uint16_t *types = (uint16_t *)(block + max);
+
+	if (node->rrset_count > 0) {
+		memcpy(block, node->rrset_tree,
+		       node->rrset_count * sizeof(knot_rrset_t *));
+		memcpy(types, node->rrset_types,
+		       node->rrset_count * sizeof(uint16_t));
+	}
+
+	arena_free(node->rrset_tree);
+	node->rrset_tree = block;
+	node->rrset_types = types;
+	node->rrset_max = max;
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * \brief Returns position of the RRSet with given type or -1.
+ */
+static int knot_node_rrset_pos(const knot_node_t *node, uint16_t type)
+{
+	const uint16_t *types = node->rrset_types;
+	for (uint16_t i = 0; i < node->rrset_count; ++i) {
+		if (types[i] == type) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 /*----------------------------------------------------------------------------*/
 /* API functions                                                              */
 /*----------------------------------------------------------------------------*/
@@ -132,17 +197,19 @@ static inline uint8_t knot_node_flags_get_empty(uint8_t flags)
 knot_node_t *knot_node_new(knot_dname_t *owner, knot_node_t *parent,
                            uint8_t flags)
 {
-	knot_node_t *ret = (knot_node_t *)calloc(1, sizeof(knot_node_t));
+	knot_node_t *ret = (knot_node_t *)arena_malloc(sizeof(knot_node_t));
 	if (ret == NULL) {
 		ERR_ALLOC_FAILED;
 		return NULL;
 	}
+	memset(ret, 0, sizeof(knot_node_t));
 
 	/* Store reference to owner. */
 	knot_dname_retain(owner);
 	ret->owner = owner;
 	knot_node_set_parent(ret, parent);
 	ret->rrset_tree = NULL;
+	ret->rrset_types = NULL;
 	ret->flags = flags;
 
 	assert(ret->children == 0);
@@ -157,13 +224,12 @@ int knot_node_add_rrset_no_merge(knot_node_t *node, knot_rrset_t *rrset)
 		return KNOT_EINVAL;
 	}
 
-	size_t nlen = (node->rrset_count + 1) * sizeof(knot_rrset_t*);
-	void *p = realloc(node->rrset_tree, nlen);
-	if (p == NULL) {
-		return KNOT_ENOMEM;
+	int ret = knot_node_reserve_rrsets(node, node->rrset_count + 1);
+	if (ret != KNOT_EOK) {
+		return ret;
 	}
-	node->rrset_tree = p;
 	node->rrset_tree[node->rrset_count] = rrset;
+	node->rrset_types[node->rrset_count] = rrset->type;
 	++node->rrset_count;
 	return KNOT_EOK;
 }
@@ -174,10 +240,9 @@ int knot_node_add_rrset_replace(knot_node_t *node, knot_rrset_t *rrset)
 		return KNOT_EINVAL;
 	}
 
-	for (uint16_t i = 0; i < node->rrset_count; ++i) {
-		if (node->rrset_tree[i]->type == rrset->type) {
-		node->rrset_tree[i] = rrset;
-		}
+	int pos = knot_node_rrset_pos(node, rrset->type);
+	if (pos >= 0) {
+		node->rrset_tree[pos] = rrset;
 	}
 
 	return knot_node_add_rrset_no_merge(node, rrset);
@@ -189,18 +254,17 @@ int knot_node_add_rrset(knot_node_t *node, knot_rrset_t *rrset)
 		return KNOT_EINVAL;
 	}
 
-	for (uint16_t i = 0; i < node->rrset_count; ++i) {
-		if (node->rrset_tree[i]->type == rrset->type) {
-			int merged, deleted_rrs;
-			int ret = knot_rrset_merge_no_dupl(node->rrset_tree[i],
-			                                   rrset, &merged, &deleted_rrs);
-			if (ret != KNOT_EOK) {
-				return ret;
-			} else if (merged || deleted_rrs) {
-				return 1;
-			} else {
-				return 0;
-			}
+	int pos = knot_node_rrset_pos(node, rrset->type);
+	if (pos >= 0) {
+		int merged, deleted_rrs;
+		int ret = knot_rrset_merge_no_dupl(node->rrset_tree[pos],
+		                                   rrset, &merged, &deleted_rrs);
+		if (ret != KNOT_EOK) {
+			return ret;
+		} else if (merged || deleted_rrs) {
+			return 1;
+		} else {
+			return 0;
 		}
 	}
 
@@ -223,14 +287,12 @@ knot_rrset_t *knot_node_get_rrset(const knot_node_t *node, uint16_t type)
 		return NULL;
 	}
 
-	knot_rrset_t **rrs = node->rrset_tree;
-	for (uint16_t i = 0; i < node->rrset_count; ++i) {
-		if (rrs[i]->type == type) {
-			return rrs[i];
-		}
+	int pos = knot_node_rrset_pos(node, type);
+	if (pos < 0) {
+		return NULL;
 	}
 
-	return NULL;
+	return node->rrset_tree[pos];
 }
 
 /*----------------------------------------------------------------------------*/
@@ -241,22 +303,18 @@ knot_rrset_t *knot_node_remove_rrset(knot_node_t *node, uint16_t type)
 		return NULL;
 	}
 
-	uint16_t i = 0;
-	knot_rrset_t *ret = NULL;
-	knot_rrset_t **rrs = node->rrset_tree;
-	for (; i < node->rrset_count && ret == NULL; ++i) {
-		if (rrs[i]->type == type) {
-			ret = rrs[i];
-			memmove(rrs + i, rrs + i + 1, (node->rrset_count - i - 1) * sizeof(knot_rrset_t *));
-			--node->rrset_count;
-		}
+	int pos = knot_node_rrset_pos(node, type);
+	if (pos < 0) {
+		return NULL;
 	}
 
-	/*!< \todo I've added this to fix a leak, but probably this wasn't the cause. Remove once tests are availabe. */
-	void *tmp = realloc(node->rrset_tree,
-	                    node->rrset_count * sizeof(knot_rrset_t *));
-	assert(tmp || node->rrset_count == 0); //Realloc to smaller memory, if it fails, something is really odd.
-	node->rrset_tree = tmp;
+	knot_rrset_t *ret = node->rrset_tree[pos];
+	uint16_t tail = node->rrset_count - pos - 1;
+	memmove(node->rrset_tree + pos, node->rrset_tree + pos + 1,
+	        tail * sizeof(knot_rrset_t *));
+	memmove(node->rrset_types + pos, node->rrset_types + pos + 1,
+	        tail * sizeof(uint16_t));
+	--node->rrset_count;
 
 	return ret;
 }
@@ -706,9 +764,11 @@ void knot_node_free(knot_node_t **node)
 
 	if ((*node)->rrset_tree != NULL) {
 		dbg_node_detail("Freeing RRSets.\n");
-		free((*node)->rrset_tree);
+		arena_free((*node)->rrset_tree);
 		(*node)->rrset_tree = NULL;
+		(*node)->rrset_types = NULL;
 		(*node)->rrset_count = 0;
+		(*node)->rrset_max = 0;
 	}
 
 	// set owner's node pointer to NULL, but only if the 'node' does
@@ -720,7 +780,7 @@ void knot_node_free(knot_node_t **node)
 
 	knot_dname_release((*node)->owner);
 
-	free(*node);
+	arena_free(*node);
 	*node = NULL;
 
 	dbg_node_detail("Done.\n");
@@ -755,14 +815,22 @@ int knot_node_shallow_copy(const knot_node_t *from, knot_node_t **to)
 	memcpy(*to, from, sizeof(knot_node_t));
 
 	// copy RRSets
-	size_t rrlen = sizeof(knot_rrset_t*) * from->rrset_count;
-	(*to)->rrset_tree = malloc(rrlen);
-	if ((*to)->rrset_tree == NULL) {
-		free(*to);
+	(*to)->rrset_tree = NULL;
+	(*to)->rrset_types = NULL;
+	(*to)->rrset_count = 0;
+	(*to)->rrset_max = 0;
+	if (knot_node_reserve_rrsets(*to, from->rrset_count) != KNOT_EOK) {
+		arena_free(*to);
 		*to = NULL;
 		return KNOT_ENOMEM;
 	}
-	memcpy((*to)->rrset_tree, from->rrset_tree, rrlen);
+	(*to)->rrset_count = from->rrset_count;
+	if (from->rrset_count > 0) {
+		memcpy((*to)->rrset_tree, from->rrset_tree,
+		       from->rrset_count * sizeof(knot_rrset_t *));
+		memcpy((*to)->rrset_types, from->rrset_types,
+		       from->rrset_count * sizeof(uint16_t));
+	}
 
 	return KNOT_EOK;
 }
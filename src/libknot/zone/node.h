@@ -43,10 +43,32 @@ struct knot_zone;
  */
 struct knot_node {
 	knot_dname_t *owner; /*!< Domain name being the owner of this node. */
-	struct knot_node *parent; /*!< Parent node in the name hierarchy. */
 
-	/*! \brief Type-ordered list of RRSets belonging to this node. */
+	/*!
+	 * \brief RRSets belonging to this node.
+	 *
+	 * Pointers to RRSets are followed by their types (\a rrset_types) in
+	 * the same block, so a type lookup scans a small contiguous array and
+	 * dereferences only the matching RRSet. RRSets themselves are kept in
+	 * their own blocks, as shallow copies of the node share them.
+	 */
 	knot_rrset_t **rrset_tree;
+	uint16_t *rrset_types; /*!< Types of RRSets (inside rrset_tree block). */
+
+	uint16_t rrset_count; /*!< Number of RRSets stored in the node. */
+	uint16_t rrset_max;   /*!< Number of RRSets the block has room for. */
+
+	/*!
+	 * \brief Various flags.
+	 *
+	 * Currently only two:
+	 *   0x01 - node is a delegation point
+	 *   0x02 - node is non-authoritative (under a delegation point)
+	 *   0x10 - node is empty and will be deleted after update
+	 */
+	uint8_t flags;
+
+	struct knot_node *parent; /*!< Parent node in the name hierarchy. */
 
 	/*! \brief Wildcard node being the direct descendant of this node. */
 	struct knot_node *wildcard_child;
@@ -73,18 +95,6 @@ struct knot_node {
 	struct knot_node *new_node;
 
 	unsigned int children;
-
-	uint16_t rrset_count; /*!< Number of RRSets stored in the node. */
-
-	/*!
-	 * \brief Various flags.
-	 *
-	 * Currently only two:
-	 *   0x01 - node is a delegation point
-	 *   0x02 - node is non-authoritative (under a delegation point)
-	 *   0x10 - node is empty and will be deleted after update
-	 */
-	uint8_t flags;
 };
 
 typedef struct knot_node knot_node_t;
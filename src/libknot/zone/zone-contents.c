@@ -19,6 +19,7 @@
 
 #include "zone/zone-contents.h"
 #include "util/debug.h"
+#include "util/tolower.h"
 #include "libknot/rrset.h"
 #include "common/base32hex.h"
 #include "common/descriptor.h"
@@ -51,6 +52,8 @@ const uint8_t KNOT_ZONE_FLAGS_GEN_FIN  = 1 << 1;       /* xxxxxx10 */
 const uint8_t KNOT_ZONE_FLAGS_GEN_MASK = 3;            /* 00000011 */
 const uint8_t KNOT_ZONE_FLAGS_ANY_MASK = 4;            /* 00000100 */
 const uint8_t KNOT_ZONE_FLAGS_ANY      = 4;            /* 00000100 */
+const uint8_t KNOT_ZONE_FLAGS_WIRE_MASK = 8;           /* 00001000 */
+const uint8_t KNOT_ZONE_FLAGS_WIRE     = 8;            /* 00001000 */
 
 /*----------------------------------------------------------------------------*/
 
@@ -359,6 +362,136 @@ static int knot_zone_contents_adjust_rrsets(knot_node_t *node,
 
 	return KNOT_EOK;
 }
+/*----------------------------------------------------------------------------*/
+/*!
+ * \brief Creates pre-rendered RDATA for all RRSets in the node.
+ *
+ * RRSets too large to be pre-rendered are skipped, these are rendered the
+ * usual way.
+ */
+static int knot_zone_contents_prepare_wire(knot_node_t *node)
+{
+	knot_rrset_t **rrsets = knot_node_get_rrsets_no_copy(node);
+	short count = knot_node_rrset_count(node);
+
+	for (int r = 0; r < count; ++r) {
+		int ret = knot_rrset_wire_prepare(rrsets[r]);
+		if (ret == KNOT_EOK && rrsets[r]->rrsigs != NULL) {
+			ret = knot_rrset_wire_prepare(rrsets[r]->rrsigs);
+		}
+		if (ret == KNOT_ENOMEM) {
+			return ret;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void knot_zone_contents_prepare_wire_in_tree(knot_node_t *node,
+                                                    void *data)
+{
+	int *ret = (int *)data;
+	if (*ret == KNOT_EOK) {
+		*ret = knot_zone_contents_prepare_wire(node);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \brief Creates NSEC3 hashed owner name for the given name in wire format.
+ *
+ * Hash is taken from the zone's NSEC3 hash cache if possible, no memory is
+ * allocated.
+ *
+ * \param zone Zone from which to take the NSEC3 parameters.
+ * \param name Domain name to hash.
+ * \param wire Buffer of KNOT_MAX_DNAME_LENGTH octets for the hashed name.
+ * \param size Size of the hashed name.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_ENSEC3PAR
+ * \retval KNOT_ECRYPTO
+ * \retval KNOT_ESPACE if the hashed name would be too long.
+ */
+static int knot_zone_contents_nsec3_wire(const knot_zone_contents_t *zone,
+                                         const knot_dname_t *name,
+                                         uint8_t *wire, size_t *size)
+{
+	/* Names may be hashed before the NSEC3 chain exists. */
+	const knot_nsec3_params_t *nsec3_params = &zone->nsec3_params;
+
+	if (nsec3_params->algorithm == 0) {
+dbg_zone_exec(
+		char *n = knot_dname_to_str(zone->apex->owner);
+		dbg_zone("No NSEC3PARAM for zone %s.\n", n);
+		free(n);
+);
+		return KNOT_ENSEC3PAR;
+	}
+
+	const knot_dname_t *apex = zone->apex->owner;
+	assert(apex != NULL);
+
+	uint8_t hash[KNOT_NSEC3_HASH_LENGTH];
+	int res = knot_nsec3_cache_hash(zone->nsec3_cache, nsec3_params,
+	                                knot_dname_name(name),
+	                                knot_dname_size(name), hash);
+	if (res != KNOT_EOK) {
+		char *n = knot_dname_to_str(name);
+		dbg_zone("Error while hashing name %s.\n", n);
+		free(n);
+		return KNOT_ECRYPTO;
+	}
+
+	/* Hashed label followed by the zone name. */
+	int32_t label_len = base32hex_encode(hash, sizeof(hash), wire + 1,
+	                                     KNOT_MAX_DNAME_LENGTH - 1);
+	if (label_len <= 0) {
+		return KNOT_ECRYPTO;
+	}
+	if (1 + label_len + knot_dname_size(apex) > KNOT_MAX_DNAME_LENGTH) {
+		return KNOT_ESPACE;
+	}
+
+	wire[0] = label_len;
+	knot_tolower_buf(wire + 1, wire + 1, label_len);
+	memcpy(wire + 1 + label_len, knot_dname_name(apex),
+	       knot_dname_size(apex));
+	*size = 1 + label_len + knot_dname_size(apex);
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Prepares NSEC3 hashed name on stack, usable for zone tree lookups.
+ *
+ * \note Only name and size of the resulting dname are set.
+ */
+static int knot_zone_contents_nsec3_lookup_name(
+	const knot_zone_contents_t *zone, const knot_dname_t *name,
+	uint8_t *wire, knot_dname_t *nsec3_name)
+{
+	/* Nothing to look up without the NSEC3 chain. */
+	if (knot_zone_contents_nsec3params(zone) == NULL) {
+		return KNOT_ENSEC3PAR;
+	}
+
+	size_t size = 0;
+	int ret = knot_zone_contents_nsec3_wire(zone, name, wire, &size);
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
+
+	memset(nsec3_name, 0, sizeof(knot_dname_t));
+	nsec3_name->name = wire;
+	nsec3_name->size = size;
+
+	return KNOT_EOK;
+}
+
 /*----------------------------------------------------------------------------*/
 /*!
  * \brief Adjusts zone node for faster query processing.
@@ -387,6 +520,14 @@ static int knot_zone_contents_adjust_node(knot_node_t *node,
 		return ret;
 	}
 
+	// pre-render RDATA (adjusted RRSets already have it)
+	if (knot_zone_contents_wire_enabled(zone)) {
+		ret = knot_zone_contents_prepare_wire(node);
+		if (ret != KNOT_EOK) {
+			return ret;
+		}
+	}
+
 //	const knot_node_t *old_dname_node = node->owner->node;
 	knot_zone_contents_insert_dname_into_table(&node->owner, lookup_tree);
 //	assert(node->owner->node == old_dname_node || old_dname_node == NULL);
@@ -406,21 +547,18 @@ static int knot_zone_contents_adjust_node(knot_node_t *node,
 	/*! \todo We need only exact matches, what if node has no nsec3 node? */
 	/* This is faster, as it doesn't need ordered access. */
 	knot_node_t *nsec3 = NULL;
-	knot_dname_t *nsec3_name = NULL;
-	ret = knot_zone_contents_nsec3_name(zone, knot_node_owner(node),
-					    &nsec3_name);
+	uint8_t nsec3_wire[KNOT_MAX_DNAME_LENGTH];
+	knot_dname_t nsec3_name;
+	ret = knot_zone_contents_nsec3_lookup_name(zone, knot_node_owner(node),
+	                                           nsec3_wire, &nsec3_name);
 	if (ret == KNOT_EOK) {
-		assert(nsec3_name);
-		knot_zone_tree_get(zone->nsec3_nodes, nsec3_name, &nsec3);
+		knot_zone_tree_get(zone->nsec3_nodes, &nsec3_name, &nsec3);
 		knot_node_set_nsec3_node(node, nsec3);
 	} else if (ret == KNOT_ENSEC3PAR) {
 		knot_node_set_nsec3_node(node, NULL);
 	} else {
-		/* Something could be in DNAME. */
-		knot_dname_free(&nsec3_name);
 		return ret;
 	}
-	knot_dname_free(&nsec3_name);
 
 	dbg_zone_detail("Set flags to the node: \n");
 	dbg_zone_detail("Delegation point: %s\n",
@@ -566,6 +704,10 @@ static void knot_zone_contents_adjust_nsec3_node_in_tree(
 
 	knot_zone_contents_t *zone = args->zone;
 	assert(zone != NULL);
+
+	if (knot_zone_contents_wire_enabled(zone)) {
+		args->err = knot_zone_contents_prepare_wire(node);
+	}
 }
 
 /*----------------------------------------------------------------------------*/
@@ -600,87 +742,19 @@ int knot_zone_contents_nsec3_name(const knot_zone_contents_t *zone,
 
 	*nsec3_name = NULL;
 
-	const knot_nsec3_params_t *nsec3_params =
-		knot_zone_contents_nsec3params(zone);
-
-	if (nsec3_params == NULL) {
-dbg_zone_exec(
-		char *n = knot_dname_to_str(zone->apex->owner);
-		dbg_zone("No NSEC3PARAM for zone %s.\n", n);
-		free(n);
-);
-		return KNOT_ENSEC3PAR;
-	}
-
-	uint8_t *hashed_name = NULL;
-	size_t hash_size = 0;
-
-dbg_zone_exec_verb(
-	char *n = knot_dname_to_str(name);
-	dbg_zone_verb("Hashing name %s.\n", n);
-	free(n);
-);
-
-	int res = knot_nsec3_sha1(nsec3_params, knot_dname_name(name),
-				    knot_dname_size(name), &hashed_name,
-				    &hash_size);
-
-	if (res != 0) {
-		char *n = knot_dname_to_str(name);
-		dbg_zone("Error while hashing name %s.\n", n);
-		free(n);
-		return KNOT_ECRYPTO;
-	}
-
-	dbg_zone("Hash: ");
-	dbg_zone_hex((char *)hashed_name, hash_size);
-	dbg_zone("\n");
-
-	uint8_t *name_b32 = NULL;
-	size_t size = base32hex_encode_alloc(hashed_name, hash_size,
-					     &name_b32);
-
-	if (size == 0) {
-		char *n = knot_dname_to_str(name);
-		dbg_zone("Error while encoding hashed name %s to base32.\n", n);
-		free(n);
-		free(name_b32);
-		return KNOT_ECRYPTO;
+	uint8_t wire[KNOT_MAX_DNAME_LENGTH];
+	size_t size = 0;
+	int ret = knot_zone_contents_nsec3_wire(zone, name, wire, &size);
+	if (ret != KNOT_EOK) {
+		return ret;
 	}
 
-	assert(name_b32 != NULL);
-	free(hashed_name);
-
-dbg_zone_exec_verb(
-	/* name_b32 is not 0-terminated. */
-	char b32_string[hash_size + 1];
-	memset(b32_string, 0, hash_size + 1);
-	memcpy(b32_string, name_b32, hash_size);
-	dbg_zone_verb("Base32-encoded hash: %s\n", b32_string);
-);
-
 	/* Will be returned to caller, make sure it is released after use. */
-	*nsec3_name = knot_dname_new_from_str((char *)name_b32, size, NULL);
-
-	free(name_b32);
-
+	*nsec3_name = knot_dname_new_from_wire(wire, size, NULL);
 	if (*nsec3_name == NULL) {
 		dbg_zone("Error while creating domain name for hashed name.\n");
 		return KNOT_ERROR;
 	}
-	knot_dname_to_lower(*nsec3_name);
-
-	assert(zone->apex->owner != NULL);
-	knot_dname_t *ret = knot_dname_cat(*nsec3_name, zone->apex->owner);
-
-	if (ret == NULL) {
-		dbg_zone("Error while creating NSEC3 domain name for "
-			 "hashed name.\n");
-		knot_dname_release(*nsec3_name);
-		return KNOT_ERROR;
-	}
-
-	assert(ret == *nsec3_name);
 
 	return KNOT_EOK;
 }
@@ -1044,6 +1118,49 @@ void knot_zone_contents_enable_any(knot_zone_contents_t *contents)
 
 /*----------------------------------------------------------------------------*/
 
+int knot_zone_contents_wire_enabled(const knot_zone_contents_t *contents)
+{
+	return ((contents->flags & KNOT_ZONE_FLAGS_WIRE_MASK)
+		== KNOT_ZONE_FLAGS_WIRE);
+}
+
+/*----------------------------------------------------------------------------*/
+
+int knot_zone_contents_enable_wire(knot_zone_contents_t *contents)
+{
+	if (contents == NULL) {
+		return KNOT_EINVAL;
+	}
+
+	contents->flags |= KNOT_ZONE_FLAGS_WIRE;
+
+	int ret = KNOT_EOK;
+	knot_zone_contents_tree_apply_inorder(contents,
+		knot_zone_contents_prepare_wire_in_tree, &ret);
+	knot_zone_contents_nsec3_apply_inorder(contents,
+		knot_zone_contents_prepare_wire_in_tree, &ret);
+
+	return ret;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int knot_zone_contents_create_arena(knot_zone_contents_t *contents)
+{
+	if (contents == NULL || contents->arena != NULL) {
+		return KNOT_EINVAL;
+	}
+
+	contents->arena = arena_new();
+	if (contents->arena == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	return KNOT_EOK;
+}
+
+/*----------------------------------------------------------------------------*/
+
 uint16_t knot_zone_contents_class(const knot_zone_contents_t *contents)
 {
 	if (contents == NULL || contents->apex == NULL
@@ -1102,7 +1219,7 @@ dbg_zone_exec_detail(
 		return KNOT_EOK;
 	}
 
-	if (knot_dname_compare(knot_node_owner(zone->apex), chopped) == 0) {
+	if (knot_dname_is_equal(knot_node_owner(zone->apex), chopped)) {
 		dbg_zone_detail("Zone apex is the parent.\n");
 		knot_node_set_parent(node, zone->apex);
 
@@ -1550,7 +1667,7 @@ dbg_zone_exec_verb(
 	free(zone_str);
 );
 
-	if (knot_dname_compare(name, zone->apex->owner) == 0) {
+	if (knot_dname_is_equal(name, zone->apex->owner)) {
 		*node = zone->apex;
 		*closest_encloser = *node;
 		return KNOT_ZONE_NAME_FOUND;
@@ -1699,8 +1816,10 @@ int knot_zone_contents_find_nsec3_for_name(const knot_zone_contents_t *zone,
 		return KNOT_EINVAL;
 	}
 
-	knot_dname_t *nsec3_name = NULL;
-	int ret = knot_zone_contents_nsec3_name(zone, name, &nsec3_name);
+	uint8_t nsec3_wire[KNOT_MAX_DNAME_LENGTH];
+	knot_dname_t nsec3_name;
+	int ret = knot_zone_contents_nsec3_lookup_name(zone, name, nsec3_wire,
+	                                               &nsec3_name);
 
 	if (ret != KNOT_EOK) {
 		return ret;
@@ -1709,25 +1828,15 @@ int knot_zone_contents_find_nsec3_for_name(const knot_zone_contents_t *zone,
 	// check if the NSEC3 tree is not empty
 	if (knot_zone_tree_weight(zone->nsec3_nodes) == 0) {
 		dbg_zone("NSEC3 tree is empty.\n");
-		knot_dname_release(nsec3_name);
 		return KNOT_ENSEC3CHAIN;
 	}
 
-dbg_zone_exec_verb(
-	char *n = knot_dname_to_str(nsec3_name);
-	dbg_zone_verb("NSEC3 node name: %s.\n", n);
-	free(n);
-);
-
 	const knot_node_t *found = NULL, *prev = NULL;
 
-	// create dummy node to use for lookup
 	int exact_match = knot_zone_tree_find_less_or_equal(
-		zone->nsec3_nodes, nsec3_name, &found, &prev);
+		zone->nsec3_nodes, &nsec3_name, &found, &prev);
 	assert(exact_match >= 0);
 
-	knot_dname_release(nsec3_name);
-
 dbg_zone_exec_detail(
 	if (found) {
 		char *n = knot_dname_to_str(found->owner);
@@ -1855,9 +1964,14 @@ int knot_zone_contents_adjust(knot_zone_contents_t *zone,
 		return KNOT_EINVAL;
 	}
 
-	/* Heal zone indexes. */
-	hattrie_build_index(zone->nodes);
-	hattrie_build_index(zone->nsec3_nodes);
+	/* Build zone indexes (no-op if built, updates keep them sorted). */
+	int ret = hattrie_build_index(zone->nodes);
+	if (ret == KNOT_EOK) {
+		ret = hattrie_build_index(zone->nsec3_nodes);
+	}
+	if (ret != KNOT_EOK) {
+		return ret;
+	}
 
 	// load NSEC3PARAM (needed on adjusting function)
 	knot_zone_contents_load_nsec3param(zone);
@@ -1883,7 +1997,7 @@ int knot_zone_contents_adjust(knot_zone_contents_t *zone,
 	 * the search functions.
 	 */
 	dbg_zone("Setting 'prev' pointers to NSEC3 nodes.\n");
-	int ret = knot_zone_tree_apply_inorder(zone->nsec3_nodes,
+	ret = knot_zone_tree_apply_inorder(zone->nsec3_nodes,
 		 knot_zone_contents_adjust_nsec3_node_in_tree_ptr, &adjust_arg);
 	assert(ret == KNOT_EOK);
 
@@ -2012,10 +2126,17 @@ int knot_zone_contents_load_nsec3param(knot_zone_contents_t *zone)
 			         knot_strerror(r));
 			return r;
 		}
+		/* Hashes are cached per zone, zone works without cache too. */
+		if (zone->nsec3_cache == NULL) {
+			zone->nsec3_cache = knot_nsec3_cache_new();
+		}
 	} else {
 		memset(&zone->nsec3_params, 0, sizeof(knot_nsec3_params_t));
 	}
 
+	/* Parameters may have changed. */
+	knot_nsec3_cache_clear(zone->nsec3_cache);
+
 	return KNOT_EOK;
 }
 
@@ -2049,6 +2170,18 @@ const knot_nsec3_params_t *knot_zone_contents_nsec3params(
 
 /*----------------------------------------------------------------------------*/
 
+const knot_nsec3_cache_t *knot_zone_contents_nsec3_cache(
+	const knot_zone_contents_t *zone)
+{
+	if (zone == NULL) {
+		return NULL;
+	}
+
+	return zone->nsec3_cache;
+}
+
+/*----------------------------------------------------------------------------*/
+
 int knot_zone_contents_tree_apply_inorder(knot_zone_contents_t *zone,
 			      void (*function)(knot_node_t *node, void *data),
                               void *data)
@@ -2165,6 +2298,9 @@ int knot_zone_contents_shallow_copy(const knot_zone_contents_t *from,
 
 	contents->zone = from->zone;
 
+	/* RRSets are shared with the original. */
+	contents->arena = from->arena;
+
 	/* Initialize NSEC3 params */
 	memcpy(&contents->nsec3_params, &from->nsec3_params,
 	       sizeof(knot_nsec3_params_t));
@@ -2178,6 +2314,7 @@ int knot_zone_contents_shallow_copy(const knot_zone_contents_t *from,
 
 	dbg_zone("knot_zone_contents_shallow_copy: finished OK\n");
 
+	arena_retain(contents->arena);
 	*to = contents;
 	return KNOT_EOK;
 
@@ -2229,6 +2366,10 @@ int knot_zone_contents_shallow_copy2(const knot_zone_contents_t *from,
 
 	contents->apex = knot_node_get_new_node(from->apex);
 
+	/* RRSets are shared with the original. */
+	contents->arena = from->arena;
+	arena_retain(contents->arena);
+
 	dbg_zone("knot_zone_contents_shallow_copy: finished OK\n");
 
 	*to = contents;
@@ -2254,6 +2395,8 @@ void knot_zone_contents_free(knot_zone_contents_t **contents)
 	knot_zone_tree_free(&(*contents)->nsec3_nodes);
 
 	knot_nsec3_params_free(&(*contents)->nsec3_params);
+	knot_nsec3_cache_free(&(*contents)->nsec3_cache);
+	arena_release((*contents)->arena);
 
 	free(*contents);
 	*contents = NULL;
@@ -2291,6 +2434,10 @@ void knot_zone_contents_deep_free(knot_zone_contents_t **contents)
 		knot_zone_tree_free(&(*contents)->nsec3_nodes);
 
 		knot_nsec3_params_free(&(*contents)->nsec3_params);
+		knot_nsec3_cache_free(&(*contents)->nsec3_cache);
+
+		/* Nodes and RRSets from the arena are freed at once. */
+		arena_release((*contents)->arena);
 	}
 
 	free((*contents));
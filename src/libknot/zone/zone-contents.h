@@ -32,6 +32,7 @@
 #include "nsec3.h"
 
 #include "zone-tree.h"
+#include "common/arena.h"
 
 struct knot_zone;
 
@@ -46,6 +47,15 @@ typedef struct knot_zone_contents_t {
 	struct knot_zone *zone;
 
 	knot_nsec3_params_t nsec3_params;
+	knot_nsec3_cache_t *nsec3_cache; /*!< Cache of NSEC3 hashes. */
+
+	/*!
+	 * \brief Arena with nodes and RRSets from the last full load.
+	 *
+	 * Updated versions of the zone share the arena with the original
+	 * one, each version holds a reference.
+	 */
+	arena_t *arena;
 
 	/*!
 	 * \todo Unify the use of this field - authoritative nodes vs. all.
@@ -65,6 +75,10 @@ typedef struct knot_zone_contents_t {
 	 * The third bit denotes whether ANY queries are enabled or disabled:
 	 * - 1xx - ANY queries disabled
 	 * - 0xx - ANY queries enabled
+	 *
+	 * The fourth bit denotes whether RRSets keep pre-rendered RDATA:
+	 * - 1xxx - RDATA are pre-rendered when the zone is adjusted
+	 * - 0xxx - RDATA are rendered for each response
 	 */
 	uint8_t flags;
 } knot_zone_contents_t;
@@ -87,6 +101,38 @@ int knot_zone_contents_any_disabled(const knot_zone_contents_t *contents);
 void knot_zone_contents_disable_any(knot_zone_contents_t *contents);
 void knot_zone_contents_enable_any(knot_zone_contents_t *contents);
 
+int knot_zone_contents_wire_enabled(const knot_zone_contents_t *contents);
+
+/*!
+ * \brief Enables pre-rendered RDATA for all RRSets in the zone.
+ *
+ * Pre-rendered RDATA are then created for changed RRSets each time the zone
+ * is adjusted.
+ *
+ * \see knot_rrset_wire_prepare()
+ *
+ * \param contents Zone contents.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int knot_zone_contents_enable_wire(knot_zone_contents_t *contents);
+
+/*!
+ * \brief Creates arena for nodes and RRSets of a zone being loaded.
+ *
+ * The loader should enter the arena (arena_enter()) while creating zone
+ * data. The arena is freed with the last version of the zone using it.
+ *
+ * \param contents Empty zone contents.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ENOMEM
+ */
+int knot_zone_contents_create_arena(knot_zone_contents_t *contents);
+
 uint16_t knot_zone_contents_class(const knot_zone_contents_t *contents);
 
 /*!
@@ -366,6 +412,16 @@ int knot_zone_contents_nsec3_enabled(const knot_zone_contents_t *contents);
 const knot_nsec3_params_t *knot_zone_contents_nsec3params(
 	const knot_zone_contents_t *contents);
 
+/*!
+ * \brief Returns cache of NSEC3 hashes of the zone.
+ *
+ * \param contents Zone to get the cache from.
+ *
+ * \return Hash cache or NULL if the zone does not use NSEC3.
+ */
+const knot_nsec3_cache_t *knot_zone_contents_nsec3_cache(
+	const knot_zone_contents_t *contents);
+
 /*!
  * \brief Applies the given function to each regular node in the zone.
  *
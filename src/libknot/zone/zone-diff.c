@@ -18,6 +18,9 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "libknot/util/debug.h"
 #include "common/errcode.h"
@@ -25,12 +28,39 @@
 #include "libknot/nameserver/name-server.h"
 #include "common/descriptor.h"
 
-struct zone_diff_param {
-	const knot_zone_contents_t *contents;
-	char nsec3;
-	knot_changeset_t *changeset;
+/*! \brief Minimal number of nodes per range diffed by one thread. */
+#define ZONE_DIFF_RANGE_MIN 8192
+
+/*! \brief Maximal number of threads diffing the zone. */
+#define ZONE_DIFF_THREADS_MAX 16
+
+/*! \brief RRSets with at least this many RRs are compared using hashes. */
+#define ZONE_DIFF_HASH_MIN 16
+
+/*! \brief RRs of an RRSet indexed by RDATA hash. */
+typedef struct {
+	uint32_t *hashes; /*!< RDATA hashes of the RRs. */
+	uint32_t *slots;  /*!< RR positions increased by one, 0 is empty. */
+	uint32_t mask;    /*!< Number of slots minus one. */
+} zone_diff_rr_index_t;
+
+/*! \brief Zone nodes in the tree order. */
+typedef struct {
+	knot_node_t **array;
+	size_t count;
+	size_t size;
+	int ret;
+} zone_diff_nodes_t;
+
+/*! \brief Range of nodes diffed by one thread. */
+typedef struct {
+	knot_node_t **nodes1;       /*!< Nodes from the first zone. */
+	size_t count1;
+	knot_node_t **nodes2;       /*!< Nodes from the second zone. */
+	size_t count2;
+	knot_changeset_t changeset; /*!< Differences within the range. */
 	int ret;
-};
+} zone_diff_range_t;
 
 // forward declaration
 static int knot_zone_diff_rdata(const knot_rrset_t *rrset1,
@@ -328,6 +358,64 @@ dbg_zonediff_exec_detail(
 	return KNOT_EOK;
 }
 
+static void knot_zone_diff_rr_index_free(zone_diff_rr_index_t *index)
+{
+	free(index->hashes);
+	free(index->slots);
+	memset(index, 0, sizeof(zone_diff_rr_index_t));
+}
+
+/*! \brief Builds open addressing table of RRs hashed by RDATA. */
+static int knot_zone_diff_rr_index(zone_diff_rr_index_t *index,
+                                   const knot_rrset_t *rrset)
+{
+	uint16_t count = knot_rrset_rdata_rr_count(rrset);
+	size_t size = 1;
+	while (size < 2 * (size_t)count) {
+		size *= 2;
+	}
+
+	index->hashes = malloc(count * sizeof(uint32_t));
+	index->slots = calloc(size, sizeof(uint32_t));
+	if (index->hashes == NULL || index->slots == NULL) {
+		knot_zone_diff_rr_index_free(index);
+		return KNOT_ENOMEM;
+	}
+	index->mask = size - 1;
+
+	for (uint16_t i = 0; i < count; ++i) {
+		uint32_t hash = knot_rrset_rdata_hash(rrset, i);
+		uint32_t slot = hash & index->mask;
+		while (index->slots[slot] != 0) {
+			slot = (slot + 1) & index->mask;
+		}
+		index->hashes[i] = hash;
+		index->slots[slot] = i + 1;
+	}
+
+	return KNOT_EOK;
+}
+
+/*! \brief Looks up RR from the reference RRSet in the indexed RRSet. */
+static int knot_zone_diff_rr_find(const zone_diff_rr_index_t *index,
+                                  const knot_rrset_t *rrset,
+                                  const knot_rrset_t *reference, size_t pos)
+{
+	uint32_t hash = knot_rrset_rdata_hash(reference, pos);
+	uint32_t slot = hash & index->mask;
+	while (index->slots[slot] != 0) {
+		size_t i = index->slots[slot] - 1;
+		if (index->hashes[i] == hash &&
+		    knot_rrset_rdata_compare_one(rrset, reference,
+		                                 i, pos) == 0) {
+			return KNOT_EOK;
+		}
+		slot = (slot + 1) & index->mask;
+	}
+
+	return KNOT_ENOENT;
+}
+
 static int knot_zone_diff_rdata_return_changes(const knot_rrset_t *rrset1,
                                                const knot_rrset_t *rrset2,
                                                knot_rrset_t **changes)
@@ -343,7 +431,8 @@ static int knot_zone_diff_rdata_return_changes(const knot_rrset_t *rrset1,
 	* looking for an exact match. If no match occurs, it means that this
 	* particular RR has changed.
 	* After the list has been traversed, we have a list of
-	* changed/removed rdatas. This has awful computation time.
+	* changed/removed rdatas. Large second lists are indexed by
+	* RDATA hash, so the search is not quadratic.
 	*/
 	dbg_zonediff_detail("zone_diff: diff_rdata: Diff of %s, type=%u. "
 	              "RR count 1=%d RR count 2=%d.\n",
@@ -366,9 +455,26 @@ static int knot_zone_diff_rdata_return_changes(const knot_rrset_t *rrset1,
 		get_rdata_descriptor(knot_rrset_type(rrset1));
 	assert(desc);
 
+	/* Index large RRSets by RDATA hash instead of searching linearly. */
+	zone_diff_rr_index_t index;
+	memset(&index, 0, sizeof(index));
+	if (knot_rrset_rdata_rr_count(rrset1) >= ZONE_DIFF_HASH_MIN &&
+	    knot_rrset_rdata_rr_count(rrset2) >= ZONE_DIFF_HASH_MIN) {
+		int ret = knot_zone_diff_rr_index(&index, rrset2);
+		if (ret != KNOT_EOK) {
+			knot_rrset_free(changes);
+			return ret;
+		}
+	}
+
 	for (uint16_t i = 0; i < knot_rrset_rdata_rr_count(rrset1); ++i) {
 		size_t rr_pos = 0;
-		int ret = knot_rrset_find_rr_pos(rrset2, rrset1, i, &rr_pos);
+		int ret = KNOT_EOK;
+		if (index.slots != NULL) {
+			ret = knot_zone_diff_rr_find(&index, rrset2, rrset1, i);
+		} else {
+			ret = knot_rrset_find_rr_pos(rrset2, rrset1, i, &rr_pos);
+		}
 		if (ret == KNOT_ENOENT) {
 			/* No such RR is present in 'rrset2'. */
 			dbg_zonediff("zone_diff: diff_rdata: "
@@ -381,6 +487,7 @@ static int knot_zone_diff_rdata_return_changes(const knot_rrset_t *rrset1,
 				dbg_zonediff("zone_diff: diff_rdata: Could not"
 				             " add RR to RRSet (%s).\n",
 				             knot_strerror(ret));
+				knot_zone_diff_rr_index_free(&index);
 				knot_rrset_free(changes);
 				return ret;
 			}
@@ -392,11 +499,14 @@ static int knot_zone_diff_rdata_return_changes(const knot_rrset_t *rrset1,
 		} else {
 			dbg_zonediff("zone_diff: diff_rdata: Could not search "
 			             "for RR (%s).\n", knot_strerror(ret));
+			knot_zone_diff_rr_index_free(&index);
 			knot_rrset_free(changes);
 			return ret;
 		}
 	}
 
+	knot_zone_diff_rr_index_free(&index);
+
 	return KNOT_EOK;
 }
 
@@ -599,64 +709,19 @@ static int knot_zone_diff_rrsets(const knot_rrset_t *rrset1,
 }
 
 /*!< \todo this could be generic function for adding / removing. */
-static void knot_zone_diff_node(knot_node_t *node, void *data)
+static int knot_zone_diff_node(const knot_node_t *node,
+                               const knot_node_t *node_in_second_tree,
+                               knot_changeset_t *changeset)
 {
-	if (node == NULL || data == NULL) {
-		dbg_zonediff("zone_diff: diff_node: NULL arguments.\n");
-		return;
-	}
-
-	struct zone_diff_param *param = (struct zone_diff_param *)data;
-	if (param->changeset == NULL || param->contents == NULL) {
+	if (node == NULL || node_in_second_tree == NULL || changeset == NULL) {
 		dbg_zonediff("zone_diff: diff_node: NULL arguments.\n");
-		param->ret = KNOT_EINVAL;
-		return;
-	}
-
-	if (param->ret != KNOT_EOK) {
-		/* Error occured before, no point in continuing. */
-		dbg_zonediff_detail("zone_diff: diff_node: error: %s\n",
-		                    knot_strerror(param->ret));
-		return;
-	}
-
-	/*
-	 * First, we have to search the second tree to see if there's according
-	 * node, if not, the whole node has been removed.
-	 */
-	const knot_node_t *node_in_second_tree = NULL;
-	const knot_dname_t *node_owner = knot_node_owner(node);
-	assert(node_owner);
-	if (!param->nsec3) {
-		node_in_second_tree =
-			knot_zone_contents_find_node(param->contents,
-			                             node_owner);
-	} else {
-		dbg_zonediff_verb("zone_diff: diff_node: NSEC3 zone.\n");
-		node_in_second_tree =
-			knot_zone_contents_find_nsec3_node(param->contents,
-			                                   node_owner);
-	}
-
-	if (node_in_second_tree == NULL) {
-		dbg_zonediff_detail("zone_diff: diff_node: Node %s is not "
-		              "in the second tree.\n",
-		              knot_dname_to_str(node_owner));
-		int ret = knot_zone_diff_remove_node(param->changeset,
-		                                               node);
-		if (ret != KNOT_EOK) {
-			dbg_zonediff("zone_diff: failed to remove node.\n");
-			param->ret = ret;
-			return;
-		}
-		param->ret = KNOT_EOK;
-		return;
+		return KNOT_EINVAL;
 	}
 
 	assert(node_in_second_tree != node);
 
 	dbg_zonediff_detail("zone_diff: diff_node: Node %s is present in "
-	              "both trees.\n", knot_dname_to_str(node_owner));
+	              "both trees.\n", knot_dname_to_str(node->owner));
 	/* The nodes are in both trees, we have to diff each RRSet. */
 	const knot_rrset_t **rrsets = knot_node_rrsets(node);
 	if (rrsets == NULL) {
@@ -666,14 +731,13 @@ static void knot_zone_diff_node(knot_node_t *node, void *data)
 		 * in the second tree will have to be inserted to ADD section.
 		 */
 		int ret = knot_zone_diff_add_node(node_in_second_tree,
-		                                  param->changeset);
+		                                  changeset);
 		if (ret != KNOT_EOK) {
 			dbg_zonediff("zone_diff: diff_node: "
 			             "Could not add node from second tree. "
 			             "Reason: %s.\n", knot_strerror(ret));
 		}
-		param->ret = ret;
-		return;
+		return ret;
 	}
 
 	for (uint i = 0; i < knot_node_rrset_count(node); i++) {
@@ -694,29 +758,26 @@ static void knot_zone_diff_node(knot_node_t *node, void *data)
 			       "for RRSet of type %u in second tree.\n",
 			       knot_rrset_type(rrset));
 			/* RRSet has been removed. Make a copy and remove. */
-			assert(rrset);
 			int ret = knot_zone_diff_changeset_remove_rrset(
-				param->changeset,
+				changeset,
 				rrset);
 			if (ret != KNOT_EOK) {
 				dbg_zonediff("zone_diff: diff_node: "
 				             "Failed to remove RRSet.\n");
-				param->ret = ret;
 				free(rrsets);
-				return;
+				return ret;
 			}
 
 			/* Remove RRSet's RRSIGs as well. */
 			if (knot_rrset_rrsigs(rrset)) {
 				ret = knot_zone_diff_changeset_remove_rrset(
-				            param->changeset,
+				            changeset,
 				            knot_rrset_rrsigs(rrset));
 				if (ret != KNOT_EOK) {
-				    dbg_zonediff("zone_diff: diff_node+: "
-				                 "Failed to remove RRSIGs.\n");
-				    param->ret = ret;
-				    free(rrsets);
-				    return;
+					dbg_zonediff("zone_diff: diff_node+: "
+					             "Failed to remove RRSIGs.\n");
+					free(rrsets);
+					return ret;
 				}
 			}
 		} else {
@@ -726,27 +787,13 @@ static void knot_zone_diff_node(knot_node_t *node, void *data)
 			/* Diff RRSets. */
 			int ret = knot_zone_diff_rrsets(rrset,
 			                                rrset_from_second_node,
-			                                param->changeset);
+			                                changeset);
 			if (ret != KNOT_EOK) {
 				dbg_zonediff("zone_diff: "
 				             "Failed to diff RRSets.\n");
-				param->ret = ret;
 				free(rrsets);
-				return;
+				return ret;
 			}
-
-//			dbg_zonediff_verb("zone_diff: diff_node: Changes in "
-//			            "RRSIGs.\n");
-//			/*! \todo There is ad-hoc solution in the function, maybe handle here. */
-//			ret = knot_zone_diff_rrsets(rrset->rrsigs,
-//			                                rrset_from_second_node->rrsigs,
-//			                                param->changeset);
-//			if (ret != KNOT_EOK) {
-//				dbg_zonediff("zone_diff: "
-//				             "Failed to diff RRSIGs.\n");
-//				param->ret = ret;
-//				return;
-//			}
 		}
 	}
 
@@ -763,15 +810,7 @@ static void knot_zone_diff_node(knot_node_t *node, void *data)
 		 */
 		// TODO following code creates duplicated RR in diff.
 		// IHMO such case should be handled here
-//		int ret = knot_zone_diff_remove_node(param->changeset,
-//		                                     node);
-//		if (ret != KNOT_EOK) {
-//			dbg_zonediff("zone_diff: diff_node: "
-//			             "Cannot remove node. Reason: %s.\n",
-//			             knot_strerror(ret));
-//		}
-		param->ret = KNOT_EOK;
-		return;
+		return KNOT_EOK;
 	}
 
 	for (uint i = 0; i < knot_node_rrset_count(node_in_second_tree); i++) {
@@ -787,103 +826,284 @@ static void knot_zone_diff_node(knot_node_t *node, void *data)
 		const knot_rrset_t *rrset_from_first_node =
 			knot_node_rrset(node,
 			                knot_rrset_type(rrset));
-		if (rrset_from_first_node == NULL) {
-			dbg_zonediff("zone_diff: diff_node: There is no counterpart "
-			       "for RRSet of type %u in first tree.\n",
-			       knot_rrset_type(rrset));
-			/* RRSet has been added. Make a copy and add. */
-			assert(rrset);
-			int ret = knot_zone_diff_changeset_add_rrset(
-				param->changeset,
-				rrset);
+		if (rrset_from_first_node != NULL) {
+			/* Already handled. */
+			continue;
+		}
+
+		dbg_zonediff("zone_diff: diff_node: There is no counterpart "
+		       "for RRSet of type %u in first tree.\n",
+		       knot_rrset_type(rrset));
+		/* RRSet has been added. Make a copy and add. */
+		int ret = knot_zone_diff_changeset_add_rrset(changeset, rrset);
+		if (ret != KNOT_EOK) {
+			dbg_zonediff("zone_diff: diff_node: "
+			             "Failed to add RRSet.\n");
+			free(rrsets);
+			return ret;
+		}
+		if (knot_rrset_rrsigs(rrset)) {
+			ret = knot_zone_diff_changeset_add_rrset(changeset,
+			                knot_rrset_rrsigs(rrset));
 			if (ret != KNOT_EOK) {
 				dbg_zonediff("zone_diff: diff_node: "
-				             "Failed to add RRSet.\n");
-				param->ret = ret;
+				             "Failed to add RRSIGs.\n");
 				free(rrsets);
-				return;
-			}
-			if (knot_rrset_rrsigs(rrset)) {
-				int ret = knot_zone_diff_changeset_add_rrset(
-			        param->changeset,
-			         knot_rrset_rrsigs(rrset));
-			   if (ret != KNOT_EOK) {
-			     dbg_zonediff("zone_diff: diff_node: "
-			            "Failed to add RRSIGs.\n");
-			    param->ret = ret;
-					free(rrsets);
-				return;
-			 }
+				return ret;
 			}
-		} else {
-			/* Already handled. */
-			;
 		}
 	}
 
 	free(rrsets);
 
-	assert(param->ret == KNOT_EOK);
+	return KNOT_EOK;
 }
 
-/*!< \todo possibly not needed! */
-static void knot_zone_diff_add_new_nodes(knot_node_t *node, void *data)
+/*! \brief Collects nodes in the tree order. */
+static void knot_zone_diff_collect(knot_node_t **node, void *data)
 {
-	assert(node);
-	if (node == NULL || data == NULL) {
-		dbg_zonediff("zone_diff: add_new_nodes: NULL arguments.\n");
+	zone_diff_nodes_t *nodes = (zone_diff_nodes_t *)data;
+	if (nodes->ret != KNOT_EOK) {
 		return;
 	}
 
-	struct zone_diff_param *param = (struct zone_diff_param *)data;
-	if (param->changeset == NULL || param->contents == NULL) {
-		dbg_zonediff("zone_diff: add_new_nodes: NULL arguments.\n");
-		param->ret = KNOT_EINVAL;
-		return;
+	if (nodes->count == nodes->size) {
+		size_t size = nodes->size > 0 ? 2 * nodes->size : 1024;
+		knot_node_t **array = realloc(nodes->array,
+		                              size * sizeof(knot_node_t *));
+		if (array == NULL) {
+			nodes->ret = KNOT_ENOMEM;
+			return;
+		}
+		nodes->array = array;
+		nodes->size = size;
 	}
 
-	if (param->ret != KNOT_EOK) {
-		/* Error occured before, no point in continuing. */
-		dbg_zonediff_detail("zone_diff: add_new_nodes: error: %s\n",
-		                    knot_strerror(param->ret));
-		return;
+	nodes->array[nodes->count++] = *node;
+}
+
+/*! \brief Compares zone tree keys, see knot_zone_tree_key(). */
+static int knot_zone_diff_key_cmp(const uint8_t *key1, const uint8_t *key2)
+{
+	size_t len = key1[0] < key2[0] ? key1[0] : key2[0];
+	int cmp = memcmp(key1 + 1, key2 + 1, len);
+	return cmp != 0 ? cmp : (int)key1[0] - (int)key2[0];
+}
+
+/*! \brief Finds the first node not lower than the given key. */
+static size_t knot_zone_diff_lower_bound(const zone_diff_nodes_t *nodes,
+                                         const uint8_t *key)
+{
+	uint8_t node_key[KNOT_ZONE_TREE_KEY_SIZE];
+	size_t lo = 0, hi = nodes->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		knot_zone_tree_key(knot_node_owner(nodes->array[mid]),
+		                   node_key);
+		if (knot_zone_diff_key_cmp(node_key, key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
 	}
 
-	/*
-	* If a node is not present in the second zone, it is a new node
-	* and has to be added to changeset. Differencies on the RRSet level are
-	* already handled.
-	*/
-	const knot_zone_contents_t *other_zone = param->contents;
-	assert(other_zone);
+	return lo;
+}
 
-	const knot_dname_t *node_owner = knot_node_owner(node);
-	/*
-	 * Node should definitely have an owner, otherwise it would not be in
-	 * the tree.
-	 */
-	assert(node_owner);
+/*!
+ * \brief Diffs a range of nodes.
+ *
+ * Both node arrays are walked at once in the tree order. Node present only
+ * in the first array was removed, node present only in the second one
+ * was added, nodes present in both are compared.
+ */
+static int knot_zone_diff_range(zone_diff_range_t *range)
+{
+	uint8_t key1[KNOT_ZONE_TREE_KEY_SIZE];
+	uint8_t key2[KNOT_ZONE_TREE_KEY_SIZE];
+	size_t key1_pos = SIZE_MAX, key2_pos = SIZE_MAX;
+	size_t i = 0, j = 0;
+	int ret = KNOT_EOK;
+	while (ret == KNOT_EOK && (i < range->count1 || j < range->count2)) {
+		int cmp = 0;
+		if (i == range->count1) {
+			cmp = 1;
+		} else if (j == range->count2) {
+			cmp = -1;
+		} else {
+			/* Keys are built once per node. */
+			if (key1_pos != i) {
+				knot_zone_tree_key(
+					knot_node_owner(range->nodes1[i]), key1);
+				key1_pos = i;
+			}
+			if (key2_pos != j) {
+				knot_zone_tree_key(
+					knot_node_owner(range->nodes2[j]), key2);
+				key2_pos = j;
+			}
+			cmp = knot_zone_diff_key_cmp(key1, key2);
+		}
 
-	knot_node_t *new_node = NULL;
-	if (!param->nsec3) {
-		new_node = knot_zone_contents_get_node(other_zone, node_owner);
-	} else {
-		new_node = knot_zone_contents_get_nsec3_node(other_zone,
-		                                             node_owner);
+		if (cmp < 0) {
+			ret = knot_zone_diff_remove_node(&range->changeset,
+			                                 range->nodes1[i++]);
+		} else if (cmp > 0) {
+			ret = knot_zone_diff_add_node(range->nodes2[j++],
+			                              &range->changeset);
+		} else {
+			ret = knot_zone_diff_node(range->nodes1[i++],
+			                          range->nodes2[j++],
+			                          &range->changeset);
+		}
 	}
 
-	if (!new_node) {
-		assert(node);
-		int ret = knot_zone_diff_add_node(node, param->changeset);
+	return ret;
+}
+
+static void *knot_zone_diff_range_thread(void *data)
+{
+	zone_diff_range_t *range = (zone_diff_range_t *)data;
+	range->ret = knot_zone_diff_range(range);
+	return NULL;
+}
+
+/*! \brief Moves range differences to the resulting changeset. */
+static int knot_zone_diff_range_merge(zone_diff_range_t *range,
+                                      knot_changeset_t *changeset)
+{
+	int ret = KNOT_EOK;
+	knot_changeset_t *from = &range->changeset;
+	for (size_t i = 0; i < from->remove_count; ++i) {
+		if (ret == KNOT_EOK) {
+			ret = knot_changeset_add_new_rr(changeset,
+			                                from->remove[i],
+			                                KNOT_CHANGESET_REMOVE);
+		}
 		if (ret != KNOT_EOK) {
-			dbg_zonediff("zone_diff: add_new_nodes: Cannot add "
-			             "node: %s to changeset. Reason: %s.\n",
-			             knot_dname_to_str(node->owner),
-			             knot_strerror(ret));
+			knot_rrset_deep_free(&from->remove[i], 1, 1);
+		}
+	}
+	for (size_t i = 0; i < from->add_count; ++i) {
+		if (ret == KNOT_EOK) {
+			ret = knot_changeset_add_new_rr(changeset,
+			                                from->add[i],
+			                                KNOT_CHANGESET_ADD);
+		}
+		if (ret != KNOT_EOK) {
+			knot_rrset_deep_free(&from->add[i], 1, 1);
 		}
 	}
 
-	assert(param->ret == KNOT_EOK);
+	free(from->remove);
+	free(from->add);
+	memset(from, 0, sizeof(knot_changeset_t));
+
+	return ret;
+}
+
+/*!
+ * \brief Diffs two zone trees.
+ *
+ * Nodes of both trees are collected in the tree order and the key space is
+ * split into ranges of about the same number of nodes. Ranges are diffed
+ * in parallel into private changesets, which are then merged in the tree
+ * order, so the result doesn't depend on the number of threads.
+ */
+static int knot_zone_diff_trees(knot_zone_tree_t *tree1,
+                                knot_zone_tree_t *tree2,
+                                knot_changeset_t *changeset)
+{
+	zone_diff_nodes_t nodes1, nodes2;
+	memset(&nodes1, 0, sizeof(nodes1));
+	memset(&nodes2, 0, sizeof(nodes2));
+	knot_zone_tree_apply_inorder(tree1, knot_zone_diff_collect, &nodes1);
+	knot_zone_tree_apply_inorder(tree2, knot_zone_diff_collect, &nodes2);
+	int ret = nodes1.ret != KNOT_EOK ? nodes1.ret : nodes2.ret;
+	if (ret != KNOT_EOK) {
+		free(nodes1.array);
+		free(nodes2.array);
+		return ret;
+	}
+
+	/* Do not spawn threads that would have nothing to do. */
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t count = (nodes1.count + nodes2.count) / ZONE_DIFF_RANGE_MIN;
+	if (threads > ZONE_DIFF_THREADS_MAX) {
+		threads = ZONE_DIFF_THREADS_MAX;
+	}
+	if (threads < 1 || nodes1.count == 0) {
+		threads = 1;
+	}
+	if (count > (size_t)threads) {
+		count = threads;
+	}
+	if (count < 1) {
+		count = 1;
+	}
+
+	zone_diff_range_t *ranges = calloc(count, sizeof(zone_diff_range_t));
+	pthread_t *thr = calloc(count, sizeof(pthread_t));
+	if (ranges == NULL || thr == NULL) {
+		free(ranges);
+		free(thr);
+		free(nodes1.array);
+		free(nodes2.array);
+		return KNOT_ENOMEM;
+	}
+
+	/* Split the first tree evenly, find the same keys in the second. */
+	uint8_t key[KNOT_ZONE_TREE_KEY_SIZE];
+	size_t begin1 = 0, begin2 = 0;
+	for (size_t r = 0; r < count; ++r) {
+		size_t end1 = nodes1.count, end2 = nodes2.count;
+		if (r + 1 < count) {
+			end1 = (r + 1) * nodes1.count / count;
+			knot_zone_tree_key(knot_node_owner(nodes1.array[end1]),
+			                   key);
+			end2 = knot_zone_diff_lower_bound(&nodes2, key);
+		}
+		ranges[r].nodes1 = nodes1.array + begin1;
+		ranges[r].count1 = end1 - begin1;
+		ranges[r].nodes2 = nodes2.array + begin2;
+		ranges[r].count2 = end2 - begin2;
+		begin1 = end1;
+		begin2 = end2;
+	}
+
+	/* The first range is diffed by the calling thread. */
+	size_t started = 1;
+	for (; started < count; ++started) {
+		if (pthread_create(&thr[started], NULL,
+		                   knot_zone_diff_range_thread,
+		                   &ranges[started]) != 0) {
+			break;
+		}
+	}
+	ranges[0].ret = knot_zone_diff_range(&ranges[0]);
+	for (size_t r = 1; r < started; ++r) {
+		pthread_join(thr[r], NULL);
+	}
+	for (size_t r = started; r < count; ++r) {
+		ranges[r].ret = knot_zone_diff_range(&ranges[r]);
+	}
+
+	for (size_t r = 0; r < count; ++r) {
+		if (ret == KNOT_EOK) {
+			ret = ranges[r].ret;
+		}
+		int merged = knot_zone_diff_range_merge(&ranges[r], changeset);
+		if (ret == KNOT_EOK) {
+			ret = merged;
+		}
+	}
+
+	free(ranges);
+	free(thr);
+	free(nodes1.array);
+	free(nodes2.array);
+
+	return ret;
 }
 
 int knot_zone_contents_diff(const knot_zone_contents_t *zone1,
@@ -895,12 +1115,6 @@ int knot_zone_contents_diff(const knot_zone_contents_t *zone1,
 		return KNOT_EINVAL;
 	}
 
-//	/* Create changeset structure. */
-//	*changeset = malloc(sizeof(knot_changeset_t));
-//	if (*changeset == NULL) {
-//		ERR_ALLOC_FAILED;
-//		return KNOT_ENOMEM;
-//	}
 	memset(changeset, 0, sizeof(knot_changeset_t));
 
 	/* Settle SOAs first. */
@@ -913,63 +1127,20 @@ int knot_zone_contents_diff(const knot_zone_contents_t *zone1,
 
 	dbg_zonediff("zone_diff: SOAs loaded.\n");
 
-	/* Traverse one tree, compare every node, each RRSet with its rdata. */
-	struct zone_diff_param param;
-	param.contents = zone2;
-	param.nsec3 = 0;
-	param.changeset = changeset;
-	param.ret = KNOT_EOK;
-	ret = knot_zone_contents_tree_apply_inorder(
-	                        (knot_zone_contents_t *)zone1,
-	                        knot_zone_diff_node,
-	                        &param);
+	/* Walk both trees at once, compare every node present in both. */
+	ret = knot_zone_diff_trees(zone1->nodes, zone2->nodes, changeset);
 	if (ret != KNOT_EOK) {
 		dbg_zonediff("zone_diff: Tree traversal failed "
-		             "with error: %s. Error from inner function: %s\n",
-		             knot_strerror(ret),
-		             knot_strerror(param.ret));
+		             "with error: %s\n", knot_strerror(ret));
 		return ret;
 	}
 
 	/* Do the same for NSEC3 nodes. */
-	param.nsec3 = 1;
-	ret = knot_zone_contents_nsec3_apply_inorder((knot_zone_contents_t *)zone1, knot_zone_diff_node,
-	                                             &param);
-	if (ret != KNOT_EOK) {
-		dbg_zonediff("zone_diff: Tree traversal failed "
-		             "with error: %s\n",
-		             knot_strerror(ret));
-		return ret;
-	}
-
-	/*
-	 * Some nodes may have been added. The code above will not notice,
-	 * we have to go through the second tree and add missing nodes to
-	 * changeset.
-	 */
-	param.nsec3 = 0;
-	param.contents = zone1;
-	ret = knot_zone_contents_tree_apply_inorder((knot_zone_contents_t *)zone2,
-		knot_zone_diff_add_new_nodes,
-		&param);
-	if (ret != KNOT_EOK) {
-		dbg_zonediff("zone_diff: Tree traversal failed "
-		             "with error: %s. Error from inner function: %s\n",
-		             knot_strerror(ret),
-		             knot_strerror(param.ret));
-		return ret;
-	}
-
-	/* NSEC3 nodes. */
-	param.nsec3 = 1;
-	param.contents = zone1;
-	ret = knot_zone_contents_nsec3_apply_inorder((knot_zone_contents_t *)zone2,
-		knot_zone_diff_add_new_nodes,
-		&param);
+	ret = knot_zone_diff_trees(zone1->nsec3_nodes, zone2->nsec3_nodes,
+	                           changeset);
 	if (ret != KNOT_EOK) {
 		dbg_zonediff("zone_diff: Tree traversal failed "
-		             "with error: %s\n",
-		             knot_strerror(ret));
+		             "with error: %s\n", knot_strerror(ret));
 		return ret;
 	}
 
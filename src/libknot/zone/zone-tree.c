@@ -103,13 +103,25 @@ size_t knot_zone_tree_weight(knot_zone_tree_t* tree)
 
 /*----------------------------------------------------------------------------*/
 
+int knot_zone_tree_key(const knot_dname_t *owner, uint8_t *key)
+{
+	return dname_lf((char *)key, owner, KNOT_ZONE_TREE_KEY_SIZE);
+}
+
+/*----------------------------------------------------------------------------*/
+
 int knot_zone_tree_insert(knot_zone_tree_t *tree, knot_node_t *node)
 {
 	assert(tree && node && node->owner);
 	char lf[DNAME_LFT_MAXLEN];
 	dname_lf(lf, node->owner, sizeof(lf));
 
-	*hattrie_get(tree, lf+1, *lf) = node;
+	value_t *val = hattrie_get(tree, lf+1, *lf);
+	if (val == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	*val = node;
 	return KNOT_EOK;
 }
 
@@ -314,6 +326,9 @@ int knot_zone_tree_shallow_copy(knot_zone_tree_t *from,
 	}
 
 	*to = hattrie_dup(from, knot_zone_node_copy);
+	if (*to == NULL) {
+		return KNOT_ENOMEM;
+	}
 
 	return KNOT_EOK;
 }
@@ -328,6 +343,9 @@ int knot_zone_tree_deep_copy(knot_zone_tree_t *from,
 	}
 
 	*to = hattrie_dup(from, knot_zone_node_deep_copy);
+	if (*to == NULL) {
+		return KNOT_ENOMEM;
+	}
 
 	return KNOT_EOK;
 }
@@ -367,7 +385,10 @@ void knot_zone_tree_deep_free(knot_zone_tree_t **tree)
 
 void hattrie_insert_dname(hattrie_t *tr, knot_dname_t *dname)
 {
-	*hattrie_get(tr, (char *)dname->name, dname->size) = dname;
+	value_t *val = hattrie_get(tr, (char *)dname->name, dname->size);
+	if (val != NULL) {
+		*val = dname;
+	}
 }
 
 /*----------------------------------------------------------------------------*/
@@ -51,6 +51,25 @@ knot_zone_tree_t* knot_zone_tree_create();
  */
 size_t knot_zone_tree_weight(knot_zone_tree_t* tree);
 
+/*! \brief Size of a buffer for the zone tree key. */
+#define KNOT_ZONE_TREE_KEY_SIZE 256
+
+/*!
+ * \brief Converts the domain name to the key used in the zone tree.
+ *
+ * The first byte of the buffer holds the key length, the key follows.
+ * Keys compared with memcmp() of the common length and then by length are
+ * in the order of the sorted tree traversal.
+ *
+ * \param owner Domain name.
+ * \param key Buffer of KNOT_ZONE_TREE_KEY_SIZE bytes.
+ *
+ * \retval KNOT_EOK
+ * \retval KNOT_EINVAL
+ * \retval KNOT_ESPACE
+ */
+int knot_zone_tree_key(const knot_dname_t *owner, uint8_t *key);
+
 /*!
  * \brief Inserts the given node into the zone tree.
  *
@@ -79,7 +79,12 @@ dbg_zonedb_exec(
 	/* Ordered lookup is not required, no dname conversion. */
 	const char *key = (const char*)knot_dname_name(zone->name);
 	size_t klen = knot_dname_size(zone->name);
-	*hattrie_get(db->zone_tree, key, klen) = zone;
+	value_t *val = hattrie_get(db->zone_tree, key, klen);
+	if (val == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	*val = zone;
 	db->zone_count++;
 
 	return ret;
@@ -188,6 +193,8 @@ knot_zonedb_t *knot_zonedb_copy(const knot_zonedb_t *db)
 		return NULL;
 	}
 
+	db_new->zone_count = db->zone_count;
+
 	return db_new;
 }
 
@@ -113,6 +113,17 @@ const knot_zone_t *knot_zonedb_find_zone_for_name(knot_zonedb_t *db,
 knot_zone_contents_t *knot_zonedb_expire_zone(knot_zonedb_t *db,
                                               const knot_dname_t *zone_name);
 
+/*!
+ * \brief Creates a shallow copy of the zone database.
+ *
+ * Only the zone index is copied, the zones are shared with the original.
+ *
+ * \param db Zone database to be copied.
+ *
+ * \return New zone database or NULL if an error occured.
+ */
+knot_zonedb_t *knot_zonedb_copy(const knot_zonedb_t *db);
+
 size_t knot_zonedb_zone_count(const knot_zonedb_t *db);
 const knot_zone_t **knot_zonedb_zones(const knot_zonedb_t *db);
 
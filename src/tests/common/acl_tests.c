@@ -15,6 +15,9 @@
  */
 
 #include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -22,6 +25,9 @@
 #include "common/sockaddr.h"
 #include "common/acl.h"
 
+/*! \brief Number of /24 prefixes in the large ACL test. */
+#define ACL_LARGE_COUNT 512
+
 static int acl_tests_count(int argc, char *argv[]);
 static int acl_tests_run(int argc, char *argv[]);
 
@@ -33,9 +39,65 @@ unit_api acl_tests_api = {
 	&acl_tests_run     //! Run scheduled tests
 };
 
+/*! \brief Creates address with given prefix. */
+static void acl_addr(sockaddr_t *addr, int family, const char *str, int pfx)
+{
+	sockaddr_set(addr, family, str, 0);
+	sockaddr_setprefix(addr, pfx);
+}
+
+/*!
+ * \brief Matches addresses in a large list of /24 and /28 prefixes.
+ *
+ * Every 10.x.y.0/24 has a rule, every 10.x.y.16/28 has a more specific one.
+ */
+static bool acl_test_large(void)
+{
+	acl_t *acl = acl_new(ACL_DENY, "large");
+	if (acl == NULL) {
+		return false;
+	}
+
+	char str[INET_ADDRSTRLEN];
+	sockaddr_t addr;
+	for (long i = 0; i < ACL_LARGE_COUNT; ++i) {
+		snprintf(str, sizeof(str), "10.%ld.%ld.0", i / 256, i % 256);
+		acl_addr(&addr, AF_INET, str, 24);
+		acl_create(acl, &addr, ACL_ACCEPT, (void *)(i + 1), 0);
+		snprintf(str, sizeof(str), "10.%ld.%ld.16", i / 256, i % 256);
+		acl_addr(&addr, AF_INET, str, 28);
+		acl_create(acl, &addr, ACL_DENY, (void *)(-i - 1), 0);
+	}
+
+	bool success = true;
+	acl_key_t *key = NULL;
+	sockaddr_set(&addr, AF_INET, "10.0.0.0", 0);
+	for (long n = 0; n < ACL_LARGE_COUNT * 64; ++n) {
+		long i = n / 64;
+		long host = n % 64;
+		addr.addr4.sin_addr.s_addr = htonl(0x0a000000 | i << 8 | host);
+		int ret = acl_match(acl, &addr, &key);
+		if (host >= 16 && host < 32) {
+			success = success && ret == ACL_DENY && key != NULL &&
+			          key->val == (void *)(-i - 1);
+		} else {
+			success = success && ret == ACL_ACCEPT && key != NULL &&
+			          key->val == (void *)(i + 1);
+		}
+	}
+
+	/* Outside of all prefixes. */
+	sockaddr_set(&addr, AF_INET, "10.16.0.1", 0);
+	success = success && acl_match(acl, &addr, &key) == ACL_DENY &&
+	          key == NULL;
+
+	acl_delete(&acl);
+	return success;
+}
+
 static int acl_tests_count(int argc, char *argv[])
 {
-	return 20;
+	return 23;
 }
 
 static int acl_tests_run(int argc, char *argv[])
@@ -158,8 +220,50 @@ static int acl_tests_run(int argc, char *argv[])
 	sockaddr_set(&match_pf4, AF_INET, "82.87.48.136", 12345);
 	ret = acl_match(acl, &match_pf4, 0);
 	ok(ret == ACL_ACCEPT, "acl: scenario after truncating");
+
+	// 20. Longest prefix wins, regardless of insertion order
+	acl_truncate(acl);
+	sockaddr_t pfx;
+	acl_addr(&pfx, AF_INET, "192.0.2.128", 25);
+	acl_create(acl, &pfx, ACL_DENY, 0, 0);
+	acl_addr(&pfx, AF_INET, "192.0.0.0", 16);
+	acl_create(acl, &pfx, ACL_ACCEPT, 0, 0);
+	acl_addr(&pfx, AF_INET, "192.0.2.192", 27);
+	acl_create(acl, &pfx, ACL_ACCEPT, 0, 0);
+	acl_addr(&pfx, AF_INET, "0.0.0.0", 0);
+	acl_create(acl, &pfx, ACL_DENY, 0, 0);
+	const char *addrs[] = { "192.0.2.127", "192.0.2.128", "192.0.2.200",
+	                        "192.0.2.224", "192.0.255.1", "192.1.0.1" };
+	int rules[] = { ACL_ACCEPT, ACL_DENY, ACL_ACCEPT,
+	                ACL_DENY, ACL_ACCEPT, ACL_DENY };
+	bool success = true;
+	for (int i = 0; i < sizeof(rules) / sizeof(rules[0]); ++i) {
+		sockaddr_set(&test_pf4, AF_INET, addrs[i], 0);
+		success = success && acl_match(acl, &test_pf4, 0) == rules[i];
+	}
+	ok(success, "acl: longest IPv4 prefix match");
+
+	// 21. Longest prefix match for IPv6, bits not aligned to octets
+	acl_addr(&pfx, AF_INET6, "2001:db8::", 32);
+	acl_create(acl, &pfx, ACL_ACCEPT, 0, 0);
+	acl_addr(&pfx, AF_INET6, "2001:db8:8000::", 33);
+	acl_create(acl, &pfx, ACL_DENY, 0, 0);
+	acl_addr(&pfx, AF_INET6, "2001:db8:ffff::1", 128);
+	acl_create(acl, &pfx, ACL_ACCEPT, 0, 0);
+	sockaddr_set(&test_pf6, AF_INET6, "2001:db8:7fff::1", 0);
+	success = acl_match(acl, &test_pf6, 0) == ACL_ACCEPT;
+	sockaddr_set(&test_pf6, AF_INET6, "2001:db8:8000::1", 0);
+	success = success && acl_match(acl, &test_pf6, 0) == ACL_DENY;
+	sockaddr_set(&test_pf6, AF_INET6, "2001:db8:ffff::1", 0);
+	success = success && acl_match(acl, &test_pf6, 0) == ACL_ACCEPT;
+	sockaddr_set(&test_pf6, AF_INET6, "2001:db9::1", 0);
+	success = success && acl_match(acl, &test_pf6, 0) == ACL_DENY;
+	ok(success, "acl: longest IPv6 prefix match");
 	acl_delete(&acl);
 
+	// 22. Large list of prefixes
+	ok(acl_test_large(), "acl: large list of prefixes");
+
 	// Return
 	return 0;
 }
@@ -0,0 +1,128 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tests/common/arena_tests.h"
+#include "common/arena.h"
+
+static int arena_tests_count(int argc, char *argv[]);
+static int arena_tests_run(int argc, char *argv[]);
+
+/*! Exported unit API.
+ */
+unit_api arena_tests_api = {
+	"Arena allocator",  //! Unit name
+	&arena_tests_count, //! Count scheduled tests
+	&arena_tests_run    //! Run scheduled tests
+};
+
+/*! \brief Number of times a block is grown in the growth test. */
+#define ARENA_GROW_COUNT 1000
+
+static int arena_tests_count(int argc, char *argv[])
+{
+	return 7;
+}
+
+static int arena_tests_run(int argc, char *argv[])
+{
+	// 1. Create arena
+	arena_t *arena = arena_new();
+	ok(arena != NULL, "arena: created empty arena");
+	if (arena == NULL) {
+		diag("arena: failed to create arena");
+		return 0;
+	}
+
+	// 2. Small blocks are aligned, zeroed and owned by arena
+	bool valid = true;
+	for (int i = 0; i < 100000 && valid; ++i) {
+		uint8_t *mem = arena_alloc(arena, 1 + i % 100);
+		valid = mem != NULL && ((uintptr_t)mem % ARENA_ALIGN) == 0 &&
+		        mem[0] == 0 && arena_owner(mem) == arena;
+		if (valid) {
+			memset(mem, 0xff, 1 + i % 100);
+		}
+	}
+	ok(valid, "arena: small blocks");
+
+	// 3. Large blocks and heap blocks
+	void *large = arena_alloc(arena, 4 * ARENA_CHUNK_SIZE);
+	void *heap = malloc(64);
+	ok(large != NULL && arena_owner(large) == arena &&
+	   arena_owner(heap) == NULL && arena_owner(NULL) == NULL,
+	   "arena: block ownership");
+
+	// 4. Resizing arena blocks
+	arena_enter(arena);
+	char *mem = arena_alloc(arena, 32);
+	strcpy(mem, "arena");
+	char *shrunk = arena_realloc(mem, 32, 16);
+	char *grown = arena_realloc(shrunk, 16, 64);
+	void *next = arena_alloc(arena, 16);
+	char *moved = arena_realloc(grown, 64, 128);
+	arena_leave();
+	ok(shrunk == mem && grown == mem && next != NULL && moved != NULL &&
+	   moved != mem && arena_owner(moved) == NULL &&
+	   strcmp(moved, "arena") == 0, "arena: resizing blocks");
+	arena_free(moved);
+
+	// 5. Current arena
+	arena_enter(arena);
+	void *from_arena = arena_malloc(16);
+	arena_leave();
+	void *from_heap = arena_malloc(16);
+	ok(arena_owner(from_arena) == arena && arena_owner(from_heap) == NULL,
+	   "arena: allocation from current arena");
+	arena_free(from_arena);
+	arena_free(from_heap);
+	free(heap);
+
+	// 6. Growing a block that is not the last one keeps arena usage
+	arena_enter(arena);
+	size_t size = 8;
+	char *block = arena_malloc(size);
+	(void)arena_malloc(8);
+	size_t used = arena->used;
+	bool grown_ok = block != NULL;
+	for (int i = 0; i < ARENA_GROW_COUNT && grown_ok; ++i) {
+		block[size - 1] = i;
+		char *resized = arena_realloc(block, size, size + 8);
+		grown_ok = resized != NULL && resized[size - 1] == (char)i;
+		block = resized;
+		size += 8;
+	}
+	arena_leave();
+	ok(grown_ok && arena->used == used && arena_owner(block) == NULL,
+	   "arena: growing blocks moves them to the heap");
+	arena_free(block);
+
+	// 7. Release frees all blocks
+	diag("arena: %zu B used, %zu B mapped", arena->used, arena->mapped);
+	arena_retain(arena);
+	arena_release(arena);
+	bool alive = arena_owner(large) == arena;
+	arena_release(arena);
+	ok(alive && arena_owner(large) == NULL && arena_owner(mem) == NULL,
+	   "arena: released arena");
+
+	return 0;
+}
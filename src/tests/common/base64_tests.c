@@ -19,6 +19,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include "common/errcode.h"
@@ -26,6 +27,16 @@
 
 #define BUF_LEN 256
 
+/*! \brief Length of binary data long enough for the vector code. */
+#define LONG_LEN 768
+/*! \brief Length of Base64 text of the long data. */
+#define LONG_TXT_LEN ((LONG_LEN / 3) * 4)
+
+/*! \brief RRSIG signature length (RSA-2048). */
+#define SIG_LEN 256
+/*! \brief Number of RRSIG signatures in the round-trip test. */
+#define SIG_COUNT 64
+
 static int base64_tests_count(int argc, char *argv[]);
 static int base64_tests_run(int argc, char *argv[]);
 
@@ -35,9 +46,44 @@ unit_api base64_tests_api = {
 	&base64_tests_run
 };
 
+/*! \brief Decodes text block by block, which is done by scalar code. */
+static int32_t decode_blocks(const uint8_t *in, uint32_t in_len, uint8_t *out)
+{
+	int32_t len = 0;
+	for (uint32_t i = 0; i < in_len; i += 4) {
+		int32_t ret = base64_decode(in + i, 4, out + len, 3);
+		if (ret < 0) {
+			return ret;
+		}
+		len += ret;
+	}
+	return len;
+}
+
+/*! \brief Encodes and decodes RRSIG-sized data back and forth. */
+static bool test_rrsig(void)
+{
+	const uint32_t txt_len = ((SIG_LEN + 2) / 3) * 4;
+	uint8_t sig[SIG_LEN], txt[((SIG_LEN + 2) / 3) * 4], dec[SIG_LEN + 2];
+
+	bool success = true;
+	for (uint32_t i = 0; i < SIG_COUNT; i++) {
+		for (uint32_t j = 0; j < SIG_LEN; j++) {
+			sig[j] = rand();
+		}
+		int32_t ret = base64_encode(sig, SIG_LEN, txt, txt_len);
+		success = success && ret == txt_len;
+		ret = base64_decode(txt, txt_len, dec, sizeof(dec));
+		success = success && ret == SIG_LEN &&
+		          memcmp(sig, dec, SIG_LEN) == 0;
+	}
+
+	return success;
+}
+
 static int base64_tests_count(int argc, char *argv[])
 {
-	return 36;
+	return 40;
 }
 
 static int base64_tests_run(int argc, char *argv[])
@@ -180,5 +226,56 @@ static int base64_tests_run(int argc, char *argv[])
         ret = base64_decode((uint8_t *)"AAA ", 4, out, BUF_LEN);
         cmp_ok(ret, "==", KNOT_BASE64_ECHAR, "Bad data character space");
 
+	// Long data go through the vector code, if available.
+	diag("base64: implementation '%s'", base64_impl());
+	uint8_t bin[LONG_LEN], txt[LONG_TXT_LEN], txt2[LONG_TXT_LEN];
+	uint8_t dec[LONG_LEN], dec2[LONG_LEN];
+	bool success = true;
+	for (uint32_t len = 0; len <= LONG_LEN; len++) {
+		for (uint32_t i = 0; i < len; i++) {
+			bin[i] = rand();
+		}
+		ret = base64_encode(bin, len, txt, LONG_TXT_LEN);
+		// Short blocks are encoded by scalar code.
+		for (uint32_t i = 0; i < len; i += 3) {
+			uint32_t n = (len - i) < 3 ? (len - i) : 3;
+			base64_encode(bin + i, n, txt2 + (i / 3) * 4, 4);
+		}
+		int32_t ret2 = base64_decode(txt, ret, dec, LONG_LEN);
+		if (ret < 0 || memcmp(txt, txt2, ret) != 0 || ret2 != len ||
+		    memcmp(dec, bin, len) != 0) {
+			success = false;
+		}
+	}
+	ok(success, "Long data - ENC and DEC match scalar code");
+
+	// Every character anywhere in the text is checked as by scalar code.
+	success = true;
+	for (int c = 0; c < 256; c++) {
+		if (c == '=') {
+			continue;
+		}
+		for (uint32_t pos = c % 64; pos < LONG_TXT_LEN; pos += 61) {
+			memcpy(txt2, txt, LONG_TXT_LEN);
+			txt2[pos] = c;
+			ret = base64_decode(txt2, LONG_TXT_LEN, dec, LONG_LEN);
+			int32_t ret2 = decode_blocks(txt2, LONG_TXT_LEN, dec2);
+			if (ret != ret2 ||
+			    (ret > 0 && memcmp(dec, dec2, ret) != 0)) {
+				success = false;
+			}
+		}
+	}
+	ok(success, "Long data - bad characters match scalar code");
+
+	// Inner padding shortens all following blocks.
+	memset(txt2, 'A', LONG_TXT_LEN);
+	memcpy(txt2 + 8, "AAA=", 4);
+	ret = base64_decode(txt2, LONG_TXT_LEN, dec, LONG_LEN);
+	cmp_ok(ret, "==", 2 * 3 + 2 + (LONG_TXT_LEN / 4 - 3) * 2,
+	       "Long data - inner padding");
+
+	ok(test_rrsig(), "RRSIG-sized data round trip");
+
 	return 0;
 }
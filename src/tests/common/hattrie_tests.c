@@ -21,6 +21,14 @@
 #include "tests/common/hattrie_tests.h"
 #include "common/mempattern.h"
 #include "common/hattrie/hat-trie.h"
+#include "common/hattrie/ahtable.h"
+#include "common/hattrie/murmurhash3.h"
+
+/*! \brief Number of names in the zone name lookup test. */
+#define HAT_ZONE_NAMES 2000
+
+/*! \brief Maximum length of a zone name in the tests. */
+#define HAT_ZONE_NAMELEN 48
 
 static const char *alphabet = "abcdefghijklmn";
 static char *randstr() {
@@ -33,6 +41,167 @@ static char *randstr() {
 	return s;
 }
 
+/*!
+ * \brief Generates name in zone tree lookup format.
+ *
+ * Names resemble a large zone: delegations and hosts below a common suffix,
+ * labels separated by \x00, rightmost first.
+ */
+static size_t zone_name(char *dst, unsigned i)
+{
+	static const char *hosts[] = { "www", "mail", "ns1", "ns2", "ftp" };
+	int len = sprintf(dst, "com%cexample%cdomain%u", 0, 0, i / 5);
+	if (i % 5 != 0) {
+		len += sprintf(dst + len, "%c%s", 0, hosts[i % 5]);
+	}
+	dst[len] = '\0';
+	return len + 1;
+}
+
+/*!
+ * \brief Checks keys in a single bucket table (fingerprints and overflow).
+ */
+static int check_single_bucket()
+{
+	char key[300];
+	unsigned count = 100;
+	ahtable_t *t = ahtable_create_n(1);
+
+	/* Short keys and keys with two-byte length. */
+	for (unsigned i = 0; i < count; ++i) {
+		size_t len = (i % 10 == 0) ? 200 + i : 4;
+		memset(key, 'a' + i % 26, len);
+		memcpy(key, &i, sizeof(i));
+		*ahtable_get(t, key, len) = (value_t)(size_t)(i + 1);
+	}
+
+	int passed = (ahtable_size(t) == count);
+	for (unsigned i = 0; i < count && passed; ++i) {
+		size_t len = (i % 10 == 0) ? 200 + i : 4;
+		memset(key, 'a' + i % 26, len);
+		memcpy(key, &i, sizeof(i));
+		/* Delete every third key. */
+		if (i % 3 == 0) {
+			passed = (ahtable_del(t, key, len) == 0);
+		}
+	}
+	for (unsigned i = 0; i < count && passed; ++i) {
+		size_t len = (i % 10 == 0) ? 200 + i : 4;
+		memset(key, 'a' + i % 26, len);
+		memcpy(key, &i, sizeof(i));
+		value_t *v = ahtable_tryget(t, key, len);
+		if (i % 3 == 0) {
+			passed = (v == NULL);
+		} else {
+			passed = (v != NULL && *v == (value_t)(size_t)(i + 1));
+		}
+	}
+
+	ahtable_free(t);
+	return passed;
+}
+
+/*!
+ * \brief Checks that the table order index is kept through updates.
+ *
+ * Index is built on an empty table and is checked after insertions causing
+ * table expansion and after deletions.
+ */
+static int check_table_index()
+{
+	char key[16];
+	unsigned count = 25000;
+	ahtable_t *t = ahtable_create_n(1);
+	ahtable_build_index(t);
+
+	for (unsigned i = 0; i < count; ++i) {
+		size_t len = sprintf(key, "%u", (i * 7919) % count);
+		*ahtable_get(t, key, len) = (value_t)(size_t)(i + 1);
+	}
+	for (unsigned i = 0; i < count; i += 3) {
+		size_t len = sprintf(key, "%u", i);
+		ahtable_del(t, key, len);
+	}
+
+	/* Keys must be ordered and complete. */
+	int passed = (t->n > 1);
+	size_t seen = 0, prev_len = 0;
+	char prev[16];
+	ahtable_iter_t i;
+	ahtable_iter_begin(t, &i, true);
+	while (!ahtable_iter_finished(&i) && passed) {
+		size_t len = 0;
+		const char *k = ahtable_iter_key(&i, &len);
+		if (seen > 0) {
+			size_t l = len < prev_len ? len : prev_len;
+			int c = memcmp(prev, k, l);
+			passed = (c < 0 || (c == 0 && prev_len < len));
+		}
+		memcpy(prev, k, len);
+		prev_len = len;
+		++seen;
+		ahtable_iter_next(&i);
+	}
+	ahtable_iter_free(&i);
+	passed = passed && (seen == ahtable_size(t));
+
+	/* Predecessor of deleted key is the previous number in order. */
+	value_t *v = NULL;
+	if (passed) {
+		passed = (ahtable_find_leq(t, "3", 1, &v) == -1 && v != NULL
+		          && ahtable_find_leq(t, "4", 1, &v) == 0
+		          && ahtable_find_leq(t, "0", 1, &v) == 1);
+	}
+
+	ahtable_free(t);
+	return passed;
+}
+
+/*!
+ * \brief Checks sorted iteration of a table without order index.
+ *
+ * Every other key is deleted through the iterator, the table must stay
+ * unindexed.
+ */
+static int check_table_sorted_iter()
+{
+	char key[16];
+	unsigned count = 2000;
+	ahtable_t *t = ahtable_create();
+	for (unsigned i = 0; i < count; ++i) {
+		size_t len = sprintf(key, "%u", (i * 7919) % count);
+		*ahtable_get(t, key, len) = (value_t)(size_t)(i + 1);
+	}
+
+	int passed = 1;
+	size_t seen = 0, prev_len = 0;
+	char prev[16];
+	ahtable_iter_t i;
+	ahtable_iter_begin(t, &i, true);
+	while (!ahtable_iter_finished(&i) && passed) {
+		size_t len = 0;
+		const char *k = ahtable_iter_key(&i, &len);
+		if (seen > 0) {
+			size_t l = len < prev_len ? len : prev_len;
+			int c = memcmp(prev, k, l);
+			passed = (c < 0 || (c == 0 && prev_len < len));
+		}
+		memcpy(prev, k, len);
+		prev_len = len;
+		if (seen++ % 2 == 0) {
+			ahtable_iter_del(&i);
+		} else {
+			ahtable_iter_next(&i);
+		}
+	}
+	ahtable_iter_free(&i);
+	passed = passed && seen == count && t->index == NULL
+	         && ahtable_size(t) == count / 2;
+
+	ahtable_free(t);
+	return passed;
+}
+
 static int hattrie_tests_count(int argc, char *argv[]);
 static int hattrie_tests_run(int argc, char *argv[]);
 
@@ -49,7 +218,7 @@ unit_api hattrie_tests_api = {
  * Unit implementation.
  */
 
-static const int HAT_TEST_COUNT = 6;
+static const int HAT_TEST_COUNT = 14;
 
 static int hattrie_tests_count(int argc, char *argv[])
 {
@@ -151,6 +320,108 @@ static int hattrie_tests_run(int argc, char *argv[])
 	int ret = hattrie_find_lpr(t, false_lpr, strlen(false_lpr), &v);
 	ok(ret != 0 && v == NULL, "hattrie: non-existent prefix lookup");
 
+	/* Test 7: Lookup of all dummy items (buckets were split). */
+	passed = 1;
+	for (unsigned i = 0; i < dummy_count; ++i) {
+		v = hattrie_tryget(t, dummy[i], strlen(dummy[i]));
+		if (!v || strcmp(*v, dummy[i]) != 0) {
+			passed = 0;
+			break;
+		}
+	}
+	ok(passed, "hattrie: lookup after bucket splits");
+
+	/* Test 8: Delete. */
+	passed = 1;
+	for (unsigned i = 0; i < count; i += 2) {
+		if (hattrie_del(t, items[i], strlen(items[i])) != 0) {
+			passed = 0;
+		}
+	}
+	for (unsigned i = 0; i < count; ++i) {
+		v = hattrie_tryget(t, items[i], strlen(items[i]));
+		if ((i % 2 == 0) != (v == NULL)) {
+			passed = 0;
+		}
+	}
+	ok(passed, "hattrie: delete");
+
+	/* Test 9: Keys beyond bucket fingerprints. */
+	ok(check_single_bucket(), "hattrie: bucket overflow");
+
+	/* Zone names, hits followed by misses. */
+	const unsigned names_count = 2 * HAT_ZONE_NAMES;
+	char *names = xmalloc(names_count * HAT_ZONE_NAMELEN);
+	size_t *names_len = xmalloc(names_count * sizeof(size_t));
+	for (unsigned i = 0; i < names_count; ++i) {
+		names_len[i] = zone_name(names + i * HAT_ZONE_NAMELEN, i);
+	}
+
+	/* Test 10: Hash of zone names doesn't depend on key alignment. */
+	char shifted[HAT_ZONE_NAMELEN + 8];
+	passed = 1;
+	for (unsigned i = 0; i < names_count && passed; ++i) {
+		const char *name = names + i * HAT_ZONE_NAMELEN;
+		unsigned off = 1 + i % 7;
+		memcpy(shifted + off, name, names_len[i]);
+		passed = hash(name, names_len[i]) ==
+		         hash(shifted + off, names_len[i]) &&
+		         hash_mum(name, names_len[i]) ==
+		         hash_mum(shifted + off, names_len[i]);
+	}
+	ok(passed, "hattrie: hash of unaligned zone names");
+
+	/* Test 11: Lookup of zone names. */
+	hattrie_t *zt = hattrie_create();
+	for (unsigned i = 0; i < HAT_ZONE_NAMES; ++i) {
+		*hattrie_get(zt, names + i * HAT_ZONE_NAMELEN, names_len[i]) =
+			(value_t)(size_t)(i + 1);
+	}
+	passed = 1;
+	for (unsigned i = 0; i < names_count; ++i) {
+		v = hattrie_tryget(zt, names + i * HAT_ZONE_NAMELEN,
+		                   names_len[i]);
+		if (i < HAT_ZONE_NAMES) {
+			passed = passed && v != NULL &&
+			         *v == (value_t)(size_t)(i + 1);
+		} else {
+			passed = passed && v == NULL;
+		}
+	}
+	ok(passed, "hattrie: zone name lookup");
+	hattrie_free(zt);
+	free(names);
+	free(names_len);
+
+	/* Test 12: Table order index maintained on updates. */
+	ok(check_table_index(), "hattrie: table order index");
+
+	/* Test 13: Trie order index maintained on updates. */
+	hattrie_build_index(t);
+	for (unsigned i = 0; i < count; ++i) {
+		*hattrie_get(t, items[i], strlen(items[i])) = (value_t)items[i];
+	}
+	for (unsigned i = 0; i < dummy_count; i += 4) {
+		hattrie_del(t, dummy[i], strlen(dummy[i]));
+	}
+	passed = 1;
+	for (unsigned i = 0; i < dummy_count && passed; i += 2) {
+		size_t len = strlen(dummy[i]);
+		int ret = hattrie_find_leq(t, dummy[i], len, &v);
+		if (hattrie_tryget(t, dummy[i], len) != NULL) {
+			passed = (ret == 0 && v != NULL
+			          && strcmp(*v, dummy[i]) == 0);
+		} else {
+			/* predecessor must be smaller */
+			passed = (ret != 0 && (v == NULL
+			          || strcmp(*v, dummy[i]) < 0));
+		}
+	}
+	ok(passed, "hattrie: ordered lookup after updates");
+
+	/* Test 14: Sorted iteration of unindexed table. */
+	ok(check_table_sorted_iter(), "hattrie: sorted iteration without index");
+
 
 	for (unsigned i = 0; i < dummy_count; ++i) {
 		free(dummy[i]);
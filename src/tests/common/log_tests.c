@@ -0,0 +1,153 @@
+/*  Copyright (C) 2011 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "tests/common/log_tests.h"
+#include "common/log.h"
+#include "common/errcode.h"
+
+static int log_tests_count(int argc, char *argv[]);
+static int log_tests_run(int argc, char *argv[]);
+
+/*! Exported unit API.
+ */
+unit_api log_tests_api = {
+	"Logging",        //! Unit name
+	&log_tests_count, //! Count scheduled tests
+	&log_tests_run    //! Run scheduled tests
+};
+
+/*! \brief Number of logging threads. */
+#define LOG_TEST_THREADS 4
+
+/*! \brief Number of messages logged by each thread. */
+#define LOG_TEST_MESSAGES 20000
+
+static void *log_test_thread(void *arg)
+{
+	int id = (int)(intptr_t)arg;
+	for (int i = 0; i < LOG_TEST_MESSAGES; ++i) {
+		log_zone_info("thread %d message %d\n", id, i);
+	}
+
+	return NULL;
+}
+
+/*! \brief Check that logged messages keep per-thread order. */
+static int log_test_check(const char *filename, size_t *lines)
+{
+	FILE *fp = fopen(filename, "r");
+	if (fp == NULL) {
+		return -1;
+	}
+
+	int next[LOG_TEST_THREADS] = { 0 };
+	char line[256];
+	int ret = 0;
+	*lines = 0;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		int id = -1, seq = -1;
+		char *msg = strstr(line, "thread ");
+		if (msg == NULL ||
+		    sscanf(msg, "thread %d message %d", &id, &seq) != 2 ||
+		    id < 0 || id >= LOG_TEST_THREADS || seq < next[id]) {
+			ret = -1;
+			break;
+		}
+		next[id] = seq + 1;
+		++*lines;
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+/*! API: return number of tests. */
+static int log_tests_count(int argc, char *argv[])
+{
+	return 4;
+}
+
+/*! API: run tests. */
+static int log_tests_run(int argc, char *argv[])
+{
+	char filename[] = "/tmp/knot-log-XXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0) {
+		skippy(4, "couldn't create temporary file");
+		return 0;
+	}
+	close(fd);
+
+	/* Log only zone messages to the file. */
+	log_truncate();
+	log_setup(1);
+	int fcl = log_open_file(filename);
+	for (int i = LOGT_SYSLOG; i <= LOGT_STDOUT; ++i) {
+		log_levels_set(i, LOG_ANY, 0);
+	}
+	log_levels_set(fcl, LOG_ZONE, LOG_MASK(LOG_INFO));
+
+	/* 1. Start asynchronous logging. */
+	int ret = log_async_start();
+	ok(ret == KNOT_EOK, "log: start asynchronous logging");
+
+	/* Log from several threads. */
+	pthread_t thr[LOG_TEST_THREADS];
+	for (int i = 0; i < LOG_TEST_THREADS; ++i) {
+		pthread_create(&thr[i], NULL, log_test_thread,
+		               (void *)(intptr_t)i);
+	}
+	for (int i = 0; i < LOG_TEST_THREADS; ++i) {
+		pthread_join(thr[i], NULL);
+	}
+	log_async_stop();
+
+	/* 2. Each message is either written or counted as dropped. */
+	size_t lines = 0;
+	ret = log_test_check(filename, &lines);
+	size_t sent = LOG_TEST_THREADS * LOG_TEST_MESSAGES;
+	size_t dropped = log_dropped();
+	ok(lines + dropped == sent, "log: written %zu, dropped %zu messages",
+	   lines, dropped);
+
+	/* 3. Messages from a single thread are kept in order. */
+	ok(ret == 0, "log: per-thread order is kept");
+
+	/* 4. Synchronous logging after stop. */
+	log_zone_info("thread 0 message %d\n", LOG_TEST_MESSAGES);
+	size_t synced = 0;
+	ret = log_test_check(filename, &synced);
+	ok(ret == 0 && synced == lines + 1, "log: synchronous after stop");
+
+	/* Restore default test levels. */
+	log_truncate();
+	log_setup(0);
+	log_levels_set(LOGT_SYSLOG, LOG_ANY, 0);
+	log_levels_set(LOGT_STDERR, LOG_ANY, 0);
+	log_levels_set(LOGT_STDOUT, LOG_ANY, LOG_MASK(LOG_DEBUG));
+	unlink(filename);
+
+	return 0;
+}
@@ -17,8 +17,10 @@
 #include <config.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include "tests/common/slab_tests.h"
 #include "common/slab/slab.h"
@@ -36,6 +38,87 @@
 extern void slab_init();
 extern void slab_deinit();
 
+/*! \brief Number of threads in magazine tests. */
+#define MAG_THREADS 4
+
+/*! \brief Number of bufs held by each thread in one round. */
+#define MAG_BATCH 1000
+
+/*! \brief Number of rounds in magazine tests. */
+#define MAG_ROUNDS 10
+
+/*! \brief Magazine test thread context. */
+typedef struct mag_thread {
+	pthread_t thread;
+	slab_mcache_t *mcache;   /*!< Tested magazine cache. */
+	pthread_barrier_t *barrier; /*!< Barrier for exchanging bufs. */
+	void **bufs;             /*!< Bufs allocated by this thread. */
+	void **peer;             /*!< Bufs to be freed by this thread. */
+	bool valid;              /*!< All allocations succeeded. */
+} mag_thread_t;
+
+/*!
+ * \brief Allocates a batch of bufs, then frees a batch allocated by
+ *        other thread.
+ */
+static void *mag_thread_run(void *arg)
+{
+	mag_thread_t *ctx = (mag_thread_t *)arg;
+	ctx->valid = true;
+
+	for (int r = 0; r < MAG_ROUNDS; ++r) {
+		for (int i = 0; i < MAG_BATCH; ++i) {
+			ctx->bufs[i] = slab_mcache_alloc(ctx->mcache);
+			if (ctx->bufs[i] == NULL) {
+				ctx->valid = false;
+			} else {
+				memset(ctx->bufs[i], r, sizeof(int));
+			}
+		}
+
+		// Free bufs of the other thread
+		pthread_barrier_wait(ctx->barrier);
+		for (int i = 0; i < MAG_BATCH; ++i) {
+			slab_free(ctx->peer[i]);
+		}
+		pthread_barrier_wait(ctx->barrier);
+	}
+
+	return NULL;
+}
+
+/*!
+ * \brief Runs magazine test threads.
+ * \return True if all allocations succeeded.
+ */
+static bool mag_threads_run(slab_mcache_t *mcache)
+{
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, MAG_THREADS);
+
+	mag_thread_t ctx[MAG_THREADS];
+	void *bufs[MAG_THREADS][MAG_BATCH];
+	for (int i = 0; i < MAG_THREADS; ++i) {
+		memset(ctx + i, 0, sizeof(mag_thread_t));
+		ctx[i].mcache = mcache;
+		ctx[i].barrier = &barrier;
+		ctx[i].bufs = bufs[i];
+		ctx[i].peer = bufs[(i + 1) % MAG_THREADS];
+	}
+
+	for (int i = 0; i < MAG_THREADS; ++i) {
+		pthread_create(&ctx[i].thread, NULL, mag_thread_run, ctx + i);
+	}
+	bool valid = true;
+	for (int i = 0; i < MAG_THREADS; ++i) {
+		pthread_join(ctx[i].thread, NULL);
+		valid = valid && ctx[i].valid;
+	}
+
+	pthread_barrier_destroy(&barrier);
+	return valid;
+}
+
 static int slab_tests_count(int argc, char *argv[]);
 static int slab_tests_run(int argc, char *argv[]);
 
@@ -49,7 +132,7 @@ unit_api slab_tests_api = {
 
 static int slab_tests_count(int argc, char *argv[])
 {
-	return 5;
+	return 9;
 }
 
 static int slab_tests_run(int argc, char *argv[])
@@ -114,5 +197,30 @@ static int slab_tests_run(int argc, char *argv[])
 	slab_cache_destroy(&cache);
 	ok(cache.bufsize == 0, "slab: freed cache");
 
+	// 6. Create magazine cache
+	slab_mcache_t mcache;
+	ret = slab_mcache_init(&mcache, 64);
+	ok(ret == 0, "slab: created magazine cache");
+
+	// 7. Alloc in threads, free in other threads
+	ok(mag_threads_run(&mcache), "slab: magazine alloc/free from threads");
+
+	// 8. All bufs returned, exited threads flushed their magazines
+	slab_mcache_stats_t stats;
+	slab_mcache_stats(&mcache, &stats);
+	unsigned long expected = MAG_THREADS * MAG_BATCH * MAG_ROUNDS;
+	ok(stats.allocs == expected && stats.frees == expected &&
+	   mcache.layers == NULL, "slab: magazine statistics");
+	diag("slab: magazines %lu allocs, %lu frees, depot %lu gets "
+	     "%lu puts, slabs %lu fills %lu flushes", stats.allocs,
+	     stats.frees, stats.depot_gets, stats.depot_puts,
+	     stats.slab_fills, stats.slab_flushes);
+
+	// 9. Reap magazine cache
+	slab_mcache_reap(&mcache);
+	ok(mcache.full_count == 0 && mcache.cache.slabs_full == NULL,
+	   "slab: magazine cache reaping works");
+	slab_mcache_destroy(&mcache);
+
 	return 0;
 }
@@ -16,6 +16,9 @@
 
 #include <config.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "tests/knot/conf_tests.h"
 #include "knot/conf/conf.h"
@@ -23,6 +26,11 @@
 /* Resources. */
 #include "sample_conf.rc"
 
+/*! Configuration with zone state in the given storage. */
+#define STATE_CONF \
+	"system { storage \"%s\"; }\n" \
+	"zones { example.net { file \"/var/lib/knot/example.net\"; } }\n"
+
 static int conf_tests_count(int argc, char *argv[]);
 static int conf_tests_run(int argc, char *argv[]);
 
@@ -39,7 +47,7 @@ unit_api conf_tests_api = {
  */
 static int conf_tests_count(int argc, char *argv[])
 {
-	return 21;
+	return 29;
 }
 
 /*! Run all scheduled tests for given parameters.
@@ -138,6 +146,88 @@ static int conf_tests_run(int argc, char *argv[])
 	}
 	knot_dname_free(&sample);
 
+	// Test 22-24: Compare zone configurations from separate parses
+	conf_t *conf2 = conf_new(config_fn);
+	ret = conf_parse_str(conf2, sample_conf_rc);
+	skip(ret != 0 || EMPTY_LIST(conf->zones), 3);
+	{
+	  conf_zone_t *z1 = (conf_zone_t *)HEAD(conf->zones);
+	  conf_zone_t *z2 = (conf_zone_t *)HEAD(conf2->zones);
+	  ok(conf_zone_equal(z1, z2), "zone config equal after reparse");
+	  z2->dbsync_timeout += 1;
+	  ok(!conf_zone_equal(z1, z2), "zone config differs in timeout");
+	  z2->dbsync_timeout -= 1;
+
+	  /* Zone config outlives its remotes when kept on reload. */
+	  rem_node(&z2->n);
+	  conf_free(conf2);
+	  conf2 = NULL;
+	  ok(conf_zone_equal(z1, z2), "zone config equal without remotes");
+	  conf_free_zone(z2);
+	} endskip;
+	conf_free(conf2);
+
+	// Test 25,26: Create zone config with defaults
+	conf_zone_t *zn = conf_zone_new(conf, "example.org");
+	ok(zn != NULL && strcmp(zn->name, "example.org.") == 0,
+	   "new zone config has FQDN name");
+	ok(zn != NULL && zn->dbsync_timeout == conf->dbsync_timeout &&
+	   zn->db != NULL, "new zone config has default settings");
+	conf_free_zone(zn);
+
+	// Test 27-29: Zones changed at runtime are kept on next parse
+	char storage[] = "/tmp/knot-conf.XXXXXX";
+	char conf_str[256];
+	char *state = NULL;
+	ret = KNOT_ENOMEM;
+	if (mkdtemp(storage) != NULL) {
+		free(conf->storage);
+		conf->storage = strdup(storage);
+		state = strcdup(storage, "/" CONFIG_ZONES_STATE);
+		snprintf(conf_str, sizeof(conf_str), STATE_CONF, storage);
+		ret = (conf->storage && state) ? KNOT_EOK : KNOT_ENOMEM;
+	}
+	const char *names[] = {
+		"example.org.", "example.org.", "example.org.", "example.net."
+	};
+	const conf_zone_state_t states[] = {
+		CONF_ZONE_ADDED, CONF_ZONE_REMOVED, CONF_ZONE_ADDED,
+		CONF_ZONE_REMOVED
+	};
+	for (int i = 0; ret == KNOT_EOK && i < 4; ++i) {
+		ret = conf_zone_state_save(conf, names[i], states[i]);
+	}
+	conf_t *conf3 = conf_new(config_fn);
+	if (ret == KNOT_EOK) {
+		ret = conf_parse_str(conf3, conf_str);
+	}
+	skip(ret != KNOT_EOK, 3);
+	{
+	  conf_zone_t *z3 = (conf_zone_t *)HEAD(conf3->zones);
+	  ok(conf3->zones_count == 1 && strcmp(z3->name, "example.org.") == 0,
+	     "zone added at runtime is present");
+	  ok(conf3->zones_count == 1 &&
+	     z3->dbsync_timeout == conf3->dbsync_timeout,
+	     "zone added at runtime has default settings");
+
+	  /* Only the last change of each zone is kept. */
+	  int lines = 0;
+	  FILE *fp = fopen(state, "r");
+	  for (int c = 0; fp != NULL && (c = fgetc(fp)) != EOF; ) {
+	    lines += (c == '\n');
+	  }
+	  if (fp != NULL) {
+	    fclose(fp);
+	  }
+	  cmp_ok(lines, "==", 2, "zone state file is compacted");
+	} endskip;
+	conf_free(conf3);
+	if (state != NULL) {
+		unlink(state);
+		free(state);
+	}
+	rmdir(storage);
+
 	} endskip;
 
 	// Deallocating config
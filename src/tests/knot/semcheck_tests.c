@@ -0,0 +1,244 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests/knot/semcheck_tests.h"
+#include "knot/zone/semantic-check.h"
+#include "libknot/common.h"
+#include "libknot/dname.h"
+#include "libknot/rrset.h"
+#include "libknot/zone/node.h"
+#include "libknot/zone/zone-contents.h"
+#include "libknot/updates/changesets.h"
+#include "common/base32hex.h"
+#include "common/descriptor.h"
+
+static int semcheck_tests_count(int argc, char *argv[]);
+static int semcheck_tests_run(int argc, char *argv[]);
+
+unit_api semcheck_tests_api = {
+	"Semantic checks",
+	&semcheck_tests_count,
+	&semcheck_tests_run
+};
+
+#define TEST_APEX "example."
+#define TEST_HASH_LEN 20
+
+static knot_dname_t *test_dname(const char *name)
+{
+	return knot_dname_new_from_str(name, strlen(name), NULL);
+}
+
+/*! \brief Finds node in the zone, creates it if missing. */
+static knot_node_t *test_node(knot_zone_contents_t *zone, const char *name)
+{
+	knot_dname_t *owner = test_dname(name);
+	knot_node_t *node = knot_zone_contents_get_node(zone, owner);
+	if (node == NULL) {
+		node = knot_node_new(owner, NULL, 0);
+		knot_zone_contents_add_node(zone, node, 1, 0);
+	}
+	knot_dname_release(owner);
+	return node;
+}
+
+/*! \brief Creates RRSet with one RR and adds it to the node. */
+static knot_rrset_t *test_rrset(knot_node_t *node, uint16_t type,
+                                const uint8_t *rdata, size_t size)
+{
+	knot_rrset_t *rrset = knot_rrset_new(knot_node_get_owner(node), type,
+	                                     KNOT_CLASS_IN, 3600);
+	memcpy(knot_rrset_create_rdata(rrset, size), rdata, size);
+	knot_node_add_rrset_no_merge(node, rrset);
+	return rrset;
+}
+
+static knot_rrset_t *test_add_a(knot_zone_contents_t *zone, const char *name)
+{
+	const uint8_t addr[] = { 192, 0, 2, 1 };
+	return test_rrset(test_node(zone, name), KNOT_RRTYPE_A, addr,
+	                  sizeof(addr));
+}
+
+/*! \brief Adds record with a single domain name in RDATA (CNAME, NSEC). */
+static knot_rrset_t *test_add_dname_rr(knot_zone_contents_t *zone,
+                                       const char *name, uint16_t type,
+                                       const char *target)
+{
+	knot_dname_t *dname = test_dname(target);
+	return test_rrset(test_node(zone, name), type, (uint8_t *)&dname,
+	                  sizeof(knot_dname_t *));
+}
+
+/*! \brief Owner of NSEC3 node for hash made of the given byte. */
+static knot_dname_t *test_nsec3_owner(uint8_t hash)
+{
+	uint8_t hash_data[TEST_HASH_LEN];
+	memset(hash_data, hash, sizeof(hash_data));
+
+	uint8_t *b32 = NULL;
+	int32_t len = base32hex_encode_alloc(hash_data, sizeof(hash_data),
+	                                     &b32);
+	char name[128] = { '\0' };
+	for (int32_t i = 0; i < len; ++i) {
+		name[i] = tolower(b32[i]);
+	}
+	free(b32);
+	strcat(name, "." TEST_APEX);
+
+	return test_dname(name);
+}
+
+/*! \brief Adds NSEC3 node with link to the next hash. */
+static knot_rrset_t *test_add_nsec3(knot_zone_contents_t *zone, uint8_t hash,
+                                    uint8_t next)
+{
+	knot_dname_t *owner = test_nsec3_owner(hash);
+	knot_node_t *node = knot_node_new(owner, NULL, 0);
+	knot_dname_release(owner);
+	knot_zone_contents_add_nsec3_node(zone, node, 0, 0);
+
+	/* SHA-1, no flags, no iterations, no salt, empty bitmap. */
+	uint8_t rdata[6 + TEST_HASH_LEN] = { 1, 0, 0, 0, 0, TEST_HASH_LEN };
+	memset(rdata + 6, next, TEST_HASH_LEN);
+	return test_rrset(node, KNOT_RRTYPE_NSEC3, rdata, sizeof(rdata));
+}
+
+/*! \brief Creates zone with SOA in the apex. */
+static knot_zone_contents_t *test_zone_new(void)
+{
+	knot_dname_t *apex_owner = test_dname(TEST_APEX);
+	knot_node_t *apex = knot_node_new(apex_owner, NULL, 0);
+	knot_dname_release(apex_owner);
+	knot_zone_contents_t *zone = knot_zone_contents_new(apex, NULL);
+
+	uint8_t soa[2 * sizeof(knot_dname_t *) + 20] = { 0 };
+	knot_dname_t *mname = test_dname("ns." TEST_APEX);
+	knot_dname_t *rname = test_dname("hostmaster." TEST_APEX);
+	memcpy(soa, &mname, sizeof(knot_dname_t *));
+	memcpy(soa + sizeof(knot_dname_t *), &rname, sizeof(knot_dname_t *));
+	soa[sizeof(soa) - 1] = 60;
+	test_rrset(apex, KNOT_RRTYPE_SOA, soa, sizeof(soa));
+
+	return zone;
+}
+
+/*!
+ * \brief Checks update consisting of a single modified RRSet.
+ *
+ * \param errors Number of errors \a error found.
+ */
+static int test_check(knot_zone_contents_t *zone, knot_rrset_t *rrset,
+                      int level, int error, int *errors)
+{
+	knot_zone_contents_adjust(zone, NULL, NULL, 0);
+
+	knot_changes_t changes;
+	memset(&changes, 0, sizeof(changes));
+	if (rrset != NULL) {
+		changes.new_rrsets = &rrset;
+		changes.new_rrsets_count = 1;
+	}
+
+	err_handler_t *handler = handler_new(1, 1, 1, 1, 1);
+	if (handler == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = zone_do_sem_checks_changes(zone, &changes, level, handler);
+	*errors = handler->errors[-error];
+
+	free(handler);
+	knot_zone_contents_deep_free(&zone);
+	return ret;
+}
+
+/*! \brief Zone with NSEC chain, the link from 'a' is broken if requested. */
+static knot_zone_contents_t *test_zone_nsec(int broken)
+{
+	knot_zone_contents_t *zone = test_zone_new();
+	test_add_a(zone, "a." TEST_APEX);
+	test_add_a(zone, "b." TEST_APEX);
+	test_add_dname_rr(zone, TEST_APEX, KNOT_RRTYPE_NSEC, "a." TEST_APEX);
+	test_add_dname_rr(zone, "a." TEST_APEX, KNOT_RRTYPE_NSEC,
+	                  broken ? "x." TEST_APEX : "b." TEST_APEX);
+	test_add_dname_rr(zone, "b." TEST_APEX, KNOT_RRTYPE_NSEC, TEST_APEX);
+	return zone;
+}
+
+static int semcheck_tests_count(int argc, char *argv[])
+{
+	return 6;
+}
+
+static int semcheck_tests_run(int argc, char *argv[])
+{
+	int errors = 0;
+
+	/* 1. Update without changes. */
+	int ret = test_check(test_zone_new(), NULL, 1,
+	                     ZC_ERR_CNAME_EXTRA_RECORDS, &errors);
+	ok(ret == KNOT_EOK, "semcheck: update with no changes passes");
+
+	/* 2. CNAME added next to other data is fatal. */
+	knot_zone_contents_t *zone = test_zone_new();
+	test_add_a(zone, "a." TEST_APEX);
+	test_add_a(zone, "c." TEST_APEX);
+	knot_rrset_t *cname = test_add_dname_rr(zone, "c." TEST_APEX,
+	                                        KNOT_RRTYPE_CNAME,
+	                                        "a." TEST_APEX);
+	ret = test_check(zone, cname, 1, ZC_ERR_CNAME_EXTRA_RECORDS, &errors);
+	ok(ret == KNOT_ERROR && errors > 0,
+	   "semcheck: CNAME with other data is fatal");
+
+	/* 3. Change of 'b' checks NSEC of its predecessor 'a'. */
+	zone = test_zone_nsec(0);
+	knot_rrset_t *rrset = knot_node_get_rrset(test_node(zone,
+	                                          "b." TEST_APEX),
+	                                          KNOT_RRTYPE_A);
+	ret = test_check(zone, rrset, 2, ZC_ERR_NSEC_RDATA_CHAIN, &errors);
+	ok(ret == KNOT_EOK && errors == 0,
+	   "semcheck: coherent NSEC chain passes");
+
+	zone = test_zone_nsec(1);
+	rrset = knot_node_get_rrset(test_node(zone, "b." TEST_APEX),
+	                            KNOT_RRTYPE_A);
+	ret = test_check(zone, rrset, 2, ZC_ERR_NSEC_RDATA_CHAIN, &errors);
+	ok(ret == KNOT_EOK && errors > 0,
+	   "semcheck: broken NSEC link at the predecessor is found");
+
+	/* 4. Changed NSEC3 next link must point to an existing NSEC3 node. */
+	zone = test_zone_new();
+	test_add_nsec3(zone, 0x11, 0x22);
+	rrset = test_add_nsec3(zone, 0x22, 0x11);
+	ret = test_check(zone, rrset, 3, ZC_ERR_NSEC3_RDATA_CHAIN, &errors);
+	ok(ret == KNOT_EOK && errors == 0,
+	   "semcheck: coherent NSEC3 chain passes");
+
+	zone = test_zone_new();
+	test_add_nsec3(zone, 0x11, 0x22);
+	rrset = test_add_nsec3(zone, 0x22, 0x33);
+	ret = test_check(zone, rrset, 3, ZC_ERR_NSEC3_RDATA_CHAIN, &errors);
+	ok(ret == KNOT_EOK && errors > 0,
+	   "semcheck: changed NSEC3 next link is checked");
+
+	return 0;
+}
@@ -15,8 +15,13 @@
  */
 
 #include <config.h>
+#include <stdbool.h>
+
 #include "tests/libknot/dname_tests.h"
 #include "libknot/dname.h"
+#include "libknot/common.h"
+#include "libknot/consts.h"
+#include "libknot/util/tolower.h"
 
 /* Test dname_parse_from_wire */
 static int test_fw(size_t l, const char *w) {
@@ -34,6 +39,93 @@ static int test_fw(size_t l, const char *w) {
 	return ret;
 }
 
+static knot_dname_t *dname_from_str(const char *str)
+{
+	return knot_dname_new_from_str(str, strlen(str), NULL);
+}
+
+/*!
+ * \brief Checks case folding kernels against the character table.
+ */
+static int check_tolower_buf()
+{
+	uint8_t src[300], dst[300];
+	for (size_t i = 0; i < sizeof(src); ++i) {
+		src[i] = (i * 7) & 0xff;
+	}
+
+	for (size_t len = 0; len <= sizeof(src); ++len) {
+		memset(dst, 0, sizeof(dst));
+		knot_tolower_buf(dst, src, len);
+		for (size_t i = 0; i < len; ++i) {
+			if (dst[i] != knot_tolower(src[i])) {
+				return 0;
+			}
+		}
+		if (len < sizeof(dst) && dst[len] != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*!
+ * \brief Checks case insensitive comparison at every position.
+ */
+static int check_tolower_cmp()
+{
+	uint8_t s1[100], s2[100];
+	for (size_t i = 0; i < sizeof(s1); ++i) {
+		s1[i] = 'a' + i % 26;
+		s2[i] = 'A' + i % 26;
+	}
+	if (knot_tolower_cmp(s1, s2, sizeof(s1)) != 0) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < sizeof(s1); ++i) {
+		uint8_t orig = s2[i];
+		s2[i] = '-';
+		int res = knot_tolower_cmp(s1, s2, sizeof(s1));
+		int prefix = knot_tolower_cmp(s1, s2, i);
+		s2[i] = orig;
+		if (res != knot_tolower(s1[i]) - '-' || prefix != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*!
+ * \brief Checks case folding of unaligned buffers against the table.
+ */
+static int check_tolower_unaligned()
+{
+	uint8_t src[KNOT_MAX_DNAME_LENGTH + 32];
+	uint8_t dst[KNOT_MAX_DNAME_LENGTH + 32];
+	for (size_t i = 0; i < sizeof(src); ++i) {
+		src[i] = 'A' + i % 58;
+	}
+
+	const size_t lens[] = { 16, 32, 64, KNOT_MAX_DNAME_LENGTH };
+	for (int l = 0; l < sizeof(lens) / sizeof(size_t); ++l) {
+		for (size_t off = 1; off < 32; off += 3) {
+			size_t dst_off = 32 - off;
+			knot_tolower_buf(dst + dst_off, src + off, lens[l]);
+			for (size_t i = 0; i < lens[l]; ++i) {
+				if (dst[dst_off + i] !=
+				    knot_tolower(src[off + i])) {
+					return 0;
+				}
+			}
+		}
+	}
+
+	return 1;
+}
+
 static int dname_tests_count(int argc, char *argv[]);
 static int dname_tests_run(int argc, char *argv[]);
 
@@ -45,7 +137,7 @@ unit_api dname_tests_api = {
 
 static int dname_tests_count(int argc, char *argv[])
 {
-	return 8;
+	return 17;
 }
 
 static int dname_tests_run(int argc, char *argv[])
@@ -80,5 +172,81 @@ static int dname_tests_run(int argc, char *argv[])
 	w = "\x20\x68\x6d\x6e\x63\x62\x67\x61\x61\x61\x61\x65\x72\x6b\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x67\x6e\x69\x64\x68\x62\x61\x61\x61\x61\x65\x6c\x64\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x61\x63\x6f\x63\x64\x62\x61\x61\x61\x61\x65\x6b\x72\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x69\x62\x63\x6d\x6a\x6f\x61\x61\x61\x61\x65\x72\x6a\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x6f\x6c\x6e\x6c\x67\x68\x61\x61\x61\x61\x65\x73\x72\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x6a\x6b\x64\x66\x66\x67\x61\x61\x61\x61\x65\x6c\x68\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x67\x67\x6c\x70\x70\x61\x61\x61\x61\x61\x65\x73\x72\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x61\x61\x61\x62\x65\x6a\x61\x6d\x20\x65\x6b\x6c\x67\x70\x66\x61\x61\x61\x61\x65\x6c\x68\x30\x30\x30\x30\x64\x6c\x61\x61\x61\x61\x61\x0\x21\x42\x63\x84\xa5\xc6\xe7\x8\xa\xd\x11\x73\x3\x6e\x69\x63\x2\x43\x5a";
 	ok(!test_fw(277, w), "parsing invalid label (spec. case 1)");
 
+	knot_dname_t *upper = dname_from_str("WWW.Example.COM.");
+	knot_dname_t *lower = dname_from_str("www.example.com.");
+	knot_dname_t *other = dname_from_str("www.example.net.");
+	knot_dname_t *prev = dname_from_str("mail.example.com.");
+	knot_dname_t *copy = NULL;
+	knot_dname_t *chopped = NULL;
+	bool names = upper != NULL && lower != NULL && other != NULL &&
+	             prev != NULL;
+	if (!names) {
+		diag("dname: failed to create names");
+	}
+	skip(!names, 6);
+	{
+
+	/* 9. Hash does not depend on case. */
+	uint32_t upper_hash = knot_dname_hash(upper);
+	ok(upper_hash == knot_dname_hash(lower),
+	   "dname: hash is case insensitive");
+
+	/* 10. Conversion to lowercase makes the name canonical. */
+	knot_dname_to_lower(lower);
+	knot_dname_to_lower(other);
+	knot_dname_to_lower(prev);
+	ok((lower->flags & KNOT_DNAME_CANONICAL) && lower->hash == upper_hash,
+	   "dname: lowercase name is canonical");
+
+	/* 11. Equality of canonical and mixed case names. */
+	ok(knot_dname_is_equal(upper, lower)
+	   && knot_dname_is_equal(lower, upper)
+	   && !knot_dname_is_equal(lower, other),
+	   "dname: equality of canonical and mixed case names");
+
+	/* 12. Canonical comparison keeps the canonical order. */
+	ok(knot_dname_compare(prev, lower) < 0
+	   && knot_dname_compare(lower, prev) > 0
+	   && knot_dname_compare(lower, other) < 0
+	   && knot_dname_compare(upper, lower) == 0
+	   && knot_dname_compare_cs(upper, lower) != 0,
+	   "dname: canonical order of canonical names");
+
+	/* 13. Copy keeps the canonical form. */
+	copy = knot_dname_deep_copy(lower);
+	ok(copy != NULL && (copy->flags & KNOT_DNAME_CANONICAL)
+	   && knot_dname_is_equal(copy, lower),
+	   "dname: copy of canonical name is canonical");
+
+	/* 14. Modified name is no longer canonical. */
+	chopped = knot_dname_deep_copy(lower);
+	if (chopped != NULL) {
+		knot_dname_left_chop_no_copy(chopped);
+	}
+	ok(chopped != NULL && !(chopped->flags & KNOT_DNAME_CANONICAL)
+	   && !knot_dname_is_equal(chopped, lower)
+	   && knot_dname_is_subdomain(lower, chopped),
+	   "dname: modified name is not canonical");
+
+	} endskip;
+
+	/* 15. Case folding kernels. */
+	ok(check_tolower_buf(), "dname: case folding (%s)",
+	   knot_tolower_impl());
+
+	/* 16. Case insensitive comparison kernels. */
+	ok(check_tolower_cmp(), "dname: case insensitive comparison (%s)",
+	   knot_tolower_impl());
+
+	/* 17. Case folding of unaligned buffers. */
+	ok(check_tolower_unaligned(), "dname: case folding of unaligned data");
+
+	knot_dname_free(&upper);
+	knot_dname_free(&lower);
+	knot_dname_free(&other);
+	knot_dname_free(&prev);
+	knot_dname_free(&copy);
+	knot_dname_free(&chopped);
+
 	return 0;
 }
@@ -0,0 +1,188 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tests/libknot/node_tests.h"
+#include "libknot/common.h"
+#include "libknot/dname.h"
+#include "libknot/rrset.h"
+#include "libknot/zone/node.h"
+#include "common/descriptor.h"
+
+static int node_tests_count(int argc, char *argv[]);
+static int node_tests_run(int argc, char *argv[]);
+
+unit_api node_tests_api = {
+	"libknot/node",
+	&node_tests_count,
+	&node_tests_run
+};
+
+/*! \brief RRSet types stored in each node. */
+static const uint16_t NODE_TYPES[] = {
+	KNOT_RRTYPE_A, KNOT_RRTYPE_AAAA, KNOT_RRTYPE_MX, KNOT_RRTYPE_TXT,
+	KNOT_RRTYPE_RRSIG, KNOT_RRTYPE_NSEC
+};
+
+#define NODE_TYPE_COUNT (sizeof(NODE_TYPES) / sizeof(NODE_TYPES[0]))
+
+/*!
+ * \brief Creates node with RRSets of the first \a count types.
+ */
+static knot_node_t *create_node(knot_dname_t *owner, unsigned count)
+{
+	knot_node_t *node = knot_node_new(owner, NULL, 0);
+	if (node == NULL) {
+		return NULL;
+	}
+
+	for (unsigned i = 0; i < count; ++i) {
+		knot_rrset_t *rrset = knot_rrset_new(owner, NODE_TYPES[i],
+		                                     KNOT_CLASS_IN, 3600);
+		if (rrset == NULL ||
+		    knot_node_add_rrset_no_merge(node, rrset) != KNOT_EOK) {
+			knot_rrset_free(&rrset);
+			break;
+		}
+	}
+
+	return node;
+}
+
+/*!
+ * \brief Checks that lookup of each type returns RRSet of that type.
+ */
+static int check_types(const knot_node_t *node, unsigned count)
+{
+	if (knot_node_rrset_count(node) != count) {
+		return 0;
+	}
+
+	for (unsigned i = 0; i < NODE_TYPE_COUNT; ++i) {
+		const knot_rrset_t *rrset = knot_node_rrset(node,
+		                                            NODE_TYPES[i]);
+		if (i < count && (rrset == NULL ||
+		                  knot_rrset_type(rrset) != NODE_TYPES[i])) {
+			return 0;
+		}
+		if (i >= count && rrset != NULL) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*!
+ * \brief Adds RRSets one by one and counts reallocations of the RRSet block.
+ */
+static int count_growth(knot_dname_t *owner, unsigned *blocks)
+{
+	knot_node_t *node = knot_node_new(owner, NULL, 0);
+	if (node == NULL) {
+		return 0;
+	}
+
+	*blocks = 0;
+	int valid = 1;
+	for (unsigned i = 0; i < NODE_TYPE_COUNT && valid; ++i) {
+		knot_rrset_t **block = node->rrset_tree;
+		knot_rrset_t *rrset = knot_rrset_new(owner, NODE_TYPES[i],
+		                                     KNOT_CLASS_IN, 3600);
+		valid = rrset != NULL &&
+		        knot_node_add_rrset_no_merge(node, rrset) == KNOT_EOK;
+		if (!valid) {
+			knot_rrset_free(&rrset);
+		} else if (node->rrset_tree != block) {
+			*blocks += 1;
+		}
+	}
+	valid = valid && check_types(node, NODE_TYPE_COUNT) &&
+	        node->rrset_max >= NODE_TYPE_COUNT &&
+	        node->rrset_max < 2 * NODE_TYPE_COUNT;
+
+	knot_node_free_rrsets(node, 0);
+	knot_node_free(&node);
+	return valid;
+}
+
+static int node_tests_count(int argc, char *argv[])
+{
+	return 6;
+}
+
+static int node_tests_run(int argc, char *argv[])
+{
+	knot_dname_t *owner = knot_dname_new_from_str("node.example.com.",
+	                                              17, NULL);
+	if (owner == NULL) {
+		diag("node: failed to create owner name");
+		return 0;
+	}
+
+	/* 1. Lookup of all types after insertion. */
+	knot_node_t *node = create_node(owner, NODE_TYPE_COUNT);
+	ok(node != NULL && check_types(node, NODE_TYPE_COUNT),
+	   "node: lookup by type");
+
+	/* 2. Removal keeps the index consistent. */
+	knot_rrset_t *removed = knot_node_remove_rrset(node, KNOT_RRTYPE_AAAA);
+	int consistent = removed != NULL &&
+	                 knot_rrset_type(removed) == KNOT_RRTYPE_AAAA &&
+	                 knot_node_rrset(node, KNOT_RRTYPE_AAAA) == NULL &&
+	                 knot_node_rrset(node, KNOT_RRTYPE_NSEC) != NULL &&
+	                 knot_node_rrset_count(node) == NODE_TYPE_COUNT - 1;
+	ok(consistent, "node: remove RRSet");
+
+	/* 3. Re-adding the RRSet. */
+	int ret = knot_node_add_rrset(node, removed);
+	ok(ret == KNOT_EOK && knot_node_rrset(node, KNOT_RRTYPE_AAAA) == removed,
+	   "node: add RRSet after removal");
+
+	/* 4. Shallow copy shares RRSets and has its own index. */
+	knot_node_t *copy = NULL;
+	ret = knot_node_shallow_copy(node, &copy);
+	int shared = ret == KNOT_EOK && check_types(copy, NODE_TYPE_COUNT) &&
+	             knot_node_rrset(copy, KNOT_RRTYPE_MX) ==
+	             knot_node_rrset(node, KNOT_RRTYPE_MX);
+	if (shared) {
+		knot_node_remove_rrset(copy, KNOT_RRTYPE_MX);
+		shared = knot_node_rrset(copy, KNOT_RRTYPE_MX) == NULL &&
+		         knot_node_rrset(node, KNOT_RRTYPE_MX) != NULL;
+	}
+	ok(shared, "node: shallow copy");
+	knot_node_free(&copy);
+
+	/* 5. Removing all RRSets. */
+	knot_node_free_rrsets(node, 0);
+	knot_node_remove_all_rrsets(node);
+	ok(knot_node_rrset_count(node) == 0 &&
+	   knot_node_rrset(node, KNOT_RRTYPE_A) == NULL,
+	   "node: remove all RRSets");
+	knot_node_free(&node);
+
+	/* 6. RRSet block grows geometrically. */
+	unsigned blocks = 0;
+	ok(count_growth(owner, &blocks) && blocks <= 4,
+	   "node: RRSet block growth");
+
+	knot_dname_release(owner);
+
+	return 0;
+}
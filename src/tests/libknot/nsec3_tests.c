@@ -0,0 +1,150 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <ctype.h>
+#include <string.h>
+
+#include "tests/libknot/nsec3_tests.h"
+#include "libknot/common.h"
+#include "libknot/nsec3.h"
+#include "common/base32hex.h"
+
+static int nsec3_tests_count(int argc, char *argv[]);
+static int nsec3_tests_run(int argc, char *argv[]);
+
+unit_api nsec3_tests_api = {
+	"libknot/nsec3",
+	&nsec3_tests_count,
+	&nsec3_tests_run
+};
+
+/*! \brief Salt from RFC 5155, Appendix A. */
+static uint8_t NSEC3_SALT[] = { 0xaa, 0xbb, 0xcc, 0xdd };
+
+/*! \brief 'example.' and 'EXAMPLE.' in wire format. */
+static const uint8_t NAME_LOWER[] = "\x07""example";
+static const uint8_t NAME_UPPER[] = "\x07""EXAMPLE";
+
+/*! \brief 'a.example.' in wire format. */
+static const uint8_t NAME_OTHER[] = "\x01""a""\x07""example";
+
+/*!
+ * \brief Checks if the hash matches expected base32hex encoded value.
+ */
+static int hash_matches(const uint8_t *digest, const char *expected)
+{
+	uint8_t b32[64];
+	int32_t len = base32hex_encode(digest, KNOT_NSEC3_HASH_LENGTH,
+	                               b32, sizeof(b32));
+	if (len != strlen(expected)) {
+		return 0;
+	}
+
+	for (int32_t i = 0; i < len; ++i) {
+		if (tolower(b32[i]) != expected[i]) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int nsec3_tests_count(int argc, char *argv[])
+{
+	return 8;
+}
+
+static int nsec3_tests_run(int argc, char *argv[])
+{
+	knot_nsec3_params_t params;
+	memset(&params, 0, sizeof(params));
+	params.algorithm = 1;
+	params.iterations = 12;
+	params.salt_length = sizeof(NSEC3_SALT);
+	params.salt = NSEC3_SALT;
+
+	uint8_t digest[KNOT_NSEC3_HASH_LENGTH];
+
+	/* 1. Allocation-free hash matches RFC 5155 example. */
+	int ret = knot_nsec3_hash(&params, NAME_UPPER, sizeof(NAME_UPPER),
+	                          digest);
+	ok(ret == KNOT_EOK
+	   && hash_matches(digest, "0p9mhaveqvm6t7vbl5lop2u3t2rp3tom"),
+	   "nsec3: hash of 'example'");
+
+	/* 2. Allocating variant gives the same result. */
+	uint8_t *digest_alloc = NULL;
+	size_t digest_size = 0;
+	ret = knot_nsec3_sha1(&params, NAME_LOWER, sizeof(NAME_LOWER),
+	                      &digest_alloc, &digest_size);
+	ok(ret == KNOT_EOK && digest_size == KNOT_NSEC3_HASH_LENGTH
+	   && memcmp(digest, digest_alloc, digest_size) == 0,
+	   "nsec3: SHA-1 with allocated digest matches");
+	free(digest_alloc);
+
+	knot_nsec3_cache_t *cache = knot_nsec3_cache_new();
+	unsigned hits = 0, misses = 0;
+
+	/* 3. First lookup is a miss. */
+	memset(digest, 0, sizeof(digest));
+	ret = knot_nsec3_cache_hash(cache, &params, NAME_LOWER,
+	                            sizeof(NAME_LOWER), digest);
+	knot_nsec3_cache_stats(cache, &hits, &misses);
+	ok(ret == KNOT_EOK && hits == 0 && misses == 1
+	   && hash_matches(digest, "0p9mhaveqvm6t7vbl5lop2u3t2rp3tom"),
+	   "nsec3: cache miss computes hash");
+
+	/* 4. Lookup with different case is a hit. */
+	memset(digest, 0, sizeof(digest));
+	ret = knot_nsec3_cache_hash(cache, &params, NAME_UPPER,
+	                            sizeof(NAME_UPPER), digest);
+	knot_nsec3_cache_stats(cache, &hits, &misses);
+	ok(ret == KNOT_EOK && hits == 1 && misses == 1
+	   && hash_matches(digest, "0p9mhaveqvm6t7vbl5lop2u3t2rp3tom"),
+	   "nsec3: cache hit is case insensitive");
+
+	/* 5. Other name is not confused with cached one. */
+	ret = knot_nsec3_cache_hash(cache, &params, NAME_OTHER,
+	                            sizeof(NAME_OTHER), digest);
+	ok(ret == KNOT_EOK
+	   && hash_matches(digest, "35mthgpgcu1qg68fab165klnsnk3dpvl"),
+	   "nsec3: hash of 'a.example'");
+
+	/* 6. Cleared cache misses again. */
+	knot_nsec3_cache_clear(cache);
+	ret = knot_nsec3_cache_hash(cache, &params, NAME_LOWER,
+	                            sizeof(NAME_LOWER), digest);
+	knot_nsec3_cache_stats(cache, &hits, &misses);
+	ok(ret == KNOT_EOK && hits == 1 && misses == 3,
+	   "nsec3: cleared cache misses");
+
+	/* 7. No cache, hash is computed. */
+	ret = knot_nsec3_cache_hash(NULL, &params, NAME_OTHER,
+	                            sizeof(NAME_OTHER), digest);
+	ok(ret == KNOT_EOK
+	   && hash_matches(digest, "35mthgpgcu1qg68fab165klnsnk3dpvl"),
+	   "nsec3: hash without cache");
+
+	/* 8. Invalid parameters. */
+	ret = knot_nsec3_cache_hash(cache, NULL, NAME_LOWER,
+	                            sizeof(NAME_LOWER), digest);
+	ok(ret == KNOT_EINVAL, "nsec3: invalid parameters");
+
+	knot_nsec3_cache_free(&cache);
+
+	return 0;
+}
@@ -0,0 +1,359 @@
+/*  Copyright (C) 2013 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests/libknot/response_tests.h"
+#include "libknot/common.h"
+#include "libknot/dname.h"
+#include "libknot/packet/packet.h"
+#include "libknot/packet/response.h"
+#include "libknot/rrset.h"
+#include "common/descriptor.h"
+#include "libknot/util/wire.h"
+
+static int response_tests_count(int argc, char *argv[]);
+static int response_tests_run(int argc, char *argv[]);
+
+unit_api response_tests_api = {
+	"libknot/response",
+	&response_tests_count,
+	&response_tests_run
+};
+
+/*! \brief Number of names in the test message (AXFR-sized message). */
+#define RESP_NAMES 2048
+
+/*! \brief Fixed part of RR following the owner (type, class, TTL, RDLENGTH). */
+#define RESP_RR_FIXED 10
+
+/*! \brief Number of RRs in the test MX RRSet. */
+#define RESP_MX_COUNT 64
+
+
+/*!
+ * \brief Creates names resembling owners and RDATA in an AXFR message.
+ */
+static int create_names(knot_dname_t **names, size_t count)
+{
+	char buf[64];
+	for (size_t i = 0; i < count; ++i) {
+		if (i % 2 == 0) {
+			snprintf(buf, sizeof(buf),
+			         "host%zu.dept%zu.example.com.", i / 2, i % 16);
+		} else {
+			snprintf(buf, sizeof(buf), "mail%zu.Example.COM.",
+			         i % 32);
+		}
+		names[i] = knot_dname_new_from_str(buf, strlen(buf), NULL);
+		if (names[i] == NULL) {
+			return KNOT_ENOMEM;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Renders names into the message as RR owners.
+ *
+ * \return Message size or 0 on error.
+ */
+static size_t render(knot_compr_dict_t *dict, uint8_t *wire, size_t max,
+                     knot_dname_t **names, size_t count, size_t *offsets)
+{
+	knot_response_compr_reset(dict);
+
+	size_t pos = KNOT_WIRE_HEADER_SIZE;
+	memset(wire, 0, pos);
+	for (size_t i = 0; i < count; ++i) {
+		knot_compr_t compr;
+		memset(&compr, 0, sizeof(knot_compr_t));
+		compr.dict = dict;
+		compr.wire = wire;
+		compr.wire_pos = pos;
+
+		int ret = knot_response_compress_dname(names[i], &compr,
+		                                       wire + pos, max - pos);
+		if (ret < 0 || pos + ret + RESP_RR_FIXED > max) {
+			return 0;
+		}
+		if (offsets) {
+			offsets[i] = pos;
+		}
+		pos += ret;
+		memset(wire + pos, 0, RESP_RR_FIXED);
+		pos += RESP_RR_FIXED;
+	}
+
+	return pos;
+}
+
+/*!
+ * \brief Adds MX record with given preference to the RRSet.
+ */
+static int add_mx(knot_rrset_t *rrset, uint16_t pref)
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "mx%u.example.com.", pref);
+	knot_dname_t *name = knot_dname_new_from_str(buf, strlen(buf), NULL);
+	if (name == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	uint8_t *rdata = knot_rrset_create_rdata(rrset, sizeof(uint16_t) +
+	                                                sizeof(knot_dname_t *));
+	knot_wire_write_u16(rdata, pref);
+	memcpy(rdata + sizeof(uint16_t), &name, sizeof(knot_dname_t *));
+
+	return KNOT_EOK;
+}
+
+/*!
+ * \brief Creates RRSet with given number of MX records.
+ */
+static knot_rrset_t *create_mx(uint16_t count)
+{
+	knot_dname_t *owner = knot_dname_new_from_str("example.com.", 12, NULL);
+	if (owner == NULL) {
+		return NULL;
+	}
+	knot_rrset_t *rrset = knot_rrset_new(owner, KNOT_RRTYPE_MX,
+	                                     KNOT_CLASS_IN, 3600);
+	knot_dname_release(owner);
+
+	for (uint16_t i = 0; i < count; ++i) {
+		if (add_mx(rrset, i) != KNOT_EOK) {
+			knot_rrset_deep_free(&rrset, 1, 1);
+			return NULL;
+		}
+	}
+
+	return rrset;
+}
+
+/*!
+ * \brief Renders the RRSet into empty message.
+ *
+ * \return Message size or 0 on error.
+ */
+static size_t render_rrset(const knot_rrset_t *rrset, knot_compr_dict_t *dict,
+                           uint8_t *wire, size_t max)
+{
+	knot_response_compr_reset(dict);
+
+	size_t pos = KNOT_WIRE_HEADER_SIZE;
+	memset(wire, 0, pos);
+
+	compression_param_t param;
+	param.compressed_dnames = dict;
+	param.wire = wire;
+	param.wire_pos = pos;
+
+	size_t size = 0;
+	uint16_t rr_count = 0;
+	int ret = knot_rrset_to_wire(rrset, wire + pos, &size, max - pos,
+	                             &rr_count, &param);
+	if (ret != KNOT_EOK || rr_count != rrset->rdata_count) {
+		return 0;
+	}
+
+	return pos + size;
+}
+
+/*!
+ * \brief Checks that all rendered names parse back to the original names.
+ */
+static int check_names(const uint8_t *wire, size_t size,
+                       knot_dname_t **names, size_t count,
+                       const size_t *offsets)
+{
+	for (size_t i = 0; i < count; ++i) {
+		size_t pos = offsets[i];
+		knot_dname_t *parsed = knot_dname_parse_from_wire(wire, &pos,
+		                                                  size, NULL,
+		                                                  NULL);
+		if (parsed == NULL) {
+			return KNOT_EMALF;
+		}
+		int cmp = knot_dname_compare_cs(parsed, names[i]);
+		knot_dname_free(&parsed);
+		if (cmp != 0) {
+			diag("response: name %zu differs", i);
+			return KNOT_EMALF;
+		}
+	}
+
+	return KNOT_EOK;
+}
+
+static int response_tests_count(int argc, char *argv[])
+{
+	return 11;
+}
+
+static int response_tests_run(int argc, char *argv[])
+{
+	static knot_compr_dict_t dict;
+	static uint8_t wire[KNOT_WIRE_PTR_MAX * 4];
+	static knot_dname_t *names[RESP_NAMES];
+	static size_t offsets[RESP_NAMES];
+
+	memset(&dict, 0, sizeof(knot_compr_dict_t));
+	int ret = create_names(names, RESP_NAMES);
+
+	/* 1. Render AXFR-sized message. */
+	size_t size = 0;
+	if (ret == KNOT_EOK) {
+		size = render(&dict, wire, sizeof(wire), names, RESP_NAMES,
+		              offsets);
+	}
+	ok(size > 0, "response: render %u names", RESP_NAMES);
+
+	/* 2. All names decompress to the original names. */
+	if (size > 0) {
+		ret = check_names(wire, size, names, RESP_NAMES, offsets);
+	}
+	ok(size > 0 && ret == KNOT_EOK, "response: names decompress correctly");
+
+	/* 3. Names are compressed. */
+	size_t plain = KNOT_WIRE_HEADER_SIZE;
+	for (size_t i = 0; i < RESP_NAMES; ++i) {
+		plain += names[i] ? knot_dname_size(names[i]) : 0;
+		plain += RESP_RR_FIXED;
+	}
+	ok(size > 0 && size * 2 < plain,
+	   "response: compressed size %zu (uncompressed %zu)", size, plain);
+
+	/* 4. Repeated name is written as a single pointer. */
+	uint8_t name_wire[KNOT_MAX_DNAME_LENGTH];
+	knot_compr_t compr;
+	memset(&compr, 0, sizeof(knot_compr_t));
+	compr.dict = &dict;
+	compr.wire = wire;
+	compr.wire_pos = size;
+	ret = knot_response_compress_dname(names[0], &compr, name_wire,
+	                                   sizeof(name_wire));
+	ok(ret == sizeof(uint16_t) &&
+	   knot_wire_get_pointer(name_wire) == offsets[0],
+	   "response: repeated name compressed to pointer");
+
+	/* 5. Reset invalidates the dictionary. */
+	knot_response_compr_reset(&dict);
+	ret = knot_response_compress_dname(names[0], &compr, name_wire,
+	                                   sizeof(name_wire));
+	ok(ret == knot_dname_size(names[0]),
+	   "response: reset clears dictionary");
+
+	/* 6. Rendering after reset gives the same message. */
+	static uint8_t again[KNOT_WIRE_PTR_MAX * 4];
+	size_t again_size = render(&dict, again, sizeof(again), names,
+	                           RESP_NAMES, NULL);
+	ok(size > 0 && again_size == size && memcmp(again, wire, size) == 0,
+	   "response: repeated rendering is identical");
+
+	for (size_t i = 0; i < RESP_NAMES; ++i) {
+		knot_dname_free(&names[i]);
+	}
+
+	/* 7. Pre-rendered RDATA give the same result. */
+	static uint8_t plain_wire[KNOT_WIRE_PTR_MAX * 4];
+	knot_rrset_t *mx = create_mx(RESP_MX_COUNT);
+	size_t plain_size = 0;
+	size = 0;
+	if (mx != NULL) {
+		plain_size = render_rrset(mx, &dict, plain_wire,
+		                          sizeof(plain_wire));
+		ret = knot_rrset_wire_prepare(mx);
+		if (ret == KNOT_EOK && mx->wire != NULL) {
+			size = render_rrset(mx, &dict, wire, sizeof(wire));
+		}
+	}
+	ok(plain_size > 0 && size == plain_size &&
+	   memcmp(wire, plain_wire, size) == 0,
+	   "response: pre-rendered RDATA render identically");
+
+	/* 8. Changing RDATA drops pre-rendered RDATA. */
+	if (mx != NULL) {
+		knot_rrset_t *copy = NULL;
+		ret = knot_rrset_deep_copy(mx, &copy, 0);
+		ok(ret == KNOT_EOK && copy->wire == NULL &&
+		   add_mx(mx, RESP_MX_COUNT) == KNOT_EOK && mx->wire == NULL,
+		   "response: pre-rendered RDATA dropped on change");
+		knot_rrset_deep_free(&copy, 1, 0);
+	} else {
+		ok(0, "response: pre-rendered RDATA dropped on change");
+	}
+
+	/* 9. RDATA prepared again after change render identically. */
+	plain_size = 0;
+	size = 0;
+	if (mx != NULL) {
+		plain_size = render_rrset(mx, &dict, plain_wire,
+		                          sizeof(plain_wire));
+		ret = knot_rrset_wire_prepare(mx);
+		if (ret == KNOT_EOK && mx->wire != NULL) {
+			size = render_rrset(mx, &dict, wire, sizeof(wire));
+		}
+	}
+	ok(plain_size > 0 && size == plain_size &&
+	   memcmp(wire, plain_wire, size) == 0,
+	   "response: changed RDATA prepared again render identically");
+
+	/* 10. Synthesized RRSet shares RDATA and renders with new owner. */
+	knot_packet_t *pkt = knot_packet_new(KNOT_PACKET_PREALLOC_RESPONSE);
+	knot_dname_t *qname = knot_dname_new_from_str("a.b.example.com.", 16,
+	                                              NULL);
+	knot_rrset_t *synth = NULL;
+	size = 0;
+	if (pkt != NULL && qname != NULL && mx != NULL) {
+		synth = knot_packet_synth_rrset(pkt, mx, qname);
+	}
+	if (synth != NULL && synth->rdata == mx->rdata) {
+		size = render_rrset(synth, &dict, wire, sizeof(wire));
+	}
+	size_t owner_pos = KNOT_WIRE_HEADER_SIZE;
+	knot_dname_t *owner = NULL;
+	if (size > 0) {
+		owner = knot_dname_parse_from_wire(wire, &owner_pos, size,
+		                                   NULL, NULL);
+	}
+	ok(owner != NULL && knot_dname_compare_cs(owner, qname) == 0,
+	   "response: synthesized RRSet renders with new owner");
+	knot_dname_free(&owner);
+
+	/* 11. Synthesized RRSets are limited and dropped with the packet. */
+	int synth_count = (synth != NULL) ? 1 : 0;
+	while (pkt != NULL && mx != NULL &&
+	       knot_packet_synth_rrset(pkt, mx, qname) != NULL) {
+		++synth_count;
+	}
+	int cleared = 0;
+	if (pkt != NULL) {
+		knot_packet_free_synth_rrsets(pkt);
+		cleared = (pkt->synth_rrsets_count == 0);
+	}
+	ok(synth_count == KNOT_PACKET_SYNTH_MAX && cleared,
+	   "response: synthesized RRSets limited by packet space");
+
+	knot_packet_free(&pkt);
+	knot_dname_release(qname);
+	knot_rrset_deep_free(&mx, 1, 1);
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+/*  Copyright (C) 2011 CZ.NIC, z.s.p.o. <knot-dns@labs.nic.cz>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include "tests/libknot/tsig_tests.h"
+#include "libknot/common.h"
+#include "libknot/tsig-op.h"
+#include "libknot/sign/key.h"
+#include "libknot/packet/packet.h"
+
+static int tsig_tests_count(int argc, char *argv[]);
+static int tsig_tests_run(int argc, char *argv[]);
+
+unit_api tsig_tests_api = {
+	"libknot/tsig",
+	&tsig_tests_count,
+	&tsig_tests_run
+};
+
+/*! \brief Query for 'example.com. IN SOA', ID 0x1234. */
+static const uint8_t TSIG_QUERY[] = {
+	0x12, 0x34, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x03, 'c', 'o', 'm', 0x00,
+	0x00, 0x06, 0x00, 0x01
+};
+
+/*!
+ * \brief Signs the test query and returns resulting message size or 0.
+ */
+static size_t sign_query(uint8_t *wire, size_t max_len,
+                         const knot_tsig_key_t *key)
+{
+	memcpy(wire, TSIG_QUERY, sizeof(TSIG_QUERY));
+	size_t wire_len = sizeof(TSIG_QUERY);
+
+	uint8_t digest[64]; /* Fits HMAC-SHA512. */
+	size_t digest_len = sizeof(digest);
+	int ret = knot_tsig_sign(wire, &wire_len, max_len, NULL, 0,
+	                         digest, &digest_len, key, 0, 0);
+
+	return ret == KNOT_EOK ? wire_len : 0;
+}
+
+/*!
+ * \brief Parses signed message and checks it with the given key.
+ */
+static int check_query(const uint8_t *wire, size_t wire_len,
+                       const knot_tsig_key_t *key)
+{
+	knot_packet_t *pkt = knot_packet_new(KNOT_PACKET_PREALLOC_QUERY);
+	if (pkt == NULL) {
+		return KNOT_ENOMEM;
+	}
+
+	int ret = knot_packet_parse_from_wire(pkt, wire, wire_len, 0, 0);
+	if (ret == KNOT_EOK) {
+		const knot_rrset_t *tsig_rr = knot_packet_tsig(pkt);
+		if (tsig_rr == NULL) {
+			ret = KNOT_EMALF;
+		} else {
+			ret = knot_tsig_server_check(tsig_rr, wire, wire_len,
+			                             key);
+		}
+	}
+
+	knot_packet_free(&pkt);
+	return ret;
+}
+
+static int tsig_tests_count(int argc, char *argv[])
+{
+	return 6;
+}
+
+static int tsig_tests_run(int argc, char *argv[])
+{
+	uint8_t wire[512];
+	knot_tsig_key_t key;
+	memset(&key, 0, sizeof(key));
+
+	/* 1. Key creation precomputes HMAC state. */
+	int ret = knot_tsig_create_key("tsig.example.com",
+	                               KNOT_TSIG_ALG_HMAC_SHA256,
+	                               "Wg5ZShMpEZ39cHRvpwJ1eNv3ONE8pXLcMHeVFCZ"
+	                               "lZ7o=", &key);
+	ok(ret == KNOT_EOK && key.hmac != NULL,
+	   "tsig: key creation precomputes HMAC state");
+
+	/* Same key without precomputed state. */
+	knot_tsig_key_t plain_key = key;
+	plain_key.hmac = NULL;
+
+	/* 2. Sign with precomputed state. */
+	size_t wire_len = sign_query(wire, sizeof(wire), &key);
+	ok(wire_len > sizeof(TSIG_QUERY), "tsig: sign with prepared key");
+
+	/* 3. Verify with plain HMAC, i.e. both paths produce same digest. */
+	ret = check_query(wire, wire_len, &plain_key);
+	ok(ret == KNOT_EOK, "tsig: plain key verifies prepared signature");
+
+	/* 4. Verify with precomputed state. */
+	ret = check_query(wire, wire_len, &key);
+	ok(ret == KNOT_EOK, "tsig: prepared key verifies its signature");
+
+	/* 5. Sign without precomputed state, verify with it. */
+	wire_len = sign_query(wire, sizeof(wire), &plain_key);
+	ret = check_query(wire, wire_len, &key);
+	ok(wire_len > 0 && ret == KNOT_EOK,
+	   "tsig: prepared key verifies plain signature");
+
+	/* 6. Tampered message is rejected. */
+	wire[sizeof(TSIG_QUERY) - 1] ^= 0x01;
+	ret = check_query(wire, wire_len, &key);
+	ok(ret == KNOT_TSIG_EBADSIG, "tsig: tampered message is rejected");
+
+	knot_tsig_key_free(&key);
+
+	return 0;
+}
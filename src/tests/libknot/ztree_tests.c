@@ -69,6 +69,33 @@ static void ztree_iter_data(knot_node_t **node, void *data)
 	++it->i;
 }
 
+struct ztree_key_iter {
+	int ret;
+	unsigned i;
+	uint8_t prev[KNOT_ZONE_TREE_KEY_SIZE];
+};
+
+static void ztree_iter_key(knot_node_t **node, void *data)
+{
+	struct ztree_key_iter *it = (struct ztree_key_iter*)data;
+	uint8_t key[KNOT_ZONE_TREE_KEY_SIZE];
+	if (knot_zone_tree_key((*node)->owner, key) != KNOT_EOK) {
+		it->ret = KNOT_ERROR;
+		return;
+	}
+
+	/* Each key must be greater than the previous one. */
+	if (it->i > 0) {
+		size_t len = key[0] < it->prev[0] ? key[0] : it->prev[0];
+		int cmp = memcmp(it->prev + 1, key + 1, len);
+		if (cmp > 0 || (cmp == 0 && it->prev[0] >= key[0])) {
+			it->ret = KNOT_ERROR;
+		}
+	}
+	memcpy(it->prev, key, KNOT_ZONE_TREE_KEY_SIZE);
+	++it->i;
+}
+
 static int ztree_tests_count(int argc, char *argv[]);
 static int ztree_tests_run(int argc, char *argv[]);
 
@@ -80,7 +107,7 @@ unit_api ztree_tests_api = {
 
 static int ztree_tests_count(int argc, char *argv[])
 {
-	return 5;
+	return 6;
 }
 
 static int ztree_tests_run(int argc, char *argv[])
@@ -130,6 +157,14 @@ static int ztree_tests_run(int argc, char *argv[])
 	knot_zone_tree_apply_inorder(t, ztree_iter_data, &it);
 	ok (it.ret == KNOT_EOK, "ztree: ordered traversal");
 
+	/* 6. keys are in the traversal order */
+	struct ztree_key_iter kit;
+	memset(&kit, 0, sizeof(kit));
+	kit.ret = KNOT_EOK;
+	knot_zone_tree_apply_inorder(t, ztree_iter_key, &kit);
+	ok(kit.ret == KNOT_EOK && kit.i == NCOUNT,
+	   "ztree: keys in traversal order");
+
 	knot_zone_tree_free(&t);
 	ztree_free_data();
 	return 0;
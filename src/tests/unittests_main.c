@@ -20,11 +20,13 @@
 
 // Units to test
 #include "tests/common/slab_tests.h"
+#include "tests/common/arena_tests.h"
 #include "tests/common/skiplist_tests.h"
 #include "tests/common/hattrie_tests.h"
 #include "tests/common/events_tests.h"
 #include "tests/common/acl_tests.h"
 #include "tests/common/fdset_tests.h"
+#include "tests/common/log_tests.h"
 #include "tests/common/base64_tests.h"
 #include "tests/common/base32hex_tests.h"
 #include "tests/common/descriptor_tests.h"
@@ -33,11 +35,16 @@
 #include "tests/knot/server_tests.h"
 #include "tests/knot/conf_tests.h"
 #include "tests/knot/rrl_tests.h"
+#include "tests/knot/semcheck_tests.h"
 #include "tests/zscanner/zscanner_tests.h"
 #include "tests/libknot/wire_tests.h"
 #include "tests/libknot/dname_tests.h"
 #include "tests/libknot/ztree_tests.h"
 #include "tests/libknot/sign_tests.h"
+#include "tests/libknot/tsig_tests.h"
+#include "tests/libknot/nsec3_tests.h"
+#include "tests/libknot/response_tests.h"
+#include "tests/libknot/node_tests.h"
 #include "tests/libknot/rrset_tests.h"
 
 // Run all loaded units
@@ -54,12 +61,14 @@ int main(int argc, char *argv[])
 	        /* Core data structures. */
 	        &journal_tests_api,	//! Journal unit
 	        &slab_tests_api,	//! SLAB allocator unit
+	        &arena_tests_api,	//! Arena allocator unit
 	        &skiplist_tests_api,	//! Skip list unit
 	        &hattrie_tests_api,	//! HAT trie unit
 	        &dthreads_tests_api,	//! DThreads testing unit
 	        &events_tests_api,	//! Events testing unit
 	        &acl_tests_api,		//! ACLs
 	        &fdset_tests_api,	//! FDSET polling wrapper
+	        &log_tests_api,		//! Logging
 	        &base64_tests_api,	//! Base64 encoding
 	        &base32hex_tests_api,	//! Base32hex encoding
 	        &descriptor_tests_api,	//! RR descriptors
@@ -68,6 +77,7 @@ int main(int argc, char *argv[])
 	        &conf_tests_api,	//! Configuration parser tests
 	        &server_tests_api,	//! Server unit
 	        &rrl_tests_api,		//! RRL tests
+	        &semcheck_tests_api,	//! Semantic checks of updates
 
 	        /* Zone scanner. */
 	        &zscanner_tests_api,	//! Wrapper for external unittests
@@ -77,6 +87,10 @@ int main(int argc, char *argv[])
 	        &dname_tests_api,
 	        &ztree_tests_api,
 	        &sign_tests_api,	//! Key manipulation.
+	        &tsig_tests_api,	//! TSIG signing.
+	        &nsec3_tests_api,	//! NSEC3 hashing.
+	        &response_tests_api,	//! Name compression.
+	        &node_tests_api,	//! Node RRSet lookup.
 	        &rrset_tests_api,
 
 	        NULL